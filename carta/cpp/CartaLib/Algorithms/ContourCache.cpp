@@ -0,0 +1,107 @@
+/**
+ *
+ **/
+
+#include "ContourCache.h"
+#include "CartaLib/MemoryBudget.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Algorithms
+{
+namespace
+{
+/// approximate memory used by the polylines, in kilobytes (at least 1)
+int
+polylinesCost( const ContourCache::Polylines & polylines )
+{
+    uint64_t bytes = sizeof( ContourCache::Polylines ) + polylines.size() * sizeof( QPolygonF );
+    for ( const QPolygonF & poly : polylines ) {
+        bytes += poly.size() * sizeof( QPointF );
+    }
+    return static_cast < int > ( std::min < uint64_t > ( bytes / 1024 + 1, INT_MAX ) );
+}
+}
+
+ContourCache::ContourCache( uint64_t maxBytes )
+{
+    m_cache.setMaxCost( static_cast < int > ( std::min < uint64_t > ( maxBytes / 1024, INT_MAX ) ) );
+}
+
+bool
+ContourCache::find( const QString & viewId, const QString & type, double level, Polylines & polylines )
+{
+    Polylines * cached = m_cache.object( _key( viewId, type, level ) );
+    if ( ! cached ) {
+        m_misses++;
+        return false;
+    }
+    m_hits++;
+    polylines = * cached;
+    return true;
+}
+
+void
+ContourCache::insert( const QString & viewId, const QString & type, double level,
+                      const Polylines & polylines )
+{
+    // entries larger than the whole budget are dropped by QCache right away
+    m_cache.insert( _key( viewId, type, level ), new Polylines( polylines ),
+                    polylinesCost( polylines ) );
+}
+
+void
+ContourCache::clear()
+{
+    m_cache.clear();
+}
+
+ContourCache::Stats
+ContourCache::stats() const
+{
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = m_cache.size();
+    stats.kilobytes = m_cache.totalCost();
+    return stats;
+}
+
+double
+ContourCache::hitRate() const
+{
+    uint64_t lookups = m_hits + m_misses;
+    return lookups == 0 ? 0.0 : double( m_hits ) / lookups;
+}
+
+uint64_t
+ContourCache::memoryUsed() const
+{
+    return static_cast < uint64_t > ( m_cache.totalCost() ) * 1024;
+}
+
+void
+ContourCache::shrink( uint64_t maxBytes )
+{
+    MemoryBudget::qCacheShrink( m_cache, maxBytes, 1024 );
+}
+
+QString
+ContourCache::_key( const QString & viewId, const QString & type, double level )
+{
+    // the level is matched exactly, by its bits
+    if ( level == 0 ) {
+        level = 0;
+    }
+    quint64 bits;
+    std::memcpy( & bits, & level, sizeof( bits ) );
+    return viewId + QChar( '\n' ) + type + QChar( '\n' ) + QString::number( bits, 16 );
+}
+}
+}
+}
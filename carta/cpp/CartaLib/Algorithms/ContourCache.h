@@ -0,0 +1,105 @@
+/**
+ * Cache of computed contours.
+ *
+ * The contours of one level only depend on the data of the frame, on the smoothing
+ * applied before contouring and on the level itself. Changing the pen or the style
+ * of a contour set, adding a level to it, or going back to a frame that was already
+ * shown therefore does not need to run the contour algorithm again for the levels
+ * that were already computed. The cache stores the polylines of every computed level
+ * under the id of the view they were computed from, the smoothing type and the level,
+ * and drops the least recently used ones once they exceed a memory budget.
+ *
+ * The cache is not thread safe, it is meant to be used from the thread that
+ * runs the contour service.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include <QCache>
+#include <QPolygonF>
+#include <QString>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Algorithms
+{
+class ContourCache
+{
+    CLASS_BOILERPLATE( ContourCache );
+
+public:
+
+    typedef std::vector < QPolygonF > Polylines;
+
+    /// counters describing how well the cache works
+    struct Stats {
+        /// number of levels found in the cache
+        uint64_t hits = 0;
+        /// number of levels that had to be computed
+        uint64_t misses = 0;
+        /// number of levels currently in the cache
+        int entries = 0;
+        /// size of the cached polylines, in kilobytes
+        int kilobytes = 0;
+    };
+
+    /// \param maxBytes the maximum size of the cached polylines
+    explicit
+    ContourCache( uint64_t maxBytes );
+
+    /// \brief look up the contours of one level
+    /// \param viewId id of the view the contours were computed from
+    /// \param type the smoothing applied before contouring
+    /// \param level the contour level
+    /// \param polylines where to copy the contours if they are found
+    /// \return whether the contours were found
+    bool
+    find( const QString & viewId, const QString & type, double level, Polylines & polylines );
+
+    /// \brief remember the contours of one level
+    /// \param viewId id of the view the contours were computed from
+    /// \param type the smoothing applied before contouring
+    /// \param level the contour level
+    /// \param polylines the contours
+    void
+    insert( const QString & viewId, const QString & type, double level, const Polylines & polylines );
+
+    /// forget all contours
+    void
+    clear();
+
+    /// return the current values of the counters
+    Stats
+    stats() const;
+
+    /// return the fraction of lookups that were answered from the cache
+    double
+    hitRate() const;
+
+    /// return the approximate size of the cached polylines, in bytes
+    uint64_t
+    memoryUsed() const;
+
+    /// \brief drop the least recently used levels
+    /// \param maxBytes the size the cached polylines are reduced to, at most
+    void
+    shrink( uint64_t maxBytes );
+
+private:
+
+    static QString
+    _key( const QString & viewId, const QString & type, double level );
+
+    /// cost of the entries is their size in kilobytes
+    QCache < QString, Polylines > m_cache;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+}
+}
+}
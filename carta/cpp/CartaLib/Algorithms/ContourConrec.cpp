@@ -5,37 +5,27 @@
 #include <cmath>
 #include "ContourConrec.h"
 #include "IImage.h"
-#include "LineCombiner.h"
+#include "SegmentStitcher.h"
+#include <algorithm>
 #include <cmath>
+#include <memory>
 #include <QString>
 #include <QDebug>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace Carta::Lib::Algorithms;
 typedef std::vector < double > VD;
 
-const double kernel_gaussian3[9] =
-{ 0.02479795, 0.10787775, 0.02479795,
-  0.10787775, 0.46929721, 0.10787775,
-  0.02479795, 0.10787775, 0.02479795};
-
-const double kernel_gaussian5[25] =
-{ 0.00178843, 0.01031068, 0.01809162, 0.01031068, 0.00178843,
-  0.01031068, 0.05944323, 0.10430201, 0.05944323, 0.01031068,
-  0.01809162, 0.10430201, 0.18301345, 0.10430201, 0.01809162,
-  0.01031068, 0.05944323, 0.10430201, 0.05944323, 0.01031068,
-  0.00178843, 0.01031068, 0.01809162, 0.01031068, 0.00178843};
-
-const double kernel_box3[9] =
-{ 1.0/9.0, 1.0/9.0, 1.0/9.0,
-  1.0/9.0, 1.0/9.0, 1.0/9.0,
-  1.0/9.0, 1.0/9.0, 1.0/9.0};
-
-const double kernel_box5[25] =
-{ 1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0,
-  1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0,
-  1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0,
-  1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0,
-  1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0, 1.0/25.0};
+// The smoothing kernels are separable, i.e. the 2D kernel is the outer product of a
+// 1D kernel with itself. These are the 1D Gaussian kernels for 3x3 and 5x5, the
+// larger ones are computed by gaussianWeights().
+const double kernel_gaussian3_1d[3] = { 0.15747365, 0.68505271, 0.15747365 };
+
+const double kernel_gaussian5_1d[5] =
+{ 0.04228984, 0.24380983, 0.42780071, 0.24380983, 0.04228984 };
 
 /*
  * The code below is modified version of Paul Bourke's algorithm:
@@ -45,117 +35,84 @@ const double kernel_box5[25] =
  * The original is included at the bottom for reference, in case the web page
  * disappears.
  */
-/*
-   Derivation from the fortran version of CONREC by Paul Bourke
-   view            ! view of the data
-   ilb,iub         ! bounds for first coordinate (column), inclusive
-   jlb,jub         ! bounds for second coordinate (row), inclusive
-   xCoords         ! column coordinates (first index)
-   yCoords         ! row coordinates (second index)
-   nc              ! number of contour levels
-   z               ! contour levels in increasing order
-*/
 
-static Carta::Lib::Algorithms::ContourConrec::Result
-conrecFaster( Carta::Lib::NdArray::RawViewInterface * view, int ilb, int iub, int jlb, int jub,
-        const VD & xCoords, const VD & yCoords, int nc, VD z,
-        const ContourConrec::ContourMode mode=ContourConrec::ContourMode::ORIGINAL){
-
-    int ghost = 0; // The useless edge width when doing filter.
-    const double kernal_default[1] = {1.0};
-    const double *kernel = &kernal_default[0];
-    switch (mode) {
-        case ContourConrec::ContourMode::GAUSSIANBLUR_3:
-            ghost = 1;
-            kernel = &kernel_gaussian3[0];
-            break;
-        case ContourConrec::ContourMode::GAUSSIANBLUR_5:
-            ghost = 2;
-            kernel = &kernel_gaussian5[0];
-            break;
-        case ContourConrec::ContourMode::BOXBLUR_3:
-            ghost = 1;
-            kernel = &kernel_box3[0];
-            break;
-        case ContourConrec::ContourMode::BOXBLUR_5:
-            ghost = 2;
-            kernel = &kernel_box5[0];
-            break;
-        default:
-            break;
-    }
+/*
+ * Banded version of the original single threaded algorithm (which is kept in
+ * Tests/conrecSerial.cpp as a reference), with identical results without smoothing,
+ * and results that only differ by rounding with it.
+ *
+ * The view is read a block of rows at a time with the buffered forEach(). The
+ * smoothing filter is applied to the rows of the block, as two 1D passes (along the
+ * rows, then along the columns) instead of one 2D pass, or the pixels are averaged
+ * into a coarser grid when downsampling. The block is then split
+ * into horizontal bands of cells that are contoured in parallel. Every band collects
+ * its segments in one flat array per level, and the arrays of the bands are appended
+ * in band order, which is the order in which the original algorithm visits the cells. A band
+ * only needs the filtered rows above and below its cells, so the bands of a block do
+ * not depend on each other.
+ */
 
-    // we will only need two rows in memory at any given time
-    // int nRows = jub - jlb + 1;
-    int nCols = iub - ilb - (2*ghost) + 1;
-    int prepareCols = iub - ilb + 1;
-    int prepareRows = 2*ghost + 1;
-    int area = prepareCols*prepareRows;
-    double * rows[2] { nullptr, nullptr };
-    std::vector < double > row1( nCols ), row2( nCols ),
-                           prepareArea( area );
-    rows[0] = & row1[0];
-    rows[1] = & row2[0];
-    int nextRowToReadIn = 0;
-    int nextFilterStart = 0;
-
-    auto updateRows = [&]() -> void {
-        CARTA_ASSERT( nextRowToReadIn < view-> dims()[1] );
-
-        SliceND rowSlice;
-        int update = ( nextRowToReadIn > 0 ? 1 : prepareRows );
-        rowSlice.next().start( nextRowToReadIn ).end( nextRowToReadIn + update );
-        auto rawRowView = view-> getView( rowSlice );
-
-        // make a double view of this raw row view
-        Carta::Lib::NdArray::Double dview( rawRowView, true );
-
-        // shift the row up
-        // note: we could avoid this memory copy if we swapped row[] pointers instead,
-        // and alternately read in the data into row1,row2..., for a miniscule performance
-        // gain and lot more complicated algorithm
-        row1 = row2;
-
-        // Prepare Data for possible filter
-        int t = nextRowToReadIn*prepareCols;
-        dview.forEach( [&] ( const double & val ) {
-            // To improve the performance, the prepareArea also update only one row
-            // by computing the module
-            prepareArea[(t++)%area] = val;
-        });
-
-        // Do the filter
-        for ( int i=0; i<nCols; i++){
-            row2[i] = 0;
-            int elems = (2*ghost+1)*(2*ghost+1);
-            for ( int e=0; e<elems; e++){
-                int row = e/(2*ghost+1) + nextFilterStart;
-                int col = e%(2*ghost+1);
-                int index = (row*prepareCols + col + i) % area;
-                row2[i] += kernel[e]*prepareArea[index];
-            }
-        }
+/// approximate number of pixels read from the view in one block
+static constexpr int64_t ConrecBlockPixels = 4 * 1024 * 1024;
 
-        nextRowToReadIn += update;
-        nextFilterStart ++;
-    };
-    updateRows();
+/// minimum number of cell rows in a band
+static constexpr int ConrecMinBandRows = 8;
 
-//    NdArray::Double doubleView( view, false );
-//    auto acc = [& doubleView] ( int col, int row ) {
-//        return doubleView.get( { col, row }
-//                               );
-//    };
+/// number of bands per thread each block is split into (for load balancing)
+static constexpr int ConrecBandsPerThread = 4;
 
-    Carta::Lib::Algorithms::ContourConrec::Result result;
-    if ( nc < 1 ) {
-        return result;
+static int
+conrecThreadCount( int nThreads )
+{
+    if ( nThreads > 0 ) {
+        return nThreads;
     }
-    result.resize( nc );
+#ifdef _OPENMP
+    return std::max( 1, omp_get_max_threads() );
+#else
+    return 1;
+#endif
+}
+
+/// read rows [first, first + count) of the view as Scalars into dst
+template < typename Scalar >
+static void
+conrecReadRows( Carta::Lib::NdArray::RawViewInterface * view, int first, int count,
+                int64_t nCols, Scalar * dst )
+{
+    SliceND rowSlice;
+    rowSlice.next().start( first ).end( first + count );
+    std::unique_ptr < Carta::Lib::NdArray::RawViewInterface > rowView( view-> getView( rowSlice ) );
+    const Carta::Lib::Image::PixelType pixelType = rowView-> pixelType();
+    const int64_t pixelSize = Carta::Lib::Image::pixelType2size( pixelType );
+    const int64_t nPixels = nCols * count;
+    int64_t counter = 0;
+    rowView-> forEach( std::min < int64_t > ( nPixels, ConrecBlockPixels ) * pixelSize,
+                       [&] ( const char * data, int64_t n ) {
+        n = std::min( n, nPixels - counter );
+        Carta::Lib::convertPixels < Scalar > ( pixelType, data, n, dst + counter );
+        counter += n;
+    });
+    CARTA_ASSERT( counter == nPixels );
+}
 
+/// contour the cells of rows [jFirst, jEnd), row j of the filtered values starting at
+/// rows + ( j - jFirst ) * nCols, and append the segments of level k to segments[k]
+/// as x1, y1, x2, y2
+///
+/// The values are widened to doubles before any arithmetic, so float rows give the
+/// same segments as the same rows converted to doubles.
+template < typename Scalar >
+static void
+conrecBand( const Scalar * rows, int nCols, int jFirst, int jEnd,
+            const VD & xCoords, const VD & yCoords, const VD & z, bool levelsOrdered,
+            std::vector < VD > & segments )
+{
 #define xsect( p1, p2 ) ( h[p2] * xh[p1] - h[p1] * xh[p2] ) / ( h[p2] - h[p1] )
 #define ysect( p1, p2 ) ( h[p2] * yh[p1] - h[p1] * yh[p2] ) / ( h[p2] - h[p1] )
 
+    const int nc = z.size();
+    const int nCells = nCols - 1;
     int m1, m2, m3, case_value, sh[5];
     double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
     double h[5], xh[5], yh[5];
@@ -166,40 +123,56 @@ conrecFaster( Carta::Lib::NdArray::RawViewInterface * view, int ilb, int iub, in
         { { 0, 3, 4 }, { 1, 3, 1 }, { 4, 3, 0 } },
         { { 9, 6, 7 }, { 5, 2, 0 }, { 8, 0, 0 } }
     };
+    std::vector < Scalar > cellMin( nCells ), cellMax( nCells );
+
+    for ( int j = jFirst ; j < jEnd ; j++ ) {
+        const Scalar * row0 = rows + int64_t( j - jFirst ) * nCols;
+        const Scalar * row1 = row0 + nCols;
+
+        // classify all cells of the row at once, this loop is vectorized; the
+        // expressions are the same as in the original algorithm, so that NaNs propagate
+        // the same way
+        for ( int i = 0 ; i < nCells ; i++ ) {
+            Scalar temp1 = std::min( row0[i], row1[i] );
+            Scalar temp2 = std::min( row0[i + 1], row1[i + 1] );
+            cellMin[i] = std::min( temp1, temp2 );
+            temp1 = std::max( row0[i], row1[i] );
+            temp2 = std::max( row0[i + 1], row1[i + 1] );
+            cellMax[i] = std::max( temp1, temp2 );
+        }
 
-    // original code went from bottom to top, not sure why
-    //    for ( j = ( jub - 1 ) ; j >= jlb ; j-- ) {
-    for ( int j = jlb ; j < jub-2*ghost ; j++ ) {
-        updateRows();
-        for ( int i = ilb ; i < iub-2*ghost ; i++ ) {
-            double temp1 = std::min( rows[0][i]  , rows[1][i]   );
-            double temp2 = std::min( rows[0][i+1], rows[1][i+1] );
-            double dmin = std::min( temp1, temp2 );
-            // early abort if one of the values is not finite
-            if ( ! std::isfinite( dmin ) ) {
+        for ( int i = 0 ; i < nCells ; i++ ) {
+            const double dmin = cellMin[i];
+            const double dmax = cellMax[i];
+            if ( ! std::isfinite( dmin ) || dmax < z[0] || dmin > z[nc - 1] ) {
                 continue;
             }
-            temp1 = std::max( rows[0][i]  , rows[1][i]   );
-            temp2 = std::max( rows[0][i+1], rows[1][i+1] );
-            double dmax = std::max( temp1, temp2 );
-            if ( dmax < z[0] || dmin > z[nc - 1] ) {
-                continue;
+            // the levels crossing the cell are contiguous, skip the ones below it
+            int k = 0;
+            if ( levelsOrdered ) {
+                k = std::lower_bound( z.begin(), z.end(), dmin ) - z.begin();
             }
-            for ( int k = 0 ; k < nc ; k++ ) {
-                if ( z[k] < dmin || z[k] > dmax ) {
+            for ( ; k < nc ; k++ ) {
+                if ( z[k] > dmax ) {
+                    if ( levelsOrdered ) {
+                        break;
+                    }
+                    continue;
+                }
+                if ( z[k] < dmin ) {
                     continue;
                 }
                 for ( int m = 4 ; m >= 0 ; m-- ) {
                     if ( m > 0 ) {
-                        int ii = i + im[m-1], jj = jm[m-1];
-                        h[m] = rows[jj][ii] - z[k];
-                        xh[m] = xCoords[i + ghost + im[m - 1]];
-                        yh[m] = yCoords[j + ghost + jm[m - 1]];
+                        const Scalar * row = jm[m - 1] ? row1 : row0;
+                        h[m] = row[i + im[m - 1]] - z[k];
+                        xh[m] = xCoords[i + im[m - 1]];
+                        yh[m] = yCoords[j + jm[m - 1]];
                     }
                     else {
                         h[0] = 0.25 * ( h[1] + h[2] + h[3] + h[4] );
-                        xh[0] = 0.50 * ( xCoords[i + ghost] + xCoords[i + ghost + 1] );
-                        yh[0] = 0.50 * ( yCoords[j + ghost] + yCoords[j + ghost + 1] );
+                        xh[0] = 0.50 * ( xCoords[i] + xCoords[i + 1] );
+                        yh[0] = 0.50 * ( yCoords[j] + yCoords[j + 1] );
                     }
                     if ( h[m] > 0.0 ) {
                         sh[m] = 1;
@@ -211,6 +184,7 @@ conrecFaster( Carta::Lib::NdArray::RawViewInterface * view, int ilb, int iub, in
                         sh[m] = 0;
                     }
                 }
+
                 /*
                    Note: at this stage the relative heights of the corners and the
                    centre are in the h array, and the corresponding coordinates are
@@ -234,7 +208,7 @@ conrecFaster( Carta::Lib::NdArray::RawViewInterface * view, int ilb, int iub, in
                                | /               \ |
                       vertex 1 +-------------------+ vertex 2
                 */
-                /* Scan each triangle in the box */
+                // the cases are described in the original code at the bottom of this file
                 for ( int m = 1 ; m <= 4 ; m++ ) {
                     m1 = m;
                     m2 = 0;
@@ -249,55 +223,55 @@ conrecFaster( Carta::Lib::NdArray::RawViewInterface * view, int ilb, int iub, in
                     }
                     switch ( case_value )
                     {
-                    case 1 : /* Line between vertices 1 and 2 */
+                    case 1 :
                         x1 = xh[m1];
                         y1 = yh[m1];
                         x2 = xh[m2];
                         y2 = yh[m2];
                         break;
-                    case 2 : /* Line between vertices 2 and 3 */
+                    case 2 :
                         x1 = xh[m2];
                         y1 = yh[m2];
                         x2 = xh[m3];
                         y2 = yh[m3];
                         break;
-                    case 3 : /* Line between vertices 3 and 1 */
+                    case 3 :
                         x1 = xh[m3];
                         y1 = yh[m3];
                         x2 = xh[m1];
                         y2 = yh[m1];
                         break;
-                    case 4 : /* Line between vertex 1 and side 2-3 */
+                    case 4 :
                         x1 = xh[m1];
                         y1 = yh[m1];
                         x2 = xsect( m2, m3 );
                         y2 = ysect( m2, m3 );
                         break;
-                    case 5 : /* Line between vertex 2 and side 3-1 */
+                    case 5 :
                         x1 = xh[m2];
                         y1 = yh[m2];
                         x2 = xsect( m3, m1 );
                         y2 = ysect( m3, m1 );
                         break;
-                    case 6 : /* Line between vertex 3 and side 1-2 */
+                    case 6 :
                         x1 = xh[m3];
                         y1 = yh[m3];
                         x2 = xsect( m1, m2 );
                         y2 = ysect( m1, m2 );
                         break;
-                    case 7 : /* Line between sides 1-2 and 2-3 */
+                    case 7 :
                         x1 = xsect( m1, m2 );
                         y1 = ysect( m1, m2 );
                         x2 = xsect( m2, m3 );
                         y2 = ysect( m2, m3 );
                         break;
-                    case 8 : /* Line between sides 2-3 and 3-1 */
+                    case 8 :
                         x1 = xsect( m2, m3 );
                         y1 = ysect( m2, m3 );
                         x2 = xsect( m3, m1 );
                         y2 = ysect( m3, m1 );
                         break;
-                    case 9 : /* Line between sides 3-1 and 1-2 */
+                    case 9 :
                         x1 = xsect( m3, m1 );
                         y1 = ysect( m3, m1 );
                         x2 = xsect( m1, m2 );
@@ -307,24 +281,246 @@ conrecFaster( Carta::Lib::NdArray::RawViewInterface * view, int ilb, int iub, in
                         break;
                     } // switch
 
-                    // add the line segment to the result
-                    // ConrecLine( x1, y1, x2, y2, k );
                     if ( std::isfinite( x1 ) && std::isfinite( y1 ) && std::isfinite( x2 ) &&
                          std::isfinite( y2 ) ) {
-                        QPolygonF poly;
-                        poly.append( QPointF( x1, y1 ) );
-                        poly.append( QPointF( x2, y2 ) );
-                        result[k].push_back( poly );
+                        VD & seg = segments[k];
+                        seg.push_back( x1 );
+                        seg.push_back( y1 );
+                        seg.push_back( x2 );
+                        seg.push_back( y2 );
                     }
                 } /* m */
             } /* k - contour */
         } /* i */
     } /* j */
-    return result;
 
 #undef xsect
 #undef ysect
-} // conrecFaster
+} // conrecBand
+
+/// smooth rows [0, nRows) of the filtered values, reading the rows of data starting at
+/// src, with a separable kernel: first along the rows into tmp, then along the columns
+template < typename Scalar >
+static void
+conrecSmoothRows( const Scalar * src, int dataCols, int nRows, int nCols,
+                  const VD & weights, VD & tmp, double * dst, int nThreads )
+{
+    const int width = weights.size();
+    const int dataRows = nRows + width - 1;
+    tmp.resize( int64_t( dataRows ) * nCols );
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( static )
+#endif
+    for ( int r = 0 ; r < dataRows ; r++ ) {
+        const Scalar * in = src + int64_t( r ) * dataCols;
+        double * out = & tmp[int64_t( r ) * nCols];
+        for ( int i = 0 ; i < nCols ; i++ ) {
+            out[i] = 0;
+        }
+        for ( int e = 0 ; e < width ; e++ ) {
+            const double weight = weights[e];
+            const Scalar * in2 = in + e;
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+            for ( int i = 0 ; i < nCols ; i++ ) {
+                out[i] += weight * in2[i];
+            }
+        }
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( static )
+#endif
+    for ( int r = 0 ; r < nRows ; r++ ) {
+        double * out = dst + int64_t( r ) * nCols;
+        for ( int i = 0 ; i < nCols ; i++ ) {
+            out[i] = 0;
+        }
+        for ( int e = 0 ; e < width ; e++ ) {
+            const double weight = weights[e];
+            const double * in = & tmp[int64_t( r + e ) * nCols];
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+            for ( int i = 0 ; i < nCols ; i++ ) {
+                out[i] += weight * in[i];
+            }
+        }
+    }
+} // conrecSmoothRows
+
+/// average blocks of factor x factor pixels into rows [0, nRows) of the filtered
+/// values, reading the rows of data starting at src; a block with a NaN is NaN
+template < typename Scalar >
+static void
+conrecDownsampleRows( const Scalar * src, int dataCols, int nRows, int nCols, int factor,
+                      double * dst, int nThreads )
+{
+    const double scale = 1.0 / ( double( factor ) * factor );
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( static )
+#endif
+    for ( int r = 0 ; r < nRows ; r++ ) {
+        double * out = dst + int64_t( r ) * nCols;
+        for ( int i = 0 ; i < nCols ; i++ ) {
+            out[i] = 0;
+        }
+        for ( int dy = 0 ; dy < factor ; dy++ ) {
+            const Scalar * in = src + ( int64_t( r ) * factor + dy ) * dataCols;
+            for ( int i = 0 ; i < nCols ; i++ ) {
+                double sum = 0;
+                for ( int dx = 0 ; dx < factor ; dx++ ) {
+                    sum += in[i * factor + dx];
+                }
+                out[i] += sum;
+            }
+        }
+        for ( int i = 0 ; i < nCols ; i++ ) {
+            out[i] *= scale;
+        }
+    }
+} // conrecDownsampleRows
+
+/// contour rows of cells [jFirst, jFirst + nCells) with multiple threads, row j of the
+/// filtered values starting at rows + ( j - jFirst ) * nCols, and append the segments
+/// of level k to levelSegments[k]
+template < typename Scalar >
+static void
+conrecBands( const Scalar * rows, int nCols, int jFirst, int nCells,
+             const VD & xCoords, const VD & yCoords, const VD & z, bool levelsOrdered,
+             int nThreads, std::vector < VD > & levelSegments )
+{
+    const int nc = z.size();
+    const int nBands = std::max( 1, std::min( nThreads * ConrecBandsPerThread,
+                                              nCells / ConrecMinBandRows ) );
+    std::vector < std::vector < VD > > bandSegments( nBands, std::vector < VD > ( nc ) );
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( dynamic )
+#endif
+    for ( int band = 0 ; band < nBands ; band++ ) {
+        const int first = int64_t( nCells ) * band / nBands;
+        const int end = int64_t( nCells ) * ( band + 1 ) / nBands;
+        conrecBand( rows + int64_t( first ) * nCols, nCols, jFirst + first, jFirst + end,
+                    xCoords, yCoords, z, levelsOrdered, bandSegments[band] );
+    }
+
+    for ( int band = 0 ; band < nBands ; band++ ) {
+        for ( int k = 0 ; k < nc ; k++ ) {
+            const VD & seg = bandSegments[band][k];
+            levelSegments[k].insert( levelSegments[k].end(), seg.begin(), seg.end() );
+        }
+    }
+} // conrecBands
+
+/// conrecBanded() with the pixels read as Scalars (float or double); smoothed or
+/// downsampled values are always doubles
+template < typename Scalar >
+static std::vector < VD >
+conrecBandedAs( Carta::Lib::NdArray::RawViewInterface * view, const VD & xCoords,
+                const VD & yCoords, const VD & z, int nThreads,
+                const ContourConrec::Smoothing & smoothing )
+{
+    const int factor = std::max( 1, smoothing.downsample );
+    const VD & weights = smoothing.weights;
+    const int ghost = factor > 1 ? 0 : weights.size() / 2;
+
+    const int nc = z.size();
+    std::vector < VD > levelSegments( nc );
+    const int dataCols = view-> dims()[0];
+    const int dataRows = view-> dims()[1];
+    // columns and rows of filtered values, and rows of cells
+    const int nCols = dataCols / factor - 2 * ghost;
+    const int nRows = dataRows / factor - 2 * ghost;
+    const int cellRows = nRows - 1;
+    if ( nc < 1 || nCols < 2 || cellRows < 1 ) {
+        return levelSegments;
+    }
+    nThreads = conrecThreadCount( nThreads );
+    const bool levelsOrdered = std::none_of( z.begin(), z.end(), [] ( double level ) {
+        return std::isnan( level );
+    });
+
+    // coordinates of the filtered values; a downsampled value is at the center of
+    // the pixels it averages
+    VD xFiltered( nCols ), yFiltered( nRows );
+    for ( int i = 0 ; i < nCols ; i++ ) {
+        xFiltered[i] = factor > 1 ? 0.5 * ( xCoords[i * factor] + xCoords[( i + 1 ) * factor - 1] )
+                                  : xCoords[i + ghost];
+    }
+    for ( int j = 0 ; j < nRows ; j++ ) {
+        yFiltered[j] = factor > 1 ? 0.5 * ( yCoords[j * factor] + yCoords[( j + 1 ) * factor - 1] )
+                                  : yCoords[j + ghost];
+    }
+
+    const int blockRows = std::max < int64_t > ( nThreads * ConrecBandsPerThread * ConrecMinBandRows,
+                                                 ConrecBlockPixels / dataCols / factor );
+    std::vector < Scalar > data;
+    VD tmp, filtered;
+
+    for ( int jBlock = 0 ; jBlock < cellRows ; jBlock += blockRows ) {
+        const int blockCells = std::min( blockRows, cellRows - jBlock );
+        const int blockFiltered = blockCells + 1;
+
+        // read the rows needed by the cells of the block, and smooth them
+        const int blockData = blockFiltered * factor + 2 * ghost;
+        data.resize( int64_t( blockData ) * dataCols );
+        conrecReadRows( view, jBlock * factor, blockData, dataCols, data.data() );
+        if ( factor == 1 && ghost == 0 ) {
+            conrecBands( data.data(), nCols, jBlock, blockCells, xFiltered, yFiltered, z,
+                         levelsOrdered, nThreads, levelSegments );
+            continue;
+        }
+        filtered.resize( int64_t( blockFiltered ) * nCols );
+        if ( factor > 1 ) {
+            conrecDownsampleRows( data.data(), dataCols, blockFiltered, nCols, factor,
+                                  filtered.data(), nThreads );
+        }
+        else {
+            conrecSmoothRows( data.data(), dataCols, blockFiltered, nCols, weights, tmp,
+                              filtered.data(), nThreads );
+        }
+
+        // contour the bands
+        conrecBands( filtered.data(), nCols, jBlock, blockCells, xFiltered, yFiltered, z,
+                     levelsOrdered, nThreads, levelSegments );
+    }
+
+    return levelSegments;
+} // conrecBandedAs
+
+/// returns the segments of each level, stored as x1, y1, x2, y2 for each of them
+static std::vector < VD >
+conrecBanded( Carta::Lib::NdArray::RawViewInterface * view, const VD & xCoords,
+              const VD & yCoords, const VD & z, int nThreads,
+              const ContourConrec::Smoothing & smoothing )
+{
+    // float pixels are read as floats, which halves the memory of the blocks
+    if ( view-> pixelType() == Carta::Lib::Image::PixelType::Real32 ) {
+        return conrecBandedAs < float > ( view, xCoords, yCoords, z, nThreads, smoothing );
+    }
+    return conrecBandedAs < double > ( view, xCoords, yCoords, z, nThreads, smoothing );
+} // conrecBanded
+
+/// normalized weights of a Gaussian with standard deviation sigma, from -radius
+/// to radius
+static VD
+gaussianWeights( double sigma, int radius )
+{
+    VD weights( 2 * radius + 1 );
+    double sum = 0;
+    for ( int i = - radius ; i <= radius ; i++ ) {
+        weights[i + radius] = std::exp( - 0.5 * i * i / ( sigma * sigma ) );
+        sum += weights[i + radius];
+    }
+    for ( double & weight : weights ) {
+        weight /= sum;
+    }
+    return weights;
+}
 
 namespace Carta
 {
@@ -341,8 +537,67 @@ ContourConrec::setLevels( const std::vector < double > & levels )
     m_levels = levels;
 }
 
+void
+ContourConrec::setThreadCount( int nThreads )
+{
+    m_threadCount = nThreads;
+}
+
+ContourConrec::Smoothing
+ContourConrec::smoothingForType( const QString & typeName )
+{
+    Smoothing smoothing;
+    bool ok = false;
+    if (typeName == "Gaussian blur 3x3"){
+        smoothing.weights.assign( kernel_gaussian3_1d, kernel_gaussian3_1d + 3 );
+    } else if (typeName == "Gaussian blur 5x5"){
+        smoothing.weights.assign( kernel_gaussian5_1d, kernel_gaussian5_1d + 5 );
+    } else if (typeName == "Gaussian blur 7x7"){
+        smoothing.weights = gaussianWeights( 1.5, 3 );
+    } else if (typeName == "Gaussian blur 9x9"){
+        smoothing.weights = gaussianWeights( 2.0, 4 );
+    } else if (typeName == "Box blur 3x3"){
+        smoothing.weights.assign( 3, 1.0 / 3.0 );
+    } else if (typeName == "Box blur 5x5"){
+        smoothing.weights.assign( 5, 1.0 / 5.0 );
+    } else if (typeName == "Box blur 7x7"){
+        smoothing.weights.assign( 7, 1.0 / 7.0 );
+    } else if (typeName == "Box blur 9x9"){
+        smoothing.weights.assign( 9, 1.0 / 9.0 );
+    } else if ( typeName.startsWith( "Gaussian blur sigma " ) ) {
+        double sigma = typeName.mid( 20 ).toDouble( & ok );
+        if ( ok && sigma > 0 && sigma <= ContourConrec::MaxSigma ) {
+            smoothing.weights = gaussianWeights( sigma, std::ceil( 3 * sigma ) );
+        }
+        else {
+            qWarning() << "Invalid contour smoothing:" << typeName;
+        }
+    } else if ( typeName.startsWith( "Downsample " ) && typeName.endsWith( "x" ) ) {
+        int factor = typeName.mid( 11, typeName.size() - 12 ).toInt( & ok );
+        if ( ok && factor >= 1 ) {
+            smoothing.downsample = factor;
+        }
+        else {
+            qWarning() << "Invalid contour smoothing:" << typeName;
+        }
+    }
+    return smoothing;
+} // smoothingForType
+
 ContourConrec::Result
 ContourConrec::compute(NdArray::RawViewInterface * view, QString typeName)
+{
+    return _compute( view, typeName, Output::Polylines );
+}
+
+ContourConrec::Result
+ContourConrec::computeSegments(NdArray::RawViewInterface * view, QString typeName)
+{
+    return _compute( view, typeName, Output::Segments );
+}
+
+ContourConrec::Result
+ContourConrec::_compute(NdArray::RawViewInterface * view, QString typeName, Output output)
 {
     // if no input view was set, we are done
     if ( ! view || m_levels.size() == 0 ) {
@@ -388,36 +643,25 @@ ContourConrec::compute(NdArray::RawViewInterface * view, QString typeName)
     QString notify = "[contour] apply Conrec Algorithm with ";
 
     qDebug() << notify + typeName;
-    ContourConrec::ContourMode mode = ContourConrec::ContourMode::ORIGINAL;
-
-    if (typeName == "Gaussian blur 3x3"){
-        mode = ContourConrec::ContourMode::GAUSSIANBLUR_3;
-    } else if (typeName == "Box blur 3x3"){
-        mode = ContourConrec::ContourMode::BOXBLUR_3;
-    } else if (typeName == "Gaussian blur 5x5"){
-        mode = ContourConrec::ContourMode::GAUSSIANBLUR_5;
-    } else if (typeName == "Box blur 5x5"){
-        mode = ContourConrec::ContourMode::BOXBLUR_5;
-    }
+    Smoothing smoothing = smoothingForType( typeName );
 
-    result = conrecFaster( view, 0, m_nCols - 1, 0, m_nRows - 1,
-                xcoords, ycoords, m_levels.size(), sortedRawLevels,
-                mode );
-
-    if (typeName == "Line combiner") {
-
-        QRectF rect( 0, 0, m_nCols, m_nRows);
-
-        for( size_t i = 0 ; i < m_levels.size() ; ++ i ) {
-            Carta::Lib::Algorithms::LineCombiner lc( rect, m_nRows+1, m_nCols+1, 1e-9);
-            std::vector < QPolygonF > & v = result[i];
-            for( QPolygonF & poly : v) {
-                for( int i = 0 ; i < poly.size() - 1 ; ++ i ) {
-                    lc.add( poly[i], poly[i+1]);
-                }
-            }
-            result.push_back( lc.getPolygons());
-            qDebug() << "contour level=" << i << "compress" << v.size() << "-->" << result.back().size();
+    std::vector < VD > segments = conrecBanded( view, xcoords, ycoords, sortedRawLevels,
+                                                m_threadCount, smoothing );
+    result.resize( m_levels.size() );
+    for ( size_t i = 0 ; i < m_levels.size() ; ++i ) {
+        const VD & seg = segments[i];
+        if ( output == Output::Polylines ) {
+            // join the segments into polylines, which is what used to be the
+            // "Line combiner" mode, for all modes
+            result[i] = SegmentStitcher::stitch( seg );
+            continue;
+        }
+        result[i].reserve( seg.size() / 4 );
+        for ( size_t s = 0 ; s + 3 < seg.size() ; s += 4 ) {
+            QPolygonF poly;
+            poly.append( QPointF( seg[s], seg[s + 1] ) );
+            poly.append( QPointF( seg[s + 2], seg[s + 3] ) );
+            result[i].push_back( poly );
         }
     }
 
@@ -428,7 +672,7 @@ ContourConrec::compute(NdArray::RawViewInterface * view, QString typeName)
     }
 
     return unsortedResult;
-} // compute
+} // _compute
 }
 }
 }
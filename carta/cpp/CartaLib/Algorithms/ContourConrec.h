@@ -3,6 +3,12 @@
  *
  * see http://paulbourke.net/papers/conrec/
  *
+ * The image is read from the view a block of rows at a time. Each block is split
+ * into horizontal bands that are contoured by separate threads, and the segments
+ * of the bands are then joined in band order, so the result does not depend on the
+ * number of threads. Finally the segments that share end points are joined into
+ * polylines (see SegmentStitcher).
+ *
  **/
 
 #pragma once
@@ -23,15 +29,30 @@ class ContourConrec
 {
 public:
 
-    enum class ContourMode
+    /// smoothing applied to the data before it is contoured
+    struct Smoothing
     {
-        ORIGINAL,
-        GAUSSIANBLUR_3,
-        GAUSSIANBLUR_5,
-        BOXBLUR_3,
-        BOXBLUR_5
+        /// weights of the 1D kernel, applied along the rows and then along the
+        /// columns; the 2D kernel is the outer product of the weights with themselves
+        std::vector < double > weights = { 1.0 };
+
+        /// size of the blocks of pixels that are averaged together before contouring,
+        /// 1 for none; the weights are not used when downsampling
+        int downsample = 1;
     };
 
+    /// largest standard deviation, in pixels, of a "Gaussian blur sigma S" type
+    static constexpr double MaxSigma = 100;
+
+    /// \brief return the smoothing selected by a contour type name
+    ///
+    /// The names are "Gaussian blur NxN" and "Box blur NxN" for N = 3, 5, 7 and 9,
+    /// "Gaussian blur sigma S" for a Gaussian with a standard deviation of S pixels
+    /// (truncated at 3 S), and "Downsample Nx" to average blocks of N x N pixels.
+    /// Any other name means no smoothing.
+    static Smoothing
+    smoothingForType( const QString & typeName );
+
     /// the result of the algorithm is a list of contour sets for each requested
     /// level. Each contour set is in turn a list of poly-lines.
     typedef std::vector < std::vector < QPolygonF > > Result;
@@ -43,13 +64,32 @@ public:
     void
     setLevels( const std::vector < double > & levels );
 
-    /// compute and return the sorted vertices
+    /// set the number of threads to use, <= 0 means one per core (the default)
+    void
+    setThreadCount( int nThreads );
+
+    /// compute and return the polylines of each level
     Result
     compute( NdArray::RawViewInterface *, QString typeName );
 
+    /// compute and return the individual segments of each level, i.e. every
+    /// polyline has exactly two vertices
+    Result
+    computeSegments( NdArray::RawViewInterface *, QString typeName );
+
 private:
 
+    enum class Output
+    {
+        Polylines,
+        Segments
+    };
+
+    Result
+    _compute( NdArray::RawViewInterface * view, QString typeName, Output output );
+
     std::vector < double > m_levels;
+    int m_threadCount = 0;
 };
 
 }
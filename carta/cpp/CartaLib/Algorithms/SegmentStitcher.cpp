@@ -0,0 +1,131 @@
+/**
+ *
+ **/
+
+#include "SegmentStitcher.h"
+#include <cstdint>
+#include <cstring>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Algorithms
+{
+namespace
+{
+/// bits of a coordinate, with -0 and 0 made equal
+inline uint64_t
+coordBits( double val )
+{
+    if ( val == 0 ) {
+        val = 0;
+    }
+    uint64_t bits;
+    std::memcpy( & bits, & val, sizeof( bits ) );
+    return bits;
+}
+
+inline uint64_t
+pointHash( double x, double y )
+{
+    uint64_t h = coordBits( x ) * 0x9E3779B97F4A7C15ULL;
+    h ^= coordBits( y ) + 0x632BE59BD9B4E019ULL + ( h << 6 ) + ( h >> 2 );
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+}
+}
+
+std::vector < QPolygonF >
+SegmentStitcher::stitch( const std::vector < double > & segments )
+{
+    std::vector < QPolygonF > result;
+    const int64_t nSegments = segments.size() / 4;
+    if ( nSegments == 0 ) {
+        return result;
+    }
+
+    // end e is end e % 2 of segment e / 2, its coordinates are at segments[2 * e]
+    const int64_t nEnds = nSegments * 2;
+    auto x = [&segments] ( int64_t end ) {
+        return segments[2 * end];
+    };
+    auto y = [&segments] ( int64_t end ) {
+        return segments[2 * end + 1];
+    };
+
+    // open addressing table with the first end seen at every point; the other ends
+    // at the same point are chained from it
+    size_t capacity = 1;
+    while ( capacity < size_t( nEnds ) * 2 ) {
+        capacity <<= 1;
+    }
+    std::vector < int64_t > table( capacity, - 1 );
+    std::vector < int64_t > nextEnd( nEnds, - 1 );
+
+    // the end of another segment joined to each end
+    std::vector < int64_t > partner( nEnds, - 1 );
+
+    for ( int64_t e = 0 ; e < nEnds ; e++ ) {
+        const double ex = x( e );
+        const double ey = y( e );
+        size_t slot = pointHash( ex, ey ) & ( capacity - 1 );
+        while ( table[slot] >= 0 && ( x( table[slot] ) != ex || y( table[slot] ) != ey ) ) {
+            slot = ( slot + 1 ) & ( capacity - 1 );
+        }
+        const int64_t head = table[slot];
+        if ( head < 0 ) {
+            table[slot] = e;
+            continue;
+        }
+        // join with the first free end of another segment at this point
+        for ( int64_t other = head ; other >= 0 ; other = nextEnd[other] ) {
+            if ( partner[other] < 0 && other / 2 != e / 2 ) {
+                partner[other] = e;
+                partner[e] = other;
+                break;
+            }
+        }
+        nextEnd[e] = nextEnd[head];
+        nextEnd[head] = e;
+    }
+
+    std::vector < char > used( nSegments, 0 );
+    for ( int64_t s = 0 ; s < nSegments ; s++ ) {
+        if ( used[s] ) {
+            continue;
+        }
+
+        // walk backwards to the first segment of the polyline, or around the loop
+        int64_t start = 2 * s;
+        while ( partner[start] >= 0 ) {
+            const int64_t entry = partner[start];
+            if ( entry / 2 == s ) {
+                start = 2 * s;
+                break;
+            }
+            start = entry ^ 1;
+        }
+
+        // and forward to the last one
+        QPolygonF poly;
+        poly.append( QPointF( x( start ), y( start ) ) );
+        int64_t entry = start;
+        while ( true ) {
+            used[entry / 2] = 1;
+            const int64_t exit = entry ^ 1;
+            poly.append( QPointF( x( exit ), y( exit ) ) );
+            entry = partner[exit];
+            if ( entry < 0 || used[entry / 2] ) {
+                break;
+            }
+        }
+        result.push_back( poly );
+    }
+    return result;
+} // stitch
+}
+}
+}
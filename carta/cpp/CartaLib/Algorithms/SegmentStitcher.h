@@ -0,0 +1,40 @@
+/**
+ * Joins line segments that share end points into polylines.
+ *
+ * Conrec computes the crossing of a level with an edge of the grid (or with a
+ * diagonal of a cell) from the values at the two ends of that edge only, so the
+ * two segments meeting at that crossing have bitwise identical end points. This lets
+ * the segments be joined by hashing their end points exactly, in linear time, instead
+ * of searching for nearby points as LineCombiner does.
+ *
+ **/
+
+#pragma once
+
+#include <QPolygonF>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Algorithms
+{
+class SegmentStitcher
+{
+public:
+
+    /// \brief join line segments into polylines
+    /// \param segments the segments, stored as x1, y1, x2, y2 for each of them
+    /// \return the polylines, in the order of their first segment; closed polylines
+    /// end with their first point
+    ///
+    /// Every polyline is as long as possible: it ends only where a segment has no
+    /// other segment attached to it. Where more than two segments meet (which happens
+    /// only when the level is equal to the data), they are joined pairwise.
+    static std::vector < QPolygonF >
+    stitch( const std::vector < double > & segments );
+};
+}
+}
+}
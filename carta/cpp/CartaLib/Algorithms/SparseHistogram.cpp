@@ -0,0 +1,81 @@
+/**
+ *
+ **/
+
+#include "SparseHistogram.h"
+#include <algorithm>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Algorithms
+{
+std::pair < double, double >
+SparseHistogram::binRange( uint16_t bin )
+{
+    const int shift = 64 - Bits;
+    uint64_t first = uint64_t( bin ) << shift;
+    uint64_t last = first | ( ( uint64_t( 1 ) << shift ) - 1 );
+    return { keyValue( first ), keyValue( last ) };
+}
+
+uint64_t
+SparseHistogram::count( uint16_t bin ) const
+{
+    auto it = std::lower_bound( bins.begin(), bins.end(), bin );
+    return ( it != bins.end() && * it == bin ) ? counts[it - bins.begin()] : 0;
+}
+
+void
+SparseHistogram::merge( const SparseHistogram & other )
+{
+    // merge the two sorted lists of bins
+    std::vector < uint16_t > mergedBins;
+    std::vector < uint64_t > mergedCounts;
+    mergedBins.reserve( bins.size() + other.bins.size() );
+    mergedCounts.reserve( bins.size() + other.bins.size() );
+    size_t i = 0, j = 0;
+    while ( i < bins.size() || j < other.bins.size() ) {
+        if ( j == other.bins.size() || ( i < bins.size() && bins[i] < other.bins[j] ) ) {
+            mergedBins.push_back( bins[i] );
+            mergedCounts.push_back( counts[i] );
+            i++;
+        }
+        else if ( i == bins.size() || other.bins[j] < bins[i] ) {
+            mergedBins.push_back( other.bins[j] );
+            mergedCounts.push_back( other.counts[j] );
+            j++;
+        }
+        else {
+            mergedBins.push_back( bins[i] );
+            mergedCounts.push_back( counts[i] + other.counts[j] );
+            i++;
+            j++;
+        }
+    }
+    bins.swap( mergedBins );
+    counts.swap( mergedCounts );
+    total += other.total;
+} // merge
+
+SparseHistogramAccumulator::SparseHistogramAccumulator()
+    : m_counts( size_t( 1 ) << SparseHistogram::Bits, 0 )
+{ }
+
+SparseHistogram
+SparseHistogramAccumulator::result() const
+{
+    SparseHistogram histogram;
+    for ( size_t b = 0 ; b < m_counts.size() ; b++ ) {
+        if ( m_counts[b] > 0 ) {
+            histogram.bins.push_back( uint16_t( b ) );
+            histogram.counts.push_back( m_counts[b] );
+            histogram.total += m_counts[b];
+        }
+    }
+    return histogram;
+}
+}
+}
+}
@@ -0,0 +1,114 @@
+/**
+ * Histograms of doubles with bins that do not depend on the range of the data.
+ *
+ * Finite doubles are mapped to unsigned 64 bit keys that sort the same way as the
+ * values. The top Bits bits of the key pick the bin of a value, so every bin spans
+ * 1/16th of a power of two, and the histograms of different data, e.g. the frames
+ * of a cube, can be stored and merged. Only the non-empty bins are stored.
+ *
+ * The exact percentile algorithm refines the bins with further bits of the keys, and
+ * the frame statistics use the bins to bracket percentiles.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Algorithms
+{
+/// order preserving mapping of finite doubles to unsigned integers
+inline uint64_t
+valueKey( double val )
+{
+    if ( val == 0 ) {
+        // -0 and +0 are the same value
+        val = 0;
+    }
+    uint64_t bits;
+    std::memcpy( & bits, & val, sizeof( bits ) );
+    return ( bits >> 63 ) ? ~ bits : ( bits | ( uint64_t( 1 ) << 63 ) );
+}
+
+/// inverse of valueKey()
+inline double
+keyValue( uint64_t key )
+{
+    uint64_t bits = ( key >> 63 ) ? ( key & ~ ( uint64_t( 1 ) << 63 ) ) : ~ key;
+    double val;
+    std::memcpy( & val, & bits, sizeof( val ) );
+    return val;
+}
+
+/// \brief histogram of finite values, with only the non-empty bins stored
+class SparseHistogram
+{
+    CLASS_BOILERPLATE( SparseHistogram );
+
+public:
+
+    /// number of bits of the key of a value used to pick its bin
+    static constexpr int Bits = 16;
+
+    /// non-empty bins, in increasing order
+    std::vector < uint16_t > bins;
+
+    /// counts of the non-empty bins
+    std::vector < uint64_t > counts;
+
+    /// number of values in all the bins
+    uint64_t total = 0;
+
+    /// bin of a finite value
+    static uint16_t
+    bin( double value )
+    {
+        return uint16_t( valueKey( value ) >> ( 64 - Bits ) );
+    }
+
+    /// smallest and largest value that fall into the given bin
+    static std::pair < double, double >
+    binRange( uint16_t bin );
+
+    /// count of the given bin
+    uint64_t
+    count( uint16_t bin ) const;
+
+    /// add the counts of another histogram to this one
+    void
+    merge( const SparseHistogram & other );
+};
+
+/// \brief builds a sparse histogram one value at a time
+class SparseHistogramAccumulator
+{
+public:
+
+    SparseHistogramAccumulator();
+
+    /// add a finite value
+    void
+    add( double value )
+    {
+        m_counts[SparseHistogram::bin( value )]++;
+    }
+
+    /// the histogram of all values added so far
+    SparseHistogram
+    result() const;
+
+private:
+
+    /// counts of all bins
+    std::vector < uint64_t > m_counts;
+};
+}
+}
+}
@@ -41,13 +41,19 @@ SOURCES += \
     StatInfo.cpp \
     VectorGraphics/VGList.cpp \
     VectorGraphics/BetterQPainter.cpp \
+    Algorithms/ContourCache.cpp \
     Algorithms/ContourConrec.cpp \
     IWcsGridRenderService.cpp \
     ContourSet.cpp \
     Algorithms/LineCombiner.cpp \
+    Algorithms/SegmentStitcher.cpp \
+    Algorithms/SparseHistogram.cpp \
     IImageRenderService.cpp \
     IRemoteVGView.cpp \
+    QImageCompositor.cpp \
     IPCache.cpp \
+    MemoryPCache.cpp \
+    MemoryBudget.cpp \
     Hooks/GetPersistentCache.cpp \
     Hooks/GetProfileExtractor.cpp \
     Regions/IRegion.cpp \
@@ -58,6 +64,8 @@ SOURCES += \
     Regions/Ellipse.cpp \
     Regions/Point.cpp \
     Regions/Rectangle.cpp \
+    Regions/RegionMask.cpp \
+    Regions/RegionStatistics.cpp \
     IntensityUnitConverter.cpp \
     IntensityCacheHelper.cpp
 
@@ -101,16 +109,20 @@ HEADERS += \
     Hooks/GetWcsGridRenderer.h \
     Hooks/LoadPlugin.h \
     VectorGraphics/BetterQPainter.h \
+    Algorithms/ContourCache.h \
     Algorithms/ContourConrec.h \
     IWcsGridRenderService.h \
     IContourGeneratorService.h \
     ContourSet.h \
     Algorithms/LineCombiner.h \
+    Algorithms/SegmentStitcher.h \
+    Algorithms/SparseHistogram.h \
     Hooks/GetInitialFileList.h \
     Hooks/Initialize.h \
     IImageRenderService.h \
     Hooks/GetImageRenderService.h \
     IRemoteVGView.h \
+    QImageCompositor.h \
     Hooks/GetProfileExtractor.h \
     Regions/IRegion.h \
     InputEvents.h \
@@ -121,7 +133,11 @@ HEADERS += \
     Regions/Ellipse.h \
     Regions/Point.h \
     Regions/Rectangle.h \
+    Regions/RegionMask.h \
+    Regions/RegionStatistics.h \
     IPCache.h \
+    MemoryPCache.h \
+    MemoryBudget.h \
     IntensityUnitConverter.h \
     IPercentileCalculator.h \
     IntensityCacheHelper.h
@@ -100,9 +100,12 @@ public:
     virtual void
     setLevelsVector( const std::vector < std::vector < double > > & levelsVector ) = 0;
 
-    /// set the input on which to generate the contours
+    /// \brief set the input on which to generate the contours
+    /// \param rawView the data to contour
+    /// \param viewId id that is unique to the data of the view; contours computed
+    /// for a view with an id may be cached and reused, an empty id disables caching
     virtual void
-    setInput( NdArray::RawViewInterface::SharedPtr rawView ) = 0;
+    setInput( NdArray::RawViewInterface::SharedPtr rawView, const QString & viewId = QString() ) = 0;
 
     /// \brief start the job
     /// \param jobId what id to assign to job, if -1, it'll be auto-generated (0,1,2,...)
@@ -5,6 +5,9 @@
 /// plugins that only declare but don't define methods compile just fine... :(
 
 #include "IImage.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 namespace Carta {
 namespace Lib {
@@ -69,5 +72,43 @@ Image::MetaDataInterface::~MetaDataInterface()
 
 }
 
+void
+NdArray::RawViewInterface::forEachBufferedFallback(
+    int64_t buffSize,
+    std::function < void (const char *, int64_t) > func,
+    char * buff,
+    Traversal traversal )
+{
+    const int64_t pixelSize = Image::pixelType2size( pixelType() );
+    CARTA_ASSERT( pixelSize > 0 );
+    const int64_t capacity = std::max < int64_t > ( 1, buffSize / pixelSize );
+
+    // use our own storage if the caller did not supply any
+    std::vector < char > ownBuff;
+    if ( buff == nullptr ) {
+        ownBuff.resize( capacity * pixelSize );
+        buff = ownBuff.data();
+    }
+
+    int64_t count = 0;
+    char * dst = buff;
+    auto lambda = [&] ( const char * ptr ) {
+        std::memcpy( dst, ptr, pixelSize );
+        dst += pixelSize;
+        count++;
+        if ( count == capacity ) {
+            func( buff, count );
+            count = 0;
+            dst = buff;
+        }
+    };
+    forEach( lambda, traversal );
+
+    // report the partially filled buffer
+    if ( count > 0 ) {
+        func( buff, count );
+    }
+} // forEachBufferedFallback
+
 }
 }
@@ -26,10 +26,12 @@
 #include "IPlotLabelGenerator.h"
 #include "Regions/ICoordSystem.h"
 #include <QObject>
+#include <algorithm>
 #include <functional>
 #include <initializer_list>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace Carta
 {
@@ -167,6 +169,21 @@ public:
              std::function < void (const char *, int64_t count) > func,
              char * buff = nullptr,
              Traversal traversal = Traversal::Sequential ) = 0;
+
+protected:
+
+    /// \brief Generic implementation of the buffered forEach() on top of the per-element
+    /// forEach(). Views that cannot do anything smarter can forward to this, so that
+    /// consumers can use the buffered API on any view.
+    /// \param buffSize size of the buffer in bytes (rounded down to whole pixels, at least 1)
+    /// \param func function to call with every filled buffer
+    /// \param buff optional buffer of at least buffSize bytes, if null one will be allocated
+    /// \param traversal order of traversal, passed on to the per-element forEach()
+    void
+    forEachBufferedFallback( int64_t buffSize,
+                             std::function < void (const char *, int64_t count) > func,
+                             char * buff,
+                             Traversal traversal );
 };
 
 /// Utility class that wraps a raw view into a typed view.
@@ -223,6 +240,42 @@ public:
         m_rawView->forEach( wrapper, traversal );
     }
 
+    /// \brief block oriented equivalent of forEach
+    /// \details func is called with contiguous spans of converted values, in the order
+    /// of the traversal. The conversion is done a buffer at a time, and if the raw pixels
+    /// already have the requested type, the spans point straight into the raw view's
+    /// buffers.
+    /// \param func function to invoke on each span, with the values and their count
+    /// \param blockSize maximum number of values in a span
+    /// \param traversal order of traversal
+    void
+    forEachBlock(
+        std::function < void (const Type *, int64_t) > func,
+        int64_t blockSize = DefaultBlockSize,
+        RawViewInterface::Traversal traversal = RawViewInterface::Traversal::Sequential )
+    {
+        const Image::PixelType pixelType = m_rawView->pixelType();
+        const int64_t pixelSize = Image::pixelType2size( pixelType );
+        blockSize = std::max < int64_t > ( 1, blockSize );
+
+        if ( pixelType == Image::CType2PixelType < Type >::type ) {
+            auto wrapper = [& func] ( const char * data, int64_t count )->void
+            {
+                func( reinterpret_cast < const Type * > ( data ), count );
+            };
+            m_rawView->forEach( blockSize * pixelSize, wrapper, nullptr, traversal );
+            return;
+        }
+
+        std::vector < Type > converted( blockSize );
+        auto wrapper = [& func, & converted, pixelType] ( const char * data, int64_t count )->void
+        {
+            convertPixels < Type > ( pixelType, data, count, converted.data() );
+            func( converted.data(), count );
+        };
+        m_rawView->forEach( blockSize * pixelSize, wrapper, nullptr, traversal );
+    }
+
     ~TypedView()
     {
         if ( m_keepOwnership ) {
@@ -238,6 +291,9 @@ public:
         return m_rawView;
     }
 
+    /// default number of values passed to the forEachBlock() function at once
+    static constexpr int64_t DefaultBlockSize = 64 * 1024;
+
 protected:
 
     /// pointer to the raw view
@@ -479,6 +535,12 @@ test_apis()
                          }
                          );
 
+    // or a block at a time, which avoids the per pixel function calls
+    doubleReader.forEachBlock([& sum] ( const double * vals, int64_t n ) {
+                                  for ( int64_t i = 0 ; i < n ; i++ ) { sum += vals[i]; }
+                              }
+                              );
+
     // META DATA API tests:
     // ===========================
 
@@ -4,3 +4,24 @@
 
 #include "IPCache.h"
 
+namespace Carta
+{
+namespace Lib
+{
+void
+IPCache::readEntries( std::vector < Entry > & entries )
+{
+    for ( Entry & entry : entries ) {
+        entry.found = readEntry( entry.key, entry.val, entry.error );
+    }
+}
+
+void
+IPCache::setEntries( const std::vector < Entry > & entries )
+{
+    for ( const Entry & entry : entries ) {
+        setEntry( entry.key, entry.val, entry.error );
+    }
+}
+}
+}
@@ -7,6 +7,7 @@
 #include <QByteArray>
 #include <QString>
 #include <memory>
+#include <vector>
 
 namespace Carta
 {
@@ -47,6 +48,26 @@ public:
               const QByteArray & val,
               const QByteArray & error ) = 0;
 
+    /// an entry for the batched accessors
+    struct Entry {
+        QByteArray key;
+        QByteArray val;
+        QByteArray error;
+        /// set by readEntries() to indicate whether the entry exists
+        bool found = false;
+    };
+
+    /// read values of several entries at once
+    /// for every entry, val and error are filled in and found is set if the key exists
+    /// the default implementation calls readEntry() for each of them
+    virtual void
+    readEntries( std::vector < Entry > & entries );
+
+    /// set values of several entries at once
+    /// the default implementation calls setEntry() for each of them
+    virtual void
+    setEntries( const std::vector < Entry > & entries );
+
     /// Release the shared_ptr before the program quits.
     /// There may be a better way to prevent the segementation fault
     /// comes from the ~SqLitePCache when CARTA shuts down.
@@ -50,6 +50,11 @@ public:
     /** This may need to be rethought, but for now it's the simplest way to achieve this without having to calculate the minimum and maximum unnecessarily. */
     void setMinMax(std::vector<Scalar> minMaxIntensities);
     
+    /** Identifies the data which will be passed to percentile2pixels, so that algorithms can reuse per-frame summaries between calls.
+     The identifier must be unique for the image (and e.g. stokes plane); firstFrame is the index of the view's first frame in the image.
+     Algorithms which don't keep any state simply ignore this. */
+    void setDataId(const QString dataId, const int firstFrame=0);
+    
     /** This is a hook which allows tests to reconfigure algorithm parameters.
      It would really be better to do this at the plugin level. */
     virtual void reconfigure(const QJsonObject config);
@@ -66,6 +71,8 @@ public:
     const bool isApproximate=false;
     const bool needsMinMax=false;
     std::vector<Scalar> minMaxIntensities;
+    QString dataId;
+    int firstFrame=0;
 };
 
 template <typename Scalar>
@@ -77,6 +84,12 @@ void IPercentilesToPixels<Scalar>::setMinMax(std::vector<Scalar> minMaxIntensiti
     this->minMaxIntensities = minMaxIntensities;
 }
 
+template <typename Scalar>
+void IPercentilesToPixels<Scalar>::setDataId(const QString dataId, const int firstFrame) {
+    this->dataId = dataId;
+    this->firstFrame = firstFrame;
+}
+
 template <typename Scalar>
 std::map<double, Scalar> IPercentilesToPixels<Scalar>::percentile2pixels(
     Carta::Lib::NdArray::TypedView < Scalar > & view,
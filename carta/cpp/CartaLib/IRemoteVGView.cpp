@@ -13,6 +13,38 @@ namespace Carta
 {
 namespace Lib
 {
+void
+IQImageCombiner::combineAll( QImage & dst, const std::vector < std::pair < QImage, SharedPtr > > & layers )
+{
+    const bool composite = QImageCompositor::isSupportedDestination( dst );
+    std::vector < QImageCompositor::Layer > batch;
+    IQImageCombiner::SharedPtr defaultComb = nullptr;
+    for ( const auto & layer : layers ) {
+        IQImageCombiner::SharedPtr combiner = layer.second;
+        if ( ! combiner ) {
+            if ( ! defaultComb ) {
+                defaultComb = std::make_shared < DefaultCombiner > ();
+            }
+            combiner = defaultComb;
+        }
+        QImageCompositor::Layer clayer;
+        if ( composite && combiner-> compositorBlend( clayer.blend ) ) {
+            clayer.image = layer.first;
+            batch.push_back( clayer );
+            continue;
+        }
+        // the layers collected so far have to be rendered before this one
+        if ( ! batch.empty() ) {
+            QImageCompositor::composite( dst, batch );
+            batch.clear();
+        }
+        combiner-> combine( dst, layer.first );
+    }
+    if ( ! batch.empty() ) {
+        QImageCompositor::composite( dst, batch );
+    }
+} // combineAll
+
 //LayeredRemoteVGView::SharedPtr
 //LayeredRemoteVGView::create( IConnector * connector, QString viewName, QObject * parent )
 //{
@@ -136,13 +168,11 @@ LayeredRemoteVGView::p_timerCB()
     buff.fill( QColor( 0, 0, 0, 0 ) );
 
     // now go through the layers and paint them on top of the last result
+    std::vector < std::pair < QImage, IQImageCombiner::SharedPtr > > rasters;
     for ( auto & layer : m_rasterLayers ) {
-        IQImageCombiner::SharedPtr combiner = layer.combiner;
-        if ( ! combiner ) {
-            combiner = std::make_shared < DefaultCombiner > ();
-        }
-        combiner->combine( buff, layer.qimg );
+        rasters.push_back( std::make_pair( layer.qimg, layer.combiner ) );
     }
+    IQImageCombiner::combineAll( buff, rasters );
     m_vgView-> setRaster( buff );
 
     // concatenate all VG lists into one
@@ -358,10 +388,9 @@ LayeredViewArbitrary::p_timerCB()
     QImage buff( size, QImage::Format_ARGB32_Premultiplied );
     buff.fill( QColor( 0, 0, 0, 255 ) );
 
-    IQImageCombiner::SharedPtr defaultComb = std::make_shared < DefaultCombiner > ();
-
-    // render all the layers from bottom to top
-//    for ( auto & layerInfo : m_layers ) {
+    // render all the layers from bottom to top; consecutive raster layers are
+    // combined together, as far as their combiners allow it
+    std::vector < std::pair < QImage, IQImageCombiner::SharedPtr > > rasters;
     for ( size_t i = startLayer ; i < m_layers.size() ; ++i ) {
         LayerInfo & layerInfo = m_layers[i];
 
@@ -372,22 +401,21 @@ LayeredViewArbitrary::p_timerCB()
 
         // for raster layers we use the image combiner to draw them
         if ( layerInfo.type == LayerType::Raster ) {
-            if ( layerInfo.comb ) {
-                layerInfo.comb-> combine( buff, layerInfo.qimg );
-            }
-            else {
-                defaultComb-> combine( buff, layerInfo.qimg );
-            }
+            rasters.push_back( std::make_pair( layerInfo.qimg, layerInfo.comb ) );
         }
 
-        // for VG layers we VGListQPainterRenderer
-        else {
+        // for VG layers we VGListQPainterRenderer; empty ones draw nothing, so they
+        // must not split the raster layers around them into separate passes
+        else if ( ! layerInfo.vglist.entries().empty() ) {
+            IQImageCombiner::combineAll( buff, rasters );
+            rasters.clear();
             QPainter painter( & buff );
             Carta::Lib::VectorGraphics::VGListQPainterRenderer renderer;
             renderer.render( layerInfo.vglist, painter );
             painter.end();
         }
     }
+    IQImageCombiner::combineAll( buff, rasters );
 
     m_vgView-> setRaster( buff );
 
@@ -4,6 +4,7 @@
 #include "core/IView.h"
 #include "VectorGraphics/VGList.h"
 #include "InputEvents.h"
+#include "QImageCompositor.h"
 
 #include <QObject>
 #include <QString>
@@ -113,6 +114,26 @@ public:
     virtual bool
     isOpaque() { return false; }
 
+    /// describe what this combiner does as a QImageCompositor blend, so that it can be
+    /// composited in one pass together with other layers; return false if that is
+    /// not possible
+    virtual bool
+    compositorBlend( QImageCompositor::Blend & blend )
+    {
+        Q_UNUSED( blend );
+        return false;
+    }
+
+    /// \brief render all layers on top of dst, from the first to the last one
+    /// \param dst the destination image
+    /// \param layers the images with their combiners (nullptr for the default combiner)
+    ///
+    /// Consecutive layers whose combiners have a compositor blend are composited in one
+    /// pass (if dst is in a format supported by QImageCompositor), the others are
+    /// rendered with their combine().
+    static void
+    combineAll( QImage & dst, const std::vector < std::pair < QImage, SharedPtr > > & layers );
+
     virtual
     ~IQImageCombiner() { }
 };
@@ -265,6 +286,13 @@ public:
         if ( m_alpha == 0.0 || src1dst.size().isEmpty() || src2.size().isEmpty() ) {
             return;
         }
+        if ( QImageCompositor::isSupportedDestination( src1dst ) ) {
+            QImageCompositor::Layer layer;
+            layer.image = src2;
+            compositorBlend( layer.blend );
+            QImageCompositor::composite( src1dst, { layer } );
+            return;
+        }
         QPainter p( & src1dst );
         p.setOpacity( m_alpha );
         p.drawImage( 0, 0, src2 );
@@ -276,6 +304,15 @@ public:
         return m_alpha == 1.0;
     }
 
+    virtual bool
+    compositorBlend( QImageCompositor::Blend & blend ) override
+    {
+        blend.mode = QImageCompositor::Mode::SourceOver;
+        blend.mask = 0xffffffff;
+        blend.alpha = m_alpha;
+        return true;
+    }
+
 private:
 
     double m_alpha = 1.0;
@@ -324,6 +361,14 @@ public:
             return;
         }
 
+        // mask and blend the source pixels in place if possible
+        QImageCompositor::Layer layer;
+        if ( QImageCompositor::isSupportedDestination( src1dst ) && compositorBlend( layer.blend ) ) {
+            layer.image = src2;
+            QImageCompositor::composite( src1dst, { layer } );
+            return;
+        }
+
         // make a copy of the source image
         QImage src22 = src2;
 
@@ -349,6 +394,14 @@ public:
         p.drawImage( 0, 0, src22 );
     } // combine
 
+    virtual bool
+    compositorBlend( QImageCompositor::Blend & blend ) override
+    {
+        blend.mask = m_mask;
+        blend.alpha = m_alpha;
+        return QImageCompositor::modeFromComposition( m_compositionMode, blend.mode );
+    }
+
     static constexpr quint32 DefaultMask = 0xffffffff;
 
 private:
@@ -10,11 +10,13 @@ IntensityValue::IntensityValue(double value, double error) : value(value), error
 IntensityCacheHelper::IntensityCacheHelper(std::shared_ptr<Carta::Lib::IPCache> diskCache) : m_diskCache(diskCache) {
 }
 
+QByteArray IntensityCacheHelper::_key(QString fileName, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel) {
+    return QString("%1/%2/%3/%4/%5/%6/intensity").arg(fileName).arg(frameLow).arg(frameHigh).arg(stokeFrame).arg(percentile).arg(transformationLabel).toUtf8();
+}
+
 std::shared_ptr<IntensityValue> IntensityCacheHelper::get(QString fileName, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel) {
-    QString intensityKey = QString("%1/%2/%3/%4/%5/%6/intensity").arg(fileName).arg(frameLow).arg(frameHigh).arg(stokeFrame).arg(percentile).arg(transformationLabel);
-        
     QByteArray intensityVal, intensityError;
-    bool intensityInCache = m_diskCache->readEntry(intensityKey.toUtf8(), intensityVal, intensityError);
+    bool intensityInCache = m_diskCache->readEntry(_key(fileName, frameLow, frameHigh, percentile, stokeFrame, transformationLabel), intensityVal, intensityError);
     
     if (intensityInCache) {
         double value = qb2d(intensityVal);
@@ -25,10 +27,39 @@ std::shared_ptr<IntensityValue> IntensityCacheHelper::get(QString fileName, int
     return nullptr;
 }
 
+std::vector<std::shared_ptr<IntensityValue> > IntensityCacheHelper::get(QString fileName, int frameLow, int frameHigh, const std::vector<double>& percentiles, int stokeFrame, QString transformationLabel) {
+    std::vector<IPCache::Entry> entries(percentiles.size());
+    for (size_t i = 0; i < percentiles.size(); i++) {
+        entries[i].key = _key(fileName, frameLow, frameHigh, percentiles[i], stokeFrame, transformationLabel);
+    }
+    
+    m_diskCache->readEntries(entries);
+    
+    std::vector<std::shared_ptr<IntensityValue> > values(percentiles.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].found) {
+            values[i] = std::make_shared<IntensityValue>(qb2d(entries[i].val), qb2d(entries[i].error));
+        }
+    }
+    return values;
+}
+
 void IntensityCacheHelper::set(QString fileName, double intensity, double error, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel) {
-    QString intensityKey = QString("%1/%2/%3/%4/%5/%6/intensity").arg(fileName).arg(frameLow).arg(frameHigh).arg(stokeFrame).arg(percentile).arg(transformationLabel);
+    m_diskCache->setEntry(_key(fileName, frameLow, frameHigh, percentile, stokeFrame, transformationLabel), d2qb(intensity), d2qb(error));
+}
+
+void IntensityCacheHelper::set(QString fileName, const std::map<double, double>& intensities, double error, int frameLow, int frameHigh, int stokeFrame, QString transformationLabel) {
+    std::vector<IPCache::Entry> entries;
+    entries.reserve(intensities.size());
+    for (auto& intensity : intensities) {
+        IPCache::Entry entry;
+        entry.key = _key(fileName, frameLow, frameHigh, intensity.first, stokeFrame, transformationLabel);
+        entry.val = d2qb(intensity.second);
+        entry.error = d2qb(error);
+        entries.push_back(entry);
+    }
     
-    m_diskCache->setEntry(intensityKey.toUtf8(), d2qb(intensity), d2qb(error));
+    m_diskCache->setEntries(entries);
 }
 
 }
@@ -5,6 +5,8 @@
 #include "CartaLib/IPCache.h"
 
 #include <QString>
+#include <map>
+#include <vector>
 
 namespace Carta {
 namespace Lib {
@@ -23,9 +25,17 @@ public:
     /** Returns a pointer to a (value, error) pair if the value exists in the cache, or a null pointer */
     std::shared_ptr<IntensityValue> get(QString fileName, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel);
     
+    /** Returns a (value, error) pair for each percentile, or a null pointer for percentiles that are not in the cache; all are read at once */
+    std::vector<std::shared_ptr<IntensityValue> > get(QString fileName, int frameLow, int frameHigh, const std::vector<double>& percentiles, int stokeFrame, QString transformationLabel);
+    
     /** Sets the provided value and error for this intensity */
     void set(QString fileName, double intensity, double error, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel);
+    
+    /** Sets the provided intensities (percentile -> intensity), which all have the same error, at once */
+    void set(QString fileName, const std::map<double, double>& intensities, double error, int frameLow, int frameHigh, int stokeFrame, QString transformationLabel);
 private:
+    static QByteArray _key(QString fileName, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel);
+
     std::shared_ptr<Carta::Lib::IPCache> m_diskCache;
 };
 
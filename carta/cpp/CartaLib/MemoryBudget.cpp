@@ -0,0 +1,146 @@
+/**
+ *
+ **/
+
+#include "MemoryBudget.h"
+#include <QDebug>
+
+namespace Carta
+{
+namespace Lib
+{
+MemoryBudget::MemoryBudget( uint64_t maxBytes )
+    : m_maxBytes( maxBytes )
+{ }
+
+MemoryBudget::Handle
+MemoryBudget::add( const QString & name, Priority priority, UsageFunc usage, ShrinkFunc shrink )
+{
+    CARTA_ASSERT( usage );
+    Client client;
+    client.info.name = name;
+    client.info.priority = priority;
+    client.info.evictable = bool (shrink);
+    client.info.lastUsed = ++m_clock;
+    client.usage = usage;
+    client.shrink = shrink;
+    const Handle handle = m_nextHandle++;
+    m_clients[handle] = client;
+    return handle;
+}
+
+void
+MemoryBudget::remove( Handle handle )
+{
+    m_clients.erase( handle );
+}
+
+void
+MemoryBudget::touch( Handle handle )
+{
+    auto it = m_clients.find( handle );
+    if ( it != m_clients.end() ) {
+        it-> second.info.lastUsed = ++m_clock;
+    }
+}
+
+uint64_t
+MemoryBudget::enforce( uint64_t extraBytes )
+{
+    uint64_t total = 0;
+    std::vector < Client * > victims;
+    for ( auto & entry : m_clients ) {
+        Client & client = entry.second;
+        client.info.bytes = client.usage();
+        total += client.info.bytes;
+        if ( client.shrink ) {
+            victims.push_back( & client );
+        }
+    }
+    const uint64_t limit = extraBytes < m_maxBytes ? m_maxBytes - extraBytes : 0;
+    if ( total <= limit ) {
+        return total;
+    }
+
+    // lowest priority first, least recently used first within the same priority
+    std::sort( victims.begin(), victims.end(), [] ( const Client * a, const Client * b ) {
+        if ( a-> info.priority != b-> info.priority ) {
+            return a-> info.priority < b-> info.priority;
+        }
+        return a-> info.lastUsed < b-> info.lastUsed;
+    } );
+    for ( Client * client : victims ) {
+        if ( total <= limit ) {
+            break;
+        }
+        const uint64_t before = client-> info.bytes;
+        if ( before == 0 ) {
+            continue;
+        }
+        const uint64_t excess = total - limit;
+        client-> shrink( before > excess ? before - excess : 0 );
+        client-> info.bytes = client-> usage();
+        client-> info.evictions++;
+        if ( client-> info.bytes < before ) {
+            total -= before - client-> info.bytes;
+        }
+    }
+    if ( total > limit ) {
+        qDebug() << "Caches use" << total / ( 1024 * 1024 ) << "MB, more than the budget of"
+                 << limit / ( 1024 * 1024 ) << "MB, after shrinking all of them";
+    }
+    return total;
+} // enforce
+
+uint64_t
+MemoryBudget::maxBytes() const
+{
+    return m_maxBytes;
+}
+
+void
+MemoryBudget::setMaxBytes( uint64_t maxBytes )
+{
+    m_maxBytes = maxBytes;
+    enforce();
+}
+
+uint64_t
+MemoryBudget::usedBytes() const
+{
+    uint64_t total = 0;
+    for ( const auto & entry : m_clients ) {
+        total += entry.second.usage();
+    }
+    return total;
+}
+
+std::vector < MemoryBudget::Usage >
+MemoryBudget::usage() const
+{
+    std::vector < Usage > result;
+    result.reserve( m_clients.size() );
+    for ( const auto & entry : m_clients ) {
+        Usage info = entry.second.info;
+        info.bytes = entry.second.usage();
+        result.push_back( info );
+    }
+    return result;
+}
+
+QString
+MemoryBudget::priorityName( Priority priority )
+{
+    switch ( priority )
+    {
+    case Priority::Low :
+        return "low";
+    case Priority::Normal :
+        return "normal";
+    case Priority::High :
+        return "high";
+    }
+    return "";
+}
+}
+}
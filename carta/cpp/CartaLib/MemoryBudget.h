@@ -0,0 +1,176 @@
+/**
+ * Process-wide accounting of the memory used by the in-memory caches.
+ *
+ * Every cache registers with the budget, telling it how to measure the memory the
+ * cache uses and how to make the cache smaller. Caches call touch() whenever they are
+ * used and enforce() after they grew. If all the caches together use more than the
+ * budget, enforce() shrinks them until they fit: the ones with the lowest priority
+ * first, and among caches of the same priority the ones that were used least recently
+ * first. The caches themselves drop their least recently used entries when asked to
+ * shrink, so what survives is what is most likely to be needed again.
+ *
+ * Memory that is only needed for a while, e.g. all the values of a cube while its
+ * exact percentiles are computed, is made room for with enforce( extraBytes ).
+ *
+ * The budget is not thread safe. Like the caches it manages, it is meant to be used
+ * from the main thread; caches that are also used from other threads have to lock
+ * in their callbacks.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include <QCache>
+#include <QString>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+class MemoryBudget
+{
+    CLASS_BOILERPLATE( MemoryBudget );
+
+public:
+
+    /// caches with a lower priority are shrunk first
+    enum class Priority {
+        /// cheap to recompute, e.g. colormapped images
+        Low,
+        /// expensive to recompute, e.g. contours or mipmaps
+        Normal,
+        /// expensive to recompute and small, e.g. the front of the disk cache
+        High
+    };
+
+    /// returns the number of bytes a cache uses
+    typedef std::function < uint64_t () > UsageFunc;
+
+    /// drops entries of a cache until it uses at most the given number of bytes
+    typedef std::function < void ( uint64_t ) > ShrinkFunc;
+
+    /// identifies a registered cache
+    typedef int Handle;
+
+    /// what the budget knows about one registered cache
+    struct Usage {
+        QString name;
+        Priority priority = Priority::Normal;
+        /// bytes used by the cache
+        uint64_t bytes = 0;
+        /// whether the cache can be shrunk, memory of other caches is only accounted for
+        bool evictable = true;
+        /// number of times the cache was shrunk to stay within the budget
+        uint64_t evictions = 0;
+        /// when the cache was last used; higher values are more recent
+        uint64_t lastUsed = 0;
+    };
+
+    /// \param maxBytes the memory all the caches together may use
+    explicit
+    MemoryBudget( uint64_t maxBytes );
+
+    /// \brief register a cache
+    /// \param name name of the cache, shown by usage()
+    /// \param priority caches with a lower priority are shrunk first
+    /// \param usage returns the number of bytes the cache uses
+    /// \param shrink drops entries of the cache; nullptr if the memory cannot be freed
+    /// \return the handle to pass to touch() and remove()
+    Handle
+    add( const QString & name, Priority priority, UsageFunc usage, ShrinkFunc shrink = nullptr );
+
+    /// forget a cache, has to be called before the cache is destroyed
+    void
+    remove( Handle handle );
+
+    /// mark a cache as just used
+    void
+    touch( Handle handle );
+
+    /// \brief shrink caches until they all fit into the budget
+    /// \param extraBytes memory that has to remain available besides the caches
+    /// \return the number of bytes used by the caches afterwards
+    uint64_t
+    enforce( uint64_t extraBytes = 0 );
+
+    /// the memory all the caches together may use
+    uint64_t
+    maxBytes() const;
+
+    /// change the memory all the caches together may use, and enforce it
+    void
+    setMaxBytes( uint64_t maxBytes );
+
+    /// the number of bytes used by all the caches together
+    uint64_t
+    usedBytes() const;
+
+    /// what the budget knows about every registered cache, in registration order
+    std::vector < Usage >
+    usage() const;
+
+    /// name of a priority, e.g. for reports
+    static QString
+    priorityName( Priority priority );
+
+    /// \brief helpers to register a QCache
+    /// \param cache the cache
+    /// \param costUnit the number of bytes one unit of cost stands for
+    template < class Key, class T >
+    static UsageFunc
+    qCacheUsage( const QCache < Key, T > & cache, uint64_t costUnit = 1 )
+    {
+        const QCache < Key, T > * ptr = & cache;
+        return [ptr, costUnit] () {
+            return static_cast < uint64_t > ( ptr-> totalCost() ) * costUnit;
+        };
+    }
+
+    template < class Key, class T >
+    static ShrinkFunc
+    qCacheShrink( QCache < Key, T > & cache, uint64_t costUnit = 1 )
+    {
+        QCache < Key, T > * ptr = & cache;
+        return [ptr, costUnit] ( uint64_t maxBytes ) {
+            qCacheShrink( * ptr, maxBytes, costUnit );
+        };
+    }
+
+    /// \brief drop the least recently used entries of a QCache, keeping its limit
+    /// \param cache the cache
+    /// \param maxBytes the memory the cache may use afterwards
+    /// \param costUnit the number of bytes one unit of cost stands for
+    template < class Key, class T >
+    static void
+    qCacheShrink( QCache < Key, T > & cache, uint64_t maxBytes, uint64_t costUnit )
+    {
+        // QCache drops its least recently used entries when the limit is lowered
+        const int maxCost = cache.maxCost();
+        cache.setMaxCost( static_cast < int > (
+                              std::min < uint64_t > ( maxBytes / costUnit, maxCost ) ) );
+        cache.setMaxCost( maxCost );
+    }
+
+private:
+
+    struct Client {
+        Usage info;
+        UsageFunc usage;
+        ShrinkFunc shrink;
+    };
+
+    uint64_t m_maxBytes;
+
+    /// incremented by every touch()
+    uint64_t m_clock = 0;
+
+    Handle m_nextHandle = 0;
+    std::map < Handle, Client > m_clients;
+};
+}
+}
@@ -0,0 +1,341 @@
+/**
+ *
+ **/
+
+#include "MemoryPCache.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace
+{
+/// approximate memory used by a node besides its data
+const uint64_t NODE_OVERHEAD = 96;
+}
+
+MemoryPCache::MemoryPCache( IPCache::SharedPtr backend, uint64_t maxBytes, int nShards, int writeBatch,
+                            int negativeTtlMs )
+    : m_backend( backend ),
+    m_shards( std::max( nShards, 1 ) ),
+    m_negativeTtlMs( negativeTtlMs ),
+    m_writeBatch( std::max( writeBatch, 1 ) ),
+    m_hits( 0 ),
+    m_misses( 0 ),
+    m_backendReadMicros( 0 ),
+    m_backendWrites( 0 ),
+    m_evictions( 0 )
+{
+    m_shardBytes = maxBytes / m_shards.size();
+    m_clock.start();
+}
+
+uint64_t
+MemoryPCache::maxStorage()
+{
+    QMutexLocker locker( & m_backendMutex );
+    return m_backend ? m_backend-> maxStorage() : 0;
+}
+
+uint64_t
+MemoryPCache::usedStorage()
+{
+    flush();
+    QMutexLocker locker( & m_backendMutex );
+    return m_backend ? m_backend-> usedStorage() : 0;
+}
+
+uint64_t
+MemoryPCache::nEntries()
+{
+    flush();
+    QMutexLocker locker( & m_backendMutex );
+    return m_backend ? m_backend-> nEntries() : 0;
+}
+
+void
+MemoryPCache::deleteAll()
+{
+    {
+        QMutexLocker locker( & m_pendingMutex );
+        m_pending.clear();
+    }
+    for ( Shard & shard : m_shards ) {
+        QMutexLocker locker( & shard.mutex );
+        shard.lru.clear();
+        shard.index.clear();
+        shard.bytes = 0;
+    }
+    QMutexLocker locker( & m_backendMutex );
+    if ( m_backend ) {
+        m_backend-> deleteAll();
+    }
+}
+
+bool
+MemoryPCache::readEntry( const QByteArray & key, QByteArray & val, QByteArray & error )
+{
+    std::vector < Entry > entries( 1 );
+    entries[0].key = key;
+    readEntries( entries );
+    val = entries[0].val;
+    error = entries[0].error;
+    return entries[0].found;
+}
+
+void
+MemoryPCache::setEntry( const QByteArray & key, const QByteArray & val, const QByteArray & error )
+{
+    Entry entry;
+    entry.key = key;
+    entry.val = val;
+    entry.error = error;
+    entry.found = true;
+    setEntries( std::vector < Entry > ( 1, entry ) );
+}
+
+void
+MemoryPCache::readEntries( std::vector < Entry > & entries )
+{
+    std::vector < size_t > missed;
+    for ( size_t i = 0 ; i < entries.size() ; i++ ) {
+        if ( ! _lookup( entries[i] ) ) {
+            missed.push_back( i );
+        }
+    }
+    m_hits += entries.size() - missed.size();
+    if ( missed.empty() ) {
+        return;
+    }
+    m_misses += missed.size();
+
+    std::vector < Entry > backendEntries( missed.size() );
+    for ( size_t i = 0 ; i < missed.size() ; i++ ) {
+        backendEntries[i].key = entries[missed[i]].key;
+    }
+    {
+        QMutexLocker locker( & m_backendMutex );
+        if ( m_backend ) {
+            QElapsedTimer timer;
+            timer.start();
+            m_backend-> readEntries( backendEntries );
+            m_backendReadMicros += timer.nsecsElapsed() / 1000;
+        }
+    }
+
+    // remember the answer, including the absence of an entry for a while, unless
+    // the key was set in the meantime
+    for ( size_t i = 0 ; i < missed.size() ; i++ ) {
+        const Entry & backendEntry = backendEntries[i];
+        _store( backendEntry.key, backendEntry.val, backendEntry.error, backendEntry.found, false );
+        Entry & entry = entries[missed[i]];
+        entry.val = backendEntry.val;
+        entry.error = backendEntry.error;
+        entry.found = backendEntry.found;
+    }
+}
+
+void
+MemoryPCache::setEntries( const std::vector < Entry > & entries )
+{
+    for ( const Entry & entry : entries ) {
+        _store( entry.key, entry.val, entry.error, true, true );
+    }
+    {
+        QMutexLocker locker( & m_pendingMutex );
+        for ( const Entry & entry : entries ) {
+            Entry & pending = m_pending[entry.key];
+            pending.key = entry.key;
+            pending.val = entry.val;
+            pending.error = entry.error;
+            pending.found = true;
+        }
+    }
+    _writeBackend( _takePending( m_writeBatch ) );
+}
+
+void
+MemoryPCache::Release()
+{
+    flush();
+    for ( Shard & shard : m_shards ) {
+        QMutexLocker locker( & shard.mutex );
+        shard.lru.clear();
+        shard.index.clear();
+        shard.bytes = 0;
+    }
+    QMutexLocker locker( & m_backendMutex );
+    if ( m_backend ) {
+        m_backend-> Release();
+        m_backend = nullptr;
+    }
+}
+
+void
+MemoryPCache::flush()
+{
+    _writeBackend( _takePending( 1 ) );
+}
+
+MemoryPCache::Stats
+MemoryPCache::stats() const
+{
+    Stats result;
+    result.hits = m_hits;
+    result.misses = m_misses;
+    result.backendReadMicros = m_backendReadMicros;
+    result.backendWrites = m_backendWrites;
+    result.evictions = m_evictions;
+    return result;
+}
+
+uint64_t
+MemoryPCache::memoryUsed() const
+{
+    uint64_t total = 0;
+    for ( const Shard & shard : m_shards ) {
+        QMutexLocker locker( & shard.mutex );
+        total += shard.bytes;
+    }
+    return total;
+}
+
+void
+MemoryPCache::shrink( uint64_t maxBytes )
+{
+    const uint64_t shardBytes = maxBytes / m_shards.size();
+    for ( Shard & shard : m_shards ) {
+        QMutexLocker locker( & shard.mutex );
+        _evict( shard, shardBytes );
+    }
+}
+
+MemoryPCache::~MemoryPCache()
+{
+    flush();
+}
+
+MemoryPCache::Shard &
+MemoryPCache::_shard( const QByteArray & key )
+{
+    return m_shards[qHash( key ) % m_shards.size()];
+}
+
+bool
+MemoryPCache::_lookup( Entry & entry )
+{
+    {
+        Shard & shard = _shard( entry.key );
+        QMutexLocker locker( & shard.mutex );
+        auto it = shard.index.find( entry.key );
+        if ( it != shard.index.end() && ! it.value()-> found &&
+             m_clock.elapsed() >= it.value()-> expiresMs ) {
+            // the backend may have the entry by now
+            shard.bytes -= it.value()-> size;
+            shard.lru.erase( it.value() );
+            shard.index.erase( it );
+            it = shard.index.end();
+        }
+        if ( it != shard.index.end() ) {
+            auto node = it.value();
+            shard.lru.splice( shard.lru.begin(), shard.lru, node );
+            entry.val = node-> val;
+            entry.error = node-> error;
+            entry.found = node-> found;
+            return true;
+        }
+    }
+
+    // an entry that was evicted before it was written is still pending
+    QMutexLocker locker( & m_pendingMutex );
+    auto it = m_pending.find( entry.key );
+    if ( it == m_pending.end() ) {
+        return false;
+    }
+    entry.val = it.value().val;
+    entry.error = it.value().error;
+    entry.found = true;
+    return true;
+}
+
+void
+MemoryPCache::_store( const QByteArray & key, const QByteArray & val, const QByteArray & error,
+                      bool found, bool replace )
+{
+    Shard & shard = _shard( key );
+    QMutexLocker locker( & shard.mutex );
+    auto it = shard.index.find( key );
+    if ( it != shard.index.end() ) {
+        if ( ! replace ) {
+            return;
+        }
+        shard.bytes -= it.value()-> size;
+        shard.lru.erase( it.value() );
+        shard.index.erase( it );
+    }
+    if ( ! found && m_negativeTtlMs <= 0 ) {
+        return;
+    }
+
+    Node node;
+    node.key = key;
+    node.val = val;
+    node.error = error;
+    node.found = found;
+    node.size = key.size() + val.size() + error.size() + NODE_OVERHEAD;
+    node.expiresMs = found ? 0 : m_clock.elapsed() + m_negativeTtlMs;
+    if ( node.size > m_shardBytes ) {
+        return;
+    }
+    shard.lru.push_front( node );
+    shard.index.insert( key, shard.lru.begin() );
+    shard.bytes += node.size;
+
+    _evict( shard, m_shardBytes );
+}
+
+void
+MemoryPCache::_evict( Shard & shard, uint64_t maxBytes )
+{
+    while ( shard.bytes > maxBytes ) {
+        const Node & last = shard.lru.back();
+        shard.bytes -= last.size;
+        shard.index.remove( last.key );
+        shard.lru.pop_back();
+        m_evictions++;
+    }
+}
+
+std::vector < MemoryPCache::Entry >
+MemoryPCache::_takePending( int minCount )
+{
+    std::vector < Entry > entries;
+    QMutexLocker locker( & m_pendingMutex );
+    if ( m_pending.size() < minCount ) {
+        return entries;
+    }
+    entries.reserve( m_pending.size() );
+    for ( auto it = m_pending.begin() ; it != m_pending.end() ; ++it ) {
+        entries.push_back( it.value() );
+    }
+    m_pending.clear();
+    return entries;
+}
+
+void
+MemoryPCache::_writeBackend( const std::vector < Entry > & entries )
+{
+    if ( entries.empty() ) {
+        return;
+    }
+    QMutexLocker locker( & m_backendMutex );
+    if ( m_backend ) {
+        m_backend-> setEntries( entries );
+        m_backendWrites += entries.size();
+    }
+}
+}
+}
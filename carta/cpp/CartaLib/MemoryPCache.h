@@ -0,0 +1,180 @@
+/// MemoryPCache is an in-memory front for another persistent cache.
+///
+/// Entries that were recently read or written are kept in memory, so repeated
+/// lookups of the same keys (e.g. the clip values of every frame during animation)
+/// do not touch the disk. Reads that miss are passed on to the backend and their
+/// result is remembered. The absence of an entry is only remembered for a while, so
+/// entries the backend gets from elsewhere are seen eventually. Writes are kept in
+/// memory and handed to the backend in batches.
+///
+/// The entries are spread over several shards, each with its own lock and its own
+/// least recently used list, so that threads reading different keys rarely wait for
+/// each other. The backend itself is only ever called by one thread at a time, and
+/// only from the threads that call this cache; in particular, pending writes are never
+/// flushed from a background thread, as some backends (sqlite) may only be used from
+/// the thread that opened them.
+
+#pragma once
+
+#include "CartaLib/IPCache.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <atomic>
+#include <list>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+class MemoryPCache : public IPCache
+{
+    CLASS_BOILERPLATE( MemoryPCache );
+
+public:
+
+    /// counters describing how well the cache works
+    struct Stats {
+        /// number of lookups answered from memory
+        uint64_t hits = 0;
+        /// number of lookups passed on to the backend
+        uint64_t misses = 0;
+        /// total time spent waiting for backend reads, in microseconds
+        uint64_t backendReadMicros = 0;
+        /// number of entries written to the backend
+        uint64_t backendWrites = 0;
+        /// number of entries dropped from memory to stay within the budget
+        uint64_t evictions = 0;
+    };
+
+    /// \brief wraps a backend cache
+    /// \param backend the cache that is read and written through
+    /// \param maxBytes the maximum size of the entries kept in memory
+    /// \param nShards the number of independently locked shards
+    /// \param writeBatch the number of pending writes that triggers a flush to the backend
+    /// \param negativeTtlMs how long the absence of an entry in the backend is remembered,
+    /// in milliseconds; <= 0 means it is not remembered at all
+    MemoryPCache( IPCache::SharedPtr backend, uint64_t maxBytes, int nShards = 16, int writeBatch = 64,
+                  int negativeTtlMs = 10000 );
+
+    virtual uint64_t
+    maxStorage() override;
+
+    virtual uint64_t
+    usedStorage() override;
+
+    virtual uint64_t
+    nEntries() override;
+
+    virtual void
+    deleteAll() override;
+
+    virtual bool
+    readEntry( const QByteArray & key, QByteArray & val, QByteArray & error ) override;
+
+    virtual void
+    setEntry( const QByteArray & key, const QByteArray & val, const QByteArray & error ) override;
+
+    virtual void
+    readEntries( std::vector < Entry > & entries ) override;
+
+    virtual void
+    setEntries( const std::vector < Entry > & entries ) override;
+
+    /// flushes the pending writes and releases the backend
+    virtual void
+    Release() override;
+
+    /// write all pending entries to the backend
+    void
+    flush();
+
+    /// return the current values of the counters
+    Stats
+    stats() const;
+
+    /// return the size of the entries kept in memory, in bytes
+    uint64_t
+    memoryUsed() const;
+
+    /// \brief drop the least recently used entries kept in memory
+    /// \param maxBytes the size the entries kept in memory are reduced to, at most
+    ///
+    /// Pending writes are not dropped, and later entries may use the full size given
+    /// to the constructor again.
+    void
+    shrink( uint64_t maxBytes );
+
+    virtual
+    ~MemoryPCache();
+
+private:
+
+    struct Node {
+        QByteArray key;
+        QByteArray val;
+        QByteArray error;
+        bool found;
+        uint64_t size;
+        /// for entries that were not found, when they expire (see m_clock)
+        qint64 expiresMs;
+    };
+
+    struct Shard {
+        mutable QMutex mutex;
+        /// most recently used entries first
+        std::list < Node > lru;
+        QHash < QByteArray, std::list < Node >::iterator > index;
+        uint64_t bytes = 0;
+    };
+
+    Shard &
+    _shard( const QByteArray & key );
+
+    /// looks the key up in memory, the pending writes included; absent entries that
+    /// expired are dropped
+    bool
+    _lookup( Entry & entry );
+
+    /// remembers an entry, evicting the least recently used ones if needed
+    /// an entry that is already in memory is only replaced if replace is set
+    void
+    _store( const QByteArray & key, const QByteArray & val, const QByteArray & error,
+            bool found, bool replace );
+
+    /// drops the least recently used entries of a locked shard until it uses at most maxBytes
+    void
+    _evict( Shard & shard, uint64_t maxBytes );
+
+    /// takes the pending writes if there are at least minCount of them
+    std::vector < Entry >
+    _takePending( int minCount );
+
+    void
+    _writeBackend( const std::vector < Entry > & entries );
+
+    IPCache::SharedPtr m_backend;
+    QMutex m_backendMutex;
+
+    std::vector < Shard > m_shards;
+    uint64_t m_shardBytes;
+
+    /// how long absent entries are remembered, and the clock they expire by
+    int m_negativeTtlMs;
+    QElapsedTimer m_clock;
+
+    /// writes that have not been passed to the backend yet
+    QHash < QByteArray, Entry > m_pending;
+    QMutex m_pendingMutex;
+    int m_writeBatch;
+
+    std::atomic < uint64_t > m_hits;
+    std::atomic < uint64_t > m_misses;
+    std::atomic < uint64_t > m_backendReadMicros;
+    std::atomic < uint64_t > m_backendWrites;
+    std::atomic < uint64_t > m_evictions;
+};
+}
+}
@@ -347,6 +347,12 @@ public:
         m_n1 = m_cache.size() - 1;
         m_d = ( m_max - m_min ) / m_n1;
         m_dInvN1 = 1 / m_d;
+
+        // 8 bit version of the cache, for convertqBlock()
+        m_qcache.resize( nSegments );
+        for ( int64_t i = 0 ; i < nSegments ; i++ ) {
+            normRgb2QRgb( m_cache[i], m_qcache[i] );
+        }
     }
 
     void
@@ -360,9 +366,100 @@ public:
         normRgb2QRgb( drgb, result );
     }
 
+    /// \brief convert a block of values to 8 bit RGB
+    /// \param src values to convert
+    /// \param count number of values in src
+    /// \param dst where to store the results (count entries)
+    /// \param nanColor color to use for NaNs
+    ///
+    /// The results are identical to calling convertq() on every non-NaN value. The loop
+    /// only reads the cache, so it is safe to call concurrently from multiple threads.
+    /// Scalar is double or float; float values are widened one at a time, so a float
+    /// source does not need a converted double copy.
+    template < typename Scalar >
+    void
+    convertqBlock( const Scalar * src, int64_t count, QRgb * dst, QRgb nanColor ) const;
+
+    /// index reported by convertIndexBlock() for NaNs
+    static constexpr uint16_t NanIndex = 0xFFFF;
+
+    /// number of cache entries
+    int64_t
+    size() const
+    {
+        return m_cache.size();
+    }
+
+    /// smallest cached value
+    double
+    min() const
+    {
+        return m_min;
+    }
+
+    /// largest cached value
+    double
+    max() const
+    {
+        return m_max;
+    }
+
+    /// \brief find the cache entries a block of values maps to
+    /// \param src values to convert
+    /// \param count number of values in src
+    /// \param dst where to store the indices (count entries), NaNs become NanIndex
+    ///
+    /// The indices only depend on min(), max() and size(), not on the cached function,
+    /// so they can be colormapped with convertIndexqBlock() of any cache with the same
+    /// geometry. Only available without interpolation, and the cache must have fewer
+    /// than NanIndex entries.
+    template < typename Scalar >
+    void
+    convertIndexBlock( const Scalar * src, int64_t count, uint16_t * dst ) const
+    {
+        static_assert( ! interpolated, "indices are only available without interpolation" );
+        CARTA_ASSERT( size() < NanIndex );
+        const double min = m_min;
+        const double dInvN1 = m_dInvN1;
+        const double n1 = m_n1;
+        for ( int64_t i = 0 ; i < count ; i++ ) {
+            const double x = src[i];
+            if ( Q_UNLIKELY( std::isnan( x ) ) ) {
+                dst[i] = NanIndex;
+                continue;
+            }
+            int64_t ind = round( ( x - min ) * dInvN1 );
+            if ( Q_UNLIKELY( ind < 0 ) ) {
+                ind = 0;
+            }
+            else if ( Q_UNLIKELY( ind >= n1 ) ) {
+                ind = static_cast < int64_t > ( n1 );
+            }
+            dst[i] = ind;
+        }
+    }
+
+    /// \brief colormap a block of indices computed by convertIndexBlock()
+    /// \param src indices to convert
+    /// \param count number of indices in src
+    /// \param dst where to store the results (count entries)
+    /// \param nanColor color to use for NanIndex
+    ///
+    /// The results are identical to calling convertqBlock() on the original values.
+    void
+    convertIndexqBlock( const uint16_t * src, int64_t count, QRgb * dst, QRgb nanColor ) const
+    {
+        static_assert( ! interpolated, "indices are only available without interpolation" );
+        const QRgb * lut = m_qcache.data();
+        for ( int64_t i = 0 ; i < count ; i++ ) {
+            dst[i] = src[i] == NanIndex ? nanColor : lut[src[i]];
+        }
+    }
+
 private:
 
     std::vector < NormRgb > m_cache;
+    std::vector < QRgb > m_qcache;
 //    NormRgb m_nanColor { { 1.0, 0.0, 0.0 } };
     double m_min = 0, m_max = 1;
     double m_d, m_dInvN1, m_n1;
@@ -415,6 +512,68 @@ inline void CachedPipeline<true>::convert(double x, NormRgb & result) /*override
     result[2] = m_cache[ind][2] * (1-frac) + m_cache[ind+1][2] * frac;
 }
 
+template <>
+template < typename Scalar >
+inline void CachedPipeline<false>::convertqBlock( const Scalar * src, int64_t count,
+                                                  QRgb * dst, QRgb nanColor ) const
+{
+    const QRgb * lut = m_qcache.data();
+    const double min = m_min;
+    const double dInvN1 = m_dInvN1;
+    const double n1 = m_n1;
+    for ( int64_t i = 0 ; i < count ; i++ ) {
+        const double x = src[i];
+        if ( Q_UNLIKELY( std::isnan( x ) ) ) {
+            dst[i] = nanColor;
+            continue;
+        }
+        int64_t ind = round( ( x - min ) * dInvN1 );
+        if ( Q_UNLIKELY( ind < 0 ) ) {
+            ind = 0;
+        }
+        else if ( Q_UNLIKELY( ind >= n1 ) ) {
+            ind = static_cast < int64_t > ( n1 );
+        }
+        dst[i] = lut[ind];
+    }
+}
+
+template <>
+template < typename Scalar >
+inline void CachedPipeline<true>::convertqBlock( const Scalar * src, int64_t count,
+                                                 QRgb * dst, QRgb nanColor ) const
+{
+    const NormRgb * cache = m_cache.data();
+    const double min = m_min;
+    const double dInvN1 = m_dInvN1;
+    const double n1 = m_n1;
+    const QRgb first = m_qcache.front();
+    const QRgb last = m_qcache.back();
+    for ( int64_t i = 0 ; i < count ; i++ ) {
+        const double x = src[i];
+        if ( Q_UNLIKELY( std::isnan( x ) ) ) {
+            dst[i] = nanColor;
+            continue;
+        }
+        double dind = ( x - min ) * dInvN1;
+        if ( Q_UNLIKELY( dind < 0 ) ) {
+            dst[i] = first;
+            continue;
+        }
+        double intpart;
+        double frac = std::modf( dind, & intpart );
+        int64_t ind = intpart;
+        if ( Q_UNLIKELY( ind >= n1 ) ) {
+            dst[i] = last;
+            continue;
+        }
+        NormRgb drgb;
+        drgb[0] = cache[ind][0] * (1-frac) + cache[ind+1][0] * frac;
+        drgb[1] = cache[ind][1] * (1-frac) + cache[ind+1][1] * frac;
+        drgb[2] = cache[ind][2] * (1-frac) + cache[ind+1][2] * frac;
+        normRgb2QRgb( drgb, dst[i] );
+    }
+}
 
 } // namespace PixelPipeline
 } // namespace Lib
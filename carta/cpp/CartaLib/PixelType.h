@@ -6,6 +6,7 @@
 
 #include <QString>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 
 namespace Carta {
@@ -176,6 +177,59 @@ typename Type2CvtFunc<DstType>::Type getConverter( Carta::Lib::Image::PixelType
     }
 }
 
+/// template to convert a block of pixels from one type to another, in a single loop
+/// that the compiler can vectorize
+template <typename SrcType, typename DstType>
+struct BlockConverters {
+    static void cvt( const char * src, int64_t count, DstType * dst) {
+        const SrcType * typed = reinterpret_cast<const SrcType *>( src);
+        for( int64_t i = 0 ; i < count ; i ++ ) {
+            dst[i] = static_cast<DstType>( typed[i]);
+        }
+    }
+};
+
+/// specialized for identical type
+template <typename SrcType>
+struct BlockConverters < SrcType, SrcType > {
+    static void cvt( const char * src, int64_t count, SrcType * dst) {
+        std::memcpy( dst, src, count * sizeof( SrcType));
+    }
+};
+
+/// convert a block of raw pixels of the given type to DstType
+/// \param srcType type of the raw pixels
+/// \param src the raw pixels
+/// \param count number of pixels
+/// \param dst where to store the converted pixels
+/// \return false if the pixel type is not supported
+template < typename DstType>
+bool convertPixels( Image::PixelType srcType, const char * src, int64_t count, DstType * dst)
+{
+    switch (srcType) {
+    case Image::PixelType::Byte:
+        BlockConverters< uint8_t, DstType>::cvt( src, count, dst);
+        return true;
+    case Image::PixelType::Int16:
+        BlockConverters< int16_t, DstType>::cvt( src, count, dst);
+        return true;
+    case Image::PixelType::Int32:
+        BlockConverters< int32_t, DstType>::cvt( src, count, dst);
+        return true;
+    case Image::PixelType::Int64:
+        BlockConverters< int64_t, DstType>::cvt( src, count, dst);
+        return true;
+    case Image::PixelType::Real32:
+        BlockConverters< float, DstType>::cvt( src, count, dst);
+        return true;
+    case Image::PixelType::Real64:
+        BlockConverters< double, DstType>::cvt( src, count, dst);
+        return true;
+    default:
+        return false;
+    }
+}
+
 /// convenience function to convert a type to a string
 QString toStr( Image::PixelType t);
 
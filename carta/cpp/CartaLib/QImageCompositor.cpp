@@ -0,0 +1,217 @@
+/**
+ *
+ **/
+
+#include "QImageCompositor.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Carta
+{
+namespace Lib
+{
+namespace
+{
+/// images with fewer pixels than this are composited by a single thread
+constexpr int64_t MinParallelPixels = 64 * 1024;
+
+/// multiply all four channels of x by a / 255, rounded
+inline quint32
+byteMul( quint32 x, quint32 a )
+{
+    quint32 t = ( x & 0xff00ff ) * a;
+    t = ( t + ( ( t >> 8 ) & 0xff00ff ) + 0x800080 ) >> 8;
+    t &= 0xff00ff;
+    x = ( ( x >> 8 ) & 0xff00ff ) * a;
+    x = ( x + ( ( x >> 8 ) & 0xff00ff ) + 0x800080 );
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+/// add all four channels, saturating at 255
+inline quint32
+byteAddSaturated( quint32 x, quint32 y )
+{
+    quint32 rb = ( x & 0xff00ff ) + ( y & 0xff00ff );
+    quint32 ag = ( ( x >> 8 ) & 0xff00ff ) + ( ( y >> 8 ) & 0xff00ff );
+    // a channel that overflowed has its 9th bit set, make it 255
+    rb |= ( ( rb >> 8 ) & 0x10001 ) * 0xff;
+    ag |= ( ( ag >> 8 ) & 0x10001 ) * 0xff;
+    return ( rb & 0xff00ff ) | ( ( ag & 0xff00ff ) << 8 );
+}
+
+/// blend one scanline of a layer; the source pixels are first ORed with setBits and
+/// ANDed with the mask, then premultiplied (unless they already are), and finally
+/// blended with the destination the way QPainter does with the layer's opacity: for
+/// SourceOver the source is multiplied by the opacity, for the other modes the result
+/// is interpolated between the blended pixel and the destination
+template < bool Premultiplied, QImageCompositor::Mode M >
+void
+blendRow( quint32 * dst, const quint32 * src, int n, quint32 setBits, quint32 mask,
+          quint32 alpha )
+{
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+    for ( int i = 0 ; i < n ; i++ ) {
+        quint32 s = ( src[i] | setBits ) & mask;
+        if ( ! Premultiplied ) {
+            s = ( byteMul( s, s >> 24 ) & 0x00ffffff ) | ( s & 0xff000000 );
+        }
+        if ( M == QImageCompositor::Mode::SourceOver ) {
+            if ( alpha != 255 ) {
+                s = byteMul( s, alpha );
+            }
+            dst[i] = s + byteMul( dst[i], 255 - ( s >> 24 ) );
+            continue;
+        }
+        if ( M == QImageCompositor::Mode::Plus ) {
+            s = byteAddSaturated( dst[i], s );
+        }
+        if ( alpha != 255 ) {
+            s = byteMul( s, alpha ) + byteMul( dst[i], 255 - alpha );
+        }
+        dst[i] = s;
+    }
+}
+
+typedef void (* BlendRowFunc)( quint32 *, const quint32 *, int, quint32, quint32, quint32 );
+
+template < bool Premultiplied >
+BlendRowFunc
+blendRowFunc( QImageCompositor::Mode mode )
+{
+    switch ( mode ) {
+    case QImageCompositor::Mode::Source:
+        return & blendRow < Premultiplied, QImageCompositor::Mode::Source >;
+    case QImageCompositor::Mode::Plus:
+        return & blendRow < Premultiplied, QImageCompositor::Mode::Plus >;
+    default:
+        return & blendRow < Premultiplied, QImageCompositor::Mode::SourceOver >;
+    }
+}
+
+/// a layer ready to be blended
+struct PreparedLayer {
+    /// the source image, or its converted copy
+    const QImage * image;
+    int width;
+    int height;
+    quint32 setBits;
+    quint32 mask;
+    quint32 alpha;
+    BlendRowFunc func;
+};
+}
+
+bool
+QImageCompositor::modeFromComposition( QPainter::CompositionMode compositionMode, Mode & mode )
+{
+    switch ( compositionMode ) {
+    case QPainter::CompositionMode_Source:
+        mode = Mode::Source;
+        return true;
+    case QPainter::CompositionMode_SourceOver:
+        mode = Mode::SourceOver;
+        return true;
+    case QPainter::CompositionMode_Plus:
+        mode = Mode::Plus;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool
+QImageCompositor::isSupportedDestination( const QImage & dst )
+{
+    return dst.format() == QImage::Format_ARGB32_Premultiplied;
+}
+
+void
+QImageCompositor::composite( QImage & dst, const std::vector < Layer > & layers, int nThreads )
+{
+    CARTA_ASSERT( isSupportedDestination( dst ) );
+    const int width = dst.width();
+    const int height = dst.height();
+    if ( width <= 0 || height <= 0 ) {
+        return;
+    }
+
+    std::vector < PreparedLayer > prepared;
+    prepared.reserve( layers.size() );
+    // copies of the images that had to be converted
+    std::vector < QImage > converted;
+    converted.reserve( layers.size() );
+    for ( const Layer & layer : layers ) {
+        const Blend & blend = layer.blend;
+        CARTA_ASSERT( blend.alpha >= 0.0 && blend.alpha <= 1.0 );
+        const quint32 alpha = std::round( blend.alpha * 255 );
+        // with no opacity, every mode leaves the destination as it is
+        if ( layer.image.isNull() || alpha == 0 ) {
+            continue;
+        }
+        PreparedLayer pl;
+        pl.image = & layer.image;
+        pl.width = std::min( width, layer.image.width() );
+        pl.height = std::min( height, layer.image.height() );
+        pl.setBits = 0;
+        pl.mask = blend.mask;
+        pl.alpha = alpha;
+
+        // premultiplied pixels can be masked in place as long as the mask keeps
+        // their alpha, other formats are read as non-premultiplied ARGB
+        QImage::Format format = layer.image.format();
+        bool premultiplied = format == QImage::Format_ARGB32_Premultiplied &&
+                             ( blend.mask >> 24 ) == 0xff;
+        if ( format == QImage::Format_RGB32 ) {
+            pl.setBits = 0xff000000;
+        }
+        else if ( format != QImage::Format_ARGB32 && ! premultiplied ) {
+            converted.push_back( layer.image.convertToFormat( QImage::Format_ARGB32 ) );
+            pl.image = & converted.back();
+        }
+        pl.func = premultiplied ? blendRowFunc < true > ( blend.mode )
+                                : blendRowFunc < false > ( blend.mode );
+        prepared.push_back( pl );
+    }
+    if ( prepared.empty() ) {
+        return;
+    }
+
+#ifdef _OPENMP
+    if ( nThreads <= 0 ) {
+        nThreads = std::max( 1, omp_get_max_threads() );
+    }
+    if ( int64_t( width ) * height < MinParallelPixels ) {
+        nThreads = 1;
+    }
+#else
+    Q_UNUSED( nThreads );
+#endif
+
+    uchar * dstBits = dst.bits();
+    const int dstStride = dst.bytesPerLine();
+
+    // every thread gets a band of consecutive scanlines, and blends all layers into
+    // one scanline before moving on to the next one
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( static )
+#endif
+    for ( int y = 0 ; y < height ; y++ ) {
+        quint32 * dstRow = reinterpret_cast < quint32 * > ( dstBits + int64_t( y ) * dstStride );
+        for ( const PreparedLayer & pl : prepared ) {
+            if ( y >= pl.height ) {
+                continue;
+            }
+            const quint32 * srcRow = reinterpret_cast < const quint32 * > ( pl.image-> constScanLine( y ) );
+            pl.func( dstRow, srcRow, pl.width, pl.setBits, pl.mask, pl.alpha );
+        }
+    }
+} // composite
+}
+}
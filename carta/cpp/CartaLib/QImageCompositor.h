@@ -0,0 +1,79 @@
+/**
+ * Blends raster layers on top of each other without QPainter.
+ *
+ * All layers are blended in one pass: the destination is split into bands of
+ * scanlines that are processed by separate threads, and every scanline of the
+ * destination is blended with the same scanline of all layers, bottom to top, while
+ * it is in cache. The per pixel work (masking, premultiplication, opacity, and the
+ * blending itself) is done on whole 32 bit pixels, two 8 bit channels at a time, in
+ * loops the compiler can vectorize. The source images are read in place, except for
+ * the formats that have to be converted to 32 bit pixels first.
+ *
+ * The destination must be in QImage::Format_ARGB32_Premultiplied, which is what
+ * QPainter uses internally anyway. Layers are aligned with the top left corner of the
+ * destination, as with QPainter::drawImage( 0, 0, image ).
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include <QImage>
+#include <QPainter>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+class QImageCompositor
+{
+public:
+
+    /// how a layer is blended with the pixels below it
+    enum class Mode
+    {
+        /// the layer replaces the pixels below it, or with an opacity below 1 is
+        /// interpolated with them (QPainter::CompositionMode_Source)
+        Source,
+        /// the layer is painted over the pixels below it, honoring its alpha
+        /// (QPainter::CompositionMode_SourceOver)
+        SourceOver,
+        /// the layer is added to the pixels below it, saturating at 255, and with an
+        /// opacity below 1 the sum is interpolated with them (QPainter::CompositionMode_Plus)
+        Plus
+    };
+
+    /// everything that is applied to the pixels of a layer
+    struct Blend {
+        Mode mode = Mode::SourceOver;
+        /// ANDed with the non-premultiplied ARGB value of every source pixel
+        quint32 mask = 0xffffffff;
+        /// opacity of the whole layer, from 0 to 1
+        double alpha = 1.0;
+    };
+
+    struct Layer {
+        /// implicitly shared, so this is not a copy of the pixels
+        QImage image;
+        Blend blend;
+    };
+
+    /// \brief find the mode matching a QPainter composition mode
+    /// \return false if the composition mode is not supported
+    static bool
+    modeFromComposition( QPainter::CompositionMode compositionMode, Mode & mode );
+
+    /// can the layers be composited onto this destination?
+    static bool
+    isSupportedDestination( const QImage & dst );
+
+    /// \brief blend the layers onto the destination, in order (bottom to top)
+    /// \param dst the destination, must be a supported one
+    /// \param layers the layers
+    /// \param nThreads number of threads to use, <= 0 means one per core
+    static void
+    composite( QImage & dst, const std::vector < Layer > & layers, int nThreads = 0 );
+};
+}
+}
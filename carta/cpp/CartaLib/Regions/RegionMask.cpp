@@ -0,0 +1,444 @@
+/**
+ *
+ **/
+
+#include "RegionMask.h"
+#include "CartaLib/MemoryBudget.h"
+#include "CartaLib/Regions/Ellipse.h"
+#include "CartaLib/Regions/Point.h"
+#include "CartaLib/Regions/Rectangle.h"
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Regions
+{
+namespace
+{
+/// size of the masks kept by the cache the plugins share
+constexpr uint64_t SharedCacheBytes = 16 * 1024 * 1024;
+
+/// floor( v ), limited to [lo, hi]; NaN becomes lo
+int64_t
+clampedFloor( double v, int64_t lo, int64_t hi )
+{
+    if ( ! ( v > lo ) ) {
+        return lo;
+    }
+    if ( v > hi ) {
+        return hi;
+    }
+    return static_cast < int64_t > ( std::floor( v ) );
+}
+
+/// ceil( v ), limited to [lo, hi]; NaN becomes hi
+int64_t
+clampedCeil( double v, int64_t lo, int64_t hi )
+{
+    if ( ! ( v < hi ) ) {
+        return hi;
+    }
+    if ( v < lo ) {
+        return lo;
+    }
+    return static_cast < int64_t > ( std::ceil( v ) );
+}
+
+/// approximate memory used by a mask, in kilobytes (at least 1)
+int
+maskCost( const RegionMask & mask )
+{
+    return static_cast < int > ( std::min < uint64_t > ( mask.memoryUsed() / 1024 + 1, INT_MAX ) );
+}
+}
+
+RegionMask::RegionMask( int width, int height )
+    : m_width( std::max( width, 0 ) ), m_height( std::max( height, 0 ) )
+{ }
+
+RegionMask::SharedPtr
+RegionMask::fromRegion( const RegionBase & region, int width, int height )
+{
+    if ( region.canHaveChildren() ) {
+        SharedPtr mask( new RegionMask( width, height ) );
+        for ( const RegionBase * kid : region.children() ) {
+            mask = unite( * mask, * fromRegion( * kid, width, height ) );
+        }
+        return mask;
+    }
+
+    const QString type = region.typeName();
+    if ( type == Rectangle::TypeName ) {
+        return fromRect( region.outlineBox(), width, height );
+    }
+    if ( type == Ellipse::TypeName || type == Circle::TypeName ) {
+        return fromEllipse( region.outlineBox(), width, height );
+    }
+    if ( type == Point::TypeName ) {
+        return fromPoint( region.outlineBox().center(), width, height );
+    }
+    if ( type == Polygon::TypeName ) {
+        const Polygon * polygon = dynamic_cast < const Polygon * > ( & region );
+        if ( polygon ) {
+            return fromPolygon( polygon-> qpolyf(), width, height );
+        }
+    }
+    return _fromPointTests( region, width, height );
+} // fromRegion
+
+RegionMask::SharedPtr
+RegionMask::fromRect( const QRectF & rect, int width, int height )
+{
+    SharedPtr mask( new RegionMask( width, height ) );
+    const QRectF box = rect.normalized();
+    const int64_t x0 = clampedFloor( box.left() + 0.5, - 1, width );
+    const int64_t x1 = clampedFloor( box.right() + 0.5, - 1, width );
+    const int64_t y0 = clampedFloor( box.top() + 0.5, 0, height );
+    const int64_t y1 = clampedFloor( box.bottom() + 0.5, - 1, height - 1 );
+    for ( int64_t y = y0 ; y <= y1 ; y++ ) {
+        mask-> _addRun( y, x0, x1 + 1 );
+    }
+    return mask;
+}
+
+RegionMask::SharedPtr
+RegionMask::fromEllipse( const QRectF & box, int width, int height )
+{
+    SharedPtr mask( new RegionMask( width, height ) );
+    const QRectF rect = box.normalized();
+    const double cx = rect.center().x();
+    const double cy = rect.center().y();
+    const double rx = rect.width() / 2;
+    const double ry = rect.height() / 2;
+    const int64_t y0 = clampedCeil( cy - ry, 0, height );
+    const int64_t y1 = clampedFloor( cy + ry, - 1, height - 1 );
+    for ( int64_t y = y0 ; y <= y1 ; y++ ) {
+        const double dy = ry > 0 ? ( y - cy ) / ry : 0;
+        const double t = 1 - dy * dy;
+        if ( t < 0 ) {
+            continue;
+        }
+        const double half = rx * std::sqrt( t );
+        mask-> _addRun( y, clampedCeil( cx - half, - 1, width ),
+                        clampedFloor( cx + half, - 1, width ) + 1 );
+    }
+    return mask;
+}
+
+RegionMask::SharedPtr
+RegionMask::fromPolygon( const QPolygonF & polygon, int width, int height )
+{
+    SharedPtr mask( new RegionMask( width, height ) );
+
+    // edges that are not horizontal, from top to bottom; an edge covers the rows
+    // top <= y < bottom, so that a vertex shared by two edges is only counted once
+    struct Edge {
+        double top, bottom, x, slope;
+        int winding;
+    };
+    std::vector < Edge > edges;
+    const int n = polygon.size();
+    for ( int i = 0 ; i < n ; i++ ) {
+        QPointF a = polygon[i];
+        QPointF b = polygon[( i + 1 ) % n];
+        if ( ! std::isfinite( a.x() ) || ! std::isfinite( a.y() ) ||
+             ! std::isfinite( b.x() ) || ! std::isfinite( b.y() ) || a.y() == b.y() ) {
+            continue;
+        }
+        int winding = 1;
+        if ( a.y() > b.y() ) {
+            std::swap( a, b );
+            winding = - 1;
+        }
+        edges.push_back( { a.y(), b.y(), a.x(), ( b.x() - a.x() ) / ( b.y() - a.y() ), winding } );
+    }
+    if ( edges.empty() ) {
+        return mask;
+    }
+    std::sort( edges.begin(), edges.end(), [] ( const Edge & a, const Edge & b ) {
+        return a.top < b.top;
+    } );
+    double bottom = edges[0].bottom;
+    for ( const Edge & edge : edges ) {
+        bottom = std::max( bottom, edge.bottom );
+    }
+
+    // scan the rows, keeping the edges that cross the current row in 'active'
+    std::vector < const Edge * > active;
+    std::vector < std::pair < double, int > > crossings;
+    size_t next = 0;
+    const int64_t y0 = clampedCeil( edges[0].top, 0, height );
+    const int64_t y1 = clampedCeil( bottom, 0, height ) - 1;
+    for ( int64_t y = y0 ; y <= y1 ; y++ ) {
+        while ( next < edges.size() && edges[next].top <= y ) {
+            active.push_back( & edges[next++] );
+        }
+        active.erase( std::remove_if( active.begin(), active.end(), [y] ( const Edge * edge ) {
+                                          return edge-> bottom <= y;
+                                      } ), active.end() );
+        crossings.clear();
+        for ( const Edge * edge : active ) {
+            crossings.push_back( { edge-> x + ( y - edge-> top ) * edge-> slope, edge-> winding } );
+        }
+        std::sort( crossings.begin(), crossings.end() );
+        int winding = 0;
+        for ( size_t i = 0 ; i + 1 < crossings.size() ; i++ ) {
+            winding += crossings[i].second;
+            if ( winding != 0 ) {
+                mask-> _addRun( y, clampedCeil( crossings[i].first, - 1, width ),
+                                clampedFloor( crossings[i + 1].first, - 1, width ) + 1 );
+            }
+        }
+    }
+    return mask;
+} // fromPolygon
+
+RegionMask::SharedPtr
+RegionMask::fromPoint( const QPointF & point, int width, int height )
+{
+    SharedPtr mask( new RegionMask( width, height ) );
+    const int64_t x = clampedFloor( point.x() + 0.5, - 1, width );
+    const int64_t y = clampedFloor( point.y() + 0.5, - 1, height );
+    mask-> _addRun( y, x, x + 1 );
+    return mask;
+}
+
+RegionMask::SharedPtr
+RegionMask::unite( const RegionMask & a, const RegionMask & b )
+{
+    CARTA_ASSERT( a.width() == b.width() && a.height() == b.height() );
+    SharedPtr mask( new RegionMask( a.width(), a.height() ) );
+    mask-> m_runs.reserve( a.m_runs.size() + b.m_runs.size() );
+    auto ia = a.m_runs.begin();
+    auto ib = b.m_runs.begin();
+    while ( ia != a.m_runs.end() || ib != b.m_runs.end() ) {
+        bool takeA = ib == b.m_runs.end();
+        if ( ia != a.m_runs.end() && ib != b.m_runs.end() ) {
+            takeA = ia-> y < ib-> y || ( ia-> y == ib-> y && ia-> x0 < ib-> x0 );
+        }
+        const Run & run = takeA ? * ia++ : * ib++;
+        mask-> _addRun( run.y, run.x0, run.x1 );
+    }
+    return mask;
+}
+
+QByteArray
+RegionMask::revision( const RegionBase & region )
+{
+    // the children are serialized by their own revisions, as not all regions store
+    // their type in their json
+    QJsonObject json = region.toJson();
+    json.remove( "lineColor" );
+    json.remove( "fillColor" );
+    json.remove( "kids" );
+    QByteArray data = region.typeName().toUtf8();
+    data.append( QJsonDocument( json ).toJson( QJsonDocument::Compact ) );
+    for ( const RegionBase * kid : region.children() ) {
+        data.append( revision( * kid ) );
+    }
+    return QCryptographicHash::hash( data, QCryptographicHash::Sha1 );
+}
+
+int
+RegionMask::width() const
+{
+    return m_width;
+}
+
+int
+RegionMask::height() const
+{
+    return m_height;
+}
+
+const std::vector < RegionMask::Run > &
+RegionMask::runs() const
+{
+    return m_runs;
+}
+
+int64_t
+RegionMask::pixelCount() const
+{
+    return m_pixelCount;
+}
+
+bool
+RegionMask::isEmpty() const
+{
+    return m_runs.empty();
+}
+
+QRect
+RegionMask::boundingRect() const
+{
+    if ( m_runs.empty() ) {
+        return QRect();
+    }
+    int x0 = m_runs.front().x0;
+    int x1 = m_runs.front().x1;
+    for ( const Run & run : m_runs ) {
+        x0 = std::min( x0, run.x0 );
+        x1 = std::max( x1, run.x1 );
+    }
+    const int y0 = m_runs.front().y;
+    const int y1 = m_runs.back().y;
+    return QRect( x0, y0, x1 - x0, y1 - y0 + 1 );
+}
+
+bool
+RegionMask::contains( int x, int y ) const
+{
+    // first run that starts to the right of x, or in a later row
+    auto it = std::upper_bound( m_runs.begin(), m_runs.end(), std::make_pair( y, x ),
+                                [] ( const std::pair < int, int > & pos, const Run & run ) {
+                                    return pos.first < run.y ||
+                                           ( pos.first == run.y && pos.second < run.x0 );
+                                } );
+    if ( it == m_runs.begin() ) {
+        return false;
+    }
+    --it;
+    return it-> y == y && x < it-> x1;
+}
+
+uint64_t
+RegionMask::memoryUsed() const
+{
+    return sizeof( RegionMask ) + m_runs.capacity() * sizeof( Run );
+}
+
+void
+RegionMask::_addRun( int y, int64_t x0, int64_t x1 )
+{
+    if ( y < 0 || y >= m_height ) {
+        return;
+    }
+    x0 = std::max < int64_t > ( x0, 0 );
+    x1 = std::min < int64_t > ( x1, m_width );
+    if ( x0 >= x1 ) {
+        return;
+    }
+    if ( ! m_runs.empty() ) {
+        Run & last = m_runs.back();
+        CARTA_ASSERT( last.y < y || ( last.y == y && last.x0 <= x0 ) );
+        if ( last.y == y && x0 <= last.x1 ) {
+            if ( x1 > last.x1 ) {
+                m_pixelCount += x1 - last.x1;
+                last.x1 = x1;
+            }
+            return;
+        }
+    }
+    m_runs.push_back( { y, static_cast < int > ( x0 ), static_cast < int > ( x1 ) } );
+    m_pixelCount += x1 - x0;
+} // _addRun
+
+RegionMask::SharedPtr
+RegionMask::_fromPointTests( const RegionBase & region, int width, int height )
+{
+    SharedPtr mask( new RegionMask( width, height ) );
+    const QRectF box = region.outlineBox().normalized();
+    const int64_t x0 = clampedCeil( box.left(), 0, width );
+    const int64_t x1 = clampedFloor( box.right(), - 1, width - 1 );
+    const int64_t y0 = clampedCeil( box.top(), 0, height );
+    const int64_t y1 = clampedFloor( box.bottom(), - 1, height - 1 );
+    RegionPointV pts( region.csId() + 1 );
+    for ( int64_t y = y0 ; y <= y1 ; y++ ) {
+        int64_t start = - 1;
+        for ( int64_t x = x0 ; x <= x1 + 1 ; x++ ) {
+            bool inside = false;
+            if ( x <= x1 ) {
+                pts[region.csId()] = QPointF( x, y );
+                inside = region.isPointInside( pts );
+            }
+            if ( inside && start < 0 ) {
+                start = x;
+            }
+            else if ( ! inside && start >= 0 ) {
+                mask-> _addRun( y, start, x );
+                start = - 1;
+            }
+        }
+    }
+    return mask;
+} // _fromPointTests
+
+RegionMaskCache::RegionMaskCache( uint64_t maxBytes )
+{
+    m_cache.setMaxCost( static_cast < int > ( std::min < uint64_t > ( maxBytes / 1024, INT_MAX ) ) );
+}
+
+RegionMaskCache &
+RegionMaskCache::shared()
+{
+    static RegionMaskCache cache( SharedCacheBytes );
+    return cache;
+}
+
+RegionMask::ConstSharedPtr
+RegionMaskCache::mask( const RegionBase & region, int width, int height )
+{
+    QByteArray key = RegionMask::revision( region );
+    key.append( QByteArray::number( width ) );
+    key.append( 'x' );
+    key.append( QByteArray::number( height ) );
+    {
+        QMutexLocker locker( & m_mutex );
+        RegionMask::ConstSharedPtr * cached = m_cache.object( key );
+        if ( cached ) {
+            m_hits++;
+            return * cached;
+        }
+        m_misses++;
+    }
+
+    // scan convert without holding the lock, so that other regions can be looked up
+    RegionMask::ConstSharedPtr mask = RegionMask::fromRegion( region, width, height );
+    QMutexLocker locker( & m_mutex );
+    m_cache.insert( key, new RegionMask::ConstSharedPtr( mask ), maskCost( * mask ) );
+    return mask;
+}
+
+void
+RegionMaskCache::clear()
+{
+    QMutexLocker locker( & m_mutex );
+    m_cache.clear();
+}
+
+RegionMaskCache::Stats
+RegionMaskCache::stats() const
+{
+    QMutexLocker locker( & m_mutex );
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = m_cache.size();
+    stats.kilobytes = m_cache.totalCost();
+    return stats;
+}
+
+uint64_t
+RegionMaskCache::memoryUsed() const
+{
+    QMutexLocker locker( & m_mutex );
+    return static_cast < uint64_t > ( m_cache.totalCost() ) * 1024;
+}
+
+void
+RegionMaskCache::shrink( uint64_t maxBytes )
+{
+    QMutexLocker locker( & m_mutex );
+    MemoryBudget::qCacheShrink( m_cache, maxBytes, 1024 );
+}
+}
+}
+}
@@ -0,0 +1,209 @@
+/**
+ * Rasterized regions.
+ *
+ * Statistics, histograms and profiles of a region only need to know which pixels
+ * of an image plane are inside the region. Testing every pixel against the shape
+ * each time one of them is computed is slow, especially for polygons, so the region
+ * is scan converted once into a RegionMask: for every row of the plane, the runs of
+ * consecutive pixels that are inside. Reducers then visit the pixels of the runs,
+ * without any further geometry.
+ *
+ * Region models are recreated from their serialized state whenever they change, so a
+ * mask is identified by the revision of the region, i.e. a digest of the geometry of
+ * the region, and by the size of the plane. RegionMaskCache keeps the masks of the
+ * most recently used revisions. The statistics, histogram and profile plugins all
+ * rasterize the same regions, so they share RegionMaskCache::shared().
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/Regions/IRegion.h"
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QPolygonF>
+#include <QRect>
+#include <QRectF>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Regions
+{
+/// \brief run length encoded set of the pixels of an image plane that are inside a region
+///
+/// Pixel (x, y) has its center at (x, y) in the pixel coordinates of the regions and is
+/// inside the region if its center is inside the shape. Rectangles and points follow
+/// the rounding of casa's box regions instead: a rectangle covers the pixels between
+/// its rounded corners, a point the pixel nearest to it. Ellipses are the ellipses
+/// inscribed in their outline box, as they are drawn, and polygons use the non-zero
+/// winding rule. Pixels outside of the plane are never part of the mask.
+class RegionMask
+{
+    CLASS_BOILERPLATE( RegionMask );
+
+public:
+
+    /// pixels x0 <= x < x1 of row y
+    struct Run {
+        int y;
+        int x0;
+        int x1;
+    };
+
+    /// \brief scan convert a region
+    /// \param region the region, in pixel coordinates of the plane
+    /// \param width number of columns of the plane
+    /// \param height number of rows of the plane
+    /// \return the mask; children of unions are merged into one mask
+    static SharedPtr
+    fromRegion( const RegionBase & region, int width, int height );
+
+    /// mask of the pixels between the rounded corners of a rectangle
+    static SharedPtr
+    fromRect( const QRectF & rect, int width, int height );
+
+    /// mask of the ellipse inscribed in a rectangle
+    static SharedPtr
+    fromEllipse( const QRectF & box, int width, int height );
+
+    /// mask of a polygon, using the non-zero winding rule
+    static SharedPtr
+    fromPolygon( const QPolygonF & polygon, int width, int height );
+
+    /// mask of the single pixel nearest to a point
+    static SharedPtr
+    fromPoint( const QPointF & point, int width, int height );
+
+    /// \brief mask of the pixels that are inside either of two masks of the same plane
+    static SharedPtr
+    unite( const RegionMask & a, const RegionMask & b );
+
+    /// \brief identifies the geometry of a region
+    ///
+    /// Two regions have the same revision if they have the same shape, position and
+    /// children; colors do not matter.
+    static QByteArray
+    revision( const RegionBase & region );
+
+    /// number of columns of the plane
+    int
+    width() const;
+
+    /// number of rows of the plane
+    int
+    height() const;
+
+    /// the runs, sorted by row and then column, not overlapping
+    const std::vector < Run > &
+    runs() const;
+
+    /// number of pixels inside the mask
+    int64_t
+    pixelCount() const;
+
+    /// whether no pixel is inside
+    bool
+    isEmpty() const;
+
+    /// the smallest rectangle containing all the pixels of the mask
+    QRect
+    boundingRect() const;
+
+    /// whether pixel (x, y) is inside the mask
+    bool
+    contains( int x, int y ) const;
+
+    /// approximate memory used by the mask, in bytes
+    uint64_t
+    memoryUsed() const;
+
+private:
+
+    RegionMask( int width, int height );
+
+    /// append the pixels x0 <= x < x1 of row y, clipped to the plane; rows have to be
+    /// added in increasing order, runs of a row from left to right
+    void
+    _addRun( int y, int64_t x0, int64_t x1 );
+
+    /// generic scan conversion, testing the center of every pixel of the outline box
+    static SharedPtr
+    _fromPointTests( const RegionBase & region, int width, int height );
+
+    int m_width = 0;
+    int m_height = 0;
+    int64_t m_pixelCount = 0;
+    std::vector < Run > m_runs;
+};
+
+/// \brief masks of the most recently used region revisions
+///
+/// The cache can be used from several threads.
+class RegionMaskCache
+{
+    CLASS_BOILERPLATE( RegionMaskCache );
+
+public:
+
+    /// counters describing how well the cache works
+    struct Stats {
+        /// number of masks found in the cache
+        uint64_t hits = 0;
+        /// number of masks that had to be scan converted
+        uint64_t misses = 0;
+        /// number of masks currently in the cache
+        int entries = 0;
+        /// size of the cached masks, in kilobytes
+        int kilobytes = 0;
+    };
+
+    /// \param maxBytes the maximum size of the cached masks
+    explicit
+    RegionMaskCache( uint64_t maxBytes );
+
+    /// the cache shared by all the plugins, created on first use and registered with
+    /// the memory budget by Globals
+    static RegionMaskCache &
+    shared();
+
+    /// \brief the mask of a region, scan converted only if its revision is not cached
+    /// \param region the region, in pixel coordinates of the plane
+    /// \param width number of columns of the plane
+    /// \param height number of rows of the plane
+    RegionMask::ConstSharedPtr
+    mask( const RegionBase & region, int width, int height );
+
+    /// forget all masks
+    void
+    clear();
+
+    /// return the current values of the counters
+    Stats
+    stats() const;
+
+    /// return the approximate size of the cached masks, in bytes
+    uint64_t
+    memoryUsed() const;
+
+    /// \brief drop the least recently used masks
+    /// \param maxBytes the size the cached masks are reduced to, at most
+    void
+    shrink( uint64_t maxBytes );
+
+private:
+
+    mutable QMutex m_mutex;
+
+    /// cost of the entries is their size in kilobytes
+    QCache < QByteArray, RegionMask::ConstSharedPtr > m_cache;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+}
+}
+}
@@ -0,0 +1,263 @@
+/**
+ *
+ **/
+
+#include "RegionStatistics.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Regions
+{
+namespace
+{
+/// approximate number of pixels reduced by one task, small enough for the tasks of a
+/// block of rows to be spread over all threads
+static constexpr int64_t TaskPixels = 1 << 16;
+
+/// a part of the runs of one region that lies in the current block of rows
+struct Task {
+    int region;
+    size_t firstRun;
+    size_t endRun;
+};
+
+int
+threadCount( int nThreads )
+{
+    if ( nThreads > 0 ) {
+        return nThreads;
+    }
+#ifdef _OPENMP
+    return std::max( 1, omp_get_max_threads() );
+#else
+    return 1;
+#endif
+}
+
+/// whether pixel (x1, y1) comes before pixel (x2, y2) in row major order
+bool
+isBefore( int x1, int y1, int x2, int y2 )
+{
+    return y1 < y2 || ( y1 == y2 && x1 < x2 );
+}
+}
+
+void
+RegionStatistics::merge( const RegionStatistics & other )
+{
+    if ( other.count == 0 ) {
+        return;
+    }
+    if ( count == 0 || other.min < min ||
+         ( other.min == min && isBefore( other.minX, other.minY, minX, minY ) ) ) {
+        min = other.min;
+        minX = other.minX;
+        minY = other.minY;
+    }
+    if ( count == 0 || other.max > max ||
+         ( other.max == max && isBefore( other.maxX, other.maxY, maxX, maxY ) ) ) {
+        max = other.max;
+        maxX = other.maxX;
+        maxY = other.maxY;
+    }
+    count += other.count;
+    sum += other.sum;
+    sumSq += other.sumSq;
+}
+
+double
+RegionStatistics::mean() const
+{
+    if ( count == 0 ) {
+        return std::numeric_limits < double >::quiet_NaN();
+    }
+    return sum / count;
+}
+
+double
+RegionStatistics::rms() const
+{
+    if ( count == 0 ) {
+        return std::numeric_limits < double >::quiet_NaN();
+    }
+    return std::sqrt( sumSq / count );
+}
+
+double
+RegionStatistics::sigma() const
+{
+    if ( count == 0 ) {
+        return std::numeric_limits < double >::quiet_NaN();
+    }
+    if ( count == 1 ) {
+        return 0;
+    }
+
+    // rounding can make the variance of (nearly) constant values slightly negative
+    double variance = ( sumSq - sum * sum / count ) / ( count - 1 );
+    return std::sqrt( std::max( 0.0, variance ) );
+}
+
+RegionStatisticsReducer::RegionStatisticsReducer(
+    const std::vector < RegionMask::ConstSharedPtr > & masks )
+    : m_masks( masks )
+    , m_stats( masks.size() )
+{
+    for ( const RegionMask::ConstSharedPtr & mask : m_masks ) {
+        CARTA_ASSERT( mask );
+        m_box = m_box.united( mask-> boundingRect() );
+    }
+}
+
+void
+RegionStatisticsReducer::setThreadCount( int nThreads )
+{
+    m_nThreads = nThreads;
+}
+
+QRect
+RegionStatisticsReducer::boundingRect() const
+{
+    return m_box;
+}
+
+void
+RegionStatisticsReducer::add( int y0, int rows, const float * data )
+{
+    // split the runs of every region in the block into tasks of about TaskPixels pixels
+    auto byRow = [] ( const RegionMask::Run & run, int y ) {
+        return run.y < y;
+    };
+    std::vector < Task > tasks;
+    for ( size_t r = 0 ; r < m_masks.size() ; r++ ) {
+        const std::vector < RegionMask::Run > & runs = m_masks[r]-> runs();
+        size_t first = std::lower_bound( runs.begin(), runs.end(), y0, byRow ) - runs.begin();
+        size_t end = std::lower_bound( runs.begin() + first, runs.end(), y0 + rows, byRow ) -
+                     runs.begin();
+        int64_t pixels = 0;
+        for ( size_t i = first ; i < end ; i++ ) {
+            pixels += runs[i].x1 - runs[i].x0;
+            if ( pixels >= TaskPixels || i + 1 == end ) {
+                tasks.push_back( { static_cast < int > ( r ), first, i + 1 } );
+                first = i + 1;
+                pixels = 0;
+            }
+        }
+    }
+
+    const int stride = m_box.width();
+    const int left = m_box.left();
+    const int nTasks = tasks.size();
+    std::vector < RegionStatistics > partials( nTasks );
+    const int nThreads = nTasks > 1 ? threadCount( m_nThreads ) : 1;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( dynamic )
+#else
+    Q_UNUSED( nThreads );
+#endif
+    for ( int t = 0 ; t < nTasks ; t++ ) {
+        const Task & task = tasks[t];
+        const std::vector < RegionMask::Run > & runs = m_masks[task.region]-> runs();
+        RegionStatistics & stats = partials[t];
+        for ( size_t i = task.firstRun ; i < task.endRun ; i++ ) {
+            const RegionMask::Run & run = runs[i];
+            const float * row = data + int64_t( run.y - y0 ) * stride - left;
+            for ( int x = run.x0 ; x < run.x1 ; x++ ) {
+                const double v = row[x];
+                if ( ! std::isfinite( v ) ) {
+                    continue;
+                }
+                stats.count++;
+                stats.sum += v;
+                stats.sumSq += v * v;
+
+                // strict comparisons keep the first pixel of equal values
+                if ( v < stats.min ) {
+                    stats.min = v;
+                    stats.minX = x;
+                    stats.minY = run.y;
+                }
+                if ( v > stats.max ) {
+                    stats.max = v;
+                    stats.maxX = x;
+                    stats.maxY = run.y;
+                }
+            }
+        }
+    }
+
+    // merge in task order, so that the sums are rounded the same way for any number
+    // of threads
+    for ( int t = 0 ; t < nTasks ; t++ ) {
+        m_stats[tasks[t].region].merge( partials[t] );
+    }
+} // add
+
+const std::vector < RegionStatistics > &
+RegionStatisticsReducer::result() const
+{
+    return m_stats;
+}
+
+RegionStatisticsCache::RegionStatisticsCache( int maxEntries )
+{
+    m_cache.setMaxCost( maxEntries );
+}
+
+bool
+RegionStatisticsCache::find( const QString & image, const QByteArray & revision,
+                             const std::vector < int > & plane, RegionStatistics & stats ) const
+{
+    QByteArray key = _key( image, revision, plane );
+    QMutexLocker locker( & m_mutex );
+    const RegionStatistics * cached = m_cache.object( key );
+    if ( ! cached ) {
+        return false;
+    }
+    stats = * cached;
+    return true;
+}
+
+void
+RegionStatisticsCache::insert( const QString & image, const QByteArray & revision,
+                               const std::vector < int > & plane,
+                               const RegionStatistics & stats )
+{
+    QByteArray key = _key( image, revision, plane );
+    QMutexLocker locker( & m_mutex );
+    m_cache.insert( key, new RegionStatistics( stats ) );
+}
+
+void
+RegionStatisticsCache::clear()
+{
+    QMutexLocker locker( & m_mutex );
+    m_cache.clear();
+}
+
+QByteArray
+RegionStatisticsCache::_key( const QString & image, const QByteArray & revision,
+                             const std::vector < int > & plane )
+{
+    QByteArray key = revision;
+    for ( int index : plane ) {
+        key.append( ',' );
+        key.append( QByteArray::number( index ) );
+    }
+    key.append( '\n' );
+    key.append( image.toUtf8() );
+    return key;
+}
+}
+}
+}
@@ -0,0 +1,169 @@
+/**
+ * Statistics of regions, computed from their masks.
+ *
+ * RegionStatisticsReducer computes the statistics of any number of regions of an image
+ * plane in one pass over the rows of the plane: only the rows that intersect at least one
+ * region are read, and each of them only once, no matter how many regions cover it. The
+ * pixels of the runs of all the regions are reduced in parallel, and the partial results
+ * are merged in a fixed order, so the results do not depend on the number of threads.
+ *
+ * RegionStatisticsCache keeps the results of the most recently used regions and planes,
+ * so that only the regions that changed have to be reduced again.
+ *
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/Regions/RegionMask.h"
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QRect>
+#include <QString>
+#include <limits>
+#include <vector>
+
+namespace Carta
+{
+namespace Lib
+{
+namespace Regions
+{
+/// \brief count, sum, sum of squares, min and max of the finite values of a region,
+/// and the positions of the min and max
+class RegionStatistics
+{
+    CLASS_BOILERPLATE( RegionStatistics );
+
+public:
+
+    /// number of finite values
+    uint64_t count = 0;
+
+    /// sum of the finite values
+    double sum = 0;
+
+    /// sum of the squares of the finite values
+    double sumSq = 0;
+
+    /// smallest finite value, numeric_limits::max() if there are none
+    double min = std::numeric_limits < double >::max();
+
+    /// largest finite value, numeric_limits::lowest() if there are none
+    double max = std::numeric_limits < double >::lowest();
+
+    /// pixel of the smallest value, the first one in row major order if there are
+    /// several, -1 if there are no values
+    int minX = - 1;
+    int minY = - 1;
+
+    /// pixel of the largest value, the first one in row major order if there are
+    /// several, -1 if there are no values
+    int maxX = - 1;
+    int maxY = - 1;
+
+    /// add the values summarized by another set of pixels to this one
+    void
+    merge( const RegionStatistics & other );
+
+    /// mean of the finite values, NaN if there are none
+    double
+    mean() const;
+
+    /// root mean square of the finite values, NaN if there are none
+    double
+    rms() const;
+
+    /// standard deviation of the finite values, normalized by count - 1 like casa's
+    /// statistics, NaN if there are none and 0 if there is only one
+    double
+    sigma() const;
+};
+
+/// \brief computes the statistics of several regions of a plane in one pass over its rows
+///
+/// The rows are added in blocks, e.g. one row of tiles of the image at a time; blocks can
+/// be added in any order, but each row only once.
+class RegionStatisticsReducer
+{
+    CLASS_BOILERPLATE( RegionStatisticsReducer );
+
+public:
+
+    /// \param masks the masks of the regions, all of them of the same plane
+    explicit
+    RegionStatisticsReducer( const std::vector < RegionMask::ConstSharedPtr > & masks );
+
+    /// set the number of threads, 0 means the OpenMP default
+    void
+    setThreadCount( int nThreads );
+
+    /// the pixels that have to be read, i.e. the smallest rectangle containing the
+    /// pixels of all the masks
+    QRect
+    boundingRect() const;
+
+    /// \brief reduce the pixels of the regions in a block of rows
+    /// \param y0 the first row of the block
+    /// \param rows number of rows in the block
+    /// \param data the values of columns boundingRect().left() to boundingRect().right()
+    /// of the rows, one row after the other; masked pixels should be NaN
+    void
+    add( int y0, int rows, const float * data );
+
+    /// the statistics of the regions, in the order of the masks
+    const std::vector < RegionStatistics > &
+    result() const;
+
+private:
+
+    std::vector < RegionMask::ConstSharedPtr > m_masks;
+    std::vector < RegionStatistics > m_stats;
+    QRect m_box;
+    int m_nThreads = 0;
+};
+
+/// \brief statistics of the most recently used regions and planes
+///
+/// The cache can be used from several threads.
+class RegionStatisticsCache
+{
+    CLASS_BOILERPLATE( RegionStatisticsCache );
+
+public:
+
+    /// \param maxEntries the maximum number of cached statistics
+    explicit
+    RegionStatisticsCache( int maxEntries );
+
+    /// \brief look up the statistics of a region
+    /// \param image identifies the image, e.g. its file name
+    /// \param revision the revision of the region, see RegionMask::revision()
+    /// \param plane the position of the plane, i.e. the indices of the other axes
+    /// \param stats set to the statistics if they are cached
+    /// \return whether the statistics are cached
+    bool
+    find( const QString & image, const QByteArray & revision, const std::vector < int > & plane,
+          RegionStatistics & stats ) const;
+
+    /// remember the statistics of a region, see find()
+    void
+    insert( const QString & image, const QByteArray & revision, const std::vector < int > & plane,
+            const RegionStatistics & stats );
+
+    /// forget all statistics
+    void
+    clear();
+
+private:
+
+    static QByteArray
+    _key( const QString & image, const QByteArray & revision, const std::vector < int > & plane );
+
+    mutable QMutex m_mutex;
+    QCache < QByteArray, RegionStatistics > m_cache;
+};
+}
+}
+}
@@ -0,0 +1,61 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/Algorithms/ContourCache.h"
+
+namespace
+{
+Carta::Lib::Algorithms::ContourCache::Polylines
+makePolylines( int nPoints, double offset )
+{
+    QPolygonF poly;
+    for ( int i = 0 ; i < nPoints ; i++ ) {
+        poly.append( QPointF( i + offset, offset ) );
+    }
+    return { poly };
+}
+}
+
+TEST_CASE( "Contour cache", "[contour]" ) {
+    typedef Carta::Lib::Algorithms::ContourCache ContourCache;
+
+    SECTION( "levels are found only for the same view, type and level" ) {
+        ContourCache cache( 1024 * 1024 );
+        cache.insert( "view1", "No smoothing", 0.5, makePolylines( 10, 1 ) );
+        cache.insert( "view1", "No smoothing", - 0.0, makePolylines( 10, 2 ) );
+
+        ContourCache::Polylines polylines;
+        REQUIRE( cache.find( "view1", "No smoothing", 0.5, polylines ) );
+        REQUIRE( polylines == makePolylines( 10, 1 ) );
+        REQUIRE( cache.find( "view1", "No smoothing", 0.0, polylines ) );
+        REQUIRE( polylines == makePolylines( 10, 2 ) );
+        REQUIRE_FALSE( cache.find( "view2", "No smoothing", 0.5, polylines ) );
+        REQUIRE_FALSE( cache.find( "view1", "Box blur 3x3", 0.5, polylines ) );
+        REQUIRE_FALSE( cache.find( "view1", "No smoothing", 0.5000000001, polylines ) );
+
+        REQUIRE( cache.stats().hits == 2 );
+        REQUIRE( cache.stats().misses == 3 );
+        REQUIRE( cache.hitRate() == Approx( 0.4 ) );
+        REQUIRE( cache.stats().entries == 2 );
+    }
+
+    SECTION( "the cache stays within its budget" ) {
+        ContourCache cache( 64 * 1024 );
+        for ( int i = 0 ; i < 100 ; i++ ) {
+            cache.insert( "view", "No smoothing", i, makePolylines( 1000, i ) );
+        }
+        REQUIRE( cache.stats().kilobytes <= 64 );
+        REQUIRE( cache.stats().entries < 100 );
+        REQUIRE( cache.stats().entries > 0 );
+
+        ContourCache::Polylines polylines;
+        REQUIRE( cache.find( "view", "No smoothing", 99, polylines ) );
+        REQUIRE( polylines == makePolylines( 1000, 99 ) );
+
+        cache.clear();
+        REQUIRE( cache.stats().entries == 0 );
+        REQUIRE_FALSE( cache.find( "view", "No smoothing", 99, polylines ) );
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "quantileTestCommon.h"
+#include "CartaLib/Algorithms/ContourConrec.h"
+#include "conrecSerial.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+/// 2D test view that supports slicing whole rows, which is what the contour
+/// algorithms need
+class RowSliceView
+    : public TestRawView < float >
+{
+public:
+    RowSliceView( const std::vector < float > data, const VI dims )
+        : TestRawView( data, dims )
+    { }
+
+    virtual RawViewInterface *
+    getView( const SliceND & sliceInfo ) override
+    {
+        SliceND::ApplyResult ar = sliceInfo.apply( { m_viewDims[0], m_viewDims[1] } );
+        const int first = ar.dims()[1].start;
+        const int count = ar.dims()[1].count;
+        std::vector < float > rows( data.begin() + first * m_viewDims[0],
+                                    data.begin() + ( first + count ) * m_viewDims[0] );
+        return new RowSliceView( rows, { m_viewDims[0], count } );
+    }
+};
+
+RowSliceView
+makeView( int width, int height, int nanStride = 37 )
+{
+    std::mt19937 gen( 1 );
+    std::normal_distribution < float > dist( 0.0, 1.0 );
+    std::vector < float > data( width * height );
+    for ( int row = 0 ; row < height ; row++ ) {
+        for ( int col = 0 ; col < width ; col++ ) {
+            data[col + row * width] = std::sin( col * 0.1 ) * std::cos( row * 0.07 ) + 0.1 * dist( gen );
+        }
+    }
+    for ( size_t i = 0 ; i < data.size() ; i += nanStride ) {
+        data[i] = std::numeric_limits < float >::quiet_NaN();
+    }
+    return RowSliceView( data, { width, height } );
+}
+
+/// whether two sets of segments are the same up to rounding of the coordinates
+bool
+sameSegments( const std::vector < QPolygonF > & a, const std::vector < QPolygonF > & b,
+              double tolerance )
+{
+    if ( a.size() != b.size() ) {
+        return false;
+    }
+    for ( size_t s = 0 ; s < a.size() ; s++ ) {
+        for ( int p = 0 ; p < 2 ; p++ ) {
+            if ( std::abs( a[s][p].x() - b[s][p].x() ) > tolerance ||
+                 std::abs( a[s][p].y() - b[s][p].y() ) > tolerance ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}
+
+TEST_CASE( "Banded contours match the serial algorithm", "[contour]" ) {
+    // the larger kernels need fewer NaNs to leave anything to contour
+    RowSliceView view = makeView( 97, 413 );
+    RowSliceView fewNaNsView = makeView( 97, 413, 1009 );
+    std::vector < double > levels = { 0.5, -0.5, 0.0, 0.25, -0.75, 0.9 };
+    QStringList types = { "No smoothing", "Gaussian blur 3x3", "Box blur 3x3",
+                          "Gaussian blur 5x5", "Box blur 5x5", "Gaussian blur 9x9",
+                          "Box blur 7x7", "Gaussian blur sigma 1.3" };
+
+    for ( RowSliceView * v : { & view, & fewNaNsView } ) {
+        for ( const QString & type : types ) {
+            Carta::Lib::Algorithms::ContourConrec cc;
+            cc.setLevels( levels );
+            auto reference = conrecSerial( v, levels, type );
+            REQUIRE( reference.size() == levels.size() );
+            Carta::Lib::Algorithms::ContourConrec::Result first;
+            for ( int nThreads : { 1, 3, 8 } ) {
+                cc.setThreadCount( nThreads );
+                auto result = cc.computeSegments( v, type );
+                REQUIRE( result.size() == reference.size() );
+                for ( size_t k = 0 ; k < levels.size() ; k++ ) {
+                    REQUIRE( result[k].size() == reference[k].size() );
+                    if ( type == "No smoothing" ) {
+                        REQUIRE( result[k] == reference[k] );
+                    }
+                    else {
+                        // the smoothing is done in two 1D passes, so it only matches
+                        // the 2D kernel of the serial algorithm up to rounding
+                        REQUIRE( sameSegments( result[k], reference[k], 1e-6 ) );
+                    }
+                }
+                // but does not depend on the number of threads
+                if ( first.empty() ) {
+                    first = result;
+                }
+                REQUIRE( result == first );
+            }
+        }
+    }
+}
+
+TEST_CASE( "Contour smoothing types", "[contour]" ) {
+    typedef Carta::Lib::Algorithms::ContourConrec ContourConrec;
+
+    auto smoothing = ContourConrec::smoothingForType( "Gaussian blur 7x7" );
+    REQUIRE( smoothing.weights.size() == 7 );
+    REQUIRE( smoothing.downsample == 1 );
+    double sum = 0;
+    for ( double weight : smoothing.weights ) {
+        sum += weight;
+    }
+    REQUIRE( sum == Approx( 1.0 ) );
+
+    smoothing = ContourConrec::smoothingForType( "Gaussian blur sigma 2" );
+    REQUIRE( smoothing.weights.size() == 13 );
+    smoothing = ContourConrec::smoothingForType( "Box blur 9x9" );
+    REQUIRE( smoothing.weights.size() == 9 );
+    smoothing = ContourConrec::smoothingForType( "Downsample 4x" );
+    REQUIRE( smoothing.downsample == 4 );
+    smoothing = ContourConrec::smoothingForType( "No smoothing" );
+    REQUIRE( smoothing.weights.size() == 1 );
+    REQUIRE( smoothing.downsample == 1 );
+}
+
+TEST_CASE( "Downsampled contours are the contours of the averaged pixels", "[contour]" ) {
+    const int width = 97;
+    const int height = 413;
+    const int factor = 3;
+    RowSliceView view = makeView( width, height, 1009 );
+
+    // average the pixels by hand
+    const int smallWidth = width / factor;
+    const int smallHeight = height / factor;
+    std::vector < float > small( smallWidth * smallHeight );
+    for ( int row = 0 ; row < smallHeight ; row++ ) {
+        for ( int col = 0 ; col < smallWidth ; col++ ) {
+            double sum = 0;
+            for ( int dy = 0 ; dy < factor ; dy++ ) {
+                for ( int dx = 0 ; dx < factor ; dx++ ) {
+                    sum += view.data[col * factor + dx + ( row * factor + dy ) * width];
+                }
+            }
+            small[col + row * smallWidth] = sum / ( factor * factor );
+        }
+    }
+    RowSliceView smallView( small, { smallWidth, smallHeight } );
+
+    std::vector < double > levels = { 0.5, -0.5, 0.0 };
+    Carta::Lib::Algorithms::ContourConrec cc;
+    cc.setLevels( levels );
+    auto result = cc.computeSegments( & view, "Downsample 3x" );
+    auto expected = cc.computeSegments( & smallView, "No smoothing" );
+    REQUIRE( result.size() == levels.size() );
+    for ( size_t k = 0 ; k < levels.size() ; k++ ) {
+        REQUIRE( result[k].size() > 0 );
+        // the averaged pixels are at the centers of the blocks
+        for ( QPolygonF & poly : expected[k] ) {
+            for ( QPointF & point : poly ) {
+                point = QPointF( point.x() * factor + 1, point.y() * factor + 1 );
+            }
+        }
+        // the hand averaged pixels were rounded to floats
+        REQUIRE( sameSegments( result[k], expected[k], 1e-3 ) );
+    }
+}
+
+namespace
+{
+/// segments of the polylines, each ordered so that the orientation does not matter
+std::vector < std::vector < double > >
+sortedSegments( const std::vector < QPolygonF > & polylines )
+{
+    std::vector < std::vector < double > > segments;
+    for ( const QPolygonF & poly : polylines ) {
+        for ( int i = 0 ; i + 1 < poly.size() ; i++ ) {
+            std::vector < double > seg = { poly[i].x(), poly[i].y(), poly[i + 1].x(), poly[i + 1].y() };
+            if ( std::make_pair( seg[2], seg[3] ) < std::make_pair( seg[0], seg[1] ) ) {
+                std::swap( seg[0], seg[2] );
+                std::swap( seg[1], seg[3] );
+            }
+            segments.push_back( seg );
+        }
+    }
+    std::sort( segments.begin(), segments.end() );
+    return segments;
+}
+}
+
+TEST_CASE( "Contour polylines are made of the Conrec segments", "[contour]" ) {
+    RowSliceView view = makeView( 97, 413 );
+    std::vector < double > levels = { 0.5, -0.5, 0.0 };
+
+    for ( const QString & type : { QString( "No smoothing" ), QString( "Gaussian blur 5x5" ) } ) {
+        Carta::Lib::Algorithms::ContourConrec cc;
+        cc.setLevels( levels );
+        auto segments = cc.computeSegments( & view, type );
+        auto polylines = cc.compute( & view, type );
+        REQUIRE( polylines.size() == levels.size() );
+        for ( size_t k = 0 ; k < levels.size() ; k++ ) {
+            REQUIRE( polylines[k].size() < segments[k].size() );
+            REQUIRE( sortedSegments( polylines[k] ) == sortedSegments( segments[k] ) );
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "core/Algorithms/floatFrameView.h"
+
+namespace
+{
+typedef Carta::Core::Algorithms::FloatFrameView FloatFrameView;
+
+/// read all pixels of a view with the buffered forEach, using a small buffer
+std::vector < float >
+readAll( Carta::Lib::NdArray::RawViewInterface & view, char * buff = nullptr )
+{
+    std::vector < float > result;
+    view.forEach( 3 * sizeof( float ), [&] ( const char * data, int64_t count ) {
+                      const float * vals = reinterpret_cast < const float * > ( data );
+                      result.insert( result.end(), vals, vals + count );
+                  }, buff );
+    return result;
+}
+}
+
+TEST_CASE( "Float frame view", "[view]" ) {
+    // 5x4 frame with an extra degenerate axis, pixel (x,y) holds 10*y + x
+    const int width = 5;
+    const int height = 4;
+    FloatFrameView::Data data = std::make_shared < std::vector < float > > ();
+    for ( int y = 0 ; y < height ; y++ ) {
+        for ( int x = 0 ; x < width ; x++ ) {
+            data-> push_back( 10 * y + x );
+        }
+    }
+    FloatFrameView view( data, { width, height, 1 } );
+
+    REQUIRE( view.dims() == std::vector < int > ( { width, height, 1 } ) );
+    REQUIRE( view.byteCount() == width * height * 4 );
+    REQUIRE( * reinterpret_cast < const float * > ( view.get( { 3, 2, 0 } ) ) == 23 );
+    REQUIRE( readAll( view ) == * data );
+
+    SECTION( "slices" ) {
+        SliceND slice;
+        slice.start( 1 ).end( 5 ).step( 2 ).next().start( 1 ).end( 3 );
+        std::unique_ptr < Carta::Lib::NdArray::RawViewInterface > sub( view.getView( slice ) );
+        REQUIRE( sub-> dims() == std::vector < int > ( { 2, 2, 1 } ) );
+        std::vector < float > expected = { 11, 13, 21, 23 };
+        char buff[3 * sizeof( float )];
+        REQUIRE( readAll( * sub ) == expected );
+        REQUIRE( readAll( * sub, buff ) == expected );
+
+        std::vector < float > perElement;
+        sub-> forEach( [&] ( const char * p ) {
+                           perElement.push_back( * reinterpret_cast < const float * > ( p ) );
+                       } );
+        REQUIRE( perElement == expected );
+
+        // a view of a view
+        SliceND row;
+        row.next().start( 1 ).end( 2 );
+        std::unique_ptr < Carta::Lib::NdArray::RawViewInterface > subRow( sub-> getView( row ) );
+        REQUIRE( readAll( * subRow ) == std::vector < float > ( { 21, 23 } ) );
+    }
+
+    SECTION( "chunked reads" ) {
+        float chunk[8];
+        REQUIRE( view.read( 2, sizeof( chunk ), reinterpret_cast < char * > ( chunk ) ) == 4 * 4 );
+        REQUIRE( chunk[0] == 31 );
+        view.seek( 1 );
+        REQUIRE( view.read( sizeof( chunk ), reinterpret_cast < char * > ( chunk ) ) == sizeof( chunk ) );
+        REQUIRE( chunk[0] == 13 );
+        REQUIRE( view.read( sizeof( chunk ), reinterpret_cast < char * > ( chunk ) ) == 4 * 4 );
+        REQUIRE( view.read( sizeof( chunk ), reinterpret_cast < char * > ( chunk ) ) == 0 );
+    }
+}
@@ -0,0 +1,57 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "core/Data/Animator/FrameSequence.h"
+
+TEST_CASE( "Animation frame sequence", "[animator]" ) {
+    typedef Carta::Data::FrameSequence FrameSequence;
+
+    SECTION( "wrap continues from the other end" ) {
+        FrameSequence seq( 2, 9, 3, FrameSequence::EndBehavior::WRAP );
+        // the current frame is not repeated
+        REQUIRE( seq.upcoming( 2, true, 5 ) == std::vector < int > ( { 5, 8 } ) );
+        REQUIRE( seq.upcoming( 5, false, 3 ) == std::vector < int > ( { 2, 9, 6 } ) );
+    }
+
+    SECTION( "jump alternates between the ends" ) {
+        FrameSequence seq( 0, 10, 1, FrameSequence::EndBehavior::JUMP );
+        REQUIRE( seq.upcoming( 4, true, 4 ) == std::vector < int > ( { 10, 0 } ) );
+        REQUIRE( seq.upcoming( 4, false, 4 ) == std::vector < int > ( { 0, 10 } ) );
+    }
+
+    SECTION( "reverse bounces off the ends" ) {
+        FrameSequence seq( 0, 5, 2, FrameSequence::EndBehavior::REVERSE );
+        bool forward = true;
+        REQUIRE( seq.next( 4, & forward ) == 2 );
+        REQUIRE_FALSE( forward );
+        REQUIRE( seq.next( 0, & forward ) == 2 );
+        REQUIRE( forward );
+        REQUIRE( seq.upcoming( 1, true, 3 ) == std::vector < int > ( { 3, 5 } ) );
+    }
+
+    SECTION( "the direction is taken from the last move" ) {
+        FrameSequence seq( 0, 20, 2, FrameSequence::EndBehavior::REVERSE );
+        bool forward = true;
+        REQUIRE( seq.followed( 10, 8, & forward ) );
+        REQUIRE_FALSE( forward );
+        REQUIRE( seq.followed( 0, 2, & forward ) );
+        REQUIRE( forward );
+        REQUIRE( seq.followed( 20, 18, & forward ) );
+        REQUIRE_FALSE( forward );
+
+        // a seek is not a step, and keeps the direction
+        REQUIRE_FALSE( seq.followed( 4, 15, & forward ) );
+        REQUIRE_FALSE( forward );
+    }
+
+    SECTION( "end behavior names" ) {
+        bool valid = false;
+        REQUIRE( FrameSequence::toEndBehavior( "Reverse", & valid ) == FrameSequence::EndBehavior::REVERSE );
+        REQUIRE( valid );
+        REQUIRE( FrameSequence::toEndBehavior( "Jump", & valid ) == FrameSequence::EndBehavior::JUMP );
+        FrameSequence::toEndBehavior( "Bounce", & valid );
+        REQUIRE_FALSE( valid );
+    }
+}
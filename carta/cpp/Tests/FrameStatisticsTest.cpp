@@ -0,0 +1,92 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "core/Algorithms/frameStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+typedef Carta::Core::Algorithms::FrameStatistics FrameStatistics;
+
+/// the value the exact percentile algorithm returns
+double
+exactPercentile( std::vector < double > values, double percentile )
+{
+    size_t x1 = Carta::Lib::clamp < size_t > ( values.size() * percentile, 1, values.size() ) - 1;
+    std::nth_element( values.begin(), values.begin() + x1, values.end() );
+    return values[x1];
+}
+}
+
+TEST_CASE( "Frame statistics", "[statistics]" ) {
+    std::mt19937 gen( 7 );
+    std::normal_distribution < double > normal( 3.0, 20.0 );
+    std::vector < double > frame1, frame2;
+    for ( int i = 0 ; i < 5000 ; i++ ) {
+        frame1.push_back( normal( gen ) );
+        frame2.push_back( 10 * normal( gen ) );
+    }
+    frame1[10] = std::numeric_limits < double >::quiet_NaN();
+    frame2[20] = std::numeric_limits < double >::infinity();
+
+    std::vector < double > finite;
+    for ( double val : frame1 ) {
+        if ( std::isfinite( val ) ) {
+            finite.push_back( val );
+        }
+    }
+    for ( double val : frame2 ) {
+        if ( std::isfinite( val ) ) {
+            finite.push_back( val );
+        }
+    }
+
+    // frame 2 is added in two blocks
+    Carta::Core::Algorithms::FrameStatisticsAccumulator accumulator;
+    accumulator.add( frame2.data(), 1234 );
+    accumulator.add( frame2.data() + 1234, frame2.size() - 1234 );
+
+    FrameStatistics stats = FrameStatistics::compute( frame1.data(), frame1.size() );
+    REQUIRE( stats.count() == frame1.size() - 1 );
+    stats.merge( accumulator.result() );
+
+    REQUIRE( stats.count() == finite.size() );
+    REQUIRE( stats.min == * std::min_element( finite.begin(), finite.end() ) );
+    REQUIRE( stats.max == * std::max_element( finite.begin(), finite.end() ) );
+
+    SECTION( "percentile brackets contain the exact percentiles" ) {
+        for ( double percentile : { 0.0, 0.001, 0.05, 0.25, 0.5, 0.9, 0.995, 1.0 } ) {
+            double exact = exactPercentile( finite, percentile );
+            std::pair < double, double > bracket = stats.percentileBracket( percentile );
+            REQUIRE( bracket.first <= exact );
+            REQUIRE( exact <= bracket.second );
+        }
+        REQUIRE( stats.percentileBracket( 0 ).first == stats.min );
+        REQUIRE( stats.percentileBracket( 1 ).second == stats.max );
+    }
+
+    SECTION( "serialization" ) {
+        FrameStatistics restored;
+        REQUIRE( FrameStatistics::fromByteArray( stats.toByteArray(), restored ) );
+        REQUIRE( restored.count() == stats.count() );
+        REQUIRE( restored.min == stats.min );
+        REQUIRE( restored.histogram.bins == stats.histogram.bins );
+        REQUIRE( restored.histogram.counts == stats.histogram.counts );
+
+        QByteArray truncated = stats.toByteArray();
+        truncated.chop( 3 );
+        REQUIRE_FALSE( FrameStatistics::fromByteArray( truncated, restored ) );
+    }
+
+    SECTION( "no finite values" ) {
+        std::vector < double > nans( 4, std::numeric_limits < double >::quiet_NaN() );
+        FrameStatistics empty = FrameStatistics::compute( nans.data(), nans.size() );
+        REQUIRE( empty.count() == 0 );
+        REQUIRE( std::isnan( empty.percentileBracket( 0.5 ).first ) );
+    }
+}
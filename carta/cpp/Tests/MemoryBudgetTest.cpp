@@ -0,0 +1,146 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/MemoryBudget.h"
+#include "CartaLib/Algorithms/ContourCache.h"
+#include <QCache>
+
+namespace
+{
+typedef Carta::Lib::MemoryBudget MemoryBudget;
+
+/// QCache of dummy entries, the cost of an entry is its size in bytes
+class TestCache
+{
+public:
+
+    TestCache( MemoryBudget & budget, const QString & name, MemoryBudget::Priority priority )
+        : m_budget( budget )
+    {
+        m_cache.setMaxCost( 1000 * 1000 );
+        m_handle = budget.add( name, priority, MemoryBudget::qCacheUsage( m_cache ),
+                               MemoryBudget::qCacheShrink( m_cache ) );
+    }
+
+    ~TestCache()
+    {
+        m_budget.remove( m_handle );
+    }
+
+    void
+    insert( int key, int bytes )
+    {
+        m_cache.insert( key, new int( key ), bytes );
+        m_budget.touch( m_handle );
+        m_budget.enforce();
+    }
+
+    int
+    bytes() const
+    {
+        return m_cache.totalCost();
+    }
+
+    QCache < int, int > m_cache;
+
+private:
+
+    MemoryBudget & m_budget;
+    MemoryBudget::Handle m_handle;
+};
+}
+
+TEST_CASE( "Memory budget", "[cache]" ) {
+    MemoryBudget budget( 1000 );
+
+    SECTION( "caches within the budget are left alone" ) {
+        TestCache a( budget, "a", MemoryBudget::Priority::Low );
+        TestCache b( budget, "b", MemoryBudget::Priority::Normal );
+        a.insert( 1, 400 );
+        b.insert( 1, 500 );
+        REQUIRE( budget.usedBytes() == 900 );
+        REQUIRE( budget.enforce() == 900 );
+
+        std::vector < MemoryBudget::Usage > usage = budget.usage();
+        REQUIRE( usage.size() == 2 );
+        REQUIRE( usage[0].name == "a" );
+        REQUIRE( usage[0].bytes == 400 );
+        REQUIRE( usage[1].bytes == 500 );
+        REQUIRE( usage[0].evictions == 0 );
+        REQUIRE( usage[1].lastUsed > usage[0].lastUsed );
+    }
+
+    SECTION( "lower priorities are shrunk first" ) {
+        TestCache low( budget, "low", MemoryBudget::Priority::Low );
+        TestCache normal( budget, "normal", MemoryBudget::Priority::Normal );
+        normal.insert( 1, 300 );
+        normal.insert( 2, 300 );
+        low.insert( 1, 300 );
+        normal.insert( 3, 300 );
+        REQUIRE( low.bytes() == 0 );
+        REQUIRE( normal.bytes() == 900 );
+        REQUIRE( budget.usage()[0].evictions == 1 );
+
+        // once the low priority cache is empty, the normal one is shrunk
+        normal.insert( 4, 300 );
+        REQUIRE( normal.bytes() <= 1000 );
+        REQUIRE( normal.m_cache.contains( 4 ) );
+    }
+
+    SECTION( "least recently used caches of the same priority are shrunk first" ) {
+        TestCache a( budget, "a", MemoryBudget::Priority::Normal );
+        TestCache b( budget, "b", MemoryBudget::Priority::Normal );
+        a.insert( 1, 400 );
+        b.insert( 1, 400 );
+        a.insert( 2, 100 );
+        b.insert( 2, 300 );
+        REQUIRE( a.bytes() == 100 );
+        REQUIRE( b.bytes() == 700 );
+    }
+
+    SECTION( "memory that is only accounted for is never shrunk" ) {
+        TestCache cache( budget, "cache", MemoryBudget::Priority::High );
+        MemoryBudget::Handle fixed = budget.add( "fixed", MemoryBudget::Priority::Low,
+                                                 [] () { return uint64_t( 800 ); } );
+        cache.insert( 1, 100 );
+        REQUIRE( cache.bytes() == 100 );
+        cache.insert( 2, 200 );
+        REQUIRE( cache.bytes() <= 200 );
+        REQUIRE( budget.usedBytes() <= 1000 );
+        REQUIRE_FALSE( budget.usage()[1].evictable );
+
+        // room for temporary memory
+        REQUIRE( budget.enforce( 150 ) == 800 );
+        REQUIRE( cache.bytes() == 0 );
+        budget.remove( fixed );
+        REQUIRE( budget.usage().size() == 1 );
+    }
+
+    SECTION( "lowering the budget shrinks the caches" ) {
+        TestCache cache( budget, "cache", MemoryBudget::Priority::Normal );
+        for ( int i = 0 ; i < 10 ; i++ ) {
+            cache.insert( i, 100 );
+        }
+        REQUIRE( cache.bytes() == 1000 );
+        budget.setMaxBytes( 500 );
+        REQUIRE( cache.bytes() <= 500 );
+        REQUIRE( cache.m_cache.maxCost() == 1000 * 1000 );
+    }
+
+    SECTION( "contour cache" ) {
+        Carta::Lib::Algorithms::ContourCache contours( 1024 * 1024 );
+        QPolygonF poly;
+        for ( int i = 0 ; i < 1000 ; i++ ) {
+            poly.append( QPointF( i, i ) );
+        }
+        for ( int i = 0 ; i < 10 ; i++ ) {
+            contours.insert( "view", "No smoothing", i, { poly } );
+        }
+        REQUIRE( contours.memoryUsed() >= 10 * 1000 * sizeof( QPointF ) );
+        contours.shrink( 50 * 1024 );
+        REQUIRE( contours.memoryUsed() <= 50 * 1024 );
+        REQUIRE( contours.stats().entries > 0 );
+    }
+}
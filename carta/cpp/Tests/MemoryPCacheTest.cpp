@@ -0,0 +1,139 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/MemoryPCache.h"
+#include <chrono>
+#include <map>
+#include <thread>
+
+namespace
+{
+// backend that keeps its entries in a map and counts how often it is used
+class CountingPCache : public Carta::Lib::IPCache
+{
+public:
+
+    virtual uint64_t maxStorage() override { return 0; }
+    virtual uint64_t usedStorage() override { return 0; }
+    virtual uint64_t nEntries() override { return m_entries.size(); }
+    virtual void deleteAll() override { m_entries.clear(); }
+
+    virtual bool readEntry( const QByteArray & key, QByteArray & val, QByteArray & error ) override
+    {
+        m_reads++;
+        auto it = m_entries.find( key );
+        if ( it == m_entries.end() ) {
+            return false;
+        }
+        val = it-> second.first;
+        error = it-> second.second;
+        return true;
+    }
+
+    virtual void setEntry( const QByteArray & key, const QByteArray & val, const QByteArray & error ) override
+    {
+        m_writes++;
+        m_entries[key] = std::make_pair( val, error );
+    }
+
+    virtual void Release() override { m_released = true; }
+
+    std::map < QByteArray, std::pair < QByteArray, QByteArray > > m_entries;
+    int m_reads = 0;
+    int m_writes = 0;
+    bool m_released = false;
+};
+}
+
+TEST_CASE( "Memory cache in front of a persistent cache", "[pcache]" ) {
+    auto backend = std::make_shared < CountingPCache > ();
+    backend-> m_entries["a"] = std::make_pair( QByteArray( "1" ), QByteArray( "e" ) );
+
+    SECTION( "hot keys are read from the backend only once" ) {
+        Carta::Lib::MemoryPCache cache( backend, 1024 * 1024, 4, 8 );
+        QByteArray val, error;
+        for ( int i = 0 ; i < 10 ; i++ ) {
+            REQUIRE( cache.readEntry( "a", val, error ) );
+            REQUIRE( val == "1" );
+            REQUIRE( error == "e" );
+            REQUIRE_FALSE( cache.readEntry( "missing", val, error ) );
+        }
+        REQUIRE( backend-> m_reads == 2 );
+        REQUIRE( cache.stats().hits == 18 );
+        REQUIRE( cache.stats().misses == 2 );
+    }
+
+    SECTION( "absent entries are only remembered for a while" ) {
+        Carta::Lib::MemoryPCache cache( backend, 1024 * 1024, 4, 8, 50 );
+        QByteArray val, error;
+        REQUIRE_FALSE( cache.readEntry( "b", val, error ) );
+        REQUIRE_FALSE( cache.readEntry( "b", val, error ) );
+        REQUIRE( backend-> m_reads == 1 );
+
+        // the backend gets the entry from elsewhere
+        backend-> m_entries["b"] = std::make_pair( QByteArray( "3" ), QByteArray() );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 60 ) );
+        REQUIRE( cache.readEntry( "b", val, error ) );
+        REQUIRE( val == "3" );
+        REQUIRE( backend-> m_reads == 2 );
+
+        // found entries do not expire
+        std::this_thread::sleep_for( std::chrono::milliseconds( 60 ) );
+        REQUIRE( cache.readEntry( "b", val, error ) );
+        REQUIRE( backend-> m_reads == 2 );
+
+        Carta::Lib::MemoryPCache uncached( backend, 1024 * 1024, 4, 8, 0 );
+        REQUIRE_FALSE( uncached.readEntry( "c", val, error ) );
+        REQUIRE_FALSE( uncached.readEntry( "c", val, error ) );
+        REQUIRE( backend-> m_reads == 4 );
+    }
+
+    SECTION( "writes are passed on in batches" ) {
+        Carta::Lib::MemoryPCache cache( backend, 1024 * 1024, 4, 8 );
+        for ( int i = 0 ; i < 7 ; i++ ) {
+            cache.setEntry( QByteArray::number( i ), "v", "" );
+        }
+        REQUIRE( backend-> m_writes == 0 );
+        QByteArray val, error;
+        REQUIRE( cache.readEntry( "3", val, error ) );
+        REQUIRE( val == "v" );
+        cache.setEntry( "7", "v", "" );
+        REQUIRE( backend-> m_writes == 8 );
+        cache.setEntry( "a", "2", "" );
+        cache.flush();
+        REQUIRE( backend-> m_entries["a"].first == "2" );
+    }
+
+    SECTION( "evicted entries are read again and pending writes survive eviction" ) {
+        Carta::Lib::MemoryPCache cache( backend, 1024, 1, 1000 );
+        for ( int i = 0 ; i < 100 ; i++ ) {
+            cache.setEntry( QByteArray::number( i ), "v", "" );
+        }
+        REQUIRE( cache.memoryUsed() <= 1024 );
+        REQUIRE( cache.stats().evictions > 0 );
+        QByteArray val, error;
+        REQUIRE( cache.readEntry( "0", val, error ) );
+        REQUIRE( backend-> m_reads == 0 );
+        cache.Release();
+        REQUIRE( backend-> m_released );
+        REQUIRE( backend-> m_entries.size() == 101 );
+    }
+
+    SECTION( "shrinking drops entries but not pending writes" ) {
+        Carta::Lib::MemoryPCache cache( backend, 1024 * 1024, 4, 1000 );
+        for ( int i = 0 ; i < 100 ; i++ ) {
+            cache.setEntry( QByteArray::number( i ), "v", "" );
+        }
+        const uint64_t used = cache.memoryUsed();
+        cache.shrink( used / 2 );
+        REQUIRE( cache.memoryUsed() <= used / 2 );
+        cache.shrink( 0 );
+        REQUIRE( cache.memoryUsed() == 0 );
+        QByteArray val, error;
+        REQUIRE( cache.readEntry( "42", val, error ) );
+        REQUIRE( val == "v" );
+        REQUIRE( backend-> m_reads == 0 );
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "core/Algorithms/floatFrameView.h"
+#include "core/Algorithms/mipmapPyramid.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace
+{
+typedef Carta::Core::Algorithms::FloatFrameView FloatFrameView;
+typedef Carta::Core::Algorithms::MipmapPyramid MipmapPyramid;
+
+/// 5x3 frame, pixel (x,y) holds 10*y + x, except for a NaN at (1,0)
+FloatFrameView
+oddFrame()
+{
+    FloatFrameView::Data data = std::make_shared < std::vector < float > > ();
+    for ( int y = 0 ; y < 3 ; y++ ) {
+        for ( int x = 0 ; x < 5 ; x++ ) {
+            data-> push_back( 10 * y + x );
+        }
+    }
+    ( * data )[1] = std::numeric_limits < float >::quiet_NaN();
+    return FloatFrameView( data, { 5, 3 } );
+}
+
+std::vector < float >
+levelValues( const MipmapPyramid::Level & level )
+{
+    return * level.data;
+}
+}
+
+TEST_CASE( "Mipmap pyramid", "[mipmap]" ) {
+    FloatFrameView frame = oddFrame();
+
+    SECTION( "level sizes round up for odd sizes" ) {
+        REQUIRE( MipmapPyramid::maxLevel( 5, 3 ) == 3 );
+        REQUIRE( MipmapPyramid::maxLevel( 1, 1 ) == 0 );
+        REQUIRE( MipmapPyramid::maxLevel( 1024, 1 ) == 10 );
+
+        MipmapPyramid pyramid;
+        const MipmapPyramid::Level & level1 = pyramid.level( 1, & frame );
+        REQUIRE( level1.width == 3 );
+        REQUIRE( level1.height == 2 );
+        REQUIRE( pyramid.builtLevels() == 1 );
+
+        const MipmapPyramid::Level & level3 = pyramid.level( 3, & frame );
+        REQUIRE( level3.width == 1 );
+        REQUIRE( level3.height == 1 );
+        REQUIRE( pyramid.builtLevels() == 3 );
+        REQUIRE( pyramid.level( 2, nullptr ).width == 2 );
+        REQUIRE( pyramid.level( 2, nullptr ).height == 1 );
+        REQUIRE( pyramid.byteCount() == ( 6 + 2 + 1 ) * int64_t( sizeof( float ) ) );
+
+        std::unique_ptr < Carta::Lib::NdArray::RawViewInterface > view( pyramid.levelView( 1, & frame ) );
+        REQUIRE( view-> dims() == std::vector < int > ( { 3, 2 } ) );
+    }
+
+    SECTION( "mean of the finite values" ) {
+        MipmapPyramid pyramid( MipmapPyramid::Method::Mean );
+        REQUIRE( levelValues( pyramid.level( 1, & frame ) ) ==
+                 std::vector < float > ( { 7, 7.5, 9, 20.5, 22.5, 24 } ) );
+        REQUIRE( levelValues( pyramid.level( 2, & frame ) ) ==
+                 std::vector < float > ( { 14.375, 16.5 } ) );
+        REQUIRE( levelValues( pyramid.level( 3, & frame ) ) ==
+                 std::vector < float > ( { 15.4375 } ) );
+    }
+
+    SECTION( "max of the finite values" ) {
+        MipmapPyramid pyramid( MipmapPyramid::Method::Max );
+        REQUIRE( levelValues( pyramid.level( 1, & frame ) ) ==
+                 std::vector < float > ( { 11, 13, 14, 21, 23, 24 } ) );
+        REQUIRE( levelValues( pyramid.level( 3, & frame ) ) == std::vector < float > ( { 24 } ) );
+    }
+
+    SECTION( "pixels with only NaN inputs are NaN" ) {
+        const float nan = std::numeric_limits < float >::quiet_NaN();
+        FloatFrameView::Data data = std::make_shared < std::vector < float > > (
+            std::vector < float > ( { nan, nan, 5 } ) );
+        FloatFrameView row( data, { 3, 1 } );
+        MipmapPyramid pyramid;
+        std::vector < float > level1 = levelValues( pyramid.level( 1, & row ) );
+        REQUIRE( level1.size() == 2 );
+        REQUIRE( std::isnan( level1[0] ) );
+        REQUIRE( level1[1] == 5 );
+    }
+
+    SECTION( "level for a zoom" ) {
+        REQUIRE( MipmapPyramid::levelForZoom( 2.0, 5 ) == 0 );
+        REQUIRE( MipmapPyramid::levelForZoom( 1.0, 5 ) == 0 );
+        REQUIRE( MipmapPyramid::levelForZoom( 0.5, 5 ) == 1 );
+        REQUIRE( MipmapPyramid::levelForZoom( 0.3, 5 ) == 1 );
+        REQUIRE( MipmapPyramid::levelForZoom( 0.25, 5 ) == 2 );
+        REQUIRE( MipmapPyramid::levelForZoom( 0.001, 3 ) == 3 );
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/MemoryBudget.h"
+#include "core/Algorithms/prefetchCap.h"
+#include <QMap>
+
+namespace
+{
+typedef Carta::Lib::MemoryBudget MemoryBudget;
+typedef Carta::Core::Algorithms::PrefetchCap PrefetchCap;
+
+/// reads frames the way the frame prefetcher does, counting the reads
+class TestPrefetcher
+{
+public:
+
+    TestPrefetcher( MemoryBudget & budget, int64_t frameBytes )
+        : m_budget( budget ),
+          m_frameBytes( frameBytes )
+    {
+        m_handle = budget.add( "frames", MemoryBudget::Priority::Low,
+                               [this] () { return static_cast < uint64_t > ( bytes() ); },
+                               [this] ( uint64_t maxBytes ) { shrink( maxBytes ); } );
+    }
+
+    ~TestPrefetcher()
+    {
+        m_budget.remove( m_handle );
+    }
+
+    /// the animation wants the frames first..first+count-1
+    void
+    prefetch( int first, int count )
+    {
+        m_wanted.clear();
+        for ( int i = first ; i < first + count ; i++ ) {
+            m_wanted.append( QString::number( i ) );
+        }
+        for ( const QString & viewId : m_frames.keys() ) {
+            if ( ! m_wanted.contains( viewId ) ) {
+                m_frames.remove( viewId );
+            }
+        }
+        requestFrames();
+    }
+
+    /// read every wanted frame the cap allows, one at a time, like the finished reads do
+    void
+    requestFrames()
+    {
+        // a budget that never has room would loop forever without the cap
+        for ( int pass = 0 ; pass < 100 ; pass++ ) {
+            const uint64_t used = m_budget.usedBytes();
+            m_cap.track( bytes(), used < m_budget.maxBytes() ? m_budget.maxBytes() - used : 0 );
+            QString next;
+            for ( const QString & viewId : m_wanted ) {
+                if ( ! m_frames.contains( viewId ) && m_cap.allows( bytes(), m_frameBytes ) ) {
+                    next = viewId;
+                    break;
+                }
+            }
+            if ( next.isEmpty() ) {
+                return;
+            }
+            m_reads++;
+            m_frames.insert( next, m_frameBytes );
+            m_budget.touch( m_handle );
+            m_budget.enforce();
+        }
+    }
+
+    int64_t
+    bytes() const
+    {
+        int64_t total = 0;
+        for ( int64_t frameBytes : m_frames.values() ) {
+            total += frameBytes;
+        }
+        return total;
+    }
+
+    QMap < QString, int64_t > m_frames;
+    int m_reads = 0;
+
+private:
+
+    /// drops the frames wanted last first
+    void
+    shrink( uint64_t maxBytes )
+    {
+        for ( int i = m_wanted.size() - 1 ; i >= 0 && static_cast < uint64_t > ( bytes() ) > maxBytes ; i-- ) {
+            m_frames.remove( m_wanted[i] );
+        }
+        m_cap.shrunk( maxBytes );
+    }
+
+    MemoryBudget & m_budget;
+    MemoryBudget::Handle m_handle;
+    int64_t m_frameBytes;
+    QStringList m_wanted;
+    PrefetchCap m_cap;
+};
+}
+
+TEST_CASE( "Prefetch cap", "[cache]" ) {
+    SECTION( "frames are only read once when the budget is smaller than one frame" ) {
+        MemoryBudget budget( 1000 );
+        TestPrefetcher prefetcher( budget, 4000 );
+        prefetcher.prefetch( 0, 4 );
+        REQUIRE( prefetcher.m_reads == 1 );
+        REQUIRE( prefetcher.m_frames.isEmpty() );
+
+        // neither the dropped frame nor the ones after it are read
+        prefetcher.requestFrames();
+        prefetcher.prefetch( 0, 4 );
+        REQUIRE( prefetcher.m_reads == 1 );
+
+        // nor when the animation moves on
+        prefetcher.prefetch( 1, 4 );
+        prefetcher.prefetch( 2, 4 );
+        REQUIRE( prefetcher.m_reads == 1 );
+        REQUIRE( budget.usedBytes() == 0 );
+    }
+
+    SECTION( "the frames stay within what the budget left room for" ) {
+        MemoryBudget budget( 2500 );
+        TestPrefetcher prefetcher( budget, 1000 );
+        prefetcher.prefetch( 0, 4 );
+        REQUIRE( prefetcher.m_reads == 3 );
+        REQUIRE( prefetcher.m_frames.size() == 2 );
+        REQUIRE( prefetcher.m_frames.contains( "0" ) );
+        REQUIRE( prefetcher.m_frames.contains( "1" ) );
+
+        // showing a frame makes room for the dropped one
+        prefetcher.prefetch( 1, 4 );
+        REQUIRE( prefetcher.m_reads == 4 );
+        REQUIRE( prefetcher.m_frames.contains( "2" ) );
+        REQUIRE( budget.usedBytes() <= 2500 );
+    }
+
+    SECTION( "the cap grows once the budget has room again" ) {
+        MemoryBudget budget( 1000 );
+        TestPrefetcher prefetcher( budget, 4000 );
+        prefetcher.prefetch( 0, 2 );
+        REQUIRE( prefetcher.m_reads == 1 );
+
+        budget.setMaxBytes( 10000 );
+        prefetcher.requestFrames();
+        REQUIRE( prefetcher.m_reads == 3 );
+        REQUIRE( prefetcher.m_frames.size() == 2 );
+    }
+}
@@ -0,0 +1,159 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/QImageCompositor.h"
+#include <random>
+
+namespace
+{
+typedef Carta::Lib::QImageCompositor QImageCompositor;
+
+QImage
+randomImage( int width, int height, QImage::Format format, unsigned seed )
+{
+    std::mt19937 gen( seed );
+    std::uniform_int_distribution < int > dist( 0, 255 );
+    QImage img( width, height, format );
+    for ( int y = 0 ; y < height ; y++ ) {
+        for ( int x = 0 ; x < width ; x++ ) {
+            int a = dist( gen );
+            int r = dist( gen );
+            int g = dist( gen );
+            int b = dist( gen );
+            if ( format == QImage::Format_ARGB32_Premultiplied ) {
+                r = r * a / 255;
+                g = g * a / 255;
+                b = b * a / 255;
+            }
+            img.setPixel( x, y, qRgba( r, g, b, a ) );
+        }
+    }
+    return img;
+}
+
+/// the pixels of a layer after masking, the way the compositor reads them: premultiplied
+/// pixels are masked in place if the mask keeps their alpha, others as non-premultiplied ARGB
+QImage
+maskedImage( const QImageCompositor::Layer & layer )
+{
+    const quint32 mask = layer.blend.mask;
+    QImage img = layer.image.format() == QImage::Format_ARGB32_Premultiplied && ( mask >> 24 ) == 0xff
+                 ? layer.image.copy() : layer.image.convertToFormat( QImage::Format_ARGB32 );
+    for ( int y = 0 ; y < img.height() ; y++ ) {
+        quint32 * row = reinterpret_cast < quint32 * > ( img.scanLine( y ) );
+        for ( int x = 0 ; x < img.width() ; x++ ) {
+            row[x] &= mask;
+        }
+    }
+    return img;
+}
+
+/// paint the masked layers with QPainter, which the compositor has to match
+QImage
+painterReference( const QImage & background, const std::vector < QImageCompositor::Layer > & layers )
+{
+    QImage result = background.copy();
+    QPainter painter( & result );
+    for ( const auto & layer : layers ) {
+        QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver;
+        if ( layer.blend.mode == QImageCompositor::Mode::Plus ) {
+            compositionMode = QPainter::CompositionMode_Plus;
+        }
+        else if ( layer.blend.mode == QImageCompositor::Mode::Source ) {
+            compositionMode = QPainter::CompositionMode_Source;
+        }
+        painter.setCompositionMode( compositionMode );
+        painter.setOpacity( layer.blend.alpha );
+        painter.drawImage( 0, 0, maskedImage( layer ) );
+    }
+    painter.end();
+    return result;
+}
+
+/// largest difference of any channel of any pixel
+int
+maxDifference( const QImage & a, const QImage & b )
+{
+    int diff = 0;
+    for ( int y = 0 ; y < a.height() ; y++ ) {
+        for ( int x = 0 ; x < a.width() ; x++ ) {
+            QRgb p = a.pixel( x, y );
+            QRgb q = b.pixel( x, y );
+            diff = std::max( diff, std::abs( qAlpha( p ) - qAlpha( q ) ) );
+            diff = std::max( diff, std::abs( qRed( p ) - qRed( q ) ) );
+            diff = std::max( diff, std::abs( qGreen( p ) - qGreen( q ) ) );
+            diff = std::max( diff, std::abs( qBlue( p ) - qBlue( q ) ) );
+        }
+    }
+    return diff;
+}
+}
+
+TEST_CASE( "Compositing layers", "[compositor]" ) {
+    const int width = 301;
+    const int height = 257;
+
+    std::vector < QImageCompositor::Layer > layers( 6 );
+    const QImage::Format formats[] = {
+        QImage::Format_ARGB32, QImage::Format_ARGB32_Premultiplied, QImage::Format_RGB32
+    };
+    const QImageCompositor::Mode modes[] = {
+        QImageCompositor::Mode::SourceOver, QImageCompositor::Mode::Plus
+    };
+    // the masks of premultiplied layers (1 and 4) keep the alpha, so they are used in place
+    const quint32 masks[] = { 0xffff0000, 0xff00ff00, 0x000000ff, 0x80ffffff, 0xffffffff, 0xff0000ff };
+    for ( size_t i = 0 ; i < layers.size() ; i++ ) {
+        // the layers do not all cover the whole destination
+        layers[i].image = randomImage( width - 7 * i, height - 5 * i, formats[i % 3], i + 1 );
+        layers[i].blend.mode = modes[i % 2];
+        layers[i].blend.mask = masks[i];
+        layers[i].blend.alpha = 1.0 - 0.15 * i;
+    }
+    layers.back().blend.mode = QImageCompositor::Mode::Source;
+
+    QImage background = randomImage( width, height, QImage::Format_ARGB32_Premultiplied, 99 );
+
+    QImage expected = painterReference( background, layers );
+
+    for ( int nThreads : { 1, 4 } ) {
+        QImage result = background.copy();
+        QImageCompositor::composite( result, layers, nThreads );
+        // QPainter rounds the premultiplication and the blending a little differently
+        REQUIRE( maxDifference( result, expected ) <= 3 );
+    }
+
+    SECTION( "partially opaque layers in every mode" ) {
+        for ( QImageCompositor::Mode mode : { QImageCompositor::Mode::Source,
+                                              QImageCompositor::Mode::SourceOver,
+                                              QImageCompositor::Mode::Plus } ) {
+            std::vector < QImageCompositor::Layer > single( 1, layers[0] );
+            single[0].blend.mode = mode;
+            single[0].blend.alpha = 0.4;
+            QImage result = background.copy();
+            QImageCompositor::composite( result, single );
+            REQUIRE( maxDifference( result, painterReference( background, single ) ) <= 3 );
+        }
+    }
+
+    SECTION( "transparent and empty layers change nothing" ) {
+        std::vector < QImageCompositor::Layer > none( 3 );
+        none[0].image = layers[0].image;
+        none[0].blend.alpha = 0.0;
+        none[1].image = layers[1].image;
+        none[1].blend.mode = QImageCompositor::Mode::Source;
+        none[1].blend.alpha = 0.0;
+        QImage result = background.copy();
+        QImageCompositor::composite( result, none );
+        REQUIRE( result == background );
+    }
+
+    SECTION( "modes of QPainter" ) {
+        QImageCompositor::Mode mode;
+        REQUIRE( QImageCompositor::modeFromComposition( QPainter::CompositionMode_Plus, mode ) );
+        REQUIRE( mode == QImageCompositor::Mode::Plus );
+        REQUIRE( QImageCompositor::modeFromComposition( QPainter::CompositionMode_SourceOver, mode ) );
+        REQUIRE( mode == QImageCompositor::Mode::SourceOver );
+    }
+}
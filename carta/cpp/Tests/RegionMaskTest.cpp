@@ -0,0 +1,145 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/Regions/Ellipse.h"
+#include "CartaLib/Regions/Rectangle.h"
+#include "CartaLib/Regions/RegionMask.h"
+
+#include <functional>
+
+namespace
+{
+typedef Carta::Lib::Regions::RegionMask RegionMask;
+
+/// number of pixels of the mask that differ from the expected ones
+int
+mismatches( const RegionMask & mask, std::function < bool ( int, int ) > expected )
+{
+    int bad = 0;
+    int64_t count = 0;
+    for ( int y = 0 ; y < mask.height() ; y++ ) {
+        for ( int x = 0 ; x < mask.width() ; x++ ) {
+            count += expected( x, y );
+            if ( mask.contains( x, y ) != expected( x, y ) ) {
+                bad++;
+            }
+        }
+    }
+    return bad + std::abs( count - mask.pixelCount() );
+}
+
+/// whether the runs are sorted, disjoint and inside the plane
+bool
+validRuns( const RegionMask & mask )
+{
+    const RegionMask::Run * prev = nullptr;
+    for ( const RegionMask::Run & run : mask.runs() ) {
+        if ( run.y < 0 || run.y >= mask.height() || run.x0 < 0 || run.x0 >= run.x1 ||
+             run.x1 > mask.width() ) {
+            return false;
+        }
+        if ( prev && ( prev-> y > run.y || ( prev-> y == run.y && prev-> x1 >= run.x0 ) ) ) {
+            return false;
+        }
+        prev = & run;
+    }
+    return true;
+}
+}
+
+TEST_CASE( "Region masks", "[regions]" ) {
+    SECTION( "rectangles cover the pixels between their rounded corners" ) {
+        RegionMask::SharedPtr mask = RegionMask::fromRect( QRectF( 1.2, 2.6, 3.0, 1.0 ), 10, 8 );
+        REQUIRE( validRuns( * mask ) );
+        REQUIRE( mask-> pixelCount() == 8 );
+        REQUIRE( mask-> boundingRect() == QRect( 1, 3, 4, 2 ) );
+        REQUIRE( mismatches( * mask, [] ( int x, int y ) {
+                                 return x >= 1 && x <= 4 && y >= 3 && y <= 4;
+                             } ) == 0 );
+    }
+
+    SECTION( "ellipses are clipped to the plane" ) {
+        RegionMask::SharedPtr mask = RegionMask::fromEllipse( QRectF( - 5.3, 2.2, 30.4, 40.1 ), 40, 30 );
+        REQUIRE( validRuns( * mask ) );
+        REQUIRE( mask-> pixelCount() > 0 );
+        REQUIRE( mismatches( * mask, [] ( int x, int y ) {
+                                 double dx = ( x - 9.9 ) / 15.2;
+                                 double dy = ( y - 22.25 ) / 20.05;
+                                 return dx * dx + dy * dy <= 1;
+                             } ) == 0 );
+    }
+
+    SECTION( "polygons use the non-zero winding rule" ) {
+        // a pentagram, whose center is inside with the non-zero rule only
+        QPolygonF star;
+        star << QPointF( 20.13, 1.37 ) << QPointF( 31.71, 36.29 ) << QPointF( 1.43, 14.61 )
+             << QPointF( 38.77, 14.53 ) << QPointF( 8.31, 36.17 );
+        Carta::Lib::Regions::Polygon polygon;
+        polygon.setqpolyf( star );
+        RegionMask::SharedPtr mask = RegionMask::fromRegion( polygon, 40, 40 );
+        REQUIRE( validRuns( * mask ) );
+        REQUIRE( mask-> contains( 20, 20 ) );
+        REQUIRE( mismatches( * mask, [&polygon] ( int x, int y ) {
+                                 return polygon.isPointInside( { QPointF( x, y ) } );
+                             } ) == 0 );
+    }
+
+    SECTION( "unions merge the masks of their children" ) {
+        Carta::Lib::Regions::Union both;
+        Carta::Lib::Regions::Rectangle * rect = new Carta::Lib::Regions::Rectangle( & both );
+        rect-> setRectangle( QRectF( 2, 2, 10, 4 ) );
+        both.addChild( new Carta::Lib::Regions::Ellipse( QPointF( 10, 6 ), 5, 3, 0 ) );
+        RegionMask::SharedPtr mask = RegionMask::fromRegion( both, 20, 12 );
+        RegionMask::SharedPtr rectMask = RegionMask::fromRegion( * rect, 20, 12 );
+        RegionMask::SharedPtr ellipseMask = RegionMask::fromRegion( * both.children()[1], 20, 12 );
+        REQUIRE( validRuns( * mask ) );
+        REQUIRE( mask-> pixelCount() < rectMask-> pixelCount() + ellipseMask-> pixelCount() );
+        REQUIRE( mismatches( * mask, [&] ( int x, int y ) {
+                                 return rectMask-> contains( x, y ) || ellipseMask-> contains( x, y );
+                             } ) == 0 );
+    }
+
+    SECTION( "regions outside of the plane have empty masks" ) {
+        RegionMask::SharedPtr mask = RegionMask::fromRect( QRectF( 50, 50, 10, 10 ), 20, 20 );
+        REQUIRE( mask-> isEmpty() );
+        REQUIRE( mask-> pixelCount() == 0 );
+        REQUIRE( mask-> boundingRect().isEmpty() );
+        REQUIRE( RegionMask::fromPoint( QPointF( - 3, 4 ), 20, 20 )-> isEmpty() );
+    }
+
+    SECTION( "the revision only depends on the geometry" ) {
+        Carta::Lib::Regions::Rectangle a, b;
+        a.setRectangle( QRectF( 1, 2, 3, 4 ) );
+        b.setRectangle( QRectF( 1, 2, 3, 4 ) );
+        b.setLineColor( QColor( 10, 20, 30 ) );
+        REQUIRE( RegionMask::revision( a ) == RegionMask::revision( b ) );
+        b.setRectangle( QRectF( 1, 2, 3, 5 ) );
+        REQUIRE( RegionMask::revision( a ) != RegionMask::revision( b ) );
+    }
+
+    SECTION( "the cache scan converts each revision once" ) {
+        Carta::Lib::Regions::RegionMaskCache cache( 1024 * 1024 );
+        Carta::Lib::Regions::Ellipse ellipse( QPointF( 30, 30 ), 20, 10, 0 );
+        RegionMask::ConstSharedPtr first = cache.mask( ellipse, 64, 64 );
+        REQUIRE( cache.mask( ellipse, 64, 64 ) == first );
+        REQUIRE( cache.mask( ellipse, 64, 32 ) != first );
+        REQUIRE( cache.stats().hits == 1 );
+        REQUIRE( cache.stats().misses == 2 );
+        REQUIRE( cache.memoryUsed() > 0 );
+
+        cache.shrink( 0 );
+        REQUIRE( cache.stats().entries == 0 );
+        REQUIRE( first-> pixelCount() > 0 );
+    }
+
+    SECTION( "the plugins share one cache" ) {
+        Carta::Lib::Regions::RegionMaskCache & shared = Carta::Lib::Regions::RegionMaskCache::shared();
+        REQUIRE( & shared == & Carta::Lib::Regions::RegionMaskCache::shared() );
+        Carta::Lib::Regions::Ellipse ellipse( QPointF( 10, 12 ), 5, 3, 0 );
+        RegionMask::ConstSharedPtr mask = shared.mask( ellipse, 32, 32 );
+        REQUIRE( Carta::Lib::Regions::RegionMaskCache::shared().mask( ellipse, 32, 32 ) == mask );
+        shared.clear();
+    }
+}
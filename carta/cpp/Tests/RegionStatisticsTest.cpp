@@ -0,0 +1,154 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/Regions/Ellipse.h"
+#include "CartaLib/Regions/RegionStatistics.h"
+
+#include <cmath>
+
+namespace
+{
+typedef Carta::Lib::Regions::RegionMask RegionMask;
+typedef Carta::Lib::Regions::RegionStatistics RegionStatistics;
+
+/// a plane with varying values, some repeated, and a few NaNs
+std::vector < float >
+testPlane( int width, int height )
+{
+    std::vector < float > plane( int64_t( width ) * height );
+    for ( int y = 0 ; y < height ; y++ ) {
+        for ( int x = 0 ; x < width ; x++ ) {
+            float v = std::round( 10 * std::sin( x * 0.37 ) * std::cos( y * 0.21 ) );
+            if ( ( x * 7 + y * 3 ) % 41 == 0 ) {
+                v = std::numeric_limits < float >::quiet_NaN();
+            }
+            plane[int64_t( y ) * width + x] = v;
+        }
+    }
+    return plane;
+}
+
+/// statistics of the pixels of a mask, one pixel at a time in row major order
+RegionStatistics
+bruteForce( const RegionMask & mask, const std::vector < float > & plane )
+{
+    RegionStatistics stats;
+    for ( int y = 0 ; y < mask.height() ; y++ ) {
+        for ( int x = 0 ; x < mask.width() ; x++ ) {
+            double v = plane[int64_t( y ) * mask.width() + x];
+            if ( ! mask.contains( x, y ) || std::isnan( v ) ) {
+                continue;
+            }
+            if ( stats.count == 0 || v < stats.min ) {
+                stats.min = v;
+                stats.minX = x;
+                stats.minY = y;
+            }
+            if ( stats.count == 0 || v > stats.max ) {
+                stats.max = v;
+                stats.maxX = x;
+                stats.maxY = y;
+            }
+            stats.count++;
+            stats.sum += v;
+            stats.sumSq += v * v;
+        }
+    }
+    return stats;
+}
+
+/// reduce the masks, reading the bounding rectangle in blocks of rows, bottom to top
+std::vector < RegionStatistics >
+reduce( const std::vector < RegionMask::ConstSharedPtr > & masks, const std::vector < float > & plane,
+        int width, int blockRows, int nThreads )
+{
+    Carta::Lib::Regions::RegionStatisticsReducer reducer( masks );
+    reducer.setThreadCount( nThreads );
+    QRect box = reducer.boundingRect();
+    std::vector < float > block;
+    for ( int y0 = box.top() + ( box.height() - 1 ) / blockRows * blockRows ; y0 >= box.top() ;
+          y0 -= blockRows ) {
+        int rows = std::min( blockRows, box.bottom() + 1 - y0 );
+        block.clear();
+        for ( int y = y0 ; y < y0 + rows ; y++ ) {
+            const float * row = & plane[int64_t( y ) * width + box.left()];
+            block.insert( block.end(), row, row + box.width() );
+        }
+        reducer.add( y0, rows, block.data() );
+    }
+    return reducer.result();
+}
+
+bool
+sameStatistics( const RegionStatistics & a, const RegionStatistics & b )
+{
+    return a.count == b.count && a.min == b.min && a.max == b.max && a.minX == b.minX &&
+           a.minY == b.minY && a.maxX == b.maxX && a.maxY == b.maxY &&
+           std::abs( a.sum - b.sum ) < 1e-9 && std::abs( a.sumSq - b.sumSq ) < 1e-9;
+}
+}
+
+TEST_CASE( "Region statistics", "[regions]" ) {
+    const int width = 300;
+    const int height = 200;
+    std::vector < float > plane = testPlane( width, height );
+
+    std::vector < RegionMask::ConstSharedPtr > masks;
+    masks.push_back( RegionMask::fromRect( QRectF( 10.2, 5.7, 120, 80 ), width, height ) );
+    masks.push_back( RegionMask::fromEllipse( QRectF( 60, 40, 200, 150 ), width, height ) );
+    masks.push_back( RegionMask::fromPoint( QPointF( 250, 20 ), width, height ) );
+    QPolygonF triangle;
+    triangle << QPointF( 5, 190 ) << QPointF( 290, 150 ) << QPointF( 100, 60 );
+    masks.push_back( RegionMask::fromPolygon( triangle, width, height ) );
+    masks.push_back( RegionMask::fromRect( QRectF( 500, 500, 10, 10 ), width, height ) );
+
+    SECTION( "one pass gives the statistics of every region" ) {
+        std::vector < RegionStatistics > stats = reduce( masks, plane, width, 16, 4 );
+        REQUIRE( stats.size() == masks.size() );
+        for ( size_t i = 0 ; i < masks.size() ; i++ ) {
+            REQUIRE( sameStatistics( stats[i], bruteForce( * masks[i], plane ) ) );
+        }
+        REQUIRE( stats[2].count == 1 );
+        REQUIRE( stats[2].sigma() == 0 );
+        REQUIRE( stats[4].count == 0 );
+        REQUIRE( stats[4].minX == - 1 );
+        REQUIRE( std::isnan( stats[4].mean() ) );
+    }
+
+    SECTION( "results do not depend on the threads or the blocks" ) {
+        std::vector < RegionStatistics > serial = reduce( masks, plane, width, height, 1 );
+        std::vector < RegionStatistics > parallel = reduce( masks, plane, width, 3, 8 );
+        for ( size_t i = 0 ; i < masks.size() ; i++ ) {
+            REQUIRE( sameStatistics( serial[i], parallel[i] ) );
+        }
+    }
+
+    SECTION( "mean, rms and sigma" ) {
+        RegionStatistics stats;
+        stats.count = 4;
+        stats.sum = 2 + 4 + 4 + 6;
+        stats.sumSq = 4 + 16 + 16 + 36;
+        REQUIRE( stats.mean() == 4 );
+        REQUIRE( std::abs( stats.rms() - std::sqrt( 18.0 ) ) < 1e-12 );
+        REQUIRE( std::abs( stats.sigma() - std::sqrt( 8.0 / 3 ) ) < 1e-12 );
+    }
+
+    SECTION( "the cache is keyed by image, revision and plane" ) {
+        Carta::Lib::Regions::RegionStatisticsCache cache( 10 );
+        Carta::Lib::Regions::Ellipse ellipse( QPointF( 30, 30 ), 20, 10, 0 );
+        QByteArray revision = RegionMask::revision( ellipse );
+        RegionStatistics stats;
+        stats.count = 3;
+        cache.insert( "a.fits", revision, { - 1, - 1, 2 }, stats );
+
+        RegionStatistics found;
+        REQUIRE( cache.find( "a.fits", revision, { - 1, - 1, 2 }, found ) );
+        REQUIRE( found.count == 3 );
+        REQUIRE_FALSE( cache.find( "a.fits", revision, { - 1, - 1, 3 }, found ) );
+        REQUIRE_FALSE( cache.find( "b.fits", revision, { - 1, - 1, 2 }, found ) );
+        cache.clear();
+        REQUIRE_FALSE( cache.find( "a.fits", revision, { - 1, - 1, 2 }, found ) );
+    }
+}
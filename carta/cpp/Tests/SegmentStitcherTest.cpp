@@ -0,0 +1,60 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "CartaLib/Algorithms/SegmentStitcher.h"
+
+using namespace Carta::Lib::Algorithms;
+
+TEST_CASE( "Segment stitcher testing", "[polyline]" ) {
+
+    SECTION( "empty input") {
+        REQUIRE( SegmentStitcher::stitch( {} ).size() == 0);
+    }
+
+    SECTION( "single line segment") {
+        auto res = SegmentStitcher::stitch( { 0, 0, 1, 1 } );
+        REQUIRE( res.size() == 1);
+        REQUIRE( res[0].size() == 2);
+    }
+
+    SECTION( "two disconnected line segments") {
+        auto res = SegmentStitcher::stitch( { 0, 0, 1, 1, 2.2, 3.3, 5, 1 } );
+        REQUIRE( res.size() == 2);
+        REQUIRE( res[0].size() == 2);
+        REQUIRE( res[1].size() == 2);
+    }
+
+    SECTION( "three connected line segments, in any order and orientation") {
+        // A(0,0) - B(1,1) - C(5,1) - D(2,2), given as C-B, D-C, A-B
+        auto res = SegmentStitcher::stitch( { 5, 1, 1, 1, 2, 2, 5, 1, 0, 0, 1, 1 } );
+        REQUIRE( res.size() == 1);
+        REQUIRE( res[0].size() == 4);
+        QPolygonF expected;
+        expected << QPointF( 2, 2 ) << QPointF( 5, 1 ) << QPointF( 1, 1 ) << QPointF( 0, 0 );
+        QPolygonF reversed;
+        reversed << QPointF( 0, 0 ) << QPointF( 1, 1 ) << QPointF( 5, 1 ) << QPointF( 2, 2 );
+        REQUIRE( ( res[0] == expected || res[0] == reversed ) );
+    }
+
+    SECTION( "triangle") {
+        auto res = SegmentStitcher::stitch( { 2, 2, 1, 1, 2, 2, 3, 1, 1, 1, 3, 1 } );
+        REQUIRE( res.size() == 1);
+        REQUIRE( res[0].size() == 4);
+        REQUIRE( res[0].isClosed());
+    }
+
+    SECTION( "negative zero is the same point as zero") {
+        auto res = SegmentStitcher::stitch( { -1, 0.0, 0, 1, 0, 1, 1, -0.0 } );
+        REQUIRE( res.size() == 1);
+        REQUIRE( res[0].size() == 3);
+    }
+
+    SECTION( "more than two segments at a point") {
+        auto res = SegmentStitcher::stitch( { 0, 0, 1, 1, 1, 1, 2, 0, 1, 1, 1, 2 } );
+        REQUIRE( res.size() == 2);
+        int nPoints = res[0].size() + res[1].size();
+        REQUIRE( nPoints == 5);
+    }
+}
@@ -5,6 +5,7 @@
 QT      +=  core
 HEADERS += \
     catch.h \
+    conrecSerial.h \
     quantileTestCommon.h
 
 SOURCES += \
@@ -14,7 +15,24 @@ SOURCES += \
     StateTester.cpp \
     pixelPipelineTest.cpp \
     LineCombinerTest.cpp \
-    quantileTest.cpp
+    quantileTest.cpp \
+    rasterRenderTest.cpp \
+    MemoryPCacheTest.cpp \
+    ContourConrecTest.cpp \
+    conrecSerial.cpp \
+    SegmentStitcherTest.cpp \
+    ContourCacheTest.cpp \
+    MemoryBudgetTest.cpp \
+    QImageCompositorTest.cpp \
+    FrameSequenceTest.cpp \
+    FrameStatisticsTest.cpp \
+    FloatFrameViewTest.cpp \
+    TypedViewTest.cpp \
+    RegionMaskTest.cpp \
+    RegionStatisticsTest.cpp \
+    MipmapPyramidTest.cpp \
+    TileGridTest.cpp \
+    PrefetchCapTest.cpp
 
 #CONFIG += precompile_header
 #PRECOMPILED_HEADER = catch.h
@@ -0,0 +1,124 @@
+#include "catch.h"
+#include "core/Algorithms/tileGrid.h"
+#include "core/Algorithms/rasterRender.h"
+#include "core/Algorithms/floatFrameView.h"
+#include "CartaLib/PixelPipeline/CustomizablePixelPipeline.h"
+#include "core/GrayColormap.h"
+#include <QImage>
+#include <memory>
+#include <random>
+
+namespace TileGrid = Carta::Core::Algorithms::TileGrid;
+namespace RasterRender = Carta::Core::Algorithms::RasterRender;
+
+/// the tile rectangle, cropped out of an image rendered bottom-up, compares equal
+static bool
+sameAsCrop( const QImage & tileImage, const QImage & full, const QRect & rect )
+{
+    if ( tileImage.width() != rect.width() || tileImage.height() != rect.height() ) {
+        return false;
+    }
+    for ( int y = 0 ; y < rect.height() ; y++ ) {
+        for ( int x = 0 ; x < rect.width() ; x++ ) {
+            QRgb tilePixel = tileImage.pixel( x, rect.height() - 1 - y );
+            QRgb fullPixel = full.pixel( rect.left() + x, full.height() - 1 - ( rect.top() + y ) );
+            if ( tilePixel != fullPixel ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST_CASE( "Tile geometry", "[tiles]" ) {
+    const int width = 37, height = 23, size = 8;
+
+    SECTION( "edges between pixels only make the pixels on the inside visible" ) {
+        // pixels 8..15 and 0..7 cover [7.5, 15.5] and [-0.5, 7.5]
+        REQUIRE( TileGrid::tilesCovering( QRectF( 7.5, - 0.5, 8, 8 ), width, height, size, 0 ) ==
+                 QRect( 1, 0, 1, 1 ) );
+        REQUIRE( TileGrid::tilesCovering( QRectF( 7.4, - 0.5, 8, 8.1 ), width, height, size, 0 ) ==
+                 QRect( 0, 0, 2, 2 ) );
+        // a flipped rectangle covers the same tiles
+        REQUIRE( TileGrid::tilesCovering( QRectF( 15.5, 7.5, - 8, - 8 ), width, height, size, 0 ) ==
+                 QRect( 1, 0, 1, 1 ) );
+    }
+
+    SECTION( "tiles are clamped to the frame, with or without margin" ) {
+        REQUIRE( TileGrid::tilesCovering( QRectF( - 100, - 100, 1000, 1000 ), width, height, size, 0 ) ==
+                 QRect( 0, 0, 5, 3 ) );
+        REQUIRE( TileGrid::tilesCovering( QRectF( 20, 10, 1, 1 ), width, height, size, 1 ) ==
+                 QRect( 1, 0, 3, 3 ) );
+        REQUIRE( TileGrid::tilesCovering( QRectF( 35, 21, 10, 10 ), width, height, size, 2 ) ==
+                 QRect( 2, 0, 3, 3 ) );
+    }
+
+    SECTION( "nothing is visible" ) {
+        REQUIRE( TileGrid::tilesCovering( QRectF( 36.5, 0, 10, 10 ), width, height, size, 1 ).isEmpty() );
+        REQUIRE( TileGrid::tilesCovering( QRectF( - 10, - 10, 9.5, 5 ), width, height, size, 1 ).isEmpty() );
+        REQUIRE( TileGrid::tilesCovering( QRectF( 0, 22.5, 10, 10 ), width, height, size, 1 ).isEmpty() );
+    }
+
+    SECTION( "the tiles at the edges are clipped to the frame" ) {
+        REQUIRE( TileGrid::tileRect( 0, 0, width, height, size ) == QRect( 0, 0, 8, 8 ) );
+        REQUIRE( TileGrid::tileRect( 4, 1, width, height, size ) == QRect( 32, 8, 5, 8 ) );
+        REQUIRE( TileGrid::tileRect( 4, 2, width, height, size ) == QRect( 32, 16, 5, 7 ) );
+        REQUIRE( TileGrid::tilesRect( QRect( 1, 1, 4, 2 ), width, height, size ) ==
+                 QRect( 8, 8, 29, 15 ) );
+        REQUIRE( TileGrid::tilesRect( QRect(), width, height, size ).isEmpty() );
+    }
+}
+
+TEST_CASE( "Tiles render the same as the cropped frame", "[tiles]" ) {
+    const int width = 37, height = 23, size = 8;
+    auto pixels = std::make_shared < std::vector < float > > ( width * height );
+    std::mt19937 gen( 11 );
+    std::normal_distribution < float > dist( 0.0, 3.0 );
+    for ( auto & x : * pixels ) {
+        x = dist( gen );
+    }
+    for ( size_t i = 0 ; i < pixels-> size() ; i += 13 ) {
+        ( * pixels )[i] = std::numeric_limits < float >::quiet_NaN();
+    }
+    Carta::Core::Algorithms::FloatFrameView view( pixels, { width, height } );
+
+    auto pp = std::make_shared < Carta::Lib::PixelPipeline::CustomizablePixelPipeline > ();
+    pp-> setColormap( std::make_shared < Carta::Core::GrayColormap > () );
+    pp-> setMinMax( - 4, 5 );
+    Carta::Lib::PixelPipeline::CachedPipeline < false > cpp;
+    cpp.cache( * pp, 1000, - 4, 5 );
+    const QRgb nanColor = qRgb( 255, 0, 0 );
+
+    QImage full( width, height, QImage::Format_ARGB32 );
+    RasterRender::view2qImage( & view, cpp, full, nanColor );
+
+    SECTION( "tiles sliced from the view" ) {
+        for ( int ty = 0 ; ty <= ( height - 1 ) / size ; ty++ ) {
+            for ( int tx = 0 ; tx <= ( width - 1 ) / size ; tx++ ) {
+                QRect rect = TileGrid::tileRect( tx, ty, width, height, size );
+                SliceND slice;
+                slice.start( rect.left() ).end( rect.right() + 1 )
+                    .next().start( rect.top() ).end( rect.bottom() + 1 );
+                std::unique_ptr < Carta::Lib::NdArray::RawViewInterface > tileView( view.getView( slice ) );
+                QImage tileImage( rect.width(), rect.height(), QImage::Format_ARGB32 );
+                RasterRender::view2qImage( tileView.get(), cpp, tileImage, nanColor );
+                REQUIRE( sameAsCrop( tileImage, full, rect ) );
+            }
+        }
+    }
+
+    SECTION( "tiles cropped from the indices of the frame" ) {
+        std::vector < uint16_t > indices;
+        RasterRender::view2indices( & view, cpp, indices );
+        for ( int ty = 0 ; ty <= ( height - 1 ) / size ; ty++ ) {
+            for ( int tx = 0 ; tx <= ( width - 1 ) / size ; tx++ ) {
+                QRect rect = TileGrid::tileRect( tx, ty, width, height, size );
+                std::vector < uint16_t > tileIndices;
+                TileGrid::cropIndices( indices, width, rect, tileIndices );
+                QImage tileImage( rect.width(), rect.height(), QImage::Format_ARGB32 );
+                RasterRender::indices2qImage( tileIndices, cpp, tileImage, nanColor );
+                REQUIRE( sameAsCrop( tileImage, full, rect ) );
+            }
+        }
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ *
+ **/
+
+#include "catch.h"
+#include "quantileTestCommon.h"
+
+#include <cmath>
+#include <numeric>
+
+TEST_CASE( "Block conversion of typed views", "[typedview]" ) {
+
+    SECTION( "pixels of another type are converted" ) {
+        std::vector < int16_t > data( 1000 );
+        std::iota( data.begin(), data.end(), -500 );
+        TestRawView < int16_t > raw( data, { 10, 100 } );
+        Carta::Lib::NdArray::Double view( & raw, false );
+
+        std::vector < double > seen;
+        int64_t blocks = 0;
+        view.forEachBlock( [&] ( const double * vals, int64_t count ) {
+            REQUIRE( count <= 64 );
+            seen.insert( seen.end(), vals, vals + count );
+            blocks++;
+        }, 64 );
+        REQUIRE( blocks == 16 );
+        REQUIRE( seen == std::vector < double > ( data.begin(), data.end() ) );
+    }
+
+    SECTION( "pixels of the same type are passed through" ) {
+        std::vector < float > data = { 1.5f, NAN, -2.0f, 7.25f };
+        TestRawView < float > raw( data, { 4 } );
+        Carta::Lib::NdArray::Float view( & raw, false );
+
+        std::vector < float > seen;
+        view.forEachBlock( [&] ( const float * vals, int64_t count ) {
+            seen.insert( seen.end(), vals, vals + count );
+        } );
+        REQUIRE( seen.size() == data.size() );
+        REQUIRE( seen[0] == 1.5f );
+        REQUIRE( std::isnan( seen[1] ) );
+        REQUIRE( seen[3] == 7.25f );
+    }
+
+    SECTION( "raw blocks" ) {
+        std::vector < int64_t > data = { -3, 0, 1LL << 40 };
+        std::vector < double > converted( data.size() );
+        REQUIRE( Carta::Lib::convertPixels < double > (
+                     Carta::Lib::Image::PixelType::Int64, reinterpret_cast < const char * > ( data.data() ),
+                     data.size(), converted.data() ) );
+        REQUIRE( converted == std::vector < double > ( { -3.0, 0.0, double( 1LL << 40 ) } ) );
+        REQUIRE_FALSE( Carta::Lib::convertPixels < double > (
+                           Carta::Lib::Image::PixelType::Other, nullptr, 0, converted.data() ) );
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * Helpers shared by the benchmarks (testRender, testContour).
+ **/
+
+#pragma once
+
+#include "CartaLib/IImage.h"
+#include "CartaLib/Slice.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace tBenchmark
+{
+typedef Carta::Lib::NdArray::RawViewInterface RawViewInterface;
+
+/// in-memory 2D view, the buffered forEach() hands out copies of the data, and views
+/// of whole rows share the data of the frame
+template < typename Scalar >
+class MemoryRawView : public RawViewInterface
+{
+public:
+
+    MemoryRawView( std::shared_ptr < std::vector < Scalar > > data, int64_t offset,
+                   int width, int height )
+        : m_data( data ), m_offset( offset ), m_dims( { width, height } )
+    { }
+
+    virtual PixelType
+    pixelType() override
+    {
+        return Carta::Lib::Image::CType2PixelType < Scalar >::type;
+    }
+
+    virtual const VI &
+    dims() override
+    {
+        return m_dims;
+    }
+
+    virtual const char *
+    get( const VI & pos ) override
+    {
+        return reinterpret_cast < const char * > (
+            & ( * m_data )[m_offset + pos[0] + int64_t( pos[1] ) * m_dims[0]] );
+    }
+
+    virtual void
+    forEach( std::function < void (const char *) > func, Traversal traversal ) override
+    {
+        Q_UNUSED( traversal );
+        const int64_t n = int64_t( m_dims[0] ) * m_dims[1];
+        for ( int64_t i = 0 ; i < n ; i++ ) {
+            func( reinterpret_cast < const char * > ( & ( * m_data )[m_offset + i] ) );
+        }
+    }
+
+    virtual const VI &
+    currentPos() override
+    {
+        qFatal( "not implemented" );
+    }
+
+    virtual RawViewInterface *
+    getView( const SliceND & sliceInfo ) override
+    {
+        SliceND::ApplyResult ar = sliceInfo.apply( { m_dims[0], m_dims[1] } );
+        CARTA_ASSERT( ar.dims()[0].count == m_dims[0] );
+        const int first = ar.dims()[1].start;
+        const int count = ar.dims()[1].count;
+        return new MemoryRawView( m_data, m_offset + int64_t( first ) * m_dims[0],
+                                  m_dims[0], count );
+    }
+
+    virtual int64_t
+    read( int64_t buffSize, char * buff, Traversal traversal ) override
+    {
+        Q_UNUSED( buffSize );
+        Q_UNUSED( buff );
+        Q_UNUSED( traversal );
+        qFatal( "not implemented" );
+    }
+
+    virtual void
+    seek( int64_t ind ) override
+    {
+        Q_UNUSED( ind );
+        qFatal( "not implemented" );
+    }
+
+    virtual int64_t
+    read( int64_t chunk, int64_t buffSize, char * buff, Traversal traversal ) override
+    {
+        Q_UNUSED( chunk );
+        Q_UNUSED( buffSize );
+        Q_UNUSED( buff );
+        Q_UNUSED( traversal );
+        qFatal( "not implemented" );
+    }
+
+    virtual void
+    forEach( int64_t buffSize,
+             std::function < void (const char *, int64_t) > func,
+             char * buff,
+             Traversal traversal ) override
+    {
+        Q_UNUSED( traversal );
+        const int64_t nPixels = int64_t( m_dims[0] ) * m_dims[1];
+        int64_t n = std::max < int64_t > ( 1, buffSize / sizeof( Scalar ) );
+        std::vector < Scalar > ownBuff;
+        if ( ! buff ) {
+            ownBuff.resize( n );
+            buff = reinterpret_cast < char * > ( ownBuff.data() );
+        }
+        for ( int64_t i = 0 ; i < nPixels ; i += n ) {
+            int64_t count = std::min < int64_t > ( n, nPixels - i );
+            std::memcpy( buff, & ( * m_data )[m_offset + i], count * sizeof( Scalar ) );
+            func( buff, count );
+        }
+    }
+
+private:
+
+    std::shared_ptr < std::vector < Scalar > > m_data;
+    int64_t m_offset;
+    VI m_dims;
+};
+
+/// time func() and return the best time in ms out of 'repeats' runs
+inline double
+bestMs( std::function < void () > func, int repeats )
+{
+    double best = 0;
+    for ( int i = 0 ; i < repeats ; i++ ) {
+        QElapsedTimer timer;
+        timer.start();
+        func();
+        double ms = std::max < qint64 > ( 1, timer.nsecsElapsed() ) * 1e-6;
+        best = i == 0 ? ms : std::min( best, ms );
+    }
+    return best;
+}
+
+/// \brief time func() with 1, 2, 4, ... up to maxThreads threads
+/// \param func called with the number of threads, returns whether its result is correct
+/// \return whether all the results are correct
+inline bool
+forThreadCounts( int maxThreads, std::function < bool (int) > func )
+{
+    bool ok = true;
+    for ( int nThreads = 1 ; ; nThreads = std::min( nThreads * 2, maxThreads ) ) {
+        ok = func( nThreads ) && ok;
+        if ( nThreads >= maxThreads ) {
+            break;
+        }
+    }
+    return ok;
+}
+}
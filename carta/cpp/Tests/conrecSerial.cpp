@@ -0,0 +1,338 @@
+/**
+ *
+ **/
+
+#include "conrecSerial.h"
+#include "CartaLib/Slice.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+typedef std::vector < double > VD;
+
+/*
+ * The code below is modified version of Paul Bourke's algorithm:
+ *
+ * http://paulbourke.net/papers/conrec/
+ *
+ * The original is included at the bottom of CartaLib/Algorithms/ContourConrec.cpp.
+ */
+/*
+   Derivation from the fortran version of CONREC by Paul Bourke
+   view            ! view of the data
+   ilb,iub         ! bounds for first coordinate (column), inclusive
+   jlb,jub         ! bounds for second coordinate (row), inclusive
+   xCoords         ! column coordinates (first index)
+   yCoords         ! row coordinates (second index)
+   nc              ! number of contour levels
+   z               ! contour levels in increasing order
+   kernel2d        ! smoothing kernel applied before contouring
+*/
+
+static Carta::Lib::Algorithms::ContourConrec::Result
+conrecFaster( Carta::Lib::NdArray::RawViewInterface * view, int ilb, int iub, int jlb, int jub,
+        const VD & xCoords, const VD & yCoords, int nc, VD z,
+        const VD & kernel2d = VD( 1, 1.0 ) ){
+
+    // the kernel is ( 2 * ghost + 1 ) x ( 2 * ghost + 1 ), row by row
+    const double * kernel = & kernel2d[0];
+    int ghost = 0; // The useless edge width when doing filter.
+    while ( ( 2 * ghost + 1 ) * ( 2 * ghost + 1 ) < int( kernel2d.size() ) ) {
+        ghost ++;
+    }
+
+    // we will only need two rows in memory at any given time
+    // int nRows = jub - jlb + 1;
+    int nCols = iub - ilb - (2*ghost) + 1;
+    int prepareCols = iub - ilb + 1;
+    int prepareRows = 2*ghost + 1;
+    int area = prepareCols*prepareRows;
+    double * rows[2] { nullptr, nullptr };
+    std::vector < double > row1( nCols ), row2( nCols ),
+                           prepareArea( area );
+    rows[0] = & row1[0];
+    rows[1] = & row2[0];
+    int nextRowToReadIn = 0;
+    int nextFilterStart = 0;
+
+    auto updateRows = [&]() -> void {
+        CARTA_ASSERT( nextRowToReadIn < view-> dims()[1] );
+
+        SliceND rowSlice;
+        int update = ( nextRowToReadIn > 0 ? 1 : prepareRows );
+        rowSlice.next().start( nextRowToReadIn ).end( nextRowToReadIn + update );
+        auto rawRowView = view-> getView( rowSlice );
+
+        // make a double view of this raw row view
+        Carta::Lib::NdArray::Double dview( rawRowView, true );
+
+        // shift the row up
+        // note: we could avoid this memory copy if we swapped row[] pointers instead,
+        // and alternately read in the data into row1,row2..., for a miniscule performance
+        // gain and lot more complicated algorithm
+        row1 = row2;
+
+        // Prepare Data for possible filter
+        int t = nextRowToReadIn*prepareCols;
+        dview.forEachBlock( [&] ( const double * vals, int64_t count ) {
+            // To improve the performance, the prepareArea also update only one row
+            // by computing the module
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                prepareArea[(t++)%area] = vals[i];
+            }
+        });
+
+        // Do the filter
+        for ( int i=0; i<nCols; i++){
+            row2[i] = 0;
+            int elems = (2*ghost+1)*(2*ghost+1);
+            for ( int e=0; e<elems; e++){
+                int row = e/(2*ghost+1) + nextFilterStart;
+                int col = e%(2*ghost+1);
+                int index = (row*prepareCols + col + i) % area;
+                row2[i] += kernel[e]*prepareArea[index];
+            }
+        }
+
+        nextRowToReadIn += update;
+        nextFilterStart ++;
+    };
+    updateRows();
+
+//    NdArray::Double doubleView( view, false );
+//    auto acc = [& doubleView] ( int col, int row ) {
+//        return doubleView.get( { col, row }
+//                               );
+//    };
+
+    Carta::Lib::Algorithms::ContourConrec::Result result;
+    if ( nc < 1 ) {
+        return result;
+    }
+    result.resize( nc );
+
+#define xsect( p1, p2 ) ( h[p2] * xh[p1] - h[p1] * xh[p2] ) / ( h[p2] - h[p1] )
+#define ysect( p1, p2 ) ( h[p2] * yh[p1] - h[p1] * yh[p2] ) / ( h[p2] - h[p1] )
+
+    int m1, m2, m3, case_value, sh[5];
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    double h[5], xh[5], yh[5];
+    int im[4] = { 0, 1, 1, 0},
+        jm[4] = { 0, 0, 1, 1};
+    int castab[3][3][3] = {
+        { { 0, 0, 8 }, { 0, 2, 5 }, { 7, 6, 9 } },
+        { { 0, 3, 4 }, { 1, 3, 1 }, { 4, 3, 0 } },
+        { { 9, 6, 7 }, { 5, 2, 0 }, { 8, 0, 0 } }
+    };
+
+    // original code went from bottom to top, not sure why
+    //    for ( j = ( jub - 1 ) ; j >= jlb ; j-- ) {
+    for ( int j = jlb ; j < jub-2*ghost ; j++ ) {
+        updateRows();
+        for ( int i = ilb ; i < iub-2*ghost ; i++ ) {
+            double temp1 = std::min( rows[0][i]  , rows[1][i]   );
+            double temp2 = std::min( rows[0][i+1], rows[1][i+1] );
+            double dmin = std::min( temp1, temp2 );
+            // early abort if one of the values is not finite
+            if ( ! std::isfinite( dmin ) ) {
+                continue;
+            }
+            temp1 = std::max( rows[0][i]  , rows[1][i]   );
+            temp2 = std::max( rows[0][i+1], rows[1][i+1] );
+            double dmax = std::max( temp1, temp2 );
+            if ( dmax < z[0] || dmin > z[nc - 1] ) {
+                continue;
+            }
+            for ( int k = 0 ; k < nc ; k++ ) {
+                if ( z[k] < dmin || z[k] > dmax ) {
+                    continue;
+                }
+                for ( int m = 4 ; m >= 0 ; m-- ) {
+                    if ( m > 0 ) {
+                        int ii = i + im[m-1], jj = jm[m-1];
+                        h[m] = rows[jj][ii] - z[k];
+                        xh[m] = xCoords[i + ghost + im[m - 1]];
+                        yh[m] = yCoords[j + ghost + jm[m - 1]];
+                    }
+                    else {
+                        h[0] = 0.25 * ( h[1] + h[2] + h[3] + h[4] );
+                        xh[0] = 0.50 * ( xCoords[i + ghost] + xCoords[i + ghost + 1] );
+                        yh[0] = 0.50 * ( yCoords[j + ghost] + yCoords[j + ghost + 1] );
+                    }
+                    if ( h[m] > 0.0 ) {
+                        sh[m] = 1;
+                    }
+                    else if ( h[m] < 0.0 ) {
+                        sh[m] = - 1;
+                    }
+                    else {
+                        sh[m] = 0;
+                    }
+                }
+                /*
+                   Note: at this stage the relative heights of the corners and the
+                   centre are in the h array, and the corresponding coordinates are
+                   in the xh and yh arrays. The centre of the box is indexed by 0
+                   and the 4 corners by 1 to 4 as shown below.
+                   Each triangle is then indexed by the parameter m, and the 3
+                   vertices of each triangle are indexed by parameters m1,m2,and m3.
+                   It is assumed that the centre of the box is always vertex 2
+                   though this is important only when all 3 vertices lie exactly on
+                   the same contour level, in which case only the side of the box
+                   is drawn.
+                      vertex 4 +-------------------+ vertex 3
+                               | \               / |
+                               |   \    m=3    /   |
+                               |     \       /     |
+                               |       \   /       |
+                               |  m=2    X   m=2   |       the centre is vertex 0
+                               |       /   \       |
+                               |     /       \     |
+                               |   /    m=1    \   |
+                               | /               \ |
+                      vertex 1 +-------------------+ vertex 2
+                */
+                /* Scan each triangle in the box */
+                for ( int m = 1 ; m <= 4 ; m++ ) {
+                    m1 = m;
+                    m2 = 0;
+                    if ( m != 4 ) {
+                        m3 = m + 1;
+                    }
+                    else {
+                        m3 = 1;
+                    }
+                    if ( ( case_value = castab[sh[m1] + 1][sh[m2] + 1][sh[m3] + 1] ) == 0 ) {
+                        continue;
+                    }
+                    switch ( case_value )
+                    {
+                    case 1 : /* Line between vertices 1 and 2 */
+                        x1 = xh[m1];
+                        y1 = yh[m1];
+                        x2 = xh[m2];
+                        y2 = yh[m2];
+                        break;
+                    case 2 : /* Line between vertices 2 and 3 */
+                        x1 = xh[m2];
+                        y1 = yh[m2];
+                        x2 = xh[m3];
+                        y2 = yh[m3];
+                        break;
+                    case 3 : /* Line between vertices 3 and 1 */
+                        x1 = xh[m3];
+                        y1 = yh[m3];
+                        x2 = xh[m1];
+                        y2 = yh[m1];
+                        break;
+                    case 4 : /* Line between vertex 1 and side 2-3 */
+                        x1 = xh[m1];
+                        y1 = yh[m1];
+                        x2 = xsect( m2, m3 );
+                        y2 = ysect( m2, m3 );
+                        break;
+                    case 5 : /* Line between vertex 2 and side 3-1 */
+                        x1 = xh[m2];
+                        y1 = yh[m2];
+                        x2 = xsect( m3, m1 );
+                        y2 = ysect( m3, m1 );
+                        break;
+                    case 6 : /* Line between vertex 3 and side 1-2 */
+                        x1 = xh[m3];
+                        y1 = yh[m3];
+                        x2 = xsect( m1, m2 );
+                        y2 = ysect( m1, m2 );
+                        break;
+                    case 7 : /* Line between sides 1-2 and 2-3 */
+                        x1 = xsect( m1, m2 );
+                        y1 = ysect( m1, m2 );
+                        x2 = xsect( m2, m3 );
+                        y2 = ysect( m2, m3 );
+                        break;
+                    case 8 : /* Line between sides 2-3 and 3-1 */
+                        x1 = xsect( m2, m3 );
+                        y1 = ysect( m2, m3 );
+                        x2 = xsect( m3, m1 );
+                        y2 = ysect( m3, m1 );
+                        break;
+                    case 9 : /* Line between sides 3-1 and 1-2 */
+                        x1 = xsect( m3, m1 );
+                        y1 = ysect( m3, m1 );
+                        x2 = xsect( m1, m2 );
+                        y2 = ysect( m1, m2 );
+                        break;
+                    default :
+                        break;
+                    } // switch
+
+                    // add the line segment to the result
+                    // ConrecLine( x1, y1, x2, y2, k );
+                    if ( std::isfinite( x1 ) && std::isfinite( y1 ) && std::isfinite( x2 ) &&
+                         std::isfinite( y2 ) ) {
+                        QPolygonF poly;
+                        poly.append( QPointF( x1, y1 ) );
+                        poly.append( QPointF( x2, y2 ) );
+                        result[k].push_back( poly );
+                    }
+                } /* m */
+            } /* k - contour */
+        } /* i */
+    } /* j */
+    return result;
+
+#undef xsect
+#undef ysect
+} // conrecFaster
+
+Carta::Lib::Algorithms::ContourConrec::Result
+conrecSerial( Carta::Lib::NdArray::RawViewInterface * view, const std::vector < double > & levels,
+              const QString & typeName )
+{
+    typedef Carta::Lib::Algorithms::ContourConrec ContourConrec;
+    if ( ! view || levels.empty() ) {
+        return ContourConrec::Result( levels.size() );
+    }
+
+    // sort the levels, and 'unsort' the results, like ContourConrec does
+    std::vector < size_t > order( levels.size() );
+    for ( size_t i = 0 ; i < levels.size() ; i++ ) {
+        order[i] = i;
+    }
+    std::stable_sort( order.begin(), order.end(), [&] ( size_t a, size_t b ) {
+        return levels[a] < levels[b];
+    });
+    VD sortedLevels( levels.size() );
+    for ( size_t i = 0 ; i < levels.size() ; i++ ) {
+        sortedLevels[i] = levels[order[i]];
+    }
+
+    const int nCols = view-> dims()[0];
+    const int nRows = view-> dims()[1];
+    VD xCoords( nCols ), yCoords( nRows );
+    for ( int col = 0 ; col < nCols ; col++ ) {
+        xCoords[col] = col;
+    }
+    for ( int row = 0 ; row < nRows ; row++ ) {
+        yCoords[row] = row;
+    }
+
+    // the 2D kernel is the outer product of the 1D one
+    ContourConrec::Smoothing smoothing = ContourConrec::smoothingForType( typeName );
+    if ( smoothing.downsample > 1 ) {
+        qWarning() << "Downsampling is not supported by the serial contour algorithm";
+    }
+    VD kernel2d;
+    for ( double wy : smoothing.weights ) {
+        for ( double wx : smoothing.weights ) {
+            kernel2d.push_back( wy * wx );
+        }
+    }
+
+    ContourConrec::Result result = conrecFaster( view, 0, nCols - 1, 0, nRows - 1, xCoords, yCoords,
+                                                 levels.size(), sortedLevels, kernel2d );
+    ContourConrec::Result unsorted( levels.size() );
+    for ( size_t i = 0 ; i < levels.size() ; i++ ) {
+        unsorted[order[i]] = result[i];
+    }
+    return unsorted;
+} // conrecSerial
@@ -0,0 +1,19 @@
+/**
+ * The original single threaded contour algorithm, which reads the view one row at a
+ * time and smooths with a 2D kernel. It is kept as the reference the banded algorithm
+ * of ContourConrec is tested and benchmarked against.
+ **/
+
+#pragma once
+
+#include "CartaLib/Algorithms/ContourConrec.h"
+
+/// \brief contour a view with the original algorithm
+/// \param view the view to contour
+/// \param levels the levels, in any order
+/// \param typeName the contour type, see ContourConrec::smoothingForType(); downsampling
+/// is not supported
+/// \return the segments of each level, in the same order as ContourConrec::computeSegments()
+Carta::Lib::Algorithms::ContourConrec::Result
+conrecSerial( Carta::Lib::NdArray::RawViewInterface * view, const std::vector < double > & levels,
+              const QString & typeName );
@@ -23,6 +23,28 @@ TEST_CASE( "Exact quantile algorithm test", "[quantile]" ) {
     }
 }
 
+TEST_CASE( "Exact quantile algorithm on float pixels", "[quantile]" ) {
+    std::mt19937 gen( 3 );
+    std::normal_distribution < float > dist( 0.0, 1.0 );
+    std::vector < float > floatData( 10000 );
+    for ( auto & val : floatData ) {
+        val = dist( gen );
+    }
+    floatData[5] = std::numeric_limits < float >::quiet_NaN();
+    std::vector < double > doubleData( floatData.begin(), floatData.end() );
+
+    TestRawView < float > floatRaw( floatData, { 100, 100 } );
+    TestRawView < double > doubleRaw( doubleData, { 100, 100 } );
+    Carta::Lib::NdArray::Double floatView( & floatRaw, false );
+    Carta::Lib::NdArray::Double doubleView( & doubleRaw, false );
+
+    Carta::Core::Algorithms::PercentilesToPixels < double > calculator;
+    std::vector < double > percentiles = { 0.0, 0.01, 0.25, 0.5, 0.999, 1.0 };
+    std::map < double, double > fromFloats = calculator.percentile2pixels( floatView, percentiles, -1, nullptr, {} );
+    std::map < double, double > fromDoubles = calculator.percentile2pixels( doubleView, percentiles, -1, nullptr, {} );
+    REQUIRE( fromFloats == fromDoubles );
+}
+
 TEST_CASE( "View stub test", "[quantile]" ){
 
     SECTION("TestRawViewSliceStub implementation") {
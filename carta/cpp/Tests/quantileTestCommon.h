@@ -97,11 +97,7 @@ public:
         char * buff = nullptr,
         Traversal traversal = Traversal::Sequential ) override
     {
-        Q_UNUSED( buffSize );
-        Q_UNUSED( func );
-        Q_UNUSED( buff );
-        Q_UNUSED( traversal );
-        qFatal( "not implemented" );
+        forEachBufferedFallback( buffSize, func, buff, traversal );
     }
 
     std::vector<PType> data;
@@ -191,7 +187,7 @@ public:
     std::map <double, double> expected;
 };
 
-std::vector<QuantileTestData> commonTestCases() {
+inline std::vector<QuantileTestData> commonTestCases() {
     std::vector<int> dims = {200, 200, 10};
     int size = std::accumulate (begin(dims), end(dims), 1, [](int a, int& b){ return b*a; });
     std::vector<double> data(size);
@@ -0,0 +1,139 @@
+#include "catch.h"
+#include "quantileTestCommon.h"
+#include "core/Algorithms/rasterRender.h"
+#include "CartaLib/PixelPipeline/CustomizablePixelPipeline.h"
+#include "core/GrayColormap.h"
+#include <QImage>
+#include <random>
+
+namespace RasterRender = Carta::Core::Algorithms::RasterRender;
+
+/// the original per-pixel render algorithm, used as the reference
+template < class Pipeline >
+static QImage
+referenceRender( Carta::Lib::NdArray::RawViewInterface * rawView, Pipeline & pipe, QRgb nanColor )
+{
+    int width = rawView-> dims()[0];
+    int height = rawView-> dims()[1];
+    QImage img( width, height, QImage::Format_ARGB32 );
+    QRgb * outPtr = reinterpret_cast < QRgb * > ( img.scanLine( height - 1 ) );
+    int64_t counter = 0;
+    Carta::Lib::NdArray::Double typedView( rawView, false );
+    typedView.forEach( [&] ( const double & val ) {
+        if ( ! std::isnan( val ) ) {
+            pipe.convertq( val, * outPtr );
+        }
+        else {
+            * outPtr = nanColor;
+        }
+        outPtr++;
+        counter++;
+        if ( counter % width == 0 ) {
+            outPtr -= width * 2;
+        }
+    });
+    return img;
+}
+
+template < class Pipeline >
+static QImage
+bandedRender( Carta::Lib::NdArray::RawViewInterface * rawView, Pipeline & pipe, QRgb nanColor,
+              int nThreads )
+{
+    QImage img( rawView-> dims()[0], rawView-> dims()[1], QImage::Format_ARGB32 );
+    RasterRender::view2qImage( rawView, pipe, img, nanColor, nThreads );
+    return img;
+}
+
+TEST_CASE( "Banded raster render is identical to per-pixel render", "[render]" ) {
+
+    // odd sized image, so that bands/chunks do not line up with rows
+    const int width = 1531, height = 977;
+    std::vector < float > data( width * height );
+    std::mt19937 gen( 7 );
+    std::normal_distribution < float > dist( 0.0, 3.0 );
+    for ( auto & x : data ) {
+        x = dist( gen );
+    }
+    for ( size_t i = 0 ; i < data.size() ; i += 97 ) {
+        data[i] = std::numeric_limits < float >::quiet_NaN();
+    }
+    TestRawView < float > view( data, { width, height } );
+
+    auto pp = std::make_shared < Carta::Lib::PixelPipeline::CustomizablePixelPipeline > ();
+    pp-> setColormap( std::make_shared < Carta::Core::GrayColormap > () );
+    pp-> setScale( Carta::Lib::PixelPipeline::ScaleType::Log );
+    pp-> setMinMax( -4, 5 );
+    const QRgb nanColor = qRgb( 255, 0, 0 );
+
+    SECTION( "raw pipeline" ) {
+        REQUIRE( bandedRender( & view, * pp, nanColor, 1 ) == referenceRender( & view, * pp, nanColor ) );
+    }
+
+    SECTION( "cached pipeline" ) {
+        Carta::Lib::PixelPipeline::CachedPipeline < false > cpp;
+        cpp.cache( * pp, 10000, -4, 5 );
+        QImage ref = referenceRender( & view, cpp, nanColor );
+        for ( int nThreads : { 1, 2, 3, 8 } ) {
+            REQUIRE( bandedRender( & view, cpp, nanColor, nThreads ) == ref );
+        }
+    }
+
+    SECTION( "interpolated cached pipeline" ) {
+        Carta::Lib::PixelPipeline::CachedPipeline < true > cppi;
+        cppi.cache( * pp, 1000, -4, 5 );
+        QImage ref = referenceRender( & view, cppi, nanColor );
+        for ( int nThreads : { 1, 2, 3, 8 } ) {
+            REQUIRE( bandedRender( & view, cppi, nanColor, nThreads ) == ref );
+        }
+    }
+
+    SECTION( "double pixels" ) {
+        TestRawView < double > doubleView( std::vector < double > ( data.begin(), data.end() ),
+                                           { width, height } );
+        Carta::Lib::PixelPipeline::CachedPipeline < true > cppi;
+        cppi.cache( * pp, 1000, -4, 5 );
+        QImage ref = referenceRender( & view, cppi, nanColor );
+        REQUIRE( bandedRender( & doubleView, cppi, nanColor, 3 ) == ref );
+    }
+}
+
+TEST_CASE( "Colormapping cache indices is identical to rendering the view", "[render]" ) {
+    const int width = 613, height = 389;
+    std::vector < float > data( width * height );
+    std::mt19937 gen( 11 );
+    std::normal_distribution < float > dist( 0.0, 3.0 );
+    for ( auto & x : data ) {
+        x = dist( gen );
+    }
+    for ( size_t i = 0 ; i < data.size() ; i += 53 ) {
+        data[i] = std::numeric_limits < float >::quiet_NaN();
+    }
+    TestRawView < float > floatView( data, { width, height } );
+    TestRawView < double > doubleView( std::vector < double > ( data.begin(), data.end() ),
+                                       { width, height } );
+    const QRgb nanColor = qRgb( 0, 255, 0 );
+
+    auto pp = std::make_shared < Carta::Lib::PixelPipeline::CustomizablePixelPipeline > ();
+    pp-> setColormap( std::make_shared < Carta::Core::GrayColormap > () );
+    pp-> setMinMax( -4, 5 );
+    Carta::Lib::PixelPipeline::CachedPipeline < false > cpp;
+    cpp.cache( * pp, 1000, -4, 5 );
+
+    std::vector < uint16_t > indices, doubleIndices;
+    RasterRender::view2indices( & floatView, cpp, indices, 3 );
+    RasterRender::view2indices( & doubleView, cpp, doubleIndices, 2 );
+    REQUIRE( indices == doubleIndices );
+
+    QImage fromIndices( width, height, QImage::Format_ARGB32 );
+    RasterRender::indices2qImage( indices, cpp, fromIndices, nanColor, 3 );
+    REQUIRE( fromIndices == bandedRender( & floatView, cpp, nanColor, 1 ) );
+
+    // a different function with the same cache geometry reuses the indices
+    pp-> setScale( Carta::Lib::PixelPipeline::ScaleType::Sqrt );
+    pp-> setInvert( true );
+    Carta::Lib::PixelPipeline::CachedPipeline < false > cpp2;
+    cpp2.cache( * pp, 1000, -4, 5 );
+    RasterRender::indices2qImage( indices, cpp2, fromIndices, nanColor, 2 );
+    REQUIRE( fromIndices == bandedRender( & floatView, cpp2, nanColor, 1 ) );
+}
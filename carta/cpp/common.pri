@@ -93,6 +93,7 @@ unix:macx {
 else{
     QMAKE_CXXFLAGS += -fopenmp
     QMAKE_CFLAGS += -fopenmp
+    QMAKE_LFLAGS += -fopenmp
 }
 
 # use gcc 4.8.1
@@ -0,0 +1,225 @@
+/**
+ *
+ **/
+
+#include "floatFrameView.h"
+#include <algorithm>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+namespace
+{
+/// number of elements a 1D slice extracts
+inline int
+sliceCount( const Slice1D::ApplyResult & res )
+{
+    return res.isSingle() ? 1 : res.count;
+}
+}
+
+FloatFrameView::FloatFrameView( Data data, const VI & dims )
+    : FloatFrameView( data, dims, SliceND().apply( dims ) )
+{ }
+
+FloatFrameView::FloatFrameView( Data data, const VI & dims, const SliceND::ApplyResult & appliedSlice )
+    : m_data( data ), m_origDims( dims ), m_appliedSlice( appliedSlice )
+{
+    CARTA_ASSERT( m_data );
+    CARTA_ASSERT( ! m_appliedSlice.isError() );
+    CARTA_ASSERT( m_appliedSlice.dims().size() == m_origDims.size() );
+    int64_t size = 1;
+    for ( size_t i = 0 ; i < m_origDims.size() ; i++ ) {
+        const Slice1D::ApplyResult & res = m_appliedSlice.dims()[i];
+        m_viewDims.push_back( sliceCount( res ) );
+        m_whole = m_whole && res.start == 0 && res.step == 1 && m_viewDims[i] == m_origDims[i];
+        size *= m_origDims[i];
+    }
+    CARTA_ASSERT( int64_t( m_data-> size() ) == size );
+    Q_UNUSED( size );
+    m_currentPos.resize( m_viewDims.size(), 0 );
+}
+
+const FloatFrameView::Data &
+FloatFrameView::data() const
+{
+    return m_data;
+}
+
+int64_t
+FloatFrameView::byteCount() const
+{
+    return m_data-> size() * sizeof( float );
+}
+
+FloatFrameView::PixelType
+FloatFrameView::pixelType()
+{
+    return PixelType::Real32;
+}
+
+const FloatFrameView::VI &
+FloatFrameView::dims()
+{
+    return m_viewDims;
+}
+
+const char *
+FloatFrameView::get( const VI & pos )
+{
+    int64_t ind = 0;
+    int64_t stride = 1;
+    for ( size_t i = 0 ; i < m_origDims.size() ; i++ ) {
+        const Slice1D::ApplyResult & res = m_appliedSlice.dims()[i];
+        const int64_t p = i < pos.size() ? pos[i] : 0;
+        ind += ( res.start + p * res.step ) * stride;
+        stride *= m_origDims[i];
+    }
+    return reinterpret_cast < const char * > ( & m_data-> at( ind ) );
+}
+
+void
+FloatFrameView::forEach( std::function < void (const char *) > func, Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    const int64_t total = nPixels();
+    if ( total == 0 ) {
+        return;
+    }
+    const int width = m_viewDims[0];
+    std::vector < float > row( width );
+    std::fill( m_currentPos.begin(), m_currentPos.end(), 0 );
+    for ( int64_t first = 0 ; first < total ; first += width ) {
+        copySequential( first, width, row.data() );
+        for ( int x = 0 ; x < width ; x++ ) {
+            m_currentPos[0] = x;
+            func( reinterpret_cast < const char * > ( & row[x] ) );
+        }
+        // advance the position of the next row
+        for ( size_t i = 1 ; i < m_currentPos.size() ; i++ ) {
+            if ( ++m_currentPos[i] < m_viewDims[i] ) {
+                break;
+            }
+            m_currentPos[i] = 0;
+        }
+    }
+}
+
+const FloatFrameView::VI &
+FloatFrameView::currentPos()
+{
+    return m_currentPos;
+}
+
+Carta::Lib::NdArray::RawViewInterface *
+FloatFrameView::getView( const SliceND & sliceInfo )
+{
+    SliceND::ApplyResult ar = sliceInfo.apply( m_viewDims );
+    return new FloatFrameView( m_data, m_origDims, SliceND::ApplyResult::combine( m_appliedSlice, ar ) );
+}
+
+int64_t
+FloatFrameView::read( int64_t buffSize, char * buff, Traversal traversal )
+{
+    int64_t n = read( m_readChunk, buffSize, buff, traversal );
+    if ( n > 0 ) {
+        m_readChunk++;
+    }
+    return n;
+}
+
+void
+FloatFrameView::seek( int64_t ind )
+{
+    m_readChunk = ind;
+}
+
+int64_t
+FloatFrameView::read( int64_t chunk, int64_t buffSize, char * buff, Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    const int64_t capacity = buffSize / sizeof( float );
+    const int64_t first = chunk * capacity;
+    if ( capacity < 1 || chunk < 0 || first >= nPixels() ) {
+        return 0;
+    }
+    const int64_t count = std::min( capacity, nPixels() - first );
+    copySequential( first, count, reinterpret_cast < float * > ( buff ) );
+    return count * sizeof( float );
+}
+
+void
+FloatFrameView::forEach( int64_t buffSize,
+                         std::function < void (const char *, int64_t) > func,
+                         char * buff,
+                         Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    const int64_t total = nPixels();
+    const int64_t n = std::max < int64_t > ( 1, buffSize / sizeof( float ) );
+    std::vector < float > ownBuff;
+    if ( ! m_whole && ! buff ) {
+        ownBuff.resize( std::min( n, total ) );
+        buff = reinterpret_cast < char * > ( ownBuff.data() );
+    }
+    for ( int64_t i = 0 ; i < total ; i += n ) {
+        const int64_t count = std::min( n, total - i );
+        if ( m_whole && ! buff ) {
+            func( reinterpret_cast < const char * > ( m_data-> data() + i ), count );
+        }
+        else {
+            copySequential( i, count, reinterpret_cast < float * > ( buff ) );
+            func( buff, count );
+        }
+    }
+}
+
+int64_t
+FloatFrameView::nPixels() const
+{
+    int64_t n = 1;
+    for ( int dim : m_viewDims ) {
+        n *= dim;
+    }
+    return n;
+}
+
+void
+FloatFrameView::copySequential( int64_t first, int64_t count, float * dst ) const
+{
+    if ( m_whole ) {
+        std::copy( m_data-> begin() + first, m_data-> begin() + first + count, dst );
+        return;
+    }
+    const std::vector < Slice1D::ApplyResult > & slices = m_appliedSlice.dims();
+    const int64_t width = m_viewDims[0];
+    const float * src = m_data-> data();
+    while ( count > 0 ) {
+        // find the start of the current row in the whole array
+        int64_t row = first / width;
+        int64_t x = first % width;
+        int64_t offset = 0;
+        int64_t stride = m_origDims[0];
+        for ( size_t i = 1 ; i < slices.size() ; i++ ) {
+            const int64_t p = row % m_viewDims[i];
+            row /= m_viewDims[i];
+            offset += ( slices[i].start + p * slices[i].step ) * stride;
+            stride *= m_origDims[i];
+        }
+        const int64_t n = std::min( count, width - x );
+        const int64_t step = slices[0].step;
+        const float * rowSrc = src + offset + slices[0].start + x * step;
+        for ( int64_t j = 0 ; j < n ; j++ ) {
+            dst[j] = rowSrc[j * step];
+        }
+        dst += n;
+        first += n;
+        count -= n;
+    }
+}
+}
+}
+}
@@ -0,0 +1,125 @@
+/**
+ * Raw view of single precision pixels that are already in memory, e.g. a downsampled
+ * mipmap level or a frame that was decoded ahead of time.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IImage.h"
+
+#include <vector>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+/// \brief View of (a slice of) an n-dimensional array of floats stored in memory, with
+/// the first dimension varying the fastest.
+///
+/// The pixels are shared between the view and all views created from it with
+/// getView(), so they remain valid for as long as any of the views exists.
+class FloatFrameView : public Carta::Lib::NdArray::RawViewInterface
+{
+    CLASS_BOILERPLATE( FloatFrameView );
+
+public:
+
+    /// shared storage of the pixels
+    typedef std::shared_ptr < std::vector < float > > Data;
+
+    /// \brief create a view of all the pixels
+    /// \param data the pixels, there must be as many as the product of the dimensions
+    /// \param dims dimensions of the array
+    FloatFrameView( Data data, const VI & dims );
+
+    /// \brief create a view of a slice of the pixels
+    /// \param data the pixels
+    /// \param dims dimensions of the whole array
+    /// \param appliedSlice the slice, applied to dims
+    FloatFrameView( Data data, const VI & dims, const SliceND::ApplyResult & appliedSlice );
+
+    /// the shared pixels
+    const Data &
+    data() const;
+
+    /// memory used by the pixels, in bytes
+    int64_t
+    byteCount() const;
+
+    virtual PixelType
+    pixelType() override;
+
+    virtual const VI &
+    dims() override;
+
+    virtual const char *
+    get( const VI & pos ) override;
+
+    virtual void
+    forEach( std::function < void (const char *) > func,
+             Traversal traversal = Traversal::Sequential ) override;
+
+    virtual const VI &
+    currentPos() override;
+
+    virtual RawViewInterface *
+    getView( const SliceND & sliceInfo ) override;
+
+    /// sequential read of the next chunk, see the stateless read() below
+    virtual int64_t
+    read( int64_t buffSize, char * buff,
+          Traversal traversal = Traversal::Sequential ) override;
+
+    /// set the chunk index for the next read()
+    virtual void
+    seek( int64_t ind ) override;
+
+    /// read chunk number 'chunk' of buffSize bytes, the traversal is always sequential
+    virtual int64_t
+    read( int64_t chunk, int64_t buffSize, char * buff,
+          Traversal traversal = Traversal::Sequential ) override;
+
+    /// unless the view is a slice or the caller supplies a buffer, the function is
+    /// handed pointers directly into the data
+    virtual void
+    forEach( int64_t buffSize,
+             std::function < void (const char *, int64_t) > func,
+             char * buff = nullptr,
+             Traversal traversal = Traversal::Sequential ) override;
+
+private:
+
+    /// number of pixels in the view
+    int64_t
+    nPixels() const;
+
+    /// copy 'count' pixels, starting at the sequential index 'first', into dst
+    void
+    copySequential( int64_t first, int64_t count, float * dst ) const;
+
+    Data m_data;
+
+    /// dimensions of the whole array
+    VI m_origDims;
+
+    /// dimensions of the view
+    VI m_viewDims;
+
+    /// the slice of the whole array this view covers
+    SliceND::ApplyResult m_appliedSlice;
+
+    /// whether the view covers all the pixels, in order
+    bool m_whole = true;
+
+    /// position reported by currentPos() during the per element forEach()
+    VI m_currentPos;
+
+    /// chunk to be returned by the next stateful read()
+    int64_t m_readChunk = 0;
+};
+}
+}
+}
@@ -0,0 +1,153 @@
+#include "frameStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+namespace
+{
+/// version of the serialized format, bumped whenever it changes
+const uint32_t SerialVersion = 2;
+
+template < typename T >
+void
+appendRaw( QByteArray & data, const T & val )
+{
+    data.append( reinterpret_cast < const char * > ( & val ), sizeof( T ) );
+}
+
+template < typename T >
+bool
+readRaw( const QByteArray & data, int & pos, T & val )
+{
+    if ( pos + int( sizeof( T ) ) > data.size() ) {
+        return false;
+    }
+    std::memcpy( & val, data.constData() + pos, sizeof( T ) );
+    pos += sizeof( T );
+    return true;
+}
+}
+
+void
+FrameStatisticsAccumulator::add( const double * values, int64_t n )
+{
+    for ( int64_t i = 0 ; i < n ; i++ ) {
+        const double val = values[i];
+        if ( ! std::isfinite( val ) ) {
+            continue;
+        }
+        m_min = std::min( m_min, val );
+        m_max = std::max( m_max, val );
+        m_histogram.add( val );
+    }
+}
+
+FrameStatistics
+FrameStatisticsAccumulator::result() const
+{
+    FrameStatistics stats;
+    stats.min = m_min;
+    stats.max = m_max;
+    stats.histogram = m_histogram.result();
+    return stats;
+}
+
+FrameStatistics
+FrameStatistics::compute( const double * values, int64_t n )
+{
+    FrameStatisticsAccumulator accumulator;
+    accumulator.add( values, n );
+    return accumulator.result();
+}
+
+void
+FrameStatistics::merge( const FrameStatistics & other )
+{
+    min = std::min( min, other.min );
+    max = std::max( max, other.max );
+    histogram.merge( other.histogram );
+}
+
+std::pair < double, double >
+FrameStatistics::percentileBracket( double percentile ) const
+{
+    const uint64_t count = histogram.total;
+    if ( count == 0 ) {
+        double nan = std::numeric_limits < double >::quiet_NaN();
+        return { nan, nan };
+    }
+    if ( percentile <= 0 ) {
+        return { min, min };
+    }
+    if ( percentile >= 1 ) {
+        return { max, max };
+    }
+
+    // same index as the exact algorithm picks
+    uint64_t rank = Carta::Lib::clamp < uint64_t > ( uint64_t( count * percentile ), 1, count ) - 1;
+    uint64_t seen = 0;
+    for ( size_t i = 0 ; i < histogram.bins.size() ; i++ ) {
+        seen += histogram.counts[i];
+        if ( rank < seen ) {
+            std::pair < double, double > range =
+                Carta::Lib::Algorithms::SparseHistogram::binRange( histogram.bins[i] );
+            return { std::max( range.first, min ), std::min( range.second, max ) };
+        }
+    }
+
+    // the histogram does not account for all values, which should not happen
+    return { min, max };
+}
+
+QByteArray
+FrameStatistics::toByteArray() const
+{
+    QByteArray data;
+    appendRaw( data, SerialVersion );
+    appendRaw( data, min );
+    appendRaw( data, max );
+    appendRaw( data, uint32_t( histogram.bins.size() ) );
+    for ( size_t i = 0 ; i < histogram.bins.size() ; i++ ) {
+        appendRaw( data, histogram.bins[i] );
+        appendRaw( data, histogram.counts[i] );
+    }
+    return data;
+}
+
+bool
+FrameStatistics::fromByteArray( const QByteArray & data, FrameStatistics & stats )
+{
+    int pos = 0;
+    uint32_t version = 0;
+    uint32_t binCount = 0;
+    FrameStatistics result;
+    if ( ! readRaw( data, pos, version ) || version != SerialVersion ||
+         ! readRaw( data, pos, result.min ) || ! readRaw( data, pos, result.max ) ||
+         ! readRaw( data, pos, binCount ) ) {
+        return false;
+    }
+    Carta::Lib::Algorithms::SparseHistogram & histogram = result.histogram;
+    histogram.bins.resize( binCount );
+    histogram.counts.resize( binCount );
+    for ( uint32_t i = 0 ; i < binCount ; i++ ) {
+        if ( ! readRaw( data, pos, histogram.bins[i] ) || ! readRaw( data, pos, histogram.counts[i] ) ) {
+            return false;
+        }
+        histogram.total += histogram.counts[i];
+    }
+    if ( pos != data.size() ) {
+        return false;
+    }
+    stats = result;
+    return true;
+}
+}
+}
+}
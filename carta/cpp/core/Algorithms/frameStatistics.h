@@ -0,0 +1,101 @@
+/**
+ * Compact summary of the finite values of a frame (one channel of one stokes plane),
+ * computed in a single streaming pass. Summaries of several frames can be merged to
+ * answer questions about any range of channels without reading the pixels again.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/Algorithms/SparseHistogram.h"
+
+#include <QByteArray>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+/// \brief min, max and a histogram of finite values
+///
+/// The histogram bins do not depend on the data range, so the histograms of different
+/// frames can be merged. Each bin spans 1/16th of a power of two, which is enough to
+/// bracket percentiles to within a few percent of the value.
+class FrameStatistics
+{
+    CLASS_BOILERPLATE( FrameStatistics );
+
+public:
+
+    /// smallest finite value, numeric_limits::max() if there are none
+    double min = std::numeric_limits < double >::max();
+
+    /// largest finite value, numeric_limits::lowest() if there are none
+    double max = std::numeric_limits < double >::lowest();
+
+    /// histogram of the finite values
+    Carta::Lib::Algorithms::SparseHistogram histogram;
+
+    /// \brief summarize a block of values, non-finite values are skipped
+    /// \param values the values
+    /// \param n number of values
+    /// \return the summary
+    static FrameStatistics
+    compute( const double * values, int64_t n );
+
+    /// add the values summarized by another frame to this one
+    void
+    merge( const FrameStatistics & other );
+
+    /// number of finite values
+    uint64_t
+    count() const { return histogram.total; }
+
+    /// \brief find an interval that contains the given percentile
+    ///
+    /// The percentile is the value the exact percentile algorithm would return, i.e.
+    /// the value at index clamp(count * percentile, 1, count) - 1 of the sorted values.
+    /// Percentiles 0 and 1 are the exact min and max.
+    /// \param percentile the percentile, in [0,1]
+    /// \return the lower and upper bound of the percentile, NaNs if there are no values
+    std::pair < double, double >
+    percentileBracket( double percentile ) const;
+
+    /// serialize the summary, e.g. for a persistent cache
+    QByteArray
+    toByteArray() const;
+
+    /// \brief restore a summary serialized with toByteArray()
+    /// \param data the serialized summary
+    /// \param stats where to store the summary
+    /// \return false if the data is not a valid summary
+    static bool
+    fromByteArray( const QByteArray & data, FrameStatistics & stats );
+};
+
+/// \brief builds the summary of a frame that is read a block at a time
+class FrameStatisticsAccumulator
+{
+public:
+
+    /// add a block of values, non-finite values are skipped
+    void
+    add( const double * values, int64_t n );
+
+    /// the summary of all values added so far
+    FrameStatistics
+    result() const;
+
+private:
+
+    double m_min = std::numeric_limits < double >::max();
+    double m_max = std::numeric_limits < double >::lowest();
+    Carta::Lib::Algorithms::SparseHistogramAccumulator m_histogram;
+};
+}
+}
+}
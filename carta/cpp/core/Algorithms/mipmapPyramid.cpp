@@ -0,0 +1,211 @@
+/**
+ *
+ **/
+
+#include "mipmapPyramid.h"
+#include "rasterRender.h"
+#include "floatFrameView.h"
+#include <cmath>
+#include <limits>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+namespace
+{
+/// \brief reduce one or two input rows into one output row
+/// \param row0 first input row
+/// \param row1 second input row, or nullptr for the last row of odd sized inputs
+/// \param width width of the input rows
+/// \param method how to combine the pixels
+/// \param out the output row, (width+1)/2 entries
+template < typename Scalar >
+void
+reduceRows( const Scalar * row0, const Scalar * row1, int width,
+            MipmapPyramid::Method method, float * out )
+{
+    const int outWidth = ( width + 1 ) / 2;
+    const Scalar * rows[2] = { row0, row1 };
+    const int nRows = row1 ? 2 : 1;
+    for ( int ox = 0 ; ox < outWidth ; ox++ ) {
+        const int x0 = ox * 2;
+        const int nx = std::min( 2, width - x0 );
+        double sum = 0;
+        double max = - std::numeric_limits < double >::infinity();
+        int count = 0;
+        for ( int r = 0 ; r < nRows ; r++ ) {
+            for ( int dx = 0 ; dx < nx ; dx++ ) {
+                const double val = rows[r][x0 + dx];
+                if ( Q_LIKELY( ! std::isnan( val ) ) ) {
+                    sum += val;
+                    max = std::max( max, val );
+                    count++;
+                }
+            }
+        }
+        if ( count == 0 ) {
+            out[ox] = std::numeric_limits < float >::quiet_NaN();
+        }
+        else if ( method == MipmapPyramid::Method::Mean ) {
+            out[ox] = sum / count;
+        }
+        else {
+            out[ox] = max;
+        }
+    }
+} // reduceRows
+
+/// allocate a level that is half the size of the given dimensions
+MipmapPyramid::Level
+halfLevel( int width, int height )
+{
+    MipmapPyramid::Level level;
+    level.width = ( width + 1 ) / 2;
+    level.height = ( height + 1 ) / 2;
+    level.data = std::make_shared < std::vector < float > > (
+        int64_t( level.width ) * level.height );
+    return level;
+}
+}
+
+MipmapPyramid::MipmapPyramid( Method method )
+    : m_method( method )
+{ }
+
+MipmapPyramid::Method
+MipmapPyramid::method() const
+{
+    return m_method;
+}
+
+const MipmapPyramid::Level &
+MipmapPyramid::level( int n, Carta::Lib::NdArray::RawViewInterface * view )
+{
+    CARTA_ASSERT( n >= 1 );
+    if ( m_levels.empty() ) {
+        buildFirstLevel( view );
+    }
+    while ( int( m_levels.size() ) < n ) {
+        buildNextLevel();
+    }
+    return m_levels[n - 1];
+}
+
+Carta::Lib::NdArray::RawViewInterface *
+MipmapPyramid::levelView( int n, Carta::Lib::NdArray::RawViewInterface * view )
+{
+    const Level & lev = level( n, view );
+    return new FloatFrameView( lev.data, { lev.width, lev.height } );
+}
+
+int
+MipmapPyramid::builtLevels() const
+{
+    return m_levels.size();
+}
+
+int64_t
+MipmapPyramid::byteCount() const
+{
+    int64_t bytes = 0;
+    for ( const Level & level : m_levels ) {
+        bytes += level.data-> size() * sizeof( float );
+    }
+    return bytes;
+}
+
+int
+MipmapPyramid::maxLevel( int width, int height )
+{
+    int n = 0;
+    while ( width > 1 || height > 1 ) {
+        width = ( width + 1 ) / 2;
+        height = ( height + 1 ) / 2;
+        n++;
+    }
+    return n;
+}
+
+int
+MipmapPyramid::levelForZoom( double zoom, int maxLevel )
+{
+    if ( ! ( zoom < 1.0 ) ) {
+        return 0;
+    }
+
+    // at level n every level pixel occupies zoom * 2^n screen pixels, we want the
+    // largest n for which this is still >= 1
+    int n = std::floor( std::log2( 1.0 / zoom ) + 1e-9 );
+    return Carta::Lib::clamp( n, 0, maxLevel );
+}
+
+QString
+MipmapPyramid::method2str( Method method )
+{
+    return method == Method::Mean ? "mean" : "max";
+}
+
+void
+MipmapPyramid::buildFirstLevel( Carta::Lib::NdArray::RawViewInterface * view )
+{
+    CARTA_ASSERT( view );
+    const int width = view-> dims()[0];
+    const int height = view-> dims()[1];
+    Level level = halfLevel( width, height );
+    float * out = level.data-> data();
+
+    const auto pixelType = view-> pixelType();
+    const int64_t pixelSize = Carta::Lib::Image::pixelType2size( pixelType );
+    const int64_t nPixels = int64_t( width ) * height;
+    const int64_t bandRows = std::max < int64_t > ( 2, RasterRender::BandPixels / width );
+
+    // two input rows converted to doubles, reduced whenever the second one is complete
+    std::vector < double > rows( 2 * width );
+    int64_t counter = 0;
+    auto func = [&] ( const char * data, int64_t count ) {
+        CARTA_ASSERT( counter + count <= nPixels );
+        count = std::min( count, nPixels - counter );
+        while ( count > 0 ) {
+            const int64_t y = counter / width;
+            const int64_t x = counter % width;
+            const int64_t n = std::min < int64_t > ( count, width - x );
+            RasterRender::raw2double( pixelType, data, n, & rows[( y % 2 ) * width + x] );
+            data += n * pixelSize;
+            count -= n;
+            counter += n;
+            if ( x + n == width && ( y % 2 == 1 || y == height - 1 ) ) {
+                const double * row1 = ( y % 2 == 1 ) ? & rows[width] : nullptr;
+                reduceRows( & rows[0], row1, width, m_method, out + ( y / 2 ) * level.width );
+            }
+        }
+    };
+    view-> forEach( bandRows * width * pixelSize, func, nullptr,
+                    Carta::Lib::NdArray::RawViewInterface::Traversal::Sequential );
+    CARTA_ASSERT( counter == nPixels );
+
+    m_levels.push_back( level );
+} // buildFirstLevel
+
+void
+MipmapPyramid::buildNextLevel()
+{
+    CARTA_ASSERT( ! m_levels.empty() );
+    const Level & prev = m_levels.back();
+    Level level = halfLevel( prev.width, prev.height );
+    const float * in = prev.data-> data();
+    float * out = level.data-> data();
+
+    for ( int oy = 0 ; oy < level.height ; oy++ ) {
+        const float * row0 = in + int64_t( oy * 2 ) * prev.width;
+        const float * row1 = ( oy * 2 + 1 < prev.height ) ? row0 + prev.width : nullptr;
+        reduceRows( row0, row1, prev.width, m_method, out + int64_t( oy ) * level.width );
+    }
+
+    m_levels.push_back( level );
+} // buildNextLevel
+}
+}
+}
@@ -0,0 +1,112 @@
+/**
+ * Multi-resolution (mipmap) pyramid of a 2D frame, used to render zoomed out images
+ * without touching every pixel of the full resolution frame.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IImage.h"
+
+#include <vector>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+/// \brief NaN-aware pyramid of downsampled versions of a 2D frame.
+///
+/// Level 0 is the frame itself (not stored), level n is the frame downsampled by 2^n in
+/// both x and y, where every pixel of level n is computed from (up to) 2x2 pixels of
+/// level n-1. Odd sized levels are handled by reducing the last row/column from fewer
+/// pixels. Pixels that only have NaNs as inputs are NaN.
+///
+/// Levels are built lazily, i.e. asking for level n builds all missing levels up to n,
+/// reading the frame only once (for level 1).
+///
+/// The levels are stored in the same order as the views, i.e. bottom row first.
+class MipmapPyramid
+{
+    CLASS_BOILERPLATE( MipmapPyramid );
+
+public:
+
+    /// how to combine 2x2 pixels into one
+    enum class Method
+    {
+        Mean, ///< average of the finite values
+        Max ///< maximum of the finite values
+    };
+
+    /// single downsampled level
+    struct Level {
+        int width = 0;
+        int height = 0;
+        std::shared_ptr < std::vector < float > > data = nullptr;
+    };
+
+    /// create an empty pyramid, levels will be built on first use
+    explicit
+    MipmapPyramid( Method method = Method::Mean );
+
+    /// return the downsampling method
+    Method
+    method() const;
+
+    /// \brief get the given level, building it (and all coarser levels before it) if needed
+    /// \param n level number, 1 <= n <= maxLevel( view dims )
+    /// \param view the full resolution frame, only used if level 1 is not built yet
+    /// \return the level
+    const Level &
+    level( int n, Carta::Lib::NdArray::RawViewInterface * view );
+
+    /// \brief get a raw view of the given level, see level() for the parameters
+    /// \return new view (caller assumes ownership), it shares the level data, so it remains
+    /// valid even if the pyramid is deleted
+    Carta::Lib::NdArray::RawViewInterface *
+    levelView( int n, Carta::Lib::NdArray::RawViewInterface * view );
+
+    /// number of levels currently built (excluding level 0)
+    int
+    builtLevels() const;
+
+    /// memory used by the built levels, in bytes
+    int64_t
+    byteCount() const;
+
+    /// the coarsest meaningful level for a frame of the given size, i.e. the first
+    /// level that is 1 pixel wide and tall
+    static int
+    maxLevel( int width, int height );
+
+    /// \brief pick the coarsest level that still has at least one level pixel per screen
+    /// pixel when rendering at the given zoom
+    /// \param zoom how many screen pixels does a full resolution pixel occupy
+    /// \param maxLevel upper limit for the result
+    static int
+    levelForZoom( double zoom, int maxLevel );
+
+    /// short string representation of the method, for building cache ids
+    static QString
+    method2str( Method method );
+
+private:
+
+    /// build level 1 from the full resolution view
+    void
+    buildFirstLevel( Carta::Lib::NdArray::RawViewInterface * view );
+
+    /// build the next level from the last built one
+    void
+    buildNextLevel();
+
+    Method m_method;
+
+    /// m_levels[i] is level i+1
+    std::vector < Level > m_levels;
+};
+}
+}
+}
@@ -63,6 +63,36 @@ public:
     ) override;
 };
 
+/// \brief pick the requested percentiles out of the finite values with quickselect
+/// \param allValues the values, they are reordered
+/// \param percentiles which percentiles to pick
+/// \return the values at the percentiles, converted to Scalar
+template < typename Scalar, typename Value >
+std::map < double, Scalar >
+selectPercentiles( std::vector < Value > & allValues, const std::vector < double > & percentiles )
+{
+    // indicate bad clip if no finite numbers were found
+    if ( allValues.size() == 0 ) {
+        qFatal( "The size of raw data is zero !!" );
+    }
+
+    std::map < double, Scalar > result;
+
+    // for every input percentile, do quickselect and store the result
+
+    for ( double q : percentiles ) {
+        // we clamp to incremented values and decrement at the end because size_t cannot be negative
+        size_t x1 = Carta::Lib::clamp<size_t>(allValues.size() * q , 1, allValues.size()) - 1;
+        CARTA_ASSERT( 0 <= x1 && x1 < allValues.size() );
+        std::nth_element( allValues.begin(), allValues.begin() + x1, allValues.end() );
+        result[q] = allValues[x1];
+    }
+
+    CARTA_ASSERT( result.size() == percentiles.size());
+
+    return result;
+}
+
 template <typename Scalar>
 PercentilesToPixels<Scalar>::PercentilesToPixels() : Carta::Lib::IPercentilesToPixels<Scalar>(0, "Exact percentile algorithm") {
 }
@@ -90,6 +120,10 @@ MinMaxPercentiles<Scalar>::MinMaxPercentiles() : Carta::Lib::IPercentilesToPixel
 /// \note NANs are treated as if they did not exist
 ///
 /// \note for best performance, the supplied list of percentiles should be sorted small->large
+///
+/// \note without a frame-dependent conversion, float pixels are kept as floats: widening
+/// them to Scalar does not change their order, so the same values are selected with half
+/// the memory
 template < typename Scalar >
 std::map < double, Scalar >
 PercentilesToPixels<Scalar>::percentile2pixels(
@@ -116,6 +150,8 @@ PercentilesToPixels<Scalar>::percentile2pixels(
 
     // read in all values from the view into memory so that we can do quickselect on it
     std::vector < Scalar > allValues;
+    std::vector < float > allFloats;
+    const bool floatPixels = view.rawView()->pixelType() == Carta::Lib::Image::PixelType::Real32;
     double hertzVal;
 
 
@@ -132,18 +168,32 @@ PercentilesToPixels<Scalar>::percentile2pixels(
             Carta::Lib::NdArray::Double viewSlice = Carta::Lib::viewSliceForFrame(view, spectralIndex, f);
 
             // iterate over the frame
-            viewSlice.forEach([&allValues, &converter, &hertzVal](const Scalar & val) {
-                if ( std::isfinite( val ) ) {
-                    allValues.push_back( converter->_frameDependentConvert(val, hertzVal) );
+            viewSlice.forEachBlock([&allValues, &converter, &hertzVal](const Scalar * vals, int64_t count) {
+                for ( int64_t i = 0 ; i < count ; i++ ) {
+                    if ( std::isfinite( vals[i] ) ) {
+                        allValues.push_back( converter->_frameDependentConvert(vals[i], hertzVal) );
+                    }
                 }
             });
         }
+    } else if ( floatPixels ) {
+        // no conversions, and the pixels can be read without widening them
+        Carta::Lib::NdArray::TypedView < float > floatView( view.rawView(), false );
+        floatView.forEachBlock([& allFloats] ( const float * vals, int64_t count ) {
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                if ( std::isfinite( vals[i] ) ) {
+                    allFloats.push_back( vals[i] );
+                }
+            }
+        });
     } else {
         // we don't have to do any conversions in the loop
         // and we can loop over the flat image
-        view.forEach([& allValues] ( const Scalar & val ) {
-            if ( std::isfinite( val ) ) {
-                allValues.push_back( val );
+        view.forEachBlock([& allValues] ( const Scalar * vals, int64_t count ) {
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                if ( std::isfinite( vals[i] ) ) {
+                    allValues.push_back( vals[i] );
+                }
             }
         });
     }
@@ -154,26 +204,10 @@ PercentilesToPixels<Scalar>::percentile2pixels(
         qCritical() << "<> Time to scan the raw data:" << elapsedTime << "ms";
     }
 
-    // indicate bad clip if no finite numbers were found
-    if ( allValues.size() == 0 ) {
-        qFatal( "The size of raw data is zero !!" );
+    if ( ! allFloats.empty() ) {
+        return selectPercentiles < Scalar > ( allFloats, percentiles );
     }
-
-    std::map < double, Scalar > result;
-
-    // for every input percentile, do quickselect and store the result
-
-    for ( double q : percentiles ) {
-        // we clamp to incremented values and decrement at the end because size_t cannot be negative
-        size_t x1 = Carta::Lib::clamp<size_t>(allValues.size() * q , 1, allValues.size()) - 1;
-        CARTA_ASSERT( 0 <= x1 && x1 < allValues.size() );
-        std::nth_element( allValues.begin(), allValues.begin() + x1, allValues.end() );
-        result[q] = allValues[x1];
-    }   
-
-    CARTA_ASSERT( result.size() == percentiles.size());
-
-    return result;
+    return selectPercentiles < Scalar > ( allValues, percentiles );
 } // percentile2pixels
 
 
@@ -201,20 +235,21 @@ PixelsToPercentiles<Scalar>::pixels2percentiles(
     std::vector<double> percentiles(intensities.size());
     
     // What we do in the loop doesn't change; how we calculate the target intensities changes
-    auto view_lambda = [&totalCount, &target_intensities, &countBelow](const double& val) {
-        if( Q_UNLIKELY( std::isnan(val))){
-            return;
-        }
-        
-        totalCount++;
+    auto view_lambda = [&totalCount, &target_intensities, &countBelow](const double * vals, int64_t count) {
+        for (int64_t j = 0; j < count; j++) {
+            const double val = vals[j];
+            if( Q_UNLIKELY( std::isnan(val))){
+                continue;
+            }
 
-        for (size_t i = 0; i < target_intensities.size(); i++) {
-            if( val <= target_intensities[i]){
-                countBelow[i]++;
+            totalCount++;
+
+            for (size_t i = 0; i < target_intensities.size(); i++) {
+                if( val <= target_intensities[i]){
+                    countBelow[i]++;
+                }
             }
         }
-        
-        return;
     };
 
     if (converter) {
@@ -233,16 +268,16 @@ PixelsToPercentiles<Scalar>::pixels2percentiles(
 
                 Carta::Lib::NdArray::Double viewSlice = Carta::Lib::viewSliceForFrame(view, spectralIndex, f);
                 
-                viewSlice.forEach(view_lambda);
+                viewSlice.forEachBlock(view_lambda);
             }
 
         } else { // not frame-dependent; calculate the target intensities once; iterate over flat image
             target_intensities = divided_intensities;
-            view.forEach(view_lambda);
+            view.forEachBlock(view_lambda);
         }
     } else { // no conversion; iterate over flat image
         target_intensities = intensities;
-        view.forEach(view_lambda);
+        view.forEachBlock(view_lambda);
     } 
 
     for (size_t i = 0; i < intensities.size(); i++) { // calculate the percentages
@@ -309,21 +344,25 @@ MinMaxPercentiles<Scalar>::percentile2pixels(
             Carta::Lib::NdArray::Double viewSlice = Carta::Lib::viewSliceForFrame(view, spectralIndex, f);
 
             // iterate over the frame
-            viewSlice.forEach([&minPixel, &maxPixel, &converter, &hertzVal, &convertedVal] ( const Scalar &val ) {
-                if ( std::isfinite( val ) ) {
-                    convertedVal = converter->_frameDependentConvert(val, hertzVal);
-                    minPixel = std::min(minPixel, convertedVal);
-                    maxPixel = std::max(maxPixel, convertedVal);
+            viewSlice.forEachBlock([&minPixel, &maxPixel, &converter, &hertzVal, &convertedVal] ( const Scalar * vals, int64_t count ) {
+                for ( int64_t i = 0 ; i < count ; i++ ) {
+                    if ( std::isfinite( vals[i] ) ) {
+                        convertedVal = converter->_frameDependentConvert(vals[i], hertzVal);
+                        minPixel = std::min(minPixel, convertedVal);
+                        maxPixel = std::max(maxPixel, convertedVal);
+                    }
                 }
             });
         }
     } else {
         // we don't have to do any conversions in the loop
         // and we can loop over the flat image
-        view.forEach([&minPixel, &maxPixel] ( const Scalar &val ) {
-            if ( std::isfinite( val ) ) {
-                minPixel = std::min(minPixel, val);
-                maxPixel = std::max(maxPixel, val);
+        view.forEachBlock([&minPixel, &maxPixel] ( const Scalar * vals, int64_t count ) {
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                if ( std::isfinite( vals[i] ) ) {
+                    minPixel = std::min(minPixel, vals[i]);
+                    maxPixel = std::max(maxPixel, vals[i]);
+                }
             }
         });
     }
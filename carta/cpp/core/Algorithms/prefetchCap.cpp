@@ -0,0 +1,44 @@
+/**
+ *
+ **/
+
+#include "prefetchCap.h"
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+void
+PrefetchCap::shrunk( uint64_t maxBytes )
+{
+    // only the tightest cap counts until the budget has room again
+    int64_t bytes = static_cast < int64_t > ( maxBytes );
+    if ( m_maxBytes < 0 || bytes < m_maxBytes ) {
+        m_maxBytes = bytes;
+    }
+}
+
+bool
+PrefetchCap::allows( int64_t heldBytes, int64_t frameBytes ) const
+{
+    return m_maxBytes < 0 || heldBytes + frameBytes <= m_maxBytes;
+}
+
+void
+PrefetchCap::track( int64_t heldBytes, uint64_t availableBytes )
+{
+    if ( m_maxBytes >= 0 ) {
+        m_maxBytes = heldBytes + static_cast < int64_t > ( availableBytes );
+    }
+}
+
+void
+PrefetchCap::clear()
+{
+    m_maxBytes = - 1;
+}
+}
+}
+}
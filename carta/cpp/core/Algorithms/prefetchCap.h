@@ -0,0 +1,52 @@
+/**
+ * Keeps frames read ahead of time from being read again and again when the memory
+ * budget has no room for them.
+ *
+ * When the budget shrinks the prefetched frames, the memory they were shrunk to becomes
+ * a cap on the frames that are read. From then on the cap follows the memory the budget
+ * has left, so that it grows when other caches free memory.
+ **/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+class PrefetchCap
+{
+public:
+
+    /// \brief the memory budget shrank the prefetched frames
+    /// \param maxBytes the memory the frames had to fit into
+    void
+    shrunk( uint64_t maxBytes );
+
+    /// \brief whether a frame may be read, or kept after it has been read
+    /// \param heldBytes memory used by the other frames that have been or are being read
+    /// \param frameBytes memory the frame uses
+    bool
+    allows( int64_t heldBytes, int64_t frameBytes ) const;
+
+    /// \brief once capped, let the frames use what they hold plus what the budget has left
+    /// \param heldBytes memory used by the frames that have been read
+    /// \param availableBytes memory the budget has not handed out
+    void
+    track( int64_t heldBytes, uint64_t availableBytes );
+
+    /// lift the cap
+    void
+    clear();
+
+private:
+
+    /// memory the frames may use, or -1 if the budget has not shrunk them
+    int64_t m_maxBytes = - 1;
+};
+}
+}
+}
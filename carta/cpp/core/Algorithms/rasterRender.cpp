@@ -0,0 +1,124 @@
+/**
+ *
+ **/
+
+#include "rasterRender.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+namespace RasterRender
+{
+int
+defaultThreadCount()
+{
+#ifdef _OPENMP
+    return std::max( 1, omp_get_max_threads() );
+#else
+    return 1;
+#endif
+}
+
+void
+raw2double( Carta::Lib::Image::PixelType pixelType, const char * src, int64_t count,
+            double * dst )
+{
+    if ( ! Carta::Lib::convertPixels < double > ( pixelType, src, count, dst ) ) {
+        qFatal( "raw2double: unsupported pixel type" );
+    }
+} // raw2double
+
+void
+view2indices( Carta::Lib::NdArray::RawViewInterface * rawView,
+              const Carta::Lib::PixelPipeline::CachedPipeline < false > & pipe,
+              std::vector < uint16_t > & indices,
+              int nThreads )
+{
+    int64_t nPixels = 1;
+    for ( int dim : rawView-> dims() ) {
+        nPixels *= dim;
+    }
+    indices.resize( nPixels );
+    if ( nPixels == 0 ) {
+        return;
+    }
+    if ( nThreads <= 0 ) {
+        nThreads = defaultThreadCount();
+    }
+
+    const auto pixelType = rawView-> pixelType();
+    const int64_t pixelSize = Carta::Lib::Image::pixelType2size( pixelType );
+    const bool native = pixelType == Carta::Lib::Image::PixelType::Real32;
+    std::vector < double > values;
+    int64_t counter = 0;
+
+    auto bandFunc = [&] ( const char * data, int64_t count ) {
+        CARTA_ASSERT( counter + count <= nPixels );
+        count = std::min( count, nPixels - counter );
+        if ( ! native ) {
+            values.resize( count );
+        }
+        uint16_t * dst = & indices[counter];
+        const int64_t nChunks = std::min < int64_t > ( count, nThreads * ChunksPerThread );
+        const int64_t chunkSize = ( count + nChunks - 1 ) / nChunks;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( static )
+#endif
+        for ( int64_t chunk = 0 ; chunk < nChunks ; chunk++ ) {
+            const int64_t i = chunk * chunkSize;
+            const int64_t n = std::min( count, i + chunkSize ) - i;
+            if ( n <= 0 ) {
+                continue;
+            }
+            if ( native ) {
+                pipe.convertIndexBlock( reinterpret_cast < const float * > ( data ) + i, n, dst + i );
+            }
+            else {
+                raw2double( pixelType, data + i * pixelSize, n, & values[i] );
+                pipe.convertIndexBlock( & values[i], n, dst + i );
+            }
+        }
+        counter += count;
+    };
+    rawView-> forEach( BandPixels * pixelSize, bandFunc, nullptr,
+                       Carta::Lib::NdArray::RawViewInterface::Traversal::Sequential );
+
+    CARTA_ASSERT( counter == nPixels );
+} // view2indices
+
+void
+indices2qImage( const std::vector < uint16_t > & indices,
+                const Carta::Lib::PixelPipeline::CachedPipeline < false > & pipe,
+                QImage & qImage,
+                QRgb nanColor,
+                int nThreads )
+{
+    const int64_t width = qImage.width();
+    const int64_t height = qImage.height();
+    CARTA_ASSERT( qImage.bytesPerLine() == width * 4 );
+    CARTA_ASSERT( int64_t( indices.size() ) == width * height );
+    if ( nThreads <= 0 ) {
+        nThreads = defaultThreadCount();
+    }
+    uchar * bits = qImage.bits();
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( static )
+#endif
+    for ( int64_t row = 0 ; row < height ; row++ ) {
+        QRgb * dst = reinterpret_cast < QRgb * > ( bits + ( height - 1 - row ) * width * 4 );
+        pipe.convertIndexqBlock( & indices[row * width], width, dst, nanColor );
+    }
+} // indices2qImage
+}
+}
+}
+}
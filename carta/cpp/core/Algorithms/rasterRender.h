@@ -0,0 +1,217 @@
+/**
+ * Algorithms for converting raw views into RGB raster images (used by the image
+ * render service).
+ *
+ * The data is pulled from the view in bulk via the buffered
+ * RawViewInterface::forEach( buffSize, ...) API, a band of rows at a time. Each band
+ * is converted to the working scalar type and colormapped by multiple threads, every
+ * thread working on a contiguous part of the band. Float views are kept as floats, all
+ * other pixel types are converted to doubles.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IImage.h"
+#include "CartaLib/PixelPipeline/IPixelPipeline.h"
+
+#include <QImage>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+namespace RasterRender
+{
+/// approximate number of pixels to read from the view in one band
+static constexpr int64_t BandPixels = 1024 * 1024;
+
+/// number of chunks per thread each band is split into (for load balancing)
+static constexpr int ChunksPerThread = 4;
+
+/// return the number of threads used when the caller does not specify it
+int
+defaultThreadCount();
+
+/// \brief convert a block of raw pixels to doubles
+/// \param pixelType type of the raw pixels
+/// \param src raw pixels
+/// \param count number of pixels in src
+/// \param dst where to store the results
+void
+raw2double( Carta::Lib::Image::PixelType pixelType, const char * src, int64_t count,
+            double * dst );
+
+/// colormap a block of values with a generic pipeline, NaNs are mapped to nanColor
+/// \warning the pipeline needs to be thread safe if this is called from multiple threads
+template < class Pipeline, typename Scalar >
+inline void
+convertqBlock( Pipeline & pipe, const Scalar * src, int64_t count, QRgb * dst,
+               QRgb nanColor )
+{
+    for ( int64_t i = 0 ; i < count ; i++ ) {
+        if ( Q_LIKELY( ! std::isnan( src[i] ) ) ) {
+            pipe.convertq( src[i], dst[i] );
+        }
+        else {
+            dst[i] = nanColor;
+        }
+    }
+}
+
+/// specialization for cached pipelines, which have a vectorizable block converter
+template < bool interpolated, typename Scalar >
+inline void
+convertqBlock( Carta::Lib::PixelPipeline::CachedPipeline < interpolated > & pipe,
+               const Scalar * src, int64_t count, QRgb * dst, QRgb nanColor )
+{
+    pipe.convertqBlock( src, count, dst, nanColor );
+}
+
+/// \brief view2qImage() with the values converted to Scalar (float or double) before
+/// they are colormapped, see view2qImage() for the parameters
+template < typename Scalar, class Pipeline >
+void
+view2qImageAs( Carta::Lib::NdArray::RawViewInterface * rawView,
+               Pipeline & pipe,
+               QImage & qImage,
+               QRgb nanColor,
+               int nThreads )
+{
+    const int64_t width = qImage.width();
+    const int64_t height = qImage.height();
+    const int64_t nPixels = width * height;
+    CARTA_ASSERT( qImage.bytesPerLine() == width * 4 );
+    if ( nPixels == 0 ) {
+        return;
+    }
+
+    const auto pixelType = rawView-> pixelType();
+    const int64_t pixelSize = Carta::Lib::Image::pixelType2size( pixelType );
+    const int64_t bandRows = std::max < int64_t > ( 1, BandPixels / width );
+    const int64_t buffSize = bandRows * width * pixelSize;
+
+    // when the pixels already are Scalars they are colormapped straight from the band
+    const bool native = pixelType == Carta::Lib::Image::CType2PixelType < Scalar >::type;
+    uchar * bits = qImage.bits();
+    std::vector < Scalar > values;
+    int64_t counter = 0;
+
+    auto bandFunc = [&] ( const char * data, int64_t count ) {
+        CARTA_ASSERT( counter + count <= nPixels );
+        count = std::min( count, nPixels - counter );
+        if ( ! native ) {
+            values.resize( count );
+        }
+        const Scalar * scalars = native ? reinterpret_cast < const Scalar * > ( data )
+                                        : values.data();
+        const int64_t first = counter;
+        const int64_t nChunks = std::min < int64_t > ( count, nThreads * ChunksPerThread );
+        const int64_t chunkSize = ( count + nChunks - 1 ) / nChunks;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nThreads ) schedule( static )
+#endif
+        for ( int64_t chunk = 0 ; chunk < nChunks ; chunk++ ) {
+            int64_t i = chunk * chunkSize;
+            const int64_t end = std::min( count, i + chunkSize );
+            if ( i >= end ) {
+                continue;
+            }
+            if ( ! native && ! Carta::Lib::convertPixels < Scalar > (
+                     pixelType, data + i * pixelSize, end - i, & values[i] ) ) {
+                qFatal( "view2qImage: unsupported pixel type" );
+            }
+
+            // colormap the chunk one row segment at a time
+            while ( i < end ) {
+                const int64_t ind = first + i;
+                const int64_t row = ind / width;
+                const int64_t col = ind % width;
+                const int64_t n = std::min( end - i, width - col );
+                QRgb * dst = reinterpret_cast < QRgb * > (
+                    bits + ( height - 1 - row ) * width * 4 ) + col;
+                convertqBlock( pipe, scalars + i, n, dst, nanColor );
+                i += n;
+            }
+        }
+        counter += count;
+    };
+    rawView-> forEach( buffSize, bandFunc, nullptr,
+                       Carta::Lib::NdArray::RawViewInterface::Traversal::Sequential );
+
+    CARTA_ASSERT( counter == nPixels );
+} // view2qImageAs
+
+/// \brief colormap the raw view into an already allocated qImage
+/// \param rawView the view to render (the first two dimensions are used as x/y)
+/// \param pipe the pixel pipeline to use
+/// \param qImage destination, it must be 32 bits per pixel, without padding, and sized to
+/// match the first two dimensions of rawView
+/// \param nanColor color to use for NaNs
+/// \param nThreads number of threads to use, <= 0 means defaultThreadCount()
+///
+/// The image is constructed bottom-up, i.e. the first row of the view becomes the last
+/// scanline of the qImage.
+///
+/// \warning with nThreads > 1 the pipeline's convertq() will be called concurrently,
+/// so only pass thread safe pipelines (e.g. CachedPipeline) in that case
+template < class Pipeline >
+void
+view2qImage( Carta::Lib::NdArray::RawViewInterface * rawView,
+             Pipeline & pipe,
+             QImage & qImage,
+             QRgb nanColor,
+             int nThreads = 0 )
+{
+    if ( nThreads <= 0 ) {
+        nThreads = defaultThreadCount();
+    }
+
+    // floats are exactly representable as doubles, so converting them would only
+    // double the memory traffic without changing the colors
+    if ( rawView-> pixelType() == Carta::Lib::Image::PixelType::Real32 ) {
+        view2qImageAs < float > ( rawView, pipe, qImage, nanColor, nThreads );
+    }
+    else {
+        view2qImageAs < double > ( rawView, pipe, qImage, nanColor, nThreads );
+    }
+} // view2qImage
+
+/// \brief compute the cache indices (see CachedPipeline::convertIndexBlock()) of all
+/// pixels of a raw view
+/// \param rawView the view (the first two dimensions are used as x/y)
+/// \param pipe the cache that determines the geometry of the indices
+/// \param indices where to store the indices, in the order of the view (i.e. the first
+/// row of the view comes first), it is resized to the number of pixels
+/// \param nThreads number of threads to use, <= 0 means defaultThreadCount()
+void
+view2indices( Carta::Lib::NdArray::RawViewInterface * rawView,
+              const Carta::Lib::PixelPipeline::CachedPipeline < false > & pipe,
+              std::vector < uint16_t > & indices,
+              int nThreads = 0 );
+
+/// \brief colormap indices computed by view2indices() into an already allocated qImage
+/// \param indices the indices, one per pixel of the qImage
+/// \param pipe the pipeline, with the same min/max/size as the one used to compute them
+/// \param qImage destination, it must be 32 bits per pixel and without padding
+/// \param nanColor color to use for NaNs
+/// \param nThreads number of threads to use, <= 0 means defaultThreadCount()
+///
+/// The result is identical to view2qImage() of the original view, including the
+/// bottom-up row order.
+void
+indices2qImage( const std::vector < uint16_t > & indices,
+                const Carta::Lib::PixelPipeline::CachedPipeline < false > & pipe,
+                QImage & qImage,
+                QRgb nanColor,
+                int nThreads = 0 );
+}
+}
+}
+}
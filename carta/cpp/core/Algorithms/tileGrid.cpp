@@ -0,0 +1,77 @@
+/**
+ *
+ **/
+
+#include "tileGrid.h"
+#include "CartaLib/CartaLib.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+namespace TileGrid
+{
+QRect
+tilesCovering( const QRectF & visible, int64_t width, int64_t height, int size, int margin )
+{
+    // shift by a half, so that pixel x covers [x, x + 1]
+    QRectF rect = visible.normalized().translated( 0.5, 0.5 );
+    if ( width <= 0 || height <= 0 || rect.right() <= 0 || rect.bottom() <= 0 ||
+         rect.left() >= width || rect.top() >= height ) {
+        return QRect();
+    }
+
+    // a pixel is visible if any of it is, so an edge exactly between two pixels
+    // only makes the pixel on the inside visible
+    const int64_t lastTileX = ( width - 1 ) / size;
+    const int64_t lastTileY = ( height - 1 ) / size;
+    int64_t xMin = Carta::Lib::clamp < int64_t > ( std::floor( rect.left() ), 0, width - 1 );
+    int64_t xMax = Carta::Lib::clamp < int64_t > ( std::ceil( rect.right() ) - 1, 0, width - 1 );
+    int64_t yMin = Carta::Lib::clamp < int64_t > ( std::floor( rect.top() ), 0, height - 1 );
+    int64_t yMax = Carta::Lib::clamp < int64_t > ( std::ceil( rect.bottom() ) - 1, 0, height - 1 );
+    int64_t tx1 = std::max < int64_t > ( xMin / size - margin, 0 );
+    int64_t tx2 = std::min < int64_t > ( xMax / size + margin, lastTileX );
+    int64_t ty1 = std::max < int64_t > ( yMin / size - margin, 0 );
+    int64_t ty2 = std::min < int64_t > ( yMax / size + margin, lastTileY );
+    return QRect( tx1, ty1, tx2 - tx1 + 1, ty2 - ty1 + 1 );
+}
+
+QRect
+tileRect( int tx, int ty, int64_t width, int64_t height, int size )
+{
+    int64_t x1 = int64_t( tx ) * size;
+    int64_t y1 = int64_t( ty ) * size;
+    int64_t x2 = std::min < int64_t > ( x1 + size, width );
+    int64_t y2 = std::min < int64_t > ( y1 + size, height );
+    return QRect( x1, y1, x2 - x1, y2 - y1 );
+}
+
+QRect
+tilesRect( const QRect & tiles, int64_t width, int64_t height, int size )
+{
+    if ( tiles.isEmpty() ) {
+        return QRect();
+    }
+    return tileRect( tiles.left(), tiles.top(), width, height, size ).united(
+               tileRect( tiles.right(), tiles.bottom(), width, height, size ) );
+}
+
+void
+cropIndices( const std::vector < uint16_t > & indices, int64_t width, const QRect & rect,
+             std::vector < uint16_t > & out )
+{
+    out.resize( int64_t( rect.width() ) * rect.height() );
+    for ( int y = 0 ; y < rect.height() ; y++ ) {
+        const uint16_t * src = indices.data() + ( rect.top() + y ) * width + rect.left();
+        std::copy( src, src + rect.width(), out.data() + int64_t( y ) * rect.width() );
+    }
+}
+}
+}
+}
+}
@@ -0,0 +1,54 @@
+/**
+ * Geometry of the tiles the image render service splits a frame into.
+ *
+ * Tile (tx,ty) covers the pixels [tx*size, (tx+1)*size) x [ty*size, (ty+1)*size) of the
+ * frame, the tiles in the last column and row are clipped to the frame. Image pixel x
+ * covers the image coordinates [x - 1/2, x + 1/2].
+ **/
+
+#pragma once
+
+#include <QRect>
+#include <QRectF>
+#include <cstdint>
+#include <vector>
+
+namespace Carta
+{
+namespace Core
+{
+namespace Algorithms
+{
+namespace TileGrid
+{
+/// \brief find the tiles covering the visible part of a frame
+/// \param visible the visible rectangle, in image coordinates
+/// \param width width of the frame
+/// \param height height of the frame
+/// \param size size of the tiles
+/// \param margin number of extra tiles around the visible ones
+/// \return the range of tiles (in tile units), clamped to the frame, or an empty
+/// rectangle if none of the frame is visible
+QRect
+tilesCovering( const QRectF & visible, int64_t width, int64_t height, int size, int margin );
+
+/// return the pixels of the frame covered by tile (tx,ty)
+QRect
+tileRect( int tx, int ty, int64_t width, int64_t height, int size );
+
+/// return the pixels of the frame covered by a range of tiles
+QRect
+tilesRect( const QRect & tiles, int64_t width, int64_t height, int size );
+
+/// \brief copy the indices of a rectangle of pixels out of the indices of a whole frame
+/// \param indices the indices of the frame, one per pixel, in row major order
+/// \param width width of the frame
+/// \param rect the rectangle, which must be inside the frame
+/// \param out set to the indices of the rectangle, in row major order
+void
+cropIndices( const std::vector < uint16_t > & indices, int64_t width, const QRect & rect,
+             std::vector < uint16_t > & out );
+}
+}
+}
+}
@@ -5,6 +5,8 @@
 #include "Data/Util.h"
 #include "State/UtilState.h"
 #include "CartaLib/CartaLib.h"
+#include "Globals.h"
+#include "MainConfig.h"
 
 #include <QDebug>
 
@@ -104,6 +106,8 @@ bool Animator::_addAnimatorType( const QString& type, QString& animatorTypeId ){
         //Restore the stored preferences.
         connect( m_animators[type], SIGNAL(indexChanged( int, const QString&)),
                 this, SLOT(_frameChanged(int, const QString&)));
+        connect( m_animators[type], SIGNAL(playingChanged( bool, const QString&)),
+                this, SLOT(_playingChanged(bool, const QString&)));
     }
     return animatorAdded;
 }
@@ -235,6 +239,13 @@ void Animator::clear(){
 
 void Animator::_frameChanged( int index, const QString& axisName ){
     changeFrame( index, axisName );
+    if ( m_animators.contains( axisName ) && m_animators[axisName]->isPlaying() ){
+        _prefetchFrames( axisName );
+    }
+}
+
+void Animator::_playingChanged( bool /*playing*/, const QString& axisName ){
+    _prefetchFrames( axisName );
 }
 
 AnimatorType* Animator::getAnimator( const QString& type ){
@@ -482,6 +493,29 @@ void Animator::refreshState(){
     m_linkImpl->refreshState();
 }
 
+void Animator::_prefetchFrames( const QString& axisName ){
+    const MainConfig::ParsedInfo* config = Globals::instance()->mainConfig();
+    if ( !config->isAnimationPrefetch() || !m_animators.contains( axisName ) ){
+        return;
+    }
+    AxisInfo::KnownType axisType = AxisMapper::getType( axisName );
+    if ( axisType == AxisInfo::KnownType::OTHER ){
+        return;
+    }
+    //Frames stepped through by hand are not worth reading ahead.
+    std::vector<int> upcoming;
+    if ( m_animators[axisName]->isPlaying() ){
+        upcoming = m_animators[axisName]->getUpcomingFrames( config->getAnimationPrefetchFrames() );
+    }
+    int linkCount = m_linkImpl->getLinkCount();
+    for( int i = 0; i < linkCount; i++ ){
+        Controller* controller = dynamic_cast<Controller*>( m_linkImpl->getLink(i));
+        if ( controller != nullptr ){
+            controller->_prefetchFrames( upcoming, axisType );
+        }
+    }
+}
+
 void Animator::_regionsChanged( Controller* controller ){
 	int selectRegionIndex = controller->getRegionIndexCurrent();
 	_resetAnimationRegion( selectRegionIndex );
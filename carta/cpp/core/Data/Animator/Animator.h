@@ -151,6 +151,7 @@ private slots:
     void _adjustStateController( Controller* controller);
     void _axesChanged();
     void _frameChanged( int index, const QString& axisName );
+    void _playingChanged( bool playing, const QString& axisName );
     void _regionsChanged( Controller* controller );
     void _updateFrame( Controller* controller, Carta::Lib::AxisInfo::KnownType type );
 
@@ -175,6 +176,10 @@ private:
     void _initializeCallbacks();
     QString _initAnimator( const QString& type, bool* newAnimator );
 
+    //Start reading the frames the animation of the axis is about to show while it is
+    //playing; drop the frames read ahead once it stops.
+    void _prefetchFrames( const QString& axisName );
+
     void _resetAnimationParameters( int selectedImage );
     void _resetAnimationRegion( int selectedIndex );
 
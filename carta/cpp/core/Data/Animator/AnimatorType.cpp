@@ -30,6 +30,7 @@ const QString AnimatorType::END_BEHAVIOR_REVERSE = "Reverse";
 const QString AnimatorType::RATE = "frameRate";
 const QString AnimatorType::SETTINGS_VISIBLE = "showSettings";
 const QString AnimatorType::STEP = "frameStep";
+const int AnimatorType::UPCOMING_MS = 2000;
 
 const QString AnimatorType::CLASS_NAME = "AnimatorType";
 const QString AnimatorType::ANIMATIONS = "animators";
@@ -43,6 +44,9 @@ AnimatorType::AnimatorType(const QString& path, const QString& id ):
         m_select = nullptr;
         m_removed = false;
         m_visible = true;
+        m_lastFrame = 0;
+        m_forward = true;
+        m_playing = false;
         _initializeState();
         _makeSelection();
 
@@ -56,6 +60,19 @@ int AnimatorType::getFrame() const {
     return m_select->getIndex();
 }
 
+int AnimatorType::getFrameInterval() const {
+    //Same as the client: the rate goes from 1 (slowest) to 100 (fastest).
+    int rate = m_state.getValue<int>( RATE );
+    int interval = static_cast<int>( ( 1 - rate / 100.0 ) * 2000 );
+    return qMax( 10, interval );
+}
+
+FrameSequence AnimatorType::getFrameSequence() const {
+    QString endStr = m_state.getValue<QString>( END_BEHAVIOR );
+    return FrameSequence( m_select->getLowerBoundUser(), m_select->getUpperBoundUser(),
+            m_state.getValue<int>( STEP ), FrameSequence::toEndBehavior( endStr ) );
+}
+
 QString AnimatorType::getStateData() const {
     QString result = m_select->getStateString();
     return result;
@@ -70,6 +87,11 @@ QString AnimatorType::getType() const {
     return m_type;
 }
 
+std::vector<int> AnimatorType::getUpcomingFrames( int maxCount ) const {
+    int count = qBound( 1, UPCOMING_MS / getFrameInterval(), qMax( 1, maxCount ) );
+    return getFrameSequence().upcoming( m_select->getIndex(), m_forward, count );
+}
+
 void AnimatorType::_initializeState( ){
     m_state.insertValue<int>( STEP, 1 );
     m_state.insertValue<int>( RATE, 100 );
@@ -187,6 +209,24 @@ void AnimatorType::_initializeCommands(){
         return result;
     });
 
+    addCommandCallback( "setPlaying", [=] (const QString & /*cmd*/,
+                                                const QString & params, const QString & /*sessionId*/) -> QString {
+            QString result;
+            std::set<QString> keys = {"playing"};
+            std::map<QString,QString> dataValues = Carta::State::UtilState::parseParamMap( params, keys );
+            QString playingStr = dataValues[*keys.begin()];
+            bool validBool = false;
+            bool playing = Util::toBool( playingStr, &validBool );
+            if ( validBool  ){
+                setPlaying( playing );
+            }
+            else {
+                result = "Animator playing must be true/false: "+params;
+            }
+            Util::commandPostProcess( result );
+            return result;
+        });
+
     addCommandCallback( "setSettingsVisible", [=] (const QString & /*cmd*/,
                                                 const QString & params, const QString & /*sessionId*/) -> QString {
             QString result;
@@ -206,6 +246,10 @@ void AnimatorType::_initializeCommands(){
         });
 }
 
+bool AnimatorType::isPlaying() const {
+    return m_playing;
+}
+
 bool AnimatorType::isRemoved() const {
     return m_removed;
 }
@@ -233,7 +277,11 @@ void AnimatorType::resetStateData( const QString& state ){
 }
 
 void AnimatorType::_selectionChanged(){
-    emit indexChanged( m_select->getIndex(), m_type );
+    int frame = m_select->getIndex();
+    //Remember which way the animation is moving; a jump to another frame keeps the direction.
+    getFrameSequence().followed( m_lastFrame, frame, &m_forward );
+    m_lastFrame = frame;
+    emit indexChanged( frame, m_type );
 }
 
 void AnimatorType::_setType( const QString& type ){
@@ -318,6 +366,13 @@ QString AnimatorType::setLowerBoundUser( int lowerBound ){
     return result;
 }
 
+void AnimatorType::setPlaying( bool playing ){
+    if ( m_playing != playing ){
+        m_playing = playing;
+        emit playingChanged( playing, m_type );
+    }
+}
+
 void AnimatorType::setSettingsVisible( bool visible ){
     bool oldVisible = m_state.getValue<bool>(SETTINGS_VISIBLE);
     if ( oldVisible != visible ){
@@ -5,7 +5,10 @@
 
 #pragma once
 
+#include "FrameSequence.h"
+
 #include <memory>
+#include <vector>
 #include <QObject>
 #include <State/StateInterface.h>
 #include <State/ObjectManager.h>
@@ -30,6 +33,19 @@ public:
      */
     int getFrame() const;
 
+    /**
+     * Returns the time between two frames of the animation, computed the same way as
+     * the client does.
+     * @return the time between frames in milliseconds.
+     */
+    int getFrameInterval() const;
+
+    /**
+     * Returns the rules for stepping from one frame of the animation to the next.
+     * @return the frame sequence of the animation.
+     */
+    FrameSequence getFrameSequence() const;
+
     /**
      * Returns a json string representing the user preferences.
      * @return a Json string representing user preferences.
@@ -44,6 +60,20 @@ public:
 
     QString getType() const;
 
+    /**
+     * Returns the frames the animation is about to show, in the direction it was last
+     * moving; enough to cover a short stretch of playback.
+     * @param maxCount - the maximum number of frames to return.
+     * @return the upcoming frames, the soonest first.
+     */
+    std::vector<int> getUpcomingFrames( int maxCount ) const;
+
+    /**
+     * Returns true if the animation is playing; false if frames are only changed by hand.
+     * @return true if the animation is playing; false otherwise.
+     */
+    bool isPlaying() const;
+
     /**
      * Returns true if the animator is no longer visually available; false otherwise.
      * @return true if the animator is hidden; false otherwise.
@@ -112,6 +142,12 @@ public:
      */
     QString setUpperBoundUser( int upperBound );
 
+    /**
+     * Notification from the client that the animation started or stopped playing.
+     * @param playing - true if the animation is playing; false otherwise.
+     */
+    void setPlaying( bool playing );
+
     /**
      * Show/hide the animator settings.
      * @param visible - true if the animator settings should be visible; false otherwise.
@@ -133,6 +169,7 @@ public:
 
 signals:
     void indexChanged(int,const QString&);
+    void playingChanged(bool,const QString&);
 
 private slots:
     void _selectionChanged();
@@ -170,6 +207,16 @@ private:
     const static QString RATE;
     const static QString STEP;
 
+    //Stretch of playback, in milliseconds, that upcoming frames should cover.
+    const static int UPCOMING_MS;
+
+    //The last frame shown and the direction the animation was moving in.
+    int m_lastFrame;
+    bool m_forward;
+
+    //Whether the client is playing the animation.
+    bool m_playing;
+
     bool m_visible;
     bool m_removed;
     AnimatorType( const AnimatorType& other);
@@ -0,0 +1,104 @@
+#include "Data/Animator/FrameSequence.h"
+
+#include <algorithm>
+#include <set>
+
+namespace Carta {
+
+namespace Data {
+
+FrameSequence::FrameSequence( int lowerBound, int upperBound, int step, EndBehavior endBehavior ):
+    m_lowerBound( lowerBound ),
+    m_upperBound( std::max( lowerBound, upperBound ) ),
+    m_step( std::max( 1, step ) ),
+    m_endBehavior( endBehavior ){
+}
+
+bool FrameSequence::followed( int previous, int frame, bool* forward ) const {
+    bool stepped = false;
+    bool direction = *forward;
+    //Prefer the current direction, the two directions can lead to the same frame.
+    for ( int i = 0; i < 2 && !stepped; i++ ){
+        bool tryForward = ( i == 0 ) ? *forward : !*forward;
+        direction = tryForward;
+        stepped = ( next( previous, &direction ) == frame );
+    }
+    if ( stepped ){
+        *forward = direction;
+    }
+    return stepped;
+}
+
+int FrameSequence::next( int frame, bool* forward ) const {
+    int val = frame;
+    if ( *forward ){
+        if ( m_endBehavior == EndBehavior::JUMP ){
+            val = frame < m_upperBound ? m_upperBound : m_lowerBound;
+        }
+        else {
+            val = frame + m_step;
+            if ( val > m_upperBound ){
+                if ( m_endBehavior == EndBehavior::WRAP ){
+                    val = m_lowerBound;
+                }
+                else {
+                    //The client turns around and steps back from the current frame.
+                    *forward = false;
+                    val = std::max( m_lowerBound, frame - m_step );
+                }
+            }
+        }
+    }
+    else {
+        if ( m_endBehavior == EndBehavior::JUMP ){
+            val = frame > m_lowerBound ? m_lowerBound : m_upperBound;
+        }
+        else {
+            val = frame - m_step;
+            if ( val < m_lowerBound ){
+                if ( m_endBehavior == EndBehavior::WRAP ){
+                    val = m_upperBound;
+                }
+                else {
+                    *forward = true;
+                    val = std::min( m_upperBound, frame + m_step );
+                }
+            }
+        }
+    }
+    return val;
+}
+
+FrameSequence::EndBehavior FrameSequence::toEndBehavior( const QString& name, bool* valid ){
+    EndBehavior endBehavior = EndBehavior::WRAP;
+    bool recognized = true;
+    if ( name == "Jump" ){
+        endBehavior = EndBehavior::JUMP;
+    }
+    else if ( name == "Reverse" ){
+        endBehavior = EndBehavior::REVERSE;
+    }
+    else if ( name != "Wrap" ){
+        recognized = false;
+    }
+    if ( valid != nullptr ){
+        *valid = recognized;
+    }
+    return endBehavior;
+}
+
+std::vector<int> FrameSequence::upcoming( int frame, bool forward, int count ) const {
+    std::vector<int> frames;
+    std::set<int> seen = { frame };
+    for ( int i = 0; i < count; i++ ){
+        frame = next( frame, &forward );
+        if ( seen.count( frame ) > 0 ){
+            break;
+        }
+        seen.insert( frame );
+        frames.push_back( frame );
+    }
+    return frames;
+}
+}
+}
@@ -0,0 +1,81 @@
+/***
+ * Predicts the frames an animation will show, using the same rules as the animator
+ * widget of the client: the frame step, the user bounds, and what happens at the ends
+ * of the range.
+ */
+
+#pragma once
+
+#include <QString>
+#include <vector>
+
+namespace Carta {
+
+namespace Data {
+
+class FrameSequence {
+
+public:
+
+    /// What the animation does when it steps past one end of the range.
+    enum class EndBehavior {
+        WRAP,       //Continue from the other end.
+        JUMP,       //Alternate between the two ends.
+        REVERSE     //Change direction.
+    };
+
+    /**
+     * Constructor.
+     * @param lowerBound - the first frame of the range.
+     * @param upperBound - the last frame of the range.
+     * @param step - the number of frames to move each time.
+     * @param endBehavior - what to do at the ends of the range.
+     */
+    FrameSequence( int lowerBound, int upperBound, int step, EndBehavior endBehavior );
+
+    /**
+     * Returns the frame shown after the given one.
+     * @param frame - the current frame.
+     * @param forward - whether the animation moves towards the upper bound; updated
+     *      when the animation reverses at an end.
+     * @return the next frame.
+     */
+    int next( int frame, bool* forward ) const;
+
+    /**
+     * Returns the frames shown after the given one, in order.
+     * @param frame - the current frame.
+     * @param forward - whether the animation moves towards the upper bound.
+     * @param count - the number of frames wanted.
+     * @return up to count frames; frames are not repeated, so fewer are returned
+     *      for short ranges.
+     */
+    std::vector<int> upcoming( int frame, bool forward, int count ) const;
+
+    /**
+     * Figures out which way the animation moved between two frames.
+     * @param previous - the frame shown before.
+     * @param frame - the frame shown now.
+     * @param forward - the direction the animation was moving in; updated if the move
+     *      was a step of the animation in either direction, left unchanged otherwise
+     *      (e.g. when the user jumped to an arbitrary frame).
+     * @return true if the move was a step of the animation; false otherwise.
+     */
+    bool followed( int previous, int frame, bool* forward ) const;
+
+    /**
+     * Translates the end behavior names used by the animator.
+     * @param name - the name of the end behavior ("Wrap", "Jump" or "Reverse").
+     * @param valid - set to whether the name was recognized.
+     * @return the end behavior, WRAP if the name was not recognized.
+     */
+    static EndBehavior toEndBehavior( const QString& name, bool* valid = nullptr );
+
+private:
+    int m_lowerBound;
+    int m_upperBound;
+    int m_step;
+    EndBehavior m_endBehavior;
+};
+}
+}
@@ -0,0 +1,721 @@
+#include "ComputeWorkerPool.h"
+#include "Data/Histogram/Render/HistogramRenderRequest.h"
+#include "Data/Util.h"
+#include "Globals.h"
+#include "PluginManager.h"
+#include "Algorithms/rasterRender.h"
+#include "CartaLib/Hooks/Histogram.h"
+#include "CartaLib/Hooks/ProfileHook.h"
+#include "CartaLib/Hooks/LoadAstroImage.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/IImage.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSocketNotifier>
+#include <QThread>
+
+#include <algorithm>
+#include <climits>
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <poll.h>
+#include <signal.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Carta {
+namespace Data {
+
+const int ComputeWorkerPool::MAX_WORKERS = 4;
+
+namespace {
+
+//Number of images each worker keeps open.
+const int MAX_OPEN_IMAGES = 4;
+
+//Maximum number of bytes received from a worker each time its socket becomes readable,
+//so that the main thread gets back to its event loop while a large frame comes in.
+const qint64 MAX_READ_PER_EVENT = 4 * 1024 * 1024;
+
+//Write the whole buffer; send() is used so that a dead peer does not raise SIGPIPE.
+//The socket of the main process is non-blocking, so wait until it can take more.
+bool _writeAll( int socket, const char* data, quint64 size ){
+    while ( size > 0 ){
+        ssize_t n = send( socket, data, size, MSG_NOSIGNAL );
+        if ( n < 0 ){
+            if ( errno == EINTR ){
+                continue;
+            }
+            if ( errno == EAGAIN || errno == EWOULDBLOCK ){
+                pollfd writable = { socket, POLLOUT, 0 };
+                poll( &writable, 1, -1 );
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool _readAll( int socket, char* data, quint64 size ){
+    while ( size > 0 ){
+        ssize_t n = read( socket, data, size );
+        if ( n < 0 && errno == EINTR ){
+            continue;
+        }
+        if ( n <= 0 ){
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+//A message is the size of its header and of its pixels, followed by both.
+bool _writeMessage( int socket, const QByteArray& header, const char* pixels = nullptr,
+        quint64 pixelBytes = 0 ){
+    quint64 sizes[2] = { quint64( header.size() ), pixelBytes };
+    return _writeAll( socket, reinterpret_cast<const char*>( sizes ), sizeof( sizes ) ) &&
+            _writeAll( socket, header.constData(), header.size() ) &&
+            _writeAll( socket, pixels, pixelBytes );
+}
+
+//Blocking read of a message without pixels, used by the workers for their jobs.
+bool _readMessage( int socket, QByteArray& header ){
+    quint64 sizes[2] = { 0, 0 };
+    if ( !_readAll( socket, reinterpret_cast<char*>( sizes ), sizeof( sizes ) ) ){
+        return false;
+    }
+    if ( sizes[0] > INT_MAX || sizes[1] != 0 ){
+        return false;
+    }
+    header.resize( sizes[0] );
+    return _readAll( socket, header.data(), sizes[0] );
+}
+
+QByteArray _regionToJson( std::shared_ptr<Carta::Lib::Regions::RegionBase> region ){
+    QByteArray json;
+    if ( region ){
+        json = QJsonDocument( region->toJson() ).toJson( QJsonDocument::Compact );
+    }
+    return json;
+}
+
+std::shared_ptr<Carta::Lib::Regions::RegionBase> _regionFromJson( const QByteArray& json ){
+    std::shared_ptr<Carta::Lib::Regions::RegionBase> region( nullptr );
+    if ( !json.isEmpty() ){
+        region.reset( Carta::Lib::Regions::fromJson( QJsonDocument::fromJson( json ).object() ) );
+    }
+    return region;
+}
+
+/// most recently used images of a worker process, most recent first
+QList<QPair<QString, std::shared_ptr<Carta::Lib::Image::ImageInterface> > > openImages;
+
+std::shared_ptr<Carta::Lib::Image::ImageInterface> _openImage( const QString& fileName ){
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image( nullptr );
+    for ( int i = 0; i < openImages.size(); i++ ){
+        if ( openImages[i].first == fileName ){
+            image = openImages[i].second;
+            openImages.move( i, 0 );
+            return image;
+        }
+    }
+    try {
+        auto res = Globals::instance()-> pluginManager()
+                -> prepare <Carta::Lib::Hooks::LoadAstroImage>( fileName ).first();
+        if ( !res.isNull() ){
+            image = res.val();
+        }
+    }
+    catch( std::logic_error& err ){
+        qDebug() << "ComputeWorkerPool: failed to load image "<<fileName<<": "<<err.what();
+    }
+    if ( image ){
+        openImages.prepend( qMakePair( fileName, image ) );
+        while ( openImages.size() > MAX_OPEN_IMAGES ){
+            openImages.removeLast();
+        }
+    }
+    return image;
+}
+
+/// read one frame of an image with single precision pixels; returns false if it could
+/// not be read
+bool _readImageFrame( const QString& fileName, const QVector<qint32>& permOrder,
+        const QVector<qint32>& frameIndices, std::vector<int>& dims, std::vector<float>& pixels ){
+    std::shared_ptr<Carta::Lib::Image::ImageInterface> image = _openImage( fileName );
+    if ( !image ){
+        return false;
+    }
+    int imageDim = image->dims().size();
+    if ( permOrder.size() != imageDim || frameIndices.size() != imageDim ){
+        return false;
+    }
+    bool identity = true;
+    std::vector<int> order( permOrder.begin(), permOrder.end() );
+    for ( int i = 0; i < imageDim; i++ ){
+        if ( order[i] != i ){
+            identity = false;
+        }
+    }
+    if ( !identity ){
+        image = image->getPermuted( order );
+        if ( !image ){
+            return false;
+        }
+    }
+
+    //Same slice as the one DataSource takes of its permuted image.
+    SliceND slice;
+    for ( int i = 0; i < imageDim; i++ ){
+        if ( i != 0 && i != 1 ){
+            int frameIndex = frameIndices[i];
+            if ( frameIndex < 0 || frameIndex >= image->dims()[i] ){
+                return false;
+            }
+            slice.start( frameIndex );
+            slice.end( frameIndex + 1 );
+        }
+        if ( i < imageDim - 1 ){
+            slice.next();
+        }
+    }
+    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> view( image->getDataSlice( slice ) );
+    //Other pixel types would lose precision or range as floats.
+    if ( !view || view->pixelType() != Carta::Lib::Image::PixelType::Real32 ){
+        return false;
+    }
+
+    dims = view->dims();
+    int64_t count = 1;
+    for ( int dim : dims ){
+        count *= dim;
+    }
+    pixels.clear();
+    pixels.reserve( count );
+    view->forEach( Carta::Core::Algorithms::RasterRender::BandPixels * sizeof( float ),
+            [&] ( const char* data, int64_t n ) {
+        const float* values = reinterpret_cast<const float*>( data );
+        pixels.insert( pixels.end(), values, values + n );
+    });
+    return int64_t( pixels.size() ) == count;
+}
+}
+
+
+ComputeWorkerPool* ComputeWorkerPool::instance(){
+    static ComputeWorkerPool* pool = new ComputeWorkerPool();
+    return pool;
+}
+
+
+ComputeWorkerPool::ComputeWorkerPool( QObject* parent ) :
+        QObject( parent ),
+        m_nextId( 1 ){
+    int workerCount = qBound( 1, QThread::idealThreadCount(), MAX_WORKERS );
+    for ( int i = 0; i < workerCount; i++ ){
+        m_workers.append( Worker() );
+    }
+}
+
+
+void ComputeWorkerPool::start(){
+    for ( int i = 0; i < m_workers.size(); i++ ){
+        if ( m_workers[i].pid == -1 ){
+            _startWorker( i );
+        }
+    }
+}
+
+
+void ComputeWorkerPool::cancel( quint64 jobId ){
+    for ( int i = 0; i < m_pending.size(); i++ ){
+        if ( m_pending[i].id == jobId ){
+            m_pending.removeAt( i );
+            return;
+        }
+    }
+    for ( const Worker& worker : m_workers ){
+        if ( worker.busy && worker.jobId == jobId ){
+            m_discarded.insert( jobId );
+            return;
+        }
+    }
+}
+
+
+quint64 ComputeWorkerPool::computeHistogram( const HistogramRenderRequest& request ){
+    QByteArray payload;
+    QDataStream out( &payload, QIODevice::WriteOnly );
+    out << request.getFileName()
+        << qint32( request.getBinCount() )
+        << qint32( request.getChannelMin() ) << qint32( request.getChannelMax() )
+        << request.getFrequencyMin() << request.getFrequencyMax()
+        << request.getRangeUnits()
+        << request.getIntensityMin() << request.getIntensityMax()
+        << _regionToJson( request.getRegion() )
+        << request.getRegionId();
+    return _enqueue( JobType::HISTOGRAM, request.getFileName(), payload );
+}
+
+
+quint64 ComputeWorkerPool::computeProfile( const QString& fileName,
+        std::shared_ptr<Carta::Lib::Regions::RegionBase> region,
+        const Carta::Lib::ProfileInfo& profInfo ){
+    QByteArray payload;
+    QDataStream out( &payload, QIODevice::WriteOnly );
+    out << fileName
+        << _regionToJson( region )
+        << qint32( profInfo.getAggregateType() )
+        << profInfo.getRestFrequency() << profInfo.getRestUnit()
+        << profInfo.getSpectralType() << profInfo.getSpectralUnit()
+        << qint32( profInfo.getStokesFrame() );
+    return _enqueue( JobType::PROFILE, fileName, payload );
+}
+
+
+quint64 ComputeWorkerPool::readFrame( const QString& fileName, const std::vector<int>& permOrder,
+        const std::vector<int>& frameIndices ){
+    QByteArray payload;
+    QDataStream out( &payload, QIODevice::WriteOnly );
+    out << fileName
+        << QVector<qint32>::fromStdVector( std::vector<qint32>( permOrder.begin(), permOrder.end() ) )
+        << QVector<qint32>::fromStdVector( std::vector<qint32>( frameIndices.begin(), frameIndices.end() ) );
+    return _enqueue( JobType::FRAME, fileName, payload );
+}
+
+
+int ComputeWorkerPool::_chooseWorker( const QString& fileName ){
+    //An idle worker that already has the image open, otherwise the idle worker that has
+    //opened the fewest images.
+    int chosen = -1;
+    for ( int i = 0; i < m_workers.size(); i++ ){
+        if ( m_workers[i].busy ){
+            continue;
+        }
+        if ( m_workers[i].pid == -1 && !_startWorker( i ) ){
+            continue;
+        }
+        if ( m_workers[i].files.contains( fileName ) ){
+            return i;
+        }
+        if ( chosen < 0 || m_workers[i].files.size() < m_workers[chosen].files.size() ){
+            chosen = i;
+        }
+    }
+    return chosen;
+}
+
+
+void ComputeWorkerPool::_dispatch(){
+    int failures = 0;
+    while ( !m_pending.isEmpty() && failures < m_workers.size() ){
+        int i = _chooseWorker( m_pending.first().fileName );
+        if ( i < 0 ){
+            break;
+        }
+        Job job = m_pending.takeFirst();
+        QByteArray header;
+        QDataStream out( &header, QIODevice::WriteOnly );
+        out << quint8( job.type ) << job.id;
+        header.append( job.payload );
+        if ( !_writeMessage( m_workers[i].socket, header ) ){
+            qDebug() << "ComputeWorkerPool: could not send job to worker: "<<strerror( errno );
+            _stopWorker( i );
+            m_pending.prepend( job );
+            failures++;
+            continue;
+        }
+        Worker& worker = m_workers[i];
+        worker.busy = true;
+        worker.jobId = job.id;
+        worker.jobType = job.type;
+        worker.files.removeAll( job.fileName );
+        worker.files.prepend( job.fileName );
+        while ( worker.files.size() > MAX_OPEN_IMAGES ){
+            worker.files.removeLast();
+        }
+    }
+
+    //If no worker could be started there is no point in keeping the jobs around.
+    bool workerAlive = false;
+    for ( const Worker& worker : m_workers ){
+        if ( worker.pid != -1 ){
+            workerAlive = true;
+            break;
+        }
+    }
+    if ( !workerAlive ){
+        while ( !m_pending.isEmpty() ){
+            Job job = m_pending.takeFirst();
+            _emitError( job.id, job.type, "Could not start a worker process" );
+        }
+    }
+}
+
+
+void ComputeWorkerPool::_emitError( quint64 jobId, JobType type, const QString& msg ){
+    if ( type == JobType::HISTOGRAM ){
+        Carta::Lib::Hooks::HistogramResult result;
+        result.setName( Util::ERROR + ": " + msg );
+        emit histogramFinished( jobId, result );
+    }
+    else if ( type == JobType::FRAME ){
+        qDebug() << "ComputeWorkerPool: could not read frame: "<<msg;
+        emit frameRead( jobId, std::shared_ptr<std::vector<float> >( nullptr ), std::vector<int>() );
+    }
+    else {
+        Carta::Lib::Hooks::ProfileResult result;
+        result.setError( msg );
+        emit profileFinished( jobId, result );
+    }
+}
+
+
+quint64 ComputeWorkerPool::_enqueue( JobType type, const QString& fileName, const QByteArray& payload ){
+    Job job;
+    job.id = m_nextId++;
+    job.type = type;
+    job.fileName = fileName;
+    job.payload = payload;
+    m_pending.append( job );
+    //Dispatch from the event loop so that results (or errors) are never announced
+    //before the caller knows the id of the job.
+    QMetaObject::invokeMethod( this, "_dispatch", Qt::QueuedConnection );
+    return job.id;
+}
+
+
+int ComputeWorkerPool::getWorkerCount() const {
+    return m_workers.size();
+}
+
+
+void ComputeWorkerPool::_handleResult( const Message& message ){
+    QDataStream in( message.header );
+    quint8 type = 0;
+    quint64 jobId = 0;
+    in >> type >> jobId;
+    if ( m_discarded.remove( jobId ) ){
+        return;
+    }
+    if ( JobType( type ) == JobType::HISTOGRAM ){
+        Carta::Lib::Hooks::HistogramResult result;
+        in >> result;
+        emit histogramFinished( jobId, result );
+    }
+    else if ( JobType( type ) == JobType::FRAME ){
+        qint32 dimCount = 0;
+        in >> dimCount;
+        std::vector<int> dims;
+        qint64 count = dimCount > 0 ? 1 : 0;
+        for ( int i = 0; i < dimCount; i++ ){
+            qint32 dim = 0;
+            in >> dim;
+            dims.push_back( dim );
+            count *= dim;
+        }
+        std::shared_ptr<std::vector<float> > pixels( message.pixels );
+        if ( !pixels || qint64( pixels->size() ) != count ){
+            pixels.reset();
+        }
+        emit frameRead( jobId, pixels, dims );
+    }
+    else {
+        Carta::Lib::Hooks::ProfileResult result;
+        in >> result;
+        emit profileFinished( jobId, result );
+    }
+}
+
+
+bool ComputeWorkerPool::_receive( Worker& worker, bool& complete ){
+    Message& message = worker.message;
+    const quint64 sizesBytes = sizeof( message.sizes );
+    qint64 budget = MAX_READ_PER_EVENT;
+    while ( true ){
+        //Where the next bytes go: the sizes, the header or the pixels.
+        char* target = nullptr;
+        quint64 remaining = 0;
+        if ( message.received < sizesBytes ){
+            target = reinterpret_cast<char*>( message.sizes ) + message.received;
+            remaining = sizesBytes - message.received;
+        }
+        else {
+            quint64 offset = message.received - sizesBytes;
+            if ( offset < message.sizes[0] ){
+                target = message.header.data() + offset;
+                remaining = message.sizes[0] - offset;
+            }
+            else {
+                offset -= message.sizes[0];
+                if ( offset == message.sizes[1] ){
+                    complete = true;
+                    return true;
+                }
+                target = reinterpret_cast<char*>( message.pixels->data() ) + offset;
+                remaining = message.sizes[1] - offset;
+            }
+        }
+        if ( budget <= 0 ){
+            //The notifier fires again for the rest.
+            complete = false;
+            return true;
+        }
+        ssize_t n = read( worker.socket, target, std::min<quint64>( remaining, budget ) );
+        if ( n < 0 ){
+            if ( errno == EINTR ){
+                continue;
+            }
+            if ( errno == EAGAIN || errno == EWOULDBLOCK ){
+                complete = false;
+                return true;
+            }
+            return false;
+        }
+        if ( n == 0 ){
+            return false;
+        }
+        message.received += n;
+        budget -= n;
+        if ( message.received == sizesBytes ){
+            //Both sizes are known, make room for the header and the pixels.
+            if ( message.sizes[0] > INT_MAX || message.sizes[1] % sizeof( float ) != 0 ){
+                qDebug() << "ComputeWorkerPool: invalid message from worker "<<worker.pid;
+                return false;
+            }
+            try {
+                message.header.resize( message.sizes[0] );
+                if ( message.sizes[1] > 0 ){
+                    message.pixels = std::make_shared<std::vector<float> >( message.sizes[1] / sizeof( float ) );
+                }
+            }
+            catch( const std::bad_alloc& ){
+                qWarning() << "ComputeWorkerPool: not enough memory for a result of "
+                        << message.sizes[1] << " bytes";
+                return false;
+            }
+        }
+    }
+}
+
+
+void ComputeWorkerPool::_readResult( int socket ){
+    int index = -1;
+    for ( int i = 0; i < m_workers.size(); i++ ){
+        if ( m_workers[i].socket == socket ){
+            index = i;
+            break;
+        }
+    }
+    if ( index < 0 ){
+        return;
+    }
+
+    //The socket is non-blocking; the result may arrive over several notifications.
+    bool complete = false;
+    if ( !_receive( m_workers[index], complete ) ){
+        //The worker died, most likely while computing its job.
+        Worker worker = m_workers[index];
+        qDebug() << "ComputeWorkerPool: worker "<<worker.pid<<" exited unexpectedly";
+        _stopWorker( index );
+        if ( worker.busy && !m_discarded.remove( worker.jobId ) ){
+            _emitError( worker.jobId, worker.jobType, "Computation process exited unexpectedly" );
+        }
+        _dispatch();
+        return;
+    }
+    if ( !complete ){
+        return;
+    }
+    Message message = m_workers[index].message;
+    m_workers[index].message = Message();
+    m_workers[index].busy = false;
+    _handleResult( message );
+    _dispatch();
+}
+
+
+bool ComputeWorkerPool::_startWorker( int index ){
+    int sockets[2];
+    if ( socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) ){
+        qDebug() << "*** ComputeWorkerPool: socket creation failed: " << strerror (errno);
+        return false;
+    }
+
+    int pid = fork();
+    if ( pid == -1 ){
+        qDebug() << "*** ComputeWorkerPool: fork failed: " << strerror (errno);
+        close( sockets[0] );
+        close( sockets[1] );
+        return false;
+    }
+    else if ( pid == 0 ){
+        //We're the worker. Close the sockets of the other workers so that they see
+        //end of file as soon as the main process goes away.
+        close( sockets[0] );
+        for ( const Worker& worker : m_workers ){
+            if ( worker.socket != -1 ){
+                close( worker.socket );
+            }
+        }
+        _workerMain( sockets[1] );
+    }
+
+    close( sockets[1] );
+    //Results are received without blocking the main thread.
+    fcntl( sockets[0], F_SETFL, fcntl( sockets[0], F_GETFL ) | O_NONBLOCK );
+    Worker& worker = m_workers[index];
+    worker.pid = pid;
+    worker.socket = sockets[0];
+    worker.busy = false;
+    worker.notifier = new QSocketNotifier( worker.socket, QSocketNotifier::Read, this );
+    connect( worker.notifier, SIGNAL(activated(int)), this, SLOT(_readResult(int)));
+    return true;
+}
+
+
+void ComputeWorkerPool::_stopWorker( int index ){
+    Worker& worker = m_workers[index];
+    if ( worker.notifier ){
+        worker.notifier->setEnabled( false );
+        worker.notifier->deleteLater();
+    }
+    if ( worker.socket != -1 ){
+        close( worker.socket );
+    }
+    if ( worker.pid != -1 ){
+        kill( worker.pid, SIGKILL );
+        waitpid( worker.pid, nullptr, 0 );
+    }
+    worker = Worker();
+}
+
+
+void ComputeWorkerPool::_workerMain( int socket ){
+    QByteArray job;
+    while ( _readMessage( socket, job ) ){
+        QDataStream in( job );
+        quint8 type = 0;
+        quint64 jobId = 0;
+        QString fileName;
+        QByteArray regionJson;
+        in >> type >> jobId >> fileName;
+
+        QByteArray reply;
+        QDataStream out( &reply, QIODevice::WriteOnly );
+        out << type << jobId;
+        std::vector<float> pixels;
+
+        if ( JobType( type ) == JobType::HISTOGRAM ){
+            qint32 binCount, minChannel, maxChannel;
+            double minFrequency, maxFrequency, minIntensity, maxIntensity;
+            QString rangeUnits, regionId;
+            in >> binCount >> minChannel >> maxChannel >> minFrequency >> maxFrequency
+               >> rangeUnits >> minIntensity >> maxIntensity >> regionJson >> regionId;
+
+            Carta::Lib::Hooks::HistogramResult histResult;
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> image = _openImage( fileName );
+            if ( image ){
+                auto result = Globals::instance()-> pluginManager()
+                        -> prepare <Carta::Lib::Hooks::HistogramHook>( image, binCount,
+                                minChannel, maxChannel, minFrequency, maxFrequency, rangeUnits,
+                                minIntensity, maxIntensity, _regionFromJson( regionJson ), regionId );
+                auto lam = [&] ( const Carta::Lib::Hooks::HistogramResult &data ) {
+                    histResult = data;
+                };
+                try {
+                    result.forEach( lam );
+                }
+                catch( char*& error ){
+                    qDebug() << "ComputeWorkerPool: caught error: " << error;
+                    histResult.setName( Util::ERROR +": "+QString(error) );
+                }
+            }
+            else {
+                histResult.setName( Util::ERROR + ": Could not load image " + fileName );
+            }
+            out << histResult;
+        }
+        else if ( JobType( type ) == JobType::FRAME ){
+            QVector<qint32> permOrder, frameIndices;
+            in >> permOrder >> frameIndices;
+            std::vector<int> dims;
+            if ( !_readImageFrame( fileName, permOrder, frameIndices, dims, pixels ) ){
+                dims.clear();
+                pixels.clear();
+            }
+            out << qint32( dims.size() );
+            for ( int dim : dims ){
+                out << qint32( dim );
+            }
+            //The pixels go out after the header, in the byte order of the machine; both
+            //ends are on it.
+        }
+        else {
+            qint32 aggregateType, stokesFrame;
+            double restFrequency;
+            QString restUnit, spectralType, spectralUnit;
+            in >> regionJson >> aggregateType >> restFrequency >> restUnit
+               >> spectralType >> spectralUnit >> stokesFrame;
+            Carta::Lib::ProfileInfo profInfo;
+            profInfo.setAggregateType( Carta::Lib::ProfileInfo::AggregateType( aggregateType ) );
+            profInfo.setRestFrequency( restFrequency );
+            profInfo.setRestUnit( restUnit );
+            profInfo.setSpectralType( spectralType );
+            profInfo.setSpectralUnit( spectralUnit );
+            profInfo.setStokesFrame( stokesFrame );
+
+            Carta::Lib::Hooks::ProfileResult profResult;
+            std::shared_ptr<Carta::Lib::Image::ImageInterface> image = _openImage( fileName );
+            if ( image ){
+                auto result = Globals::instance()-> pluginManager()
+                        -> prepare <Carta::Lib::Hooks::ProfileHook>( image,
+                                _regionFromJson( regionJson ), profInfo );
+                auto lam = [&] ( const Carta::Lib::Hooks::ProfileResult &data ) {
+                    profResult = data;
+                };
+                try {
+                    result.forEach( lam );
+                }
+                catch( char*& error ){
+                    qDebug() << "ComputeWorkerPool: caught error: " << error;
+                    profResult.setError( QString(error) );
+                }
+            }
+            else {
+                profResult.setError( "Could not load image " + fileName );
+            }
+            out << profResult;
+        }
+
+        if ( !_writeMessage( socket, reply, reinterpret_cast<const char*>( pixels.data() ),
+                pixels.size() * sizeof( float ) ) ){
+            break;
+        }
+    }
+    //The main process closed its end (or died). Use _exit so that no Qt/static
+    //destructors inherited from the main process are run.
+    _exit( EXIT_SUCCESS );
+}
+
+
+ComputeWorkerPool::~ComputeWorkerPool(){
+    for ( int i = 0; i < m_workers.size(); i++ ){
+        _stopWorker( i );
+    }
+}
+}
+}
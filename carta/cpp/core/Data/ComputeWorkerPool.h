@@ -0,0 +1,206 @@
+/**
+ * Pool of persistent worker processes for computing histograms and profiles, and for
+ * reading frames ahead of an animation.
+ *
+ * Casacore tables cannot be accessed by different threads at the same time, so the
+ * computations are done in separate processes. Instead of forking a new process
+ * (and re-opening the image) for every request, a small number of workers are forked
+ * at startup and then kept alive. Each worker keeps the most recently used images open,
+ * and jobs are preferably sent to a worker that already has their image open, so
+ * repeated requests against the same file do not pay for opening it again.
+ *
+ * Requests and results are exchanged over a socket pair per worker, as messages made
+ * of a QDataStream header and, for frames, the raw pixels, both with a 64 bit length.
+ * The image is identified by its file name and regions are sent as json. Results are
+ * received piecewise in the main thread, without ever blocking it, and announced via
+ * signals.
+ **/
+
+#pragma once
+
+#include "CartaLib/Hooks/HistogramResult.h"
+#include "CartaLib/Hooks/ProfileResult.h"
+#include "CartaLib/ProfileInfo.h"
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+class QSocketNotifier;
+
+namespace Carta {
+namespace Lib {
+namespace Regions {
+	class RegionBase;
+}
+}
+}
+
+namespace Carta{
+namespace Data{
+
+class HistogramRenderRequest;
+
+class ComputeWorkerPool : public QObject {
+    Q_OBJECT
+
+public:
+
+    /**
+     * Returns the process wide pool.
+     * @return - the worker pool.
+     */
+    static ComputeWorkerPool* instance();
+
+    /**
+     * Forks the worker processes. This should be done once the plugins are loaded and
+     * before the first job is queued; workers that die are restarted when needed.
+     */
+    void start();
+
+    /**
+     * Queues the computation of a histogram.
+     * @param request - the parameters of the histogram; the image is identified by its file name.
+     * @return - an identifier for the job, passed back with the result.
+     */
+    quint64 computeHistogram( const HistogramRenderRequest& request );
+
+    /**
+     * Queues the computation of a profile.
+     * @param fileName - the image that will be the source of the profile.
+     * @param region - the region within the image that will be profiled (may be null).
+     * @param profInfo - information about the profile such as the rest frequency.
+     * @return - an identifier for the job, passed back with the result.
+     */
+    quint64 computeProfile( const QString& fileName,
+            std::shared_ptr<Carta::Lib::Regions::RegionBase> region,
+            const Carta::Lib::ProfileInfo& profInfo );
+
+    /**
+     * Queues reading a frame of an image with single precision pixels.
+     * @param fileName - the image to read; frames of images with other pixel types cannot be read.
+     * @param permOrder - the order of the image axes, the first two are the display axes.
+     * @param frameIndices - the index of the frame on each axis of the permuted image;
+     *      the entries of the display axes are ignored.
+     * @return - an identifier for the job, passed back with the result.
+     */
+    quint64 readFrame( const QString& fileName, const std::vector<int>& permOrder,
+            const std::vector<int>& frameIndices );
+
+    /**
+     * Cancels a job. A job that has not been sent to a worker yet is dropped; the
+     * result of a job that is already being computed is discarded when it arrives.
+     * @param jobId - the identifier returned when the job was queued.
+     */
+    void cancel( quint64 jobId );
+
+    /**
+     * Returns the number of worker processes.
+     * @return - the size of the pool.
+     */
+    int getWorkerCount() const;
+
+    /**
+     * Destructor.
+     */
+    ~ComputeWorkerPool();
+
+signals:
+
+    /**
+     * Notification that a histogram has been computed.
+     * @param jobId - the identifier returned by computeHistogram.
+     * @param result - the histogram.
+     */
+    void histogramFinished( quint64 jobId, const Carta::Lib::Hooks::HistogramResult& result );
+
+    /**
+     * Notification that a profile has been computed.
+     * @param jobId - the identifier returned by computeProfile.
+     * @param result - the profile.
+     */
+    void profileFinished( quint64 jobId, const Carta::Lib::Hooks::ProfileResult& result );
+
+    /**
+     * Notification that a frame has been read.
+     * @param jobId - the identifier returned by readFrame.
+     * @param pixels - the pixels of the frame; null if the frame could not be read.
+     * @param dims - the dimensions of the frame, as those of a data slice of the image.
+     */
+    void frameRead( quint64 jobId, std::shared_ptr<std::vector<float> > pixels,
+            const std::vector<int>& dims );
+
+private slots:
+
+    void _dispatch();
+    void _readResult( int socket );
+
+private:
+
+    /// kinds of jobs (and results) exchanged with the workers
+    enum class JobType : quint8 {
+        HISTOGRAM = 1,
+        PROFILE = 2,
+        FRAME = 3
+    };
+
+    struct Job {
+        quint64 id;
+        JobType type;
+        QString fileName;
+        QByteArray payload;
+    };
+
+    /// a message being received from a worker
+    struct Message {
+        /// sizes of the header and of the pixels, in bytes
+        quint64 sizes[2] = { 0, 0 };
+        /// number of bytes received, including the sizes
+        quint64 received = 0;
+        QByteArray header;
+        std::shared_ptr<std::vector<float> > pixels;
+    };
+
+    struct Worker {
+        int pid = -1;
+        int socket = -1;
+        QSocketNotifier* notifier = nullptr;
+        bool busy = false;
+        quint64 jobId = 0;
+        JobType jobType = JobType::HISTOGRAM;
+        //Images the worker has opened, most recent first.
+        QStringList files;
+        Message message;
+    };
+
+    explicit ComputeWorkerPool( QObject* parent = 0 );
+
+    int _chooseWorker( const QString& fileName );
+    quint64 _enqueue( JobType type, const QString& fileName, const QByteArray& payload );
+    void _emitError( quint64 jobId, JobType type, const QString& msg );
+    void _handleResult( const Message& message );
+    bool _receive( Worker& worker, bool& complete );
+    bool _startWorker( int index );
+    void _stopWorker( int index );
+
+    /// main loop of a worker process, never returns
+    static void _workerMain( int socket );
+
+    //Maximum number of worker processes.
+    static const int MAX_WORKERS;
+
+    QList<Worker> m_workers;
+    QList<Job> m_pending;
+    QSet<quint64> m_discarded;
+    quint64 m_nextId;
+
+    ComputeWorkerPool( const ComputeWorkerPool& other);
+    ComputeWorkerPool& operator=( const ComputeWorkerPool& other );
+};
+}
+}
@@ -1,81 +1,68 @@
 #include "HistogramRenderService.h"
-#include "HistogramRenderWorker.h"
-#include "HistogramRenderThread.h"
-#include "CartaLib/Hooks/Histogram.h"
-#include "Data/Util.h"
+#include "Data/ComputeWorkerPool.h"
 
 namespace Carta {
 namespace Data {
 
 HistogramRenderService::HistogramRenderService( QObject * parent ) :
-        QObject( parent ),
-        m_worker( nullptr),
-        m_renderThread( nullptr ){
-    m_renderQueued = false;
+        QObject( parent ){
+    connect( ComputeWorkerPool::instance(),
+            SIGNAL(histogramFinished(quint64, const Carta::Lib::Hooks::HistogramResult&)),
+            this, SLOT( _postResult(quint64, const Carta::Lib::Hooks::HistogramResult&)));
 }
 
 
-bool HistogramRenderService::renderHistogram( const HistogramRenderRequest& request ){
-	bool histogramRender = true;
-	if ( request.getImage() ){
-		if ( ! m_requests.contains( request ) ){
-			m_requests.enqueue( request );
-			_scheduleRender( request );
+void HistogramRenderService::_cancelStale( const HistogramRenderRequest& request ){
+	auto iter = m_requests.begin();
+	while ( iter != m_requests.end() ){
+		if ( iter.value().getFileName() == request.getFileName() &&
+				iter.value().getRegionId() == request.getRegionId() ){
+			ComputeWorkerPool::instance()->cancel( iter.key() );
+			iter = m_requests.erase( iter );
+		}
+		else {
+			iter++;
 		}
 	}
-	else {
-		histogramRender = false;
-	}
-	return histogramRender;
 }
 
 
-void HistogramRenderService::_scheduleRender( const HistogramRenderRequest& request ){
-	if ( m_renderQueued ) {
-		return;
-	}
-	m_renderQueued = true;
-	if ( !m_worker ){
-		m_worker = new HistogramRenderWorker();
-	}
-	m_worker->setParameters( request );
-	int pid = m_worker->computeHist();
-	if ( pid != -1 ){
-		if ( !m_renderThread ){
-			m_renderThread = new HistogramRenderThread( pid );
-			connect( m_renderThread, SIGNAL(finished()), this, SLOT( _postResult()));
+bool HistogramRenderService::renderHistogram( const HistogramRenderRequest& request ){
+	bool histogramRender = true;
+	if ( request.getImage() ){
+		bool pending = false;
+		for ( auto iter = m_requests.begin(); iter != m_requests.end(); iter++ ){
+			if ( iter.value() == request ){
+				pending = true;
+				break;
+			}
 		}
-		else {
-			m_renderThread->setFileDescriptor( pid );
+		if ( !pending ){
+			_cancelStale( request );
+			quint64 jobId = ComputeWorkerPool::instance()->computeHistogram( request );
+			m_requests.insert( jobId, request );
 		}
-		m_renderThread->start();
 	}
 	else {
-		qDebug() << "Bad file descriptor: "<<pid;
-		m_renderQueued = false;
+		histogramRender = false;
 	}
-
+	return histogramRender;
 }
 
-void HistogramRenderService::_postResult( ){
-	Carta::Lib::Hooks::HistogramResult result = m_renderThread->getResult();
-	m_requests.dequeue();
-	emit histogramResult( result );
-	m_renderQueued = false;
-	if ( m_requests.size() > 0 ){
-		HistogramRenderRequest& head = m_requests.head();
-		_scheduleRender( head );
+
+void HistogramRenderService::_postResult( quint64 jobId,
+		const Carta::Lib::Hooks::HistogramResult& result ){
+	//Results of other services (or cancelled requests) are not ours to post.
+	if ( m_requests.remove( jobId ) > 0 ){
+		emit histogramResult( result );
 	}
 }
 
 
 HistogramRenderService::~HistogramRenderService(){
-    if ( m_renderThread ){
-    	m_renderThread->wait();
-    	delete m_renderThread;
-    }
-    delete m_worker;
+	for ( quint64 jobId : m_requests.keys() ){
+		ComputeWorkerPool::instance()->cancel( jobId );
+	}
 }
 }
 }
-
@@ -1,5 +1,6 @@
 /**
- * Manages the production of histogram data from an image cube.
+ * Manages the production of histogram data from an image cube. The histograms are
+ * computed by the shared ComputeWorkerPool.
  **/
 
 #pragma once
@@ -7,7 +8,7 @@
 #include "CartaLib/CartaLib.h"
 #include "CartaLib/Hooks/HistogramResult.h"
 
-#include <QQueue>
+#include <QMap>
 #include <memory>
 
 namespace Carta {
@@ -25,9 +26,6 @@ namespace Regions {
 namespace Carta{
 namespace Data{
 
-class HistogramRenderWorker;
-class HistogramRenderThread;
-
 class HistogramRenderService : public QObject {
     Q_OBJECT
 
@@ -58,14 +56,15 @@ signals:
 
 private slots:
 
-    void _postResult( );
+    void _postResult( quint64 jobId, const Carta::Lib::Hooks::HistogramResult& result );
 
 private:
-    void _scheduleRender( const HistogramRenderRequest& request );
-    HistogramRenderWorker* m_worker;
-    HistogramRenderThread* m_renderThread;
-    bool m_renderQueued;
-    QQueue<HistogramRenderRequest> m_requests;
+    //Cancel outstanding requests for the same image and region that the new request
+    //makes obsolete.
+    void _cancelStale( const HistogramRenderRequest& request );
+
+    //Requests that have been submitted to the worker pool, by job id.
+    QMap<quint64,HistogramRenderRequest> m_requests;
 
     HistogramRenderService( const HistogramRenderService& other);
     HistogramRenderService& operator=( const HistogramRenderService& other );
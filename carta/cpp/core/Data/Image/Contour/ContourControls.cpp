@@ -476,6 +476,23 @@ void ContourControls::_initializeCallbacks(){
                 return result;
             });
 
+    addCommandCallback( "setSmoothingSigma", [=] (const QString & /*cmd*/,
+                                const QString & params, const QString & /*sessionId*/) -> QString {
+                std::set<QString> keys = {"sigma"};
+                std::map<QString,QString> dataValues = Carta::State::UtilState::parseParamMap( params, keys );
+                bool validDouble = false;
+                QString result;
+                double sigma = dataValues[*keys.begin()].toDouble(&validDouble);
+                if ( validDouble ){
+                    result = setSmoothingSigma( sigma );
+                }
+                else {
+                    result = "Contour smoothing sigma must be a number: "+dataValues[*keys.begin()];
+                }
+                Util::commandPostProcess( result );
+                return result;
+            });
+
     addCommandCallback( "setSpacing", [=] (const QString & /*cmd*/,
                     const QString & params, const QString & /*sessionId*/) -> QString {
         std::set<QString> keys = {"method"};
@@ -814,6 +831,11 @@ QString ContourControls::setSpacingInterval( double interval ){
     return result;
 }
 
+QString ContourControls::setSmoothingSigma( double sigma ){
+    QString result = m_generatorState->setSmoothingSigma( sigma );
+    return result;
+}
+
 QString ContourControls::setThickness( const QString& contourName,
         std::vector<double>& levels, double thickness ){
     QString result;
@@ -167,6 +167,14 @@ public:
      */
     QString setSpacingInterval( double interval );
 
+    /**
+     * Set the standard deviation of the Gaussian blur sigma contour type.
+     * @param sigma - the standard deviation of the Gaussian blur, in pixels.
+     * @return - an error message if there is a problem setting the standard deviation;
+     *      an empty string otherwise.
+     */
+    QString setSmoothingSigma( double sigma );
+
     /**
      * Set the width of the lines used to draw the contours in the identified set.
      * @param contourName - an identifier for a contour set.
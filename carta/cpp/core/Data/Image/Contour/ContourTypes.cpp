@@ -15,6 +15,13 @@ const QString ContourTypes::MODE_GAUSSBLUR3 = "Gaussian blur 3x3";
 const QString ContourTypes::MODE_GAUSSBLUR5 = "Gaussian blur 5x5";
 const QString ContourTypes::MODE_BOXBLUR3 = "Box blur 3x3";
 const QString ContourTypes::MODE_BOXBLUR5 = "Box blur 5x5";
+const QString ContourTypes::MODE_GAUSSBLUR7 = "Gaussian blur 7x7";
+const QString ContourTypes::MODE_GAUSSBLUR9 = "Gaussian blur 9x9";
+const QString ContourTypes::MODE_BOXBLUR7 = "Box blur 7x7";
+const QString ContourTypes::MODE_BOXBLUR9 = "Box blur 9x9";
+const QString ContourTypes::MODE_DOWNSAMPLE2 = "Downsample 2x";
+const QString ContourTypes::MODE_DOWNSAMPLE4 = "Downsample 4x";
+const QString ContourTypes::MODE_GAUSSBLURSIGMA = "Gaussian blur sigma";
 
 class ContourTypes::Factory : public Carta::State::CartaObjectFactory {
 
@@ -34,13 +41,20 @@ bool ContourTypes::m_registered =
 
 ContourTypes::ContourTypes(const QString& path, const QString& id):
     CartaObject(CLASS_NAME, path, id){
-    m_typeModes.resize( 6 );
+    m_typeModes.resize( 13 );
     m_typeModes[0] = MODE_NOLINECOMBOPT;
     m_typeModes[1] = MODE_LINECOMBOPT;
     m_typeModes[2] = MODE_GAUSSBLUR3;
     m_typeModes[3] = MODE_GAUSSBLUR5;
     m_typeModes[4] = MODE_BOXBLUR3;
     m_typeModes[5] = MODE_BOXBLUR5;
+    m_typeModes[6] = MODE_GAUSSBLUR7;
+    m_typeModes[7] = MODE_GAUSSBLUR9;
+    m_typeModes[8] = MODE_BOXBLUR7;
+    m_typeModes[9] = MODE_BOXBLUR9;
+    m_typeModes[10] = MODE_DOWNSAMPLE2;
+    m_typeModes[11] = MODE_DOWNSAMPLE4;
+    m_typeModes[12] = MODE_GAUSSBLURSIGMA;
     _initializeDefaultState();
 }
 
@@ -39,6 +39,13 @@ public:
     const static QString MODE_GAUSSBLUR5;
     const static QString MODE_BOXBLUR3;
     const static QString MODE_BOXBLUR5;
+    const static QString MODE_GAUSSBLUR7;
+    const static QString MODE_GAUSSBLUR9;
+    const static QString MODE_BOXBLUR7;
+    const static QString MODE_BOXBLUR9;
+    const static QString MODE_DOWNSAMPLE2;
+    const static QString MODE_DOWNSAMPLE4;
+    const static QString MODE_GAUSSBLURSIGMA;
 
 private:
 
@@ -81,7 +81,7 @@ QString DataContours::getName() const {
 }
 
 QString DataContours::getContourType() const {
-    return m_generatorState -> getContourType();
+    return m_generatorState -> getSmoothingType();
 }
 
 std::vector<QPen> DataContours::getPens() const {
@@ -50,7 +50,7 @@ public:
     QString getName() const;
 
     /**
-     * Return the type of the contour set.
+     * Return the type of the contour set, in the form the contour algorithm takes.
      * @return - the type of the contour set.
      */
     QString getContourType() const;
@@ -5,6 +5,7 @@
 #include "Data/Util.h"
 #include "Globals.h"
 #include "MainConfig.h"
+#include "CartaLib/Algorithms/ContourConrec.h"
 
 #include <QDebug>
 
@@ -24,6 +25,7 @@ const QString GeneratorState::RANGE_MIN = "rangeMin";
 const QString GeneratorState::RANGE_MAX = "rangeMax";
 const QString GeneratorState::SPACING_MODE = "spacingMode";
 const QString GeneratorState::SPACING_INTERVAL = "spacingInterval";
+const QString GeneratorState::SMOOTHING_SIGMA = "smoothingSigma";
 
 const int GeneratorState::LEVEL_COUNT_MAX_VALUE = 30;
 const double GeneratorState::ERROR_MARGIN = 0.000001;
@@ -51,6 +53,19 @@ QString GeneratorState::getContourType() const {
     return type;
 }
 
+double GeneratorState::getSmoothingSigma() const {
+    double sigma = m_state.getValue<double>( SMOOTHING_SIGMA );
+    return sigma;
+}
+
+QString GeneratorState::getSmoothingType() const {
+    QString type = m_state.getValue<QString>( TYPE_MODE );
+    if ( type == ContourTypes::MODE_GAUSSBLURSIGMA ){
+        type = type + " " + QString::number( getSmoothingSigma() );
+    }
+    return type;
+}
+
 int GeneratorState::getLevelCount() const {
     int levelCount = m_state.getValue<int>(LEVEL_COUNT );
     return levelCount;
@@ -97,6 +112,7 @@ void GeneratorState::_initializeDefaultState(){
     }
     m_state.insertValue<QString>(SPACING_MODE, m_spacingModes->getModeDefault());
     m_state.insertValue<double>(SPACING_INTERVAL, 0.25);
+    m_state.insertValue<double>(SMOOTHING_SIGMA, 2);
 }
 
 
@@ -315,6 +331,22 @@ QString GeneratorState::setSpacingInterval( double interval ){
     return result;
 }
 
+QString GeneratorState::setSmoothingSigma( double sigma ){
+    QString result;
+    double maxSigma = Carta::Lib::Algorithms::ContourConrec::MaxSigma;
+    if ( sigma > 0 && sigma <= maxSigma ){
+        double oldSigma = m_state.getValue<double>( SMOOTHING_SIGMA );
+        if ( qAbs( oldSigma - sigma ) > ERROR_MARGIN ){
+            m_state.setValue<double>( SMOOTHING_SIGMA, sigma );
+        }
+    }
+    else {
+        result = "The contour smoothing sigma must be positive and at most "+
+                QString::number( maxSigma )+" pixels.";
+    }
+    return result;
+}
+
 void GeneratorState::_updateState( const std::shared_ptr<GeneratorState>& other ){
     QString stateStr = other->getStateString( );
     m_state.setState( stateStr );
@@ -46,6 +46,19 @@ public:
      */
     QString getContourType() const;
 
+    /**
+     * Returns the standard deviation of the Gaussian blur sigma contour type.
+     * @return - the standard deviation of the Gaussian blur, in pixels.
+     */
+    double getSmoothingSigma() const;
+
+    /**
+     * Returns the contour type in the form the contour algorithm takes, i.e. with the
+     * standard deviation appended for the Gaussian blur sigma type.
+     * @return - the contour type for the contour algorithm.
+     */
+    QString getSmoothingType() const;
+
     /**
      * Returns the maximum contour level.
      * @return - the maximum contour level.
@@ -170,6 +183,14 @@ public:
      */
     QString setSpacingInterval( double interval );
 
+    /**
+     * Set the standard deviation of the Gaussian blur sigma contour type.
+     * @param sigma - the standard deviation of the Gaussian blur, in pixels.
+     * @return - an error message if there is a problem setting the standard deviation;
+     *      an empty string otherwise.
+     */
+    QString setSmoothingSigma( double sigma );
+
     virtual ~GeneratorState();
 
 
@@ -186,6 +207,7 @@ private:
     const static QString RANGE_MAX;
     const static QString SPACING_MODE;
     const static QString SPACING_INTERVAL;
+    const static QString SMOOTHING_SIGMA;
     const static int LEVEL_COUNT_MAX_VALUE;
     const static double ERROR_MARGIN;
 
@@ -1164,6 +1164,13 @@ void Controller::_setSkyCSName(){
 }
 
 
+void Controller::_prefetchFrames( const std::vector<int>& upcoming, AxisInfo::KnownType axisType ){
+    //With auto clip the colormap changes from one frame to the next, so frames are only read.
+    bool autoClip = m_state.getValue<bool>(AUTO_CLIP);
+    m_stack->_prefetchFrames( axisType, upcoming, !autoClip );
+}
+
+
 void Controller::_setFrameAxis(int value, AxisInfo::KnownType axisType ) {
     m_stack->_setFrameAxis( value, axisType );
     _updateCursorText( true );
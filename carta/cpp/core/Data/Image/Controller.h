@@ -692,6 +692,13 @@ private:
 	void _initializeState();
 	void _initializeCallbacks();
 
+	/**
+	 * Start reading the frames an animation is about to show.
+	 * @param upcoming - the frames of the axis that will be shown next, the soonest first.
+	 * @param axisType - the axis being animated.
+	 */
+	void _prefetchFrames( const std::vector<int>& upcoming, Carta::Lib::AxisInfo::KnownType axisType );
+
 	void _renderZoom( double factor );
 	void _renderContext( double zoomFactor );
 
@@ -1,5 +1,6 @@
 #include "DataSource.h"
 #include "CoordinateSystems.h"
+#include "FramePrefetcher.h"
 #include "Data/Colormap/Colormaps.h"
 #include "Globals.h"
 #include "MainConfig.h"
@@ -9,13 +10,15 @@
 #include "Data/Util.h"
 #include "Data/Colormap/TransformsData.h"
 #include "CartaLib/Hooks/LoadAstroImage.h"
-#include "CartaLib/Hooks/GetPersistentCache.h"
+#include "CartaLib/MemoryPCache.h"
+#include "CartaLib/MemoryBudget.h"
 #include "CartaLib/Hooks/ConversionSpectralHook.h"
 #include "CartaLib/Hooks/PercentileToPixelHook.h"
 #include "CartaLib/PixelPipeline/CustomizablePixelPipeline.h"
 #include "CartaLib/IPCache.h"
 #include "../../ImageRenderService.h"
 #include "../../Algorithms/percentileAlgorithms.h"
+#include "../../Algorithms/frameStatistics.h"
 #include "../Clips.h"
 #include <QDebug>
 #include <QElapsedTimer>
@@ -42,13 +45,15 @@ DataSource::DataSource() :
     m_image( nullptr ),
     m_permuteImage( nullptr),
     m_axisIndexX( 0 ),
-    m_axisIndexY( 1 ){
+    m_axisIndexY( 1 ),
+    m_prefetcher( nullptr ){
         m_cmapCacheSize = 1000;
 
         _initializeSingletons();
 
         //Initialize the rendering service
         m_renderService.reset( new Carta::Core::ImageRenderService::Service() );
+        m_renderService->setMemoryBudget( Globals::instance()->memoryBudget() );
 
         // assign a default colormap to the view
         auto rawCmap = std::make_shared < Carta::Core::GrayColormap > ();
@@ -61,17 +66,13 @@ DataSource::DataSource() :
         m_pixelPipeline-> setMinMax( 0, 1 );
         m_renderService-> setPixelPipeline( m_pixelPipeline, m_pixelPipeline-> cacheId());
 
-        // initialize disk cache
-        auto res = Globals::instance()-> pluginManager()
-                   -> prepare < Carta::Lib::Hooks::GetPersistentCache > ().first();
-        if ( res.isNull() || ! res.val() ) {
-            qWarning( "Could not find a disk cache plugin." );
-            m_diskCache = nullptr;
-            m_diskCacheHelper = nullptr;
+        // initialize disk cache; all data sources share the in-memory cache in front of it
+        m_diskCache = Globals::instance()-> diskCache();
+        if ( m_diskCache ) {
+            m_diskCacheHelper = std::make_shared<Carta::Lib::IntensityCacheHelper>(m_diskCache);
         }
         else {
-            m_diskCache = res.val();
-            m_diskCacheHelper = std::make_shared<Carta::Lib::IntensityCacheHelper>(m_diskCache);
+            m_diskCacheHelper = nullptr;
         }
 }
 
@@ -435,6 +436,19 @@ std::shared_ptr<Carta::Lib::IntensityValue> DataSource::_readIntensityCache(int
     return nullptr;
 }
 
+std::vector<std::shared_ptr<Carta::Lib::IntensityValue> > DataSource::_readIntensityCache(int frameLow, int frameHigh, const std::vector<double>& percentiles, int stokeFrame, QString transformationLabel) const {
+    if (m_diskCacheHelper) {
+        return m_diskCacheHelper->get(m_fileName, frameLow, frameHigh, percentiles, stokeFrame, transformationLabel);
+    }
+    return std::vector<std::shared_ptr<Carta::Lib::IntensityValue> >(percentiles.size());
+}
+
+void DataSource::_setIntensityCache(const std::map<double, double>& intensities, double error, int frameLow, int frameHigh, int stokeFrame, QString transformationLabel) const {
+    if (m_diskCacheHelper) {
+        m_diskCacheHelper->set(m_fileName, intensities, error, frameLow, frameHigh, stokeFrame, transformationLabel);
+    }
+}
+
 void DataSource::_setIntensityCache(double intensity, double error, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel) const {
     if (m_diskCacheHelper) {
         m_diskCacheHelper->set(m_fileName, intensity, error, frameLow, frameHigh, percentile, stokeFrame, transformationLabel);
@@ -451,6 +465,7 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
     
     if (percentiles.size() == 2 && percentiles[0] == 0 && percentiles[1] == 1) {
         // Special case: always use the min/max algorithm for min and max
+        // (only needed when they can't be taken from the per-frame statistics)
         calculator = std::make_shared<Carta::Core::Algorithms::MinMaxPercentiles<double> >();
     } else {
         // Look for the best approximate plugin
@@ -481,8 +496,10 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
 
     // If the disk cache exists, try to look up cached intensity values
     
+    std::vector<std::shared_ptr<Carta::Lib::IntensityValue> > cachedValues = _readIntensityCache(frameLow, frameHigh, percentiles, stokeFrame, transformationLabel);
+    
     for (size_t i = 0; i < percentiles.size(); i++) {
-        std::shared_ptr<Carta::Lib::IntensityValue> cachedValue = _readIntensityCache(frameLow, frameHigh, percentiles[i], stokeFrame, transformationLabel);
+        std::shared_ptr<Carta::Lib::IntensityValue> cachedValue = cachedValues[i];
         
         if (cachedValue /* this intensity cache exists */ &&
             cachedValue->error <= calculator->error /* already has an intensity error order smaller than the current choice */ ) {
@@ -501,6 +518,49 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
         }
     }
 
+    // Try to answer the rest from the per-frame statistics. The min and max are exact, so they are
+    // always taken from the statistics, which are computed on first use. Other percentiles are only
+    // bracketed by the histograms, so they are used if they already exist and are accurate enough.
+    // Frame-dependent unit conversions change the values per frame and can't use the statistics.
+    if (foundCount < percentiles.size() && !(converter && converter->frameDependent)) {
+        bool minMax = percentiles.size() == 2 && percentiles[0] == 0 && percentiles[1] == 1;
+        Carta::Core::Algorithms::FrameStatistics stats;
+        if (_getFrameStatistics(frameLow, frameHigh, stokeFrame, minMax, stats) && stats.count() > 0) {
+            double range = stats.max - stats.min;
+            double error = 0;
+            std::map<double, double> statsMap;
+            for (size_t i = 0; i < percentiles.size(); i++) {
+                if (!found[i]) {
+                    std::pair<double, double> bracket = stats.percentileBracket(percentiles[i]);
+                    double halfWidth = (bracket.second - bracket.first) / 2;
+                    if (halfWidth > calculator->error * range) {
+                        statsMap.clear();
+                        break;
+                    }
+                    if (range > 0) {
+                        error = std::max(error, halfWidth / range);
+                    }
+                    statsMap[percentiles[i]] = bracket.first + halfWidth;
+                }
+            }
+
+            if (!statsMap.empty()) {
+                qDebug() << "++++++++ Found percentiles in the frame statistics, +/- (max-min)*" << error;
+                _setIntensityCache(statsMap, error, frameLow, frameHigh, stokeFrame, transformationLabel);
+                for (size_t i = 0; i < percentiles.size(); i++) {
+                    if (!found[i]) {
+                        intensities[i] = statsMap[percentiles[i]];
+                        if (converter) {
+                            intensities[i] = intensities[i] * converter->multiplier;
+                        }
+                        found[i] = true;
+                        foundCount++;
+                    }
+                }
+            }
+        }
+    }
+
     // Not all percentiles were in the cache.  We are going to have to look some up.
     if (foundCount < percentiles.size()) {
         qDebug() << "++++++++ Calculating intensities for percentiles";
@@ -536,6 +596,7 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
         if (calculator->isApproximate) {
             std::shared_ptr<Carta::Data::Clips> m_clips;
             std::vector<double> percentilesFromClips = m_clips->getAllClips2percentiles();
+            std::vector<double> extraPercentiles;
             
             for (auto& p : percentilesFromClips) {
                 // TODO check exactly why this is necessary
@@ -555,12 +616,15 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
                 }
                 if (!isDuplicate) {
                     // This is a different percentile
-                    // Look in the cache first
-                    std::shared_ptr<Carta::Lib::IntensityValue> cachedValue = _readIntensityCache(frameLow, frameHigh, p, stokeFrame, transformationLabel);
-                    // Add it to the list if it's not in the cache
-                    if (!cachedValue) {
-                        percentilesToCalculate.push_back(p);
-                    }
+                    extraPercentiles.push_back(p);
+                }
+            }
+            
+            // Look in the cache first, and add the ones that are not in the cache to the list
+            std::vector<std::shared_ptr<Carta::Lib::IntensityValue> > extraCachedValues = _readIntensityCache(frameLow, frameHigh, extraPercentiles, stokeFrame, transformationLabel);
+            for (size_t i = 0; i < extraPercentiles.size(); i++) {
+                if (!extraCachedValues[i]) {
+                    percentilesToCalculate.push_back(extraPercentiles[i]);
                 }
             }
             
@@ -574,6 +638,15 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
             hertzValues = _getHertzValues(doubleView.dims(), spectralIndex);
         }
 
+        // The exact algorithm keeps all the values in memory, so the caches have to make room for them
+        if (std::dynamic_pointer_cast<Carta::Core::Algorithms::PercentilesToPixels<double> >(calculator)) {
+            uint64_t nPixels = 1;
+            for (int dim : doubleView.dims()) {
+                nPixels *= dim;
+            }
+            Globals::instance()->memoryBudget()->enforce(nPixels * sizeof(double));
+        }
+
         // Calculate only the required percentiles
         std::map<double, double> clips_map;
         
@@ -581,23 +654,32 @@ std::vector<double> DataSource::_getIntensity(int frameLow, int frameHigh,
         if (calculator->needsMinMax) {
             // If an approximate algorithm requires min and max, they will always be calculated exactly
             // Because any approximate values in the cache will not satisfy the error requirement inside this call
+            // Unless the unit conversion is frame-dependent, they come from the per-frame statistics
             std::vector<double> minMaxIntensities = _getIntensity(frameLow, frameHigh, std::vector<double>({0, 1}), stokeFrame, converter);
             calculator->setMinMax(minMaxIntensities);
         }
 
+        // Let the algorithm know which data it is looking at, so that it can reuse per-frame summaries.
+        // _getRawDataForStoke falls back to the entire spectral axis if the frame range is invalid.
+        int firstFrame = 0;
+        if ( spectralIndex >= 0 && 0 <= frameLow && frameLow < m_image->dims()[spectralIndex] &&
+                0 <= frameHigh && frameHigh < m_image->dims()[spectralIndex] ) {
+            firstFrame = frameLow;
+        }
+        calculator->setDataId(QString("%1/%2").arg(m_fileName).arg(stokeFrame), firstFrame);
+
         // perform the calculation on all of the percentiles
-        
+
         clips_map = calculator->percentile2pixels(doubleView, percentilesToCalculate, spectralIndex, converter, hertzValues);
         
         // add all the calculated values to the cache
         
         for (auto &m : clips_map) {
             // TODO: check what happens with the close values. Do we also need to cache the value with a different key, or does the serialisation unify them?
-            // put calculated values in the disk cache if it exists
-            _setIntensityCache(m.second, calculator->error, frameLow, frameHigh, m.first, stokeFrame, transformationLabel);
-            
             qDebug() << "++++++++ [set cache] for percentile" << m.first << ", intensity=" << m.second << "+/- (max-min)*" << calculator->error;
         }
+        // put calculated values in the disk cache if it exists
+        _setIntensityCache(clips_map, calculator->error, frameLow, frameHigh, stokeFrame, transformationLabel);
         
         // set return values (only the intensities which were requested)
         
@@ -770,6 +852,76 @@ Carta::Lib::NdArray::RawViewInterface* DataSource::_getRawData( int frameStart,
     return rawData;
 }
 
+bool DataSource::_getFrameStatistics( int frameLow, int frameHigh, int stokeFrame, bool compute,
+        Carta::Core::Algorithms::FrameStatistics& stats ) const {
+    if ( !m_image ){
+        return false;
+    }
+    int spectralIndex = Util::getAxisIndex( m_image, AxisInfo::KnownType::SPECTRAL );
+    int stokeIndex = Util::getAxisIndex( m_image, AxisInfo::KnownType::STOKES );
+
+    // Same frame range as _getRawDataForStoke: the entire spectral axis if the range is invalid.
+    int firstFrame = 0;
+    int lastFrame = 0;
+    if ( spectralIndex >= 0 ){
+        int frameCount = m_image->dims()[spectralIndex];
+        if ( 0 <= frameLow && frameLow < frameCount && 0 <= frameHigh && frameHigh < frameCount ){
+            firstFrame = frameLow;
+            lastFrame = frameHigh;
+        }
+        else {
+            lastFrame = frameCount - 1;
+        }
+    }
+
+    // Look up the summaries of all the frames at once.
+    std::vector<Carta::Lib::IPCache::Entry> entries( lastFrame - firstFrame + 1 );
+    for ( int frame = firstFrame; frame <= lastFrame; frame++ ){
+        entries[frame - firstFrame].key = QString( "%1/%2/%3/framestats" )
+                .arg( m_fileName ).arg( stokeFrame ).arg( frame ).toUtf8();
+    }
+    if ( m_diskCache ){
+        m_diskCache->readEntries( entries );
+    }
+
+    Carta::Core::Algorithms::FrameStatistics result;
+    std::vector<Carta::Lib::IPCache::Entry> computed;
+    for ( int frame = firstFrame; frame <= lastFrame; frame++ ){
+        Carta::Lib::IPCache::Entry& entry = entries[frame - firstFrame];
+        Carta::Core::Algorithms::FrameStatistics frameStats;
+        if ( entry.found && Carta::Core::Algorithms::FrameStatistics::fromByteArray( entry.val, frameStats ) ){
+            result.merge( frameStats );
+            continue;
+        }
+        if ( !compute ){
+            return false;
+        }
+
+        // Summarize the frame in a single pass.
+        std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view(
+                _getRawDataForStoke( frame, frame, spectralIndex, stokeIndex, stokeFrame ) );
+        if ( !view ){
+            qWarning() << "Could not read frame" << frame << "of" << m_fileName << "for its statistics";
+            return false;
+        }
+        Carta::Core::Algorithms::FrameStatisticsAccumulator accumulator;
+        Carta::Lib::NdArray::Double doubleView( view.get(), false );
+        doubleView.forEachBlock( [&accumulator] ( const double* vals, int64_t count ) {
+            accumulator.add( vals, count );
+        });
+        frameStats = accumulator.result();
+        result.merge( frameStats );
+
+        entry.val = frameStats.toByteArray();
+        computed.push_back( entry );
+    }
+    if ( m_diskCache && !computed.empty() ){
+        m_diskCache->setEntries( computed );
+    }
+    stats = result;
+    return true;
+}
+
 Carta::Lib::NdArray::RawViewInterface* DataSource::_getRawDataForStoke( int frameStart, int frameEnd, int axisIndex,
         int axisStokeIndex, int stokeSliceIndex ) const {
 
@@ -892,9 +1044,7 @@ Carta::Lib::NdArray::RawViewInterface* DataSource::_getRawData( const std::vecto
 
     if ( m_permuteImage ){
         int imageDim =m_permuteImage->dims().size();
-
-        //Build a vector showing the permute order.
-        std::vector<int> indices = _getPermOrder();
+        std::vector<int> sliceIndices = _getSliceIndices( mFrames );
 
         SliceND nextSlice = SliceND();
         SliceND& slice = nextSlice;
@@ -903,30 +1053,9 @@ Carta::Lib::NdArray::RawViewInterface* DataSource::_getRawData( const std::vecto
 
             //Since the image has been permuted the first two indices represent the display axes.
             if ( i != 0 && i != 1 ){
-
                 //Take a slice at the indicated frame.
-                int frameIndex = 0;
-                int thisAxis = indices[i];
-                AxisInfo::KnownType type = _getAxisType( thisAxis );
-
-                // check the type of axis and its indix of slices
-                int axisIndex = -1;
-                if ( type == AxisInfo::KnownType::SPECTRAL ) {
-                    axisIndex = static_cast<int>( type );
-                    frameIndex = mFrames[axisIndex];
-                    // qDebug() << "++++++++ SPECTRAL axis Index with permutation is" << axisIndex << ", the current frame Index is" << frameIndex;
-                } else if ( type == AxisInfo::KnownType::STOKES ) {
-                    axisIndex = static_cast<int>( type );
-                    frameIndex = mFrames[axisIndex];
-                    // qDebug() << "++++++++ STOKE axis Index with permutation is" << axisIndex << ", the current frame Index is" << frameIndex;
-                } else if ( type != AxisInfo::KnownType::OTHER ) {
-                    axisIndex = static_cast<int>( type );
-                    frameIndex = mFrames[axisIndex];
-                    // qDebug() << "++++++++ axis Index with permutation is" << axisIndex << ", the current frame Index is" << frameIndex;
-                }
-
-                slice.start( frameIndex );
-                slice.end( frameIndex + 1);
+                slice.start( sliceIndices[i] );
+                slice.end( sliceIndices[i] + 1);
             }
 
             if ( i < imageDim - 1 ){
@@ -939,6 +1068,37 @@ Carta::Lib::NdArray::RawViewInterface* DataSource::_getRawData( const std::vecto
 }
 
 
+std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> DataSource::_getFrameData( const std::vector<int>& frames ) const {
+    std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view( nullptr );
+    if ( m_prefetcher ){
+        view = m_prefetcher->getFrame( _getViewIdCurrent( _fitFramesToImage( frames ) ) );
+    }
+    if ( !view ){
+        view.reset( _getRawData( frames ) );
+    }
+    return view;
+}
+
+
+std::vector<int> DataSource::_getSliceIndices( const std::vector<int>& frames ) const {
+    std::vector<int> sliceIndices;
+    if ( m_image ){
+        //Build a vector showing the permute order.
+        std::vector<int> indices = _getPermOrder();
+        int imageDim = indices.size();
+        sliceIndices.resize( imageDim, 0 );
+        for ( int i = 2; i < imageDim; i++ ){
+            int thisAxis = indices[i];
+            AxisInfo::KnownType type = _getAxisType( thisAxis );
+            if ( type != AxisInfo::KnownType::OTHER ) {
+                sliceIndices[i] = frames[static_cast<int>( type )];
+            }
+        }
+    }
+    return sliceIndices;
+}
+
+
 QString DataSource::_getViewIdCurrent( const std::vector<int>& frames ) const {
    // We create an identifier consisting of the file name and -1 for the two display axes
    // and frame indices for the other axes.
@@ -1021,7 +1181,7 @@ void DataSource::_load(std::vector<int> frames, bool recomputeClipsOnNewFrame,
 		int frameSize = frames.size();
 		CARTA_ASSERT( frameSize == static_cast<int>(AxisInfo::KnownType::OTHER));
 		std::vector<int> mFrames = _fitFramesToImage( frames );
-		std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view ( _getRawData( mFrames ) );
+		std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view = _getFrameData( mFrames );
 		std::vector<int> dimVector = view->dims();
 
 		//Update the clip values
@@ -1037,6 +1197,37 @@ void DataSource::_load(std::vector<int> frames, bool recomputeClipsOnNewFrame,
 }
 
 
+void DataSource::_prefetch( const std::vector<int>& frames,
+        const std::vector<std::vector<int> >& upcoming, bool colormap ){
+    //Only frames of single precision images can be read ahead without changing their values.
+    if ( !m_image || m_fileName.isEmpty() ||
+            m_image->pixelType() != Carta::Lib::Image::PixelType::Real32 ){
+        return;
+    }
+    QList<FramePrefetcher::FrameRequest> requests;
+    for ( const std::vector<int>& upcomingFrames : upcoming ){
+        if ( _isLoadable( upcomingFrames ) ){
+            std::vector<int> mFrames = _fitFramesToImage( upcomingFrames );
+            FramePrefetcher::FrameRequest request;
+            request.viewId = _getViewIdCurrent( mFrames );
+            request.frameIndices = _getSliceIndices( mFrames );
+            requests.append( request );
+        }
+    }
+    if ( !m_prefetcher ){
+        if ( requests.isEmpty() ){
+            return;
+        }
+        m_prefetcher = new FramePrefetcher( m_renderService, this );
+    }
+    QString currentId;
+    if ( _isLoadable( frames ) ){
+        currentId = _getViewIdCurrent( _fitFramesToImage( frames ) );
+    }
+    m_prefetcher->prefetch( m_fileName, _getPermOrder(), currentId, requests, colormap );
+}
+
+
 void DataSource::_resetZoom(){
     m_renderService-> setZoom( ZOOM_DEFAULT );
 }
@@ -36,11 +36,15 @@ namespace Core {
 namespace ImageRenderService {
 class Service;
 }
+namespace Algorithms {
+class FrameStatistics;
+}
 }
 
 namespace Data {
 
 class CoordinateSystems;
+class FramePrefetcher;
 
 class DataSource : public QObject {
 
@@ -223,8 +227,20 @@ private:
      */
     std::shared_ptr<Carta::Lib::IntensityValue> _readIntensityCache(int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel) const;
 
+    /**
+     * Returns the intensities and errors corresponding to several percentile values, read at once.
+     * @return - a pointer to an IntensityValue object for each percentile,
+     * or a null pointer if the percentile is not in the cache
+     */
+    std::vector<std::shared_ptr<Carta::Lib::IntensityValue> > _readIntensityCache(int frameLow, int frameHigh, const std::vector<double>& percentiles, int stokeFrame, QString transformationLabel) const;
+
     void _setIntensityCache(double intensity, double error, int frameLow, int frameHigh, double percentile, int stokeFrame, QString transformationLabel) const;
 
+    /**
+     * Stores the intensities (percentile -> intensity) of a calculation with the given error at once.
+     */
+    void _setIntensityCache(const std::map<double, double>& intensities, double error, int frameLow, int frameHigh, int stokeFrame, QString transformationLabel) const;
+
 
     /**
      * Returns the intensities corresponding to a given percentiles.
@@ -239,6 +255,18 @@ private:
             const std::vector<double>& percentiles, int stokeFrame,
             Carta::Lib::IntensityUnitConverter::SharedPtr converter);
 
+    /**
+     * Returns the merged per-frame statistics of a range of channels.
+     * @param frameLow - a lower bound for the image channels or -1 if there is no lower bound.
+     * @param frameHigh - an upper bound for the image channels or -1 if there is no upper bound.
+     * @param stokeFrame - the index number of stoke slice
+     * @param compute - whether statistics missing from the cache should be computed.
+     * @param stats - set to the statistics of the channel range.
+     * @return - true if the statistics of all the channels were available.
+     */
+    bool _getFrameStatistics( int frameLow, int frameHigh, int stokeFrame, bool compute,
+            Carta::Core::Algorithms::FrameStatistics& stats ) const;
+
 
     /**
      * Returns the color used to draw nan pixels.
@@ -344,6 +372,13 @@ private:
      */
     Carta::Lib::NdArray::RawViewInterface* _getRawData( const std::vector<int> frames ) const;
 
+    /**
+     * Returns the raw data for a view, using the frame read ahead of time if there is one.
+     * @param frames - a list of image frames.
+     * @return the raw data for the view or nullptr if there is none.
+     */
+    std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> _getFrameData( const std::vector<int>& frames ) const;
+
     std::shared_ptr<Carta::Core::ImageRenderService::Service> _getRenderer() const;
 
     /**
@@ -356,6 +391,9 @@ private:
             const QSize& outputSize, bool* valid ) const;
 
 
+    //Returns the index of the frame on each axis of the permuted image; 0 for the display axes.
+    std::vector<int> _getSliceIndices( const std::vector<int>& frames ) const;
+
     //Returns an identifier for the current image slice being rendered.
     QString _getViewIdCurrent( const std::vector<int>& frames ) const;
 
@@ -380,6 +418,16 @@ private:
     void _load( std::vector<int> frames, bool recomputeClipsOnNewFrame,
             double clipMinPercentile, double clipMaxPercentile );
 
+    /**
+     * Start reading frames the animation is about to show; only frames of images with
+     * single precision pixels are read ahead.
+     * @param frames - the frames being loaded, one for each axis.
+     * @param upcoming - the frames that will be loaded next, the soonest first.
+     * @param colormap - whether the frames may also be colormapped ahead of time.
+     */
+    void _prefetch( const std::vector<int>& frames,
+            const std::vector<std::vector<int> >& upcoming, bool colormap );
+
     /**
      * Center the image.
      */
@@ -538,6 +586,9 @@ private:
     int m_axisIndexX;
     int m_axisIndexY;
 
+    //Reads upcoming frames of an animation; created when first needed.
+    FramePrefetcher* m_prefetcher;
+
     const static int INDEX_LOCATION;
     const static int INDEX_INTENSITY;
     const static int INDEX_PERCENTILE;
@@ -71,27 +71,28 @@ void DrawGroupSynchronizer::_scheduleFrameRepaint( const std::shared_ptr<RenderR
     if ( m_imageSize.height() > 0 && m_imageSize.width() > 0 ){
     	Carta::Lib::VectorGraphics::VGComposer comp = Carta::Lib::VectorGraphics::VGComposer( );
         if ( m_combineMode == LayerCompositionModes::PLUS ){
-            std::shared_ptr<Carta::Lib::PixelMaskCombiner> pmc =
-                    std::make_shared < Carta::Lib::PixelMaskCombiner > ();
-            image = QImage(m_imageSize, QImage::Format_ARGB32 );
+            //All layers are masked and added together in a single pass.
+            std::vector<Carta::Lib::QImageCompositor::Layer> compositorLayers;
+            image = QImage(m_imageSize, QImage::Format_ARGB32_Premultiplied );
             image.fill( QColor(0,0,0,0));
             for ( int i = 0; i < dataCount; i++ ){
                 m_layers[i]->disconnect( this );
                 QString layerName = m_layers[i]->_getLayerId();
                 if ( m_images.contains( layerName ) ){
                     std::shared_ptr<RenderResponse> response = m_images[layerName];
-                    QImage layerImage = response->getImage();
                     Carta::Lib::VectorGraphics::VGList vgList = response->getVectorGraphics();
                     if ( vgList.entries().size() > 0 ){
                     	comp.appendList( vgList );
                     }
-                    float alphaVal = m_layers[i]->_getMaskAlpha();
-                    pmc-> setAlpha( alphaVal );
-                    qint32 maskColor = m_layers[i]->_getMaskColor();
-                    pmc-> setMask( maskColor );
-                    pmc->combine( image, layerImage );
+                    Carta::Lib::QImageCompositor::Layer compositorLayer;
+                    compositorLayer.image = response->getImage();
+                    compositorLayer.blend.mode = Carta::Lib::QImageCompositor::Mode::Plus;
+                    compositorLayer.blend.alpha = m_layers[i]->_getMaskAlpha();
+                    compositorLayer.blend.mask = m_layers[i]->_getMaskColor();
+                    compositorLayers.push_back( compositorLayer );
                 }
             }
+            Carta::Lib::QImageCompositor::composite( image, compositorLayers );
             graphics = comp.vgList();
         }
 
@@ -83,8 +83,9 @@ void DrawSynchronizer::_irsDone( QImage img, int64_t jobId ){
     }
 }
 
-void DrawSynchronizer::setInput( std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> rawView ){
-    m_cec->setInput( rawView );
+void DrawSynchronizer::setInput( std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> rawView,
+        const QString& viewId ){
+    m_cec->setInput( rawView, viewId );
 }
 
 void DrawSynchronizer::setContours( const std::set<std::shared_ptr<DataContours> > & contours ){
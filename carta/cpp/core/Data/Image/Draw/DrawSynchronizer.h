@@ -42,8 +42,11 @@ public:
     /**
      * Sets the data to be used in calculating contours.
      * @param rawView - the data for calculating contours.
+     * @param viewId - an identifier for the data, used to reuse contours computed before;
+     *      an empty identifier means the contours are always computed.
      */
-    void setInput( std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> rawView );
+    void setInput( std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> rawView,
+            const QString& viewId = QString() );
 
     /**
      * Sets the contour set(s) to be drawn.
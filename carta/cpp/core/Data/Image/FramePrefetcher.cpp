@@ -0,0 +1,257 @@
+#include "FramePrefetcher.h"
+#include "Data/ComputeWorkerPool.h"
+#include "Data/Image/Render/FrameRenderThread.h"
+#include "ImageRenderService.h"
+#include "Algorithms/floatFrameView.h"
+#include "Globals.h"
+#include "MainConfig.h"
+
+#include <QDebug>
+
+namespace Carta {
+namespace Data {
+
+const int FramePrefetcher::MAX_READS = 2;
+qint64 FramePrefetcher::m_memoryUsed = 0;
+
+
+FramePrefetcher::FramePrefetcher( std::shared_ptr<Carta::Core::ImageRenderService::Service> renderService,
+        QObject* parent ) :
+        QObject( parent ),
+        m_renderService( renderService ),
+        m_colormap( false ),
+        m_bytes( 0 ),
+        m_frameSize( 0 ),
+        m_memoryBudget( Globals::instance()->memoryBudget() ),
+        m_renderThread( nullptr ){
+    //Direct connection; the signal carries a shared pointer that is not a registered type.
+    connect( ComputeWorkerPool::instance(), &ComputeWorkerPool::frameRead,
+            this, &FramePrefetcher::_frameRead );
+    //Prefetched frames are cheap to read again, so they go before the render caches.
+    m_budgetHandle = m_memoryBudget->add( "prefetched frames",
+            Carta::Lib::MemoryBudget::Priority::Low,
+            [this] () { return static_cast<uint64_t>( m_bytes ); },
+            [this] ( uint64_t maxBytes ) { _shrink( maxBytes ); } );
+}
+
+
+void FramePrefetcher::cancel(){
+    for ( quint64 jobId : m_reads.keys() ){
+        ComputeWorkerPool::instance()->cancel( jobId );
+    }
+    m_reads.clear();
+    m_renderQueue.clear();
+    _stopRender();
+    for ( const QString& viewId : m_frames.keys() ){
+        _removeFrame( viewId );
+    }
+    m_wanted.clear();
+    m_currentId = QString();
+    m_budgetCap.clear();
+    m_frameSize = 0;
+}
+
+
+void FramePrefetcher::_frameRead( quint64 jobId, std::shared_ptr<std::vector<float> > pixels,
+        const std::vector<int>& dims ){
+    auto iter = m_reads.find( jobId );
+    //Frames read for other prefetchers.
+    if ( iter == m_reads.end() ){
+        return;
+    }
+    QString viewId = iter.value();
+    m_reads.erase( iter );
+    if ( pixels && _isWanted( viewId ) ){
+        std::shared_ptr<Carta::Core::Algorithms::FloatFrameView> view =
+                std::make_shared<Carta::Core::Algorithms::FloatFrameView>( pixels, dims );
+        qint64 bytes = view->byteCount();
+        m_frameSize = bytes;
+        //The budget would only drop the frame again.
+        if ( m_memoryUsed + bytes <= _getMemoryLimit() &&
+                m_budgetCap.allows( m_bytes, bytes ) ){
+            m_frames.insert( viewId, view );
+            m_frameBytes.insert( viewId, bytes );
+            m_memoryUsed += bytes;
+            m_bytes += bytes;
+            m_memoryBudget->touch( m_budgetHandle );
+            m_memoryBudget->enforce();
+            if ( m_colormap && m_frames.contains( viewId ) ){
+                m_renderQueue.append( viewId );
+                _startRender();
+            }
+        }
+    }
+    _requestFrames();
+}
+
+
+void FramePrefetcher::_frameRendered(){
+    FrameRenderThread* thread = m_renderThread;
+    m_renderThread = nullptr;
+    if ( thread ){
+        if ( _isWanted( thread->getViewId() ) ){
+            m_renderService->insertFrame( thread->getCacheKey(), thread->getResult() );
+        }
+        thread->deleteLater();
+    }
+    _startRender();
+}
+
+
+qint64 FramePrefetcher::_getMemoryLimit(){
+    static const qint64 memoryLimit =
+            qint64( Globals::instance()->mainConfig()->getAnimationPrefetchMB() ) * 1024 * 1024;
+    return memoryLimit;
+}
+
+
+std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> FramePrefetcher::getFrame( const QString& viewId ) const {
+    return m_frames.value( viewId, nullptr );
+}
+
+
+bool FramePrefetcher::_isWanted( const QString& viewId ) const {
+    if ( viewId == m_currentId ){
+        return true;
+    }
+    for ( const FrameRequest& request : m_wanted ){
+        if ( request.viewId == viewId ){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void FramePrefetcher::prefetch( const QString& fileName, const std::vector<int>& permOrder,
+        const QString& currentId, const QList<FrameRequest>& frames, bool colormap ){
+    if ( fileName != m_fileName || permOrder != m_permOrder ){
+        cancel();
+        m_fileName = fileName;
+        m_permOrder = permOrder;
+    }
+    m_currentId = currentId;
+    m_wanted = frames;
+    m_colormap = colormap;
+
+    //The animation moved somewhere else; forget the frames it will not show.
+    for ( const QString& viewId : m_frames.keys() ){
+        if ( !_isWanted( viewId ) ){
+            _removeFrame( viewId );
+        }
+    }
+    auto iter = m_reads.begin();
+    while ( iter != m_reads.end() ){
+        if ( !_isWanted( iter.value() ) ){
+            ComputeWorkerPool::instance()->cancel( iter.key() );
+            iter = m_reads.erase( iter );
+        }
+        else {
+            iter++;
+        }
+    }
+    m_renderQueue.clear();
+    if ( m_colormap ){
+        for ( const FrameRequest& request : m_wanted ){
+            if ( m_frames.contains( request.viewId ) ){
+                m_renderQueue.append( request.viewId );
+            }
+        }
+    }
+    _requestFrames();
+    _startRender();
+}
+
+
+void FramePrefetcher::_removeFrame( const QString& viewId ){
+    if ( m_frames.remove( viewId ) > 0 ){
+        qint64 bytes = m_frameBytes.take( viewId );
+        m_memoryUsed -= bytes;
+        m_bytes -= bytes;
+    }
+}
+
+
+void FramePrefetcher::_shrink( quint64 maxBytes ){
+    //The frame being loaded goes last.
+    for ( int i = m_wanted.size() - 1; i >= 0 && static_cast<quint64>( m_bytes ) > maxBytes; i-- ){
+        _removeFrame( m_wanted[i].viewId );
+    }
+    if ( static_cast<quint64>( m_bytes ) > maxBytes ){
+        for ( const QString& viewId : m_frames.keys() ){
+            _removeFrame( viewId );
+        }
+    }
+    //Otherwise the frames would be read again right away, only to be dropped again.
+    m_budgetCap.shrunk( maxBytes );
+}
+
+
+void FramePrefetcher::_requestFrames(){
+    //Frames are all the same size, so one that has been read tells whether another fits.
+    qint64 frameBytes = m_frameSize;
+    uint64_t budgetUsed = m_memoryBudget->usedBytes();
+    uint64_t budgetMax = m_memoryBudget->maxBytes();
+    m_budgetCap.track( m_bytes, budgetUsed < budgetMax ? budgetMax - budgetUsed : 0 );
+    for ( int i = 0; i < m_wanted.size() && m_reads.size() < MAX_READS; i++ ){
+        const FrameRequest& request = m_wanted[i];
+        if ( m_frames.contains( request.viewId ) ||
+                m_reads.values().contains( request.viewId ) ){
+            continue;
+        }
+        if ( m_memoryUsed + ( m_reads.size() + 1 ) * frameBytes > _getMemoryLimit() ){
+            break;
+        }
+        if ( !m_budgetCap.allows( m_bytes + m_reads.size() * frameBytes, frameBytes ) ){
+            break;
+        }
+        quint64 jobId = ComputeWorkerPool::instance()->readFrame( m_fileName, m_permOrder,
+                request.frameIndices );
+        m_reads.insert( jobId, request.viewId );
+    }
+}
+
+
+
+
+void FramePrefetcher::_startRender(){
+    if ( m_renderThread ){
+        return;
+    }
+    Carta::Core::ImageRenderService::Service::FrameRenderer renderer =
+            m_renderService->frameRenderer();
+    //Without a cached pipeline, colormapping is only safe in the main thread.
+    if ( !renderer.isThreadSafe() ){
+        m_renderQueue.clear();
+        return;
+    }
+    while ( !m_renderQueue.isEmpty() ){
+        QString viewId = m_renderQueue.takeFirst();
+        auto view = m_frames.value( viewId, nullptr );
+        if ( view && !m_renderService->isFrameCached( renderer.cacheKey( viewId ) ) ){
+            m_renderThread = new FrameRenderThread( renderer, viewId, view );
+            connect( m_renderThread, SIGNAL(finished()), this, SLOT(_frameRendered()));
+            m_renderThread->start();
+            break;
+        }
+    }
+}
+
+
+void FramePrefetcher::_stopRender(){
+    if ( m_renderThread ){
+        disconnect( m_renderThread, SIGNAL(finished()), this, SLOT(_frameRendered()));
+        //Rendering a single frame does not take long.
+        m_renderThread->wait();
+        delete m_renderThread;
+        m_renderThread = nullptr;
+    }
+}
+
+
+FramePrefetcher::~FramePrefetcher(){
+    cancel();
+    m_memoryBudget->remove( m_budgetHandle );
+}
+}
+}
@@ -0,0 +1,150 @@
+/**
+ * Reads the frames an animation is about to show before it gets to them, and
+ * colormaps them into the frame cache of the render service when the colormap
+ * does not depend on the frame.
+ *
+ * Frames are read by the shared ComputeWorkerPool, because casacore tables cannot be
+ * accessed by different threads at the same time; colormapping happens in a
+ * separate thread.
+ *
+ * The frames count against the process-wide memory budget as a low priority cache;
+ * when it has to shrink, the frames the animation will get to last are dropped first.
+ * After that, no more frames are read than fit into what the budget has left; otherwise
+ * the dropped frames would be read again right away.
+ **/
+
+#pragma once
+
+#include "CartaLib/MemoryBudget.h"
+#include "Algorithms/prefetchCap.h"
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <memory>
+#include <vector>
+
+namespace Carta {
+namespace Lib {
+namespace NdArray {
+class RawViewInterface;
+}
+}
+namespace Core {
+namespace ImageRenderService {
+class Service;
+}
+}
+}
+
+namespace Carta{
+namespace Data{
+
+class FrameRenderThread;
+
+class FramePrefetcher : public QObject {
+    Q_OBJECT
+
+public:
+
+    /// A frame to read ahead of time.
+    struct FrameRequest {
+        /// Identifier of the frame, the same as the cache id of its view.
+        QString viewId;
+        /// Index of the frame on each axis of the permuted image.
+        std::vector<int> frameIndices;
+    };
+
+    /**
+     * Constructor.
+     * @param renderService - the service the frames will be rendered by.
+     */
+    explicit FramePrefetcher( std::shared_ptr<Carta::Core::ImageRenderService::Service> renderService,
+            QObject* parent = 0 );
+
+    /**
+     * Replaces the frames to read ahead of time. Frames that are no longer upcoming are
+     * dropped and reads of them are cancelled.
+     * @param fileName - the image the frames come from.
+     * @param permOrder - the order of the axes of the image, display axes first.
+     * @param currentId - the identifier of the frame being loaded; it is kept if it has
+     *      already been read, but not requested.
+     * @param frames - the upcoming frames, the soonest first.
+     * @param colormap - whether the frames may also be colormapped; this should be false
+     *      when the colormap changes from one frame to the next.
+     */
+    void prefetch( const QString& fileName, const std::vector<int>& permOrder,
+            const QString& currentId, const QList<FrameRequest>& frames, bool colormap );
+
+    /**
+     * Returns a frame that has been read ahead of time.
+     * @param viewId - the identifier of the frame.
+     * @return - the frame, or null if it has not been read.
+     */
+    std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> getFrame( const QString& viewId ) const;
+
+    /**
+     * Drops all frames and cancels all outstanding work.
+     */
+    void cancel();
+
+    /**
+     * Destructor.
+     */
+    ~FramePrefetcher();
+
+private slots:
+
+    void _frameRead( quint64 jobId, std::shared_ptr<std::vector<float> > pixels,
+            const std::vector<int>& dims );
+    void _frameRendered();
+
+private:
+
+    //Memory all prefetchers together may use for frames, from the configuration.
+    static qint64 _getMemoryLimit();
+    bool _isWanted( const QString& viewId ) const;
+    void _removeFrame( const QString& viewId );
+    //Drops frames, the ones needed last first, until at most maxBytes are used.
+    void _shrink( quint64 maxBytes );
+    void _requestFrames();
+    void _startRender();
+    void _stopRender();
+
+    //Maximum number of frames that are being read at the same time.
+    static const int MAX_READS;
+
+    //Memory used by the frames of all prefetchers.
+    static qint64 m_memoryUsed;
+
+    std::shared_ptr<Carta::Core::ImageRenderService::Service> m_renderService;
+    QString m_fileName;
+    std::vector<int> m_permOrder;
+    QString m_currentId;
+    QList<FrameRequest> m_wanted;
+    bool m_colormap;
+
+    //Frames being read, by job id.
+    QMap<quint64,QString> m_reads;
+
+    //Frames that have been read, and their size in bytes.
+    QMap<QString,std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> > m_frames;
+    QMap<QString,qint64> m_frameBytes;
+    qint64 m_bytes;
+    //Size of a frame of the image, 0 until one has been read.
+    qint64 m_frameSize;
+
+    Carta::Lib::MemoryBudget::SharedPtr m_memoryBudget;
+    Carta::Lib::MemoryBudget::Handle m_budgetHandle;
+    //What the memory budget left room for.
+    Carta::Core::Algorithms::PrefetchCap m_budgetCap;
+
+    //Frames waiting to be colormapped, the soonest first.
+    QList<QString> m_renderQueue;
+    FrameRenderThread* m_renderThread;
+
+    FramePrefetcher( const FramePrefetcher& other);
+    FramePrefetcher& operator=( const FramePrefetcher& other );
+};
+}
+}
@@ -160,6 +160,10 @@ bool Layer::_isLoadable( const std::vector<int>& /*frames*/ ) const {
 	return false;
 }
 
+void Layer::_prefetch( const std::vector<int>& /*frames*/,
+        const std::vector<std::vector<int> >& /*upcoming*/, bool /*colormap*/ ){
+}
+
 bool Layer::_isMatch( const QString& name ) const {
     bool matched = false;
     QString id = _getLayerId();
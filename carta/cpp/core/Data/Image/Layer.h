@@ -282,6 +282,15 @@ protected:
      */
     virtual bool _isLoadable( const std::vector<int>& frames ) const;
 
+    /**
+     * Start reading the frames an animation is about to show.
+     * @param frames - list of frame indices being loaded.
+     * @param upcoming - lists of frame indices that will be loaded next, the soonest first.
+     * @param colormap - whether the frames may also be colormapped ahead of time.
+     */
+    virtual void _prefetch( const std::vector<int>& frames,
+            const std::vector<std::vector<int> >& upcoming, bool colormap );
+
 
     /**
      * Return the layer with the given name, if a name is specified; otherwise, return the current
@@ -725,13 +725,23 @@ void LayerData::_load(std::vector<int> frames, bool recomputeClipsOnNewFrame,
             }
         }
         if ( m_drawSync ){
-        	std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> rawData( m_dataSource->_getRawData( frames ));
-        	m_drawSync->setInput( rawData );
+        	//Use the same frames, and so the same view id, as the render service.
+        	std::vector<int> mFrames = m_dataSource->_fitFramesToImage( frames );
+        	std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> rawData = m_dataSource->_getFrameData( mFrames );
+        	m_drawSync->setInput( rawData, m_dataSource->_getViewIdCurrent( mFrames ) );
         }
     }
 }
 
 
+void LayerData::_prefetch( const std::vector<int>& frames,
+        const std::vector<std::vector<int> >& upcoming, bool colormap ){
+    if ( m_dataSource ){
+        m_dataSource->_prefetch( frames, upcoming, colormap );
+    }
+}
+
+
 void LayerData::_removeContourSet( std::shared_ptr<DataContours> contourSet ){
     if ( contourSet ){
         QString targetName = contourSet->getName();
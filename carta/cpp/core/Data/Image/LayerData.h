@@ -315,6 +315,15 @@ protected:
     void _load( std::vector<int> frames, bool autoClip, double clipMinPercentile,
     		double clipMaxPercentile );
 
+    /**
+     * Start reading the frames an animation is about to show.
+     * @param frames - list of frame indices being loaded.
+     * @param upcoming - lists of frame indices that will be loaded next, the soonest first.
+     * @param colormap - whether the frames may also be colormapped ahead of time.
+     */
+    virtual void _prefetch( const std::vector<int>& frames,
+            const std::vector<std::vector<int> >& upcoming, bool colormap ) Q_DECL_OVERRIDE;
+
     /**
      * Center the image.
      */
@@ -773,6 +773,16 @@ bool LayerGroup::_isLoadable( const std::vector<int>& frames ) const {
 	return loadable;
 }
 
+void LayerGroup::_prefetch( const std::vector<int>& frames,
+        const std::vector<std::vector<int> >& upcoming, bool colormap ){
+	int childCount = m_children.size();
+	for ( int i = 0; i < childCount; i++ ){
+		if ( m_children[i]->_isVisible() && !m_children[i]->_isEmpty() ){
+			m_children[i]->_prefetch( frames, upcoming, colormap );
+		}
+	}
+}
+
 bool LayerGroup::_isSpectralAxis() const {
 	bool spectralAxis = false;
 
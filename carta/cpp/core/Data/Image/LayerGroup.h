@@ -382,6 +382,15 @@ protected:
      */
     virtual bool _isLoadable( const std::vector<int>& frames ) const Q_DECL_OVERRIDE;
 
+    /**
+     * Start reading the frames an animation is about to show in the visible layers.
+     * @param frames - list of frame indices being loaded.
+     * @param upcoming - lists of frame indices that will be loaded next, the soonest first.
+     * @param colormap - whether the frames may also be colormapped ahead of time.
+     */
+    virtual void _prefetch( const std::vector<int>& frames,
+            const std::vector<std::vector<int> >& upcoming, bool colormap ) Q_DECL_OVERRIDE;
+
     /**
      * Returns whether or not the layered images have spectral axes.
      * @return - true if the layered images all have spectral axes; false, otherwise.
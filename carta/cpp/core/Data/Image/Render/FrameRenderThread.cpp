@@ -0,0 +1,40 @@
+#include "FrameRenderThread.h"
+
+namespace Carta
+{
+namespace Data
+{
+
+FrameRenderThread::FrameRenderThread(
+        const Carta::Core::ImageRenderService::Service::FrameRenderer& renderer,
+        const QString& viewId,
+        std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view,
+        QObject* parent ):
+    QThread( parent ),
+    m_renderer( renderer ),
+    m_viewId( viewId ),
+    m_view( view ){
+}
+
+QString FrameRenderThread::getCacheKey() const {
+    return m_renderer.cacheKey( m_viewId );
+}
+
+QImage FrameRenderThread::getResult() const {
+    return m_result;
+}
+
+QString FrameRenderThread::getViewId() const {
+    return m_viewId;
+}
+
+void FrameRenderThread::run(){
+    //A single thread, so that the frame being shown keeps the other cores.
+    m_result = m_renderer.render( m_view.get(), 1 );
+}
+
+
+FrameRenderThread::~FrameRenderThread(){
+}
+}
+}
@@ -0,0 +1,70 @@
+/**
+ * A thread that colormaps a frame the animation has not reached yet.
+ **/
+
+#pragma once
+
+#include "ImageRenderService.h"
+#include <QThread>
+#include <QImage>
+
+
+namespace Carta{
+namespace Data{
+
+class FrameRenderThread : public QThread {
+
+    Q_OBJECT;
+
+public:
+
+    /**
+     * Constructor.
+     * @param renderer - the rendering settings, captured when the frame was queued.
+     * @param viewId - the identifier of the frame.
+     * @param view - the frame.
+     */
+    FrameRenderThread( const Carta::Core::ImageRenderService::Service::FrameRenderer& renderer,
+            const QString& viewId,
+            std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> view,
+            QObject* parent = nullptr );
+
+    /**
+     * Returns the key the rendered frame is cached under.
+     * @return - the frame cache key.
+     */
+    QString getCacheKey() const;
+
+    /**
+     * Returns the rendered frame.
+     * @return - the frame, or a null image if it could not be rendered.
+     */
+    QImage getResult() const;
+
+    /**
+     * Returns the identifier of the frame.
+     * @return - the identifier of the frame.
+     */
+    QString getViewId() const;
+
+    /**
+     * Render the frame.
+     */
+    void run();
+
+    /**
+     * Destructor.
+     */
+    virtual ~FrameRenderThread();
+
+private:
+    Carta::Core::ImageRenderService::Service::FrameRenderer m_renderer;
+    QString m_viewId;
+    std::shared_ptr<Carta::Lib::NdArray::RawViewInterface> m_view;
+    QImage m_result;
+
+    FrameRenderThread( const FrameRenderThread& other);
+    FrameRenderThread& operator=( const FrameRenderThread& other );
+};
+}
+}
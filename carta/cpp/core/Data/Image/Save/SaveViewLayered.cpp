@@ -49,13 +49,11 @@ void SaveViewLayered::paintLayers(){
     buff.fill( QColor( 0, 0, 0, 255 ) );
 
     // now go through the layers and paint them on top of the last result
+    std::vector < std::pair < QImage, Carta::Lib::IQImageCombiner::SharedPtr > > rasters;
     for ( auto & layer : m_rasterLayers ) {
-        Carta::Lib::IQImageCombiner::SharedPtr combiner = layer.combiner;
-        if ( ! combiner ) {
-            combiner = std::make_shared < Carta::Lib::DefaultCombiner > ();
-        }
-        combiner->combine( buff, layer.qimg );
+        rasters.push_back( std::make_pair( layer.qimg, layer.combiner ) );
     }
+    Carta::Lib::IQImageCombiner::combineAll( buff, rasters );
 
     m_vgView-> setRaster( buff );
 
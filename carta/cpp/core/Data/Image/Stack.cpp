@@ -441,6 +441,22 @@ QString Stack::_moveSelectedLayers( bool moveDown ){
     return result;
 }
 
+void Stack::_prefetchFrames( AxisInfo::KnownType axisType, const std::vector<int>& upcoming,
+        bool colormap ){
+    int axisIndex = static_cast<int>( axisType );
+    std::vector<int> frames = _getFrameIndices();
+    if ( axisIndex < 0 || axisIndex >= static_cast<int>( frames.size() ) ){
+        return;
+    }
+    std::vector<std::vector<int> > upcomingFrames;
+    for ( int frame : upcoming ){
+        std::vector<int> nextFrames = frames;
+        nextFrames[axisIndex] = frame;
+        upcomingFrames.push_back( nextFrames );
+    }
+    _prefetch( frames, upcomingFrames, colormap );
+}
+
 void Stack::_render( QList<std::shared_ptr<Layer> > datas, int gridIndex,
 		bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile ){
     std::vector<int> frames =_getFrameIndices();
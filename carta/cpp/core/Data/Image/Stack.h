@@ -137,6 +137,15 @@ private:
     void _initializeState();
 
     QString _moveSelectedLayers( bool moveDown );
+
+    /**
+     * Start reading the frames of the visible layers that an animation is about to show.
+     * @param axisType - the axis being animated.
+     * @param upcoming - the frames of the axis that will be shown next, the soonest first.
+     * @param colormap - whether the frames may also be colormapped ahead of time.
+     */
+    void _prefetchFrames( Carta::Lib::AxisInfo::KnownType axisType,
+            const std::vector<int>& upcoming, bool colormap );
     void _render(QList<std::shared_ptr<Layer> > datas, int gridIndex,
     		bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile);
     void _renderAll(bool recomputeClipsOnNewFrame, double minClipPercentile, double maxClipPercentile);
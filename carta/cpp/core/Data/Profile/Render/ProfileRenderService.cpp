@@ -1,19 +1,41 @@
 #include "ProfileRenderService.h"
-#include "ProfileRenderWorker.h"
-#include "ProfileRenderThread.h"
 #include "ProfileRenderRequest.h"
+#include "Data/ComputeWorkerPool.h"
 #include "Data/Image/Layer.h"
 #include "Data/Region/Region.h"
-#include "CartaLib/Hooks/ProfileHook.h"
 
 namespace Carta {
 namespace Data {
 
 ProfileRenderService::ProfileRenderService( QObject * parent ) :
-        QObject( parent ),
-        m_worker( nullptr),
-        m_renderThread( nullptr ){
-    m_renderQueued = false;
+        QObject( parent ){
+    connect( ComputeWorkerPool::instance(),
+            SIGNAL(profileFinished(quint64, const Carta::Lib::Hooks::ProfileResult&)),
+            this, SLOT( _postResult(quint64, const Carta::Lib::Hooks::ProfileResult&)));
+}
+
+
+void ProfileRenderService::_cancelStale( const ProfileRenderRequest& request ){
+    //Requests that create a new profile are never stale; neither are requests
+    //for a different statistic of the same region.
+    if ( request.isCreateNew() ){
+        return;
+    }
+    auto iter = m_requests.begin();
+    while ( iter != m_requests.end() ){
+        const ProfileRenderRequest& other = iter.value();
+        if ( !other.isCreateNew() &&
+                other.getLayer() == request.getLayer() &&
+                other.getRegion() == request.getRegion() &&
+                other.getProfileInfo().getAggregateType() ==
+                        request.getProfileInfo().getAggregateType() ){
+            ComputeWorkerPool::instance()->cancel( iter.key() );
+            iter = m_requests.erase( iter );
+        }
+        else {
+            iter++;
+        }
+    }
 }
 
 
@@ -23,10 +45,23 @@ bool ProfileRenderService::renderProfile(std::shared_ptr<Layer> layer,
     bool profileRender = true;
     ProfileRenderRequest request( layer, region, profInfo, createNew );
     if ( layer ){
-    	if ( ! m_requests.contains( request ) ){
-    		m_requests.enqueue( request );
-    		_scheduleRender( layer, region, profInfo );
-    	}
+        bool pending = false;
+        for ( auto iter = m_requests.begin(); iter != m_requests.end(); iter++ ){
+            if ( iter.value() == request ){
+                pending = true;
+                break;
+            }
+        }
+        if ( !pending ){
+            _cancelStale( request );
+            std::shared_ptr<Carta::Lib::Regions::RegionBase> regionInfo(nullptr);
+            if ( region ){
+                regionInfo = region->getModel();
+            }
+            quint64 jobId = ComputeWorkerPool::instance()->computeProfile(
+                    layer->_getFileName(), regionInfo, profInfo );
+            m_requests.insert( jobId, request );
+        }
     }
     else {
         profileRender = false;
@@ -35,56 +70,22 @@ bool ProfileRenderService::renderProfile(std::shared_ptr<Layer> layer,
 }
 
 
-void ProfileRenderService::_scheduleRender( std::shared_ptr<Layer> layer,
-        std::shared_ptr<Region> region, const Carta::Lib::ProfileInfo& profInfo){
-    if ( m_renderQueued ) {
-        return;
-    }
-    m_renderQueued = true;
-
-
-    //Create a worker if we don't have one.
-    if ( !m_worker ){
-        m_worker = new ProfileRenderWorker();
-    }
-
-    if ( !m_renderThread ){
-        m_renderThread = new ProfileRenderThread();
-        connect( m_renderThread, SIGNAL(finished()),
-                this, SLOT( _postResult()));
-    }
-    std::shared_ptr<Carta::Lib::Regions::RegionBase> regionInfo(nullptr);
-    if ( region ){
-        regionInfo = region->getModel();
-    }
-    std::shared_ptr<Carta::Lib::Image::ImageInterface> dataSource = layer->_getImage();
-    m_worker->setParameters( dataSource, regionInfo, profInfo );
-    int pid = m_worker->computeProfile();
-    if ( pid != -1 ){
-        m_renderThread->setFileDescriptor( pid );
-        m_renderThread->start();
-    }
-    else {
-        m_renderQueued = false;
-    }
-}
-
-void ProfileRenderService::_postResult(  ){
-    Lib::Hooks::ProfileResult result = m_renderThread->getResult();
-    ProfileRenderRequest request = m_requests.dequeue();
-    emit profileResult(result, request.getLayer(), request.getRegion(), request.isCreateNew() );
-    m_renderQueued = false;
-    if ( m_requests.size() > 0 ){
-        ProfileRenderRequest& head = m_requests.head();
-         _scheduleRender( head.getLayer(), head.getRegion(), head.getProfileInfo() );
+void ProfileRenderService::_postResult( quint64 jobId,
+        const Carta::Lib::Hooks::ProfileResult& result ){
+    auto iter = m_requests.find( jobId );
+    //Results of other services (or cancelled requests) are not ours to post.
+    if ( iter != m_requests.end() ){
+        ProfileRenderRequest request = iter.value();
+        m_requests.erase( iter );
+        emit profileResult(result, request.getLayer(), request.getRegion(), request.isCreateNew() );
     }
 }
 
 
 ProfileRenderService::~ProfileRenderService(){
-    delete m_worker;
-    delete m_renderThread;
+    for ( quint64 jobId : m_requests.keys() ){
+        ComputeWorkerPool::instance()->cancel( jobId );
+    }
 }
 }
 }
-
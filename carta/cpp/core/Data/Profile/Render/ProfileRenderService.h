@@ -1,5 +1,6 @@
 /**
- * Manages the production of profile data from an image cube.
+ * Manages the production of profile data from an image cube. The profiles are
+ * computed by the shared ComputeWorkerPool.
  **/
 
 #pragma once
@@ -9,7 +10,7 @@
 #include "CartaLib/Hooks/ProfileResult.h"
 
 #include <QObject>
-#include <QQueue>
+#include <QMap>
 #include <memory>
 
 
@@ -17,8 +18,6 @@ namespace Carta{
 namespace Data{
 
 class Layer;
-class ProfileRenderWorker;
-class ProfileRenderThread;
 class ProfileRenderRequest;
 class Region;
 
@@ -61,15 +60,14 @@ signals:
 
 private slots:
 
-    void _postResult( );
+    void _postResult( quint64 jobId, const Carta::Lib::Hooks::ProfileResult& result );
 
 private:
-    void _scheduleRender( std::shared_ptr<Layer> layer,
-            std::shared_ptr<Region> region, const Carta::Lib::ProfileInfo& profInfo );
-    ProfileRenderWorker* m_worker;
-    ProfileRenderThread* m_renderThread;
-    bool m_renderQueued;
-    QQueue<ProfileRenderRequest> m_requests;
+    //Cancel outstanding updates of the same profile that the new request makes obsolete.
+    void _cancelStale( const ProfileRenderRequest& request );
+
+    //Requests that have been submitted to the worker pool, by job id.
+    QMap<quint64,ProfileRenderRequest> m_requests;
 
     ProfileRenderService( const ProfileRenderService& other);
     ProfileRenderService& operator=( const ProfileRenderService& other );
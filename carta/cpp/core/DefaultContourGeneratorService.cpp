@@ -4,6 +4,9 @@
 
 #include "DefaultContourGeneratorService.h"
 #include "CartaLib/Algorithms/ContourConrec.h"
+#include "CartaLib/Algorithms/ContourCache.h"
+#include "CartaLib/MemoryBudget.h"
+#include "Globals.h"
 #include <utility>
 #include <QElapsedTimer>
 
@@ -32,9 +35,11 @@ DefaultContourGeneratorService::setLevelsVector( const std::vector < std::vector
 }
 
 void
-DefaultContourGeneratorService::setInput( Carta::Lib::NdArray::RawViewInterface::SharedPtr rawView )
+DefaultContourGeneratorService::setInput( Carta::Lib::NdArray::RawViewInterface::SharedPtr rawView,
+                                          const QString & viewId )
 {
     m_rawView = rawView;
+    m_viewId = viewId;
 }
 
 Lib::IContourGeneratorService::JobId
@@ -62,22 +67,58 @@ DefaultContourGeneratorService::timerCB()
     // set the output result
     Result result;
 
+    // contours of levels computed before for this view are reused, the algorithm
+    // only runs for the others
+    Carta::Lib::Algorithms::ContourCache * cache = nullptr;
+    if ( ! m_viewId.isEmpty() ) {
+        cache = Globals::instance()->contourCache();
+    }
+
     // run the contour algorithm
     for (int i = 0; i < m_contourTypesVector.size(); i++) {
         qDebug() << "++++++++ [contour] build the contour for" << m_contourTypesVector.size() << "smoothness type(s)";
-        Carta::Lib::Algorithms::ContourConrec cc;
-        cc.setLevels(m_levelsVector[i]);
-        auto rawContours = cc.compute(m_rawView.get(), m_contourTypesVector[i]);
-        for (size_t j = 0; j < m_levelsVector[i].size(); ++ j) {
-            Carta::Lib::Contour contour( m_levelsVector[i][j], rawContours[j]);
+        const QString & type = m_contourTypesVector[i];
+        const std::vector < double > & levels = m_levelsVector[i];
+        std::vector < std::vector < QPolygonF > > polylines( levels.size() );
+        std::vector < double > missingLevels;
+        std::vector < size_t > missingIndices;
+        for (size_t j = 0; j < levels.size(); ++ j) {
+            if ( ! cache || ! cache->find( m_viewId, type, levels[j], polylines[j] ) ) {
+                missingLevels.push_back( levels[j] );
+                missingIndices.push_back( j );
+            }
+        }
+        if ( ! missingLevels.empty() ) {
+            Carta::Lib::Algorithms::ContourConrec cc;
+            cc.setLevels( missingLevels );
+            auto rawContours = cc.compute( m_rawView.get(), type );
+            for (size_t k = 0; k < missingIndices.size(); ++ k) {
+                polylines[missingIndices[k]] = std::move( rawContours[k] );
+                if ( cache ) {
+                    cache->insert( m_viewId, type, missingLevels[k], polylines[missingIndices[k]] );
+                }
+            }
+        }
+        for (size_t j = 0; j < levels.size(); ++ j) {
+            Carta::Lib::Contour contour( levels[j], polylines[j]);
             result.add(contour);
         }
     }
 
+    // the new levels may have pushed the caches over the memory budget
+    if ( cache ) {
+        Globals::instance()->memoryBudget()->enforce();
+    }
+
     int elapsedTime = timer.elapsed();
     if (CARTA_RUNTIME_CHECKS) {
         // stop the timer and print out the elapsed time
         qDebug() << "++++++++ [contour] Spending time for calculating contours:" << elapsedTime << "ms";
+        if ( cache ) {
+            Carta::Lib::Algorithms::ContourCache::Stats stats = cache->stats();
+            qDebug() << "++++++++ [contour] cache hit rate:" << cache->hitRate()
+                     << "levels cached:" << stats.entries << "size (kB):" << stats.kilobytes;
+        }
     }
 
     emit done( result, m_lastJobId );
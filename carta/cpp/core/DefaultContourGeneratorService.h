@@ -30,7 +30,8 @@ public:
     setLevelsVector( const std::vector < std::vector < double > > & levelsVector ) override;
 
     virtual void
-    setInput( Carta::Lib::NdArray::RawViewInterface::SharedPtr rawView ) override;
+    setInput( Carta::Lib::NdArray::RawViewInterface::SharedPtr rawView,
+              const QString & viewId = QString() ) override;
 
     virtual JobId
     start( JobId jobId ) override;
@@ -47,6 +48,7 @@ private:
     QStringList m_contourTypesVector;
     JobId m_lastJobId = - 1;
     Carta::Lib::NdArray::RawViewInterface::SharedPtr m_rawView = nullptr;
+    QString m_viewId;
     QTimer m_timer;
 
 };
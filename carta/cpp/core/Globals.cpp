@@ -6,6 +6,13 @@
 #include "IConnector.h"
 #include "IPlatform.h"
 #include "PluginManager.h"
+#include "MainConfig.h"
+#include "CartaLib/Hooks/GetPersistentCache.h"
+#include "CartaLib/MemoryPCache.h"
+#include "CartaLib/MemoryBudget.h"
+#include "CartaLib/Algorithms/ContourCache.h"
+#include "CartaLib/Regions/RegionMask.h"
+#include <QDebug>
 
 Globals * Globals::m_instance = nullptr;
 
@@ -64,6 +71,73 @@ void Globals::setMainConfig(const MainConfig::ParsedInfo * mainConfig)
     m_mainConfig = mainConfig;
 }
 
+std::shared_ptr<Carta::Lib::MemoryPCache> Globals::diskCache()
+{
+    if ( ! m_diskCacheLoaded ) {
+        m_diskCacheLoaded = true;
+        auto res = pluginManager()-> prepare < Carta::Lib::Hooks::GetPersistentCache > ().first();
+        if ( res.isNull() || ! res.val() ) {
+            qWarning( "Could not find a disk cache plugin." );
+        }
+        else {
+            const MainConfig::ParsedInfo * config = mainConfig();
+            m_diskCache = std::make_shared<Carta::Lib::MemoryPCache>( res.val(),
+                    static_cast<uint64_t>( config->getMemoryCacheMB() ) * 1024 * 1024,
+                    config->getMemoryCacheShards(), config->getMemoryCacheWriteBatch(),
+                    config->getMemoryCacheNegativeSeconds() * 1000 );
+            Carta::Lib::MemoryPCache * cache = m_diskCache.get();
+            m_diskCacheBudgetHandle = memoryBudget()->add( "disk cache front",
+                    Carta::Lib::MemoryBudget::Priority::High,
+                    [cache] () { return cache->memoryUsed(); },
+                    [cache] ( uint64_t maxBytes ) { cache->shrink( maxBytes ); } );
+        }
+    }
+    return m_diskCache;
+}
+
+void Globals::releaseDiskCache()
+{
+    if ( m_diskCache ) {
+        Carta::Lib::MemoryPCache::Stats stats = m_diskCache->stats();
+        qDebug() << "Memory cache hits:" << stats.hits << "misses:" << stats.misses
+                 << "disk read time (us):" << stats.backendReadMicros
+                 << "disk writes:" << stats.backendWrites << "evictions:" << stats.evictions;
+        m_diskCache->Release();
+        m_diskCache = nullptr;
+        memoryBudget()->remove( m_diskCacheBudgetHandle );
+        m_diskCacheBudgetHandle = -1;
+    }
+}
+
+Carta::Lib::Algorithms::ContourCache * Globals::contourCache()
+{
+    if ( ! m_contourCache ) {
+        m_contourCache = std::make_shared<Carta::Lib::Algorithms::ContourCache>(
+                static_cast<uint64_t>( mainConfig()->getContourCacheMB() ) * 1024 * 1024 );
+        Carta::Lib::Algorithms::ContourCache * cache = m_contourCache.get();
+        m_contourCacheBudgetHandle = memoryBudget()->add( "contours",
+                Carta::Lib::MemoryBudget::Priority::Normal,
+                [cache] () { return cache->memoryUsed(); },
+                [cache] ( uint64_t maxBytes ) { cache->shrink( maxBytes ); } );
+    }
+    memoryBudget()->touch( m_contourCacheBudgetHandle );
+    return m_contourCache.get();
+}
+
+std::shared_ptr<Carta::Lib::MemoryBudget> Globals::memoryBudget()
+{
+    if ( ! m_memoryBudget ) {
+        m_memoryBudget = std::make_shared<Carta::Lib::MemoryBudget>(
+                static_cast<uint64_t>( mainConfig()->getMemoryBudgetMB() ) * 1024 * 1024 );
+        //The plugins cannot get to the budget, so the masks they share are registered here.
+        Carta::Lib::Regions::RegionMaskCache * masks = & Carta::Lib::Regions::RegionMaskCache::shared();
+        m_memoryBudget->add( "region masks",
+                Carta::Lib::MemoryBudget::Priority::Normal,
+                [masks] () { return masks->memoryUsed(); },
+                [masks] ( uint64_t maxBytes ) { masks->shrink( maxBytes ); } );
+    }
+    return m_memoryBudget;
+}
 
 Globals::Globals()
 {
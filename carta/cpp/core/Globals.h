@@ -18,6 +18,7 @@ class IConnector;
 class IPlatform;
 namespace CmdLine { class ParsedInfo; }
 namespace MainConfig { class ParsedInfo; }
+namespace Carta { namespace Lib { class MemoryPCache; class MemoryBudget; namespace Algorithms { class ContourCache; } } }
 
 class Globals {
 
@@ -55,6 +56,20 @@ public:
     const MainConfig::ParsedInfo * mainConfig() const;
     void setMainConfig(const MainConfig::ParsedInfo * mainConfig);
 
+    /// get the in-memory cache, shared by all images, in front of the persistent
+    /// cache; nullptr if there is no persistent cache plugin
+    std::shared_ptr<Carta::Lib::MemoryPCache> diskCache();
+
+    /// flush the shared in-memory cache and release the persistent cache
+    void releaseDiskCache();
+
+    /// get the cache of computed contours, shared by all images; the memory budget
+    /// counts every call as a use of the cache
+    Carta::Lib::Algorithms::ContourCache * contourCache();
+
+    /// get the memory budget all the in-memory caches of the process register with
+    std::shared_ptr<Carta::Lib::MemoryBudget> memoryBudget();
+
 protected:
 
 //    PluginManager * m_pluginManager = nullptr;
@@ -63,6 +78,12 @@ protected:
     IConnector * m_connector = nullptr;
     const CmdLine::ParsedInfo * m_cmdLineInfo = nullptr;
     const MainConfig::ParsedInfo * m_mainConfig = nullptr;
+    std::shared_ptr<Carta::Lib::MemoryPCache> m_diskCache = nullptr;
+    bool m_diskCacheLoaded = false;
+    std::shared_ptr<Carta::Lib::Algorithms::ContourCache> m_contourCache = nullptr;
+    std::shared_ptr<Carta::Lib::MemoryBudget> m_memoryBudget = nullptr;
+    int m_diskCacheBudgetHandle = -1;
+    int m_contourCacheBudgetHandle = -1;
 
     static Globals * m_instance;
 
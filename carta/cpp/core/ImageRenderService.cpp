@@ -4,9 +4,13 @@
 
 #include "ImageRenderService.h"
 #include "CartaLib/LinearMap.h"
+#include "Algorithms/rasterRender.h"
+#include "Algorithms/tileGrid.h"
 #include <QColor>
 #include <QPainter>
 #include <QElapsedTimer>
+#include <cstring>
+#include <limits>
 
 namespace NdArray = Carta::Lib::NdArray;
 
@@ -20,23 +24,10 @@ static constexpr QImage::Format OptimalQImageFormat = QImage::Format_ARGB32_Prem
 /// \todo check if the bug is still there in Qt5.4+, it definitely is there in Qt5.3
 static constexpr bool QtPremultipliedBugStillExists = true;
 
-/// internal algorithm for converting an instance of image interface to qimage
-/// using the pixel pipeline
-///
-/// \tparam Pipeline
-/// \param m_rawView
-/// \param pipe
-/// \param m_qImage
-template < class Pipeline >
+/// make sure qImage has the given size and the format the frames are rendered in
 static void
-iView2qImage( NdArray::RawViewInterface * rawView, Pipeline & pipe, QImage & qImage,
-        QRgb nanColor)
+allocateFrameImage( QImage & qImage, QSize size )
 {
-    //qDebug() << "rv2qi2" << rawView-> dims();
-    typedef double Scalar;
-
-    QSize size( rawView->dims()[0], rawView->dims()[1] );
-
     QImage::Format desiredFormat = OptimalQImageFormat;
     if ( QtPremultipliedBugStillExists ) {
         desiredFormat = QImage::Format_ARGB32;
@@ -50,48 +41,26 @@ iView2qImage( NdArray::RawViewInterface * rawView, Pipeline & pipe, QImage & qIm
     auto bytesPerLine = qImage.bytesPerLine();
     CARTA_ASSERT( bytesPerLine == size.width() * 4 );
     Q_UNUSED( bytesPerLine );
+}
 
-    // start with a pointer to the beginning of last row (we are constructing image
-    // bottom-up)
-    QRgb * outPtr = reinterpret_cast < QRgb * > (
-        qImage.bits() + size.width() * ( size.height() - 1 ) * 4 );
-
-    if( 0) {
-        CARTA_ASSERT( qImage.bits() + size.width() * (size.height() - 1) * 4 == qImage.scanLine( size.height() - 1));
-        // sanity check
-        for( int y = 0 ; y < size.height() ; y ++ ) {
-            CARTA_ASSERT( qImage.bits() + size.width() * 4 * y == qImage.scanLine(y) );
-        }
-    }
-
-    // make a double view
-    NdArray::TypedView < Scalar > typedView( rawView, false );
-
-    /// @todo for more efficiency, instead of forEach() we should switch to one of the
-    /// higher performance APIs and maybe even sprinkle it with some openmp/cilk magic :)
-    int64_t counter = 0;
-
-
-    auto lambda = [&] ( const Scalar & ival )
-    {
-        if ( Q_LIKELY( ! std::isnan( ival ) ) ) {
-            pipe.convertq( ival, * outPtr );
-        }
-        else {
-            * outPtr = nanColor;
-        }
-        outPtr++;
-        counter++;
-
-        // build the image bottom-up
-        if ( counter % size.width() == 0 ) {
-            outPtr -= size.width() * 2;
-        }
-    };
-    typedView.forEach( lambda );
-
-    CARTA_ASSERT( counter == size.width() * size.height());
+/// internal algorithm for converting an instance of image interface to qimage
+/// using the pixel pipeline
+///
+/// \tparam Pipeline
+/// \param m_rawView
+/// \param pipe
+/// \param m_qImage
+/// \param nThreads how many threads to use for colormapping (<= 0 means all available),
+/// only pipelines that are safe to call concurrently should use more than one
+template < class Pipeline >
+static void
+iView2qImage( NdArray::RawViewInterface * rawView, Pipeline & pipe, QImage & qImage,
+        QRgb nanColor, int nThreads )
+{
+    allocateFrameImage( qImage, QSize( rawView->dims()[0], rawView->dims()[1] ) );
 
+    // the image is constructed bottom-up, in bands of rows, in parallel
+    Carta::Core::Algorithms::RasterRender::view2qImage( rawView, pipe, qImage, nanColor, nThreads );
 } // rawView2QImage
 
 namespace Carta
@@ -202,6 +171,32 @@ Service::pixelPipelineCacheSettings() const
     return m_pixelPipelineCacheSettings;
 }
 
+void
+Service::setMipmapSettings( const MipmapSettings & params )
+{
+    m_mipmapSettings = params;
+}
+
+const Service::MipmapSettings &
+Service::mipmapSettings() const
+{
+    return m_mipmapSettings;
+}
+
+void
+Service::setTileSettings( const TileSettings & params )
+{
+    m_tileSettings = params;
+    m_tileSettings.size = std::max( 16, m_tileSettings.size );
+    m_tileSettings.margin = std::max( 0, m_tileSettings.margin );
+}
+
+const Service::TileSettings &
+Service::tileSettings() const
+{
+    return m_tileSettings;
+}
+
 JobId
 Service::render( JobId jobId )
 {
@@ -232,10 +227,74 @@ Service::Service( QObject * parent ) : Carta::Lib::IImageRenderService( parent )
     connect( & m_renderTimer, & QTimer::timeout, this, & Me::internalRenderSlot );
 
     m_frameCache.setMaxCost( 1 * 1024 * 1024 * 1024 ); // 1 gig
+    m_mipmapCache.setMaxCost( 512 * 1024 * 1024 ); // half a gig
+    m_frameDataCache.setMaxCost( 512 * 1024 * 1024 ); // half a gig
+    m_tileCache.setMaxCost( 256 * 1024 * 1024 ); // quarter of a gig
 }
 
 Service::~Service()
-{ }
+{
+    setMemoryBudget( nullptr );
+}
+
+void
+Service::setMemoryBudget( Carta::Lib::MemoryBudget::SharedPtr budget )
+{
+    typedef Carta::Lib::MemoryBudget MemoryBudget;
+    if ( m_memoryBudget ) {
+        for ( MemoryBudget::Handle handle : { m_frameCacheHandle, m_frameDataCacheHandle,
+                                              m_mipmapCacheHandle, m_tileCacheHandle,
+                                              m_pipelineHandle } ) {
+            m_memoryBudget-> remove( handle );
+        }
+    }
+    m_memoryBudget = budget;
+    if ( ! m_memoryBudget ) {
+        return;
+    }
+
+    // names tell the instances apart in usage reports
+    static int instanceCounter = 0;
+    const QString name = QString( "render service %1: %2" ).arg( instanceCounter++ );
+
+    // rendered frames and tiles are cheap to redo from the frame data and mipmaps
+    m_frameCacheHandle = m_memoryBudget-> add(
+        name.arg( "frames" ), MemoryBudget::Priority::Low,
+        MemoryBudget::qCacheUsage( m_frameCache ), MemoryBudget::qCacheShrink( m_frameCache ) );
+    m_tileCacheHandle = m_memoryBudget-> add(
+        name.arg( "tiles" ), MemoryBudget::Priority::Low,
+        MemoryBudget::qCacheUsage( m_tileCache ), MemoryBudget::qCacheShrink( m_tileCache ) );
+    m_frameDataCacheHandle = m_memoryBudget-> add(
+        name.arg( "frame data" ), MemoryBudget::Priority::Normal,
+        MemoryBudget::qCacheUsage( m_frameDataCache ), MemoryBudget::qCacheShrink( m_frameDataCache ) );
+    m_mipmapCacheHandle = m_memoryBudget-> add(
+        name.arg( "mipmaps" ), MemoryBudget::Priority::Normal,
+        MemoryBudget::qCacheUsage( m_mipmapCache ), MemoryBudget::qCacheShrink( m_mipmapCache ) );
+
+    // the cached pipelines are in use, they can only be accounted for
+    m_pipelineHandle = m_memoryBudget-> add(
+        name.arg( "pixel pipelines" ), MemoryBudget::Priority::High,
+        [this] () {
+            const uint64_t entryBytes = sizeof( Lib::PixelPipeline::NormRgb ) + sizeof( QRgb );
+            uint64_t bytes = 0;
+            if ( m_cachedPP ) {
+                bytes += m_cachedPP-> size() * entryBytes;
+            }
+            if ( m_cachedPPinterp ) {
+                bytes += m_cachedPPinterp-> size() * entryBytes;
+            }
+            return bytes;
+        } );
+    m_memoryBudget-> enforce();
+} // setMemoryBudget
+
+void
+Service::budgetTouch( Carta::Lib::MemoryBudget::Handle handle )
+{
+    if ( m_memoryBudget ) {
+        m_memoryBudget-> touch( handle );
+    }
+}
 
 QPointF
 Service::img2screen( const QPointF & p )
@@ -284,11 +343,286 @@ Service::screen2image( const QPointF & p, const QPointF& pan, double zoom,
     return res;
 }
 
+NdArray::RawViewInterface *
+Service::mipmapView( int level )
+{
+    QString key = QString( "%1/%2" )
+                      .arg( m_inputViewCacheId )
+                      .arg( Algorithms::MipmapPyramid::method2str( m_mipmapSettings.method ) );
+
+    // take the pyramid out of the cache (if it's there), so that we can re-insert it
+    // with the updated cost in case more levels get built
+    std::unique_ptr < Algorithms::MipmapPyramid > pyramid(
+        m_inputViewCacheId.isEmpty() ? nullptr : m_mipmapCache.take( key ) );
+    if ( ! pyramid ) {
+        pyramid.reset( new Algorithms::MipmapPyramid( m_mipmapSettings.method ) );
+    }
+
+    // the view shares the level data, so it remains valid even if the cache decides
+    // to delete the pyramid
+    NdArray::RawViewInterface * view = pyramid-> levelView( level, m_inputView.get() );
+
+    if ( ! m_inputViewCacheId.isEmpty() ) {
+        int cost = pyramid-> byteCount();
+        m_mipmapCache.insert( key, pyramid.release(), cost );
+        budgetTouch( m_mipmapCacheHandle );
+    }
+    return view;
+}
+
+bool
+Service::FrameRenderer::isThreadSafe() const
+{
+    return cachedPPinterp || cachedPP;
+}
+
+QString
+Service::FrameRenderer::cacheKey( const QString & viewCacheId ) const
+{
+    return viewCacheId + cacheKeySuffix;
+}
+
+QImage
+Service::FrameRenderer::render( NdArray::RawViewInterface * view, int nThreads ) const
+{
+    QImage frame;
+    if ( ! isThreadSafe() ) {
+        return frame;
+    }
+    std::unique_ptr < NdArray::RawViewInterface > levelView;
+    if ( mipLevel > 0 ) {
+        // the level view shares the level data, so the pyramid does not have to outlive it
+        Algorithms::MipmapPyramid pyramid( mipmapMethod );
+        levelView.reset( pyramid.levelView( mipLevel, view ) );
+        view = levelView.get();
+    }
+    if ( cachedPPinterp ) {
+        ::iView2qImage( view, * cachedPPinterp, frame, nanColor, nThreads );
+    }
+    else {
+        ::iView2qImage( view, * cachedPP, frame, nanColor, nThreads );
+    }
+    return frame;
+}
+
+int
+Service::mipmapLevel() const
+{
+    // when zoomed out, render from the coarsest mipmap level that still fills the screen
+    int mipLevel = 0;
+    if ( m_mipmapSettings.enabled && m_inputView ) {
+        int maxLevel = Algorithms::MipmapPyramid::maxLevel(
+            m_inputView-> dims()[0], m_inputView-> dims()[1] );
+        mipLevel = Algorithms::MipmapPyramid::levelForZoom( m_zoom, maxLevel );
+    }
+    return mipLevel;
+}
+
 void
-Service::internalRenderSlot()
+Service::updateCachedPipeline( double clipMin, double clipMax )
 {
-    //static int renderCount = 0;
-    //qDebug() << "Image render" << renderCount++ << "xyz";
+    budgetTouch( m_pipelineHandle );
+    if ( pixelPipelineCacheSettings().interpolated ) {
+        if ( ! m_cachedPPinterp ) {
+            m_cachedPPinterp.reset( new Lib::PixelPipeline::CachedPipeline < true > () );
+            m_cachedPPinterp-> cache( * m_pixelPipelineRaw,
+                    pixelPipelineCacheSettings().size, clipMin, clipMax );
+        }
+    }
+    else {
+        if ( ! m_cachedPP ) {
+            m_cachedPP.reset( new Lib::PixelPipeline::CachedPipeline < false > () );
+            m_cachedPP-> cache( * m_pixelPipelineRaw,
+                    pixelPipelineCacheSettings().size, clipMin, clipMax );
+        }
+    }
+}
+
+void
+Service::colormapView( const FrameRenderer & renderer, NdArray::RawViewInterface * view,
+                       QImage & image )
+{
+    if ( renderer.cachedPPinterp ) {
+        ::iView2qImage( view, * renderer.cachedPPinterp, image, renderer.nanColor, 0 );
+    }
+    else if ( renderer.cachedPP ) {
+        ::iView2qImage( view, * renderer.cachedPP, image, renderer.nanColor, 0 );
+    }
+    else {
+        // the raw pipeline is not guaranteed to be thread safe
+        ::iView2qImage( view, * m_pixelPipelineRaw, image, renderer.nanColor, 1 );
+    }
+}
+
+bool
+Service::visibleTiles( QRect & tiles ) const
+{
+    tiles = QRect();
+    if ( ! m_tileSettings.enabled || ! m_inputView ||
+         m_outputSize.width() <= 0 || m_outputSize.height() <= 0 ) {
+        return false;
+    }
+    const int64_t width = m_inputView-> dims()[0];
+    const int64_t height = m_inputView-> dims()[1];
+    const int size = m_tileSettings.size;
+
+    QPointF p1 = screen2image( QPointF( 0, 0 ), m_pan, m_zoom, m_outputSize );
+    QPointF p2 = screen2image( QPointF( m_outputSize.width(), m_outputSize.height() ),
+                               m_pan, m_zoom, m_outputSize );
+    tiles = Algorithms::TileGrid::tilesCovering( QRectF( p1, p2 ), width, height, size,
+                                                 m_tileSettings.margin );
+    if ( tiles.isEmpty() ) {
+        // nothing is visible, so there is nothing to render
+        return true;
+    }
+
+    // only worth it if the tiles cover well under the whole frame
+    QRect covered = Algorithms::TileGrid::tilesRect( tiles, width, height, size );
+    return int64_t( covered.width() ) * covered.height() * 2 <= width * height;
+} // visibleTiles
+
+QImage
+Service::tile( const FrameRenderer & renderer, int tileX, int tileY )
+{
+    const int size = m_tileSettings.size;
+    QString key = QString( "%1/T%2/%3/%4" )
+                      .arg( renderer.cacheKey( m_inputViewCacheId ) )
+                      .arg( size ).arg( tileX ).arg( tileY );
+    if ( ! m_inputViewCacheId.isEmpty() ) {
+        QImage * cached = m_tileCache.object( key );
+        budgetTouch( m_tileCacheHandle );
+        if ( cached ) {
+            return * cached;
+        }
+    }
+
+    const QRect rect = Algorithms::TileGrid::tileRect( tileX, tileY, m_inputView-> dims()[0],
+                                                       m_inputView-> dims()[1], size );
+
+    // cut the tile out of the frame data if the whole frame was colormapped before,
+    // otherwise read it from the input view
+    QImage image;
+    const QString frameKey = frameDataKey( renderer );
+    FrameData * frameData = frameKey.isEmpty() ? nullptr : m_frameDataCache.object( frameKey );
+    if ( frameData ) {
+        budgetTouch( m_frameDataCacheHandle );
+    }
+    if ( frameData && renderer.cachedPP ) {
+        std::vector < uint16_t > indices;
+        Algorithms::TileGrid::cropIndices( frameData-> indices, m_inputView-> dims()[0], rect, indices );
+        allocateFrameImage( image, rect.size() );
+        Algorithms::RasterRender::indices2qImage( indices, * renderer.cachedPP, image,
+                                                  renderer.nanColor );
+    }
+    else {
+        SliceND slice;
+        slice.start( rect.left() ).end( rect.right() + 1 )
+            .next().start( rect.top() ).end( rect.bottom() + 1 );
+        NdArray::RawViewInterface * source = frameData ? frameData-> values.get() : m_inputView.get();
+        std::unique_ptr < NdArray::RawViewInterface > tileView( source-> getView( slice ) );
+        colormapView( renderer, tileView.get(), image );
+    }
+    if ( ! m_inputViewCacheId.isEmpty() && image.byteCount() > 0 ) {
+        m_tileCache.insert( key, new QImage( image ), image.byteCount() );
+    }
+    return image;
+} // tile
+
+int64_t
+Service::FrameData::byteCount() const
+{
+    return indices.size() * sizeof( uint16_t ) + ( values ? values-> byteCount() : 0 );
+}
+
+QString
+Service::frameDataKey( const FrameRenderer & renderer ) const
+{
+    NdArray::RawViewInterface * view = m_inputView.get();
+    if ( ! view || m_inputViewCacheId.isEmpty() || renderer.mipLevel > 0 ) {
+        return QString();
+    }
+
+    if ( renderer.cachedPP ) {
+        // the indices do not depend on the colormap, only on the clips and the cache size
+        const Lib::PixelPipeline::CachedPipeline < false > & pipe = * renderer.cachedPP;
+        if ( pipe.size() >= Lib::PixelPipeline::CachedPipeline < false >::NanIndex ) {
+            return QString();
+        }
+        return QString( "%1/I/%2/%3/%4" )
+                   .arg( m_inputViewCacheId )
+                   .arg( pipe.size() )
+                   .arg( Carta::Lib::double2base64( pipe.min() ) )
+                   .arg( Carta::Lib::double2base64( pipe.max() ) );
+    }
+
+    // a copy of the pixels is only exact for floats, and only helps if the input view
+    // is not in memory already
+    if ( view-> pixelType() != Carta::Lib::Image::PixelType::Real32 ||
+         dynamic_cast < Algorithms::FloatFrameView * > ( view ) ) {
+        return QString();
+    }
+    return m_inputViewCacheId + "/F";
+} // frameDataKey
+
+bool
+Service::colormapFromFrameData( const FrameRenderer & renderer, QImage & image )
+{
+    NdArray::RawViewInterface * view = m_inputView.get();
+    const QString key = frameDataKey( renderer );
+    if ( key.isEmpty() ) {
+        return false;
+    }
+
+    std::unique_ptr < FrameData > created;
+    FrameData * frameData = m_frameDataCache.object( key );
+    budgetTouch( m_frameDataCacheHandle );
+    if ( ! frameData ) {
+        created.reset( new FrameData() );
+        frameData = created.get();
+        if ( renderer.cachedPP ) {
+            Algorithms::RasterRender::view2indices( view, * renderer.cachedPP, frameData-> indices );
+        }
+        else {
+            int64_t nPixels = 1;
+            for ( int dim : view-> dims() ) {
+                nPixels *= dim;
+            }
+            auto pixels = std::make_shared < std::vector < float > > ( nPixels );
+            int64_t counter = 0;
+            view-> forEach( Algorithms::RasterRender::BandPixels * sizeof( float ),
+                            [&] ( const char * data, int64_t count ) {
+                count = std::min( count, nPixels - counter );
+                std::memcpy( pixels-> data() + counter, data, count * sizeof( float ) );
+                counter += count;
+            });
+            CARTA_ASSERT( counter == nPixels );
+            frameData-> values = std::make_shared < Algorithms::FloatFrameView > ( pixels, view-> dims() );
+        }
+    }
+
+    if ( renderer.cachedPP ) {
+        allocateFrameImage( image, QSize( view-> dims()[0], view-> dims()[1] ) );
+        Algorithms::RasterRender::indices2qImage( frameData-> indices, * renderer.cachedPP,
+                                                  image, renderer.nanColor );
+    }
+    else {
+        colormapView( renderer, frameData-> values.get(), image );
+    }
+
+    if ( created ) {
+        int cost = std::min < int64_t > ( created-> byteCount(), std::numeric_limits < int >::max() );
+        m_frameDataCache.insert( key, created.release(), cost );
+    }
+    return true;
+} // colormapFromFrameData
+
+Service::FrameRenderer
+Service::frameRenderer()
+{
+    FrameRenderer renderer;
+    if ( ! m_pixelPipelineRaw ) {
+        return renderer;
+    }
 
     double clipMin, clipMax;
     m_pixelPipelineRaw-> getClips( clipMin, clipMax );
@@ -307,32 +641,72 @@ Service::internalRenderSlot()
             m_pixelPipelineRaw->convertq( clipMin, nanColor );
         }
     }
+    renderer.nanColor = nanColor;
 
     // cache id will be concatenation of:
     // view id
     // pipeline id
     // nan
     // pixel pipeline cache settings
-    QString cacheId = QString( "%1/%2//%8" )
-                          .arg( m_inputViewCacheId )
-                          .arg( m_pixelPipelineCacheId )
-                          .arg( QString::number(nanColor) );
-
+    // mipmap level
+    renderer.cacheKeySuffix = QString( "/%1//%2" )
+                                  .arg( m_pixelPipelineCacheId )
+                                  .arg( QString::number(nanColor) );
 
     // disable pixelPipelineCache in case [clipMin, clipMax] = nan
     if ( m_pixelPipelineCacheSettings.enabled && !std::isnan(clipMin) && !std::isnan(clipMax)){
-        cacheId += QString( "/1/%1/%2" )
-                       .arg( int (m_pixelPipelineCacheSettings.interpolated) )
-                       .arg( m_pixelPipelineCacheSettings.size );
+        renderer.cacheKeySuffix += QString( "/1/%1/%2" )
+                                       .arg( int (m_pixelPipelineCacheSettings.interpolated) )
+                                       .arg( m_pixelPipelineCacheSettings.size );
+        updateCachedPipeline( clipMin, clipMax );
+        if ( m_pixelPipelineCacheSettings.interpolated ) {
+            renderer.cachedPPinterp = m_cachedPPinterp;
+        }
+        else {
+            renderer.cachedPP = m_cachedPP;
+        }
     }
     else {
-        cacheId += "/0";
+        renderer.cacheKeySuffix += "/0";
+    }
+
+    renderer.mipLevel = mipmapLevel();
+    renderer.mipmapMethod = m_mipmapSettings.method;
+    if ( renderer.mipLevel > 0 ) {
+        renderer.cacheKeySuffix += QString( "/L%1%2" )
+                                       .arg( renderer.mipLevel )
+                                       .arg( Algorithms::MipmapPyramid::method2str( m_mipmapSettings.method ) );
     }
+    return renderer;
+}
+
+bool
+Service::isFrameCached( const QString & key ) const
+{
+    return m_frameCache.contains( key );
+}
+
+void
+Service::insertFrame( const QString & key, const QImage & frame )
+{
+    if ( frame.byteCount() > 0 ) {
+        m_frameCache.insert( key, new QImage( frame ), frame.byteCount() );
+        budgetTouch( m_frameCacheHandle );
+        if ( m_memoryBudget ) {
+            m_memoryBudget-> enforce();
+        }
+    }
+}
+
+void
+Service::internalRenderSlot()
+{
+    //static int renderCount = 0;
+    //qDebug() << "Image render" << renderCount++ << "xyz";
 
 //    qDebug() << "internalRenderSlot... cache size: "
 //             << m_frameCache.totalCost() * 100.0 / m_frameCache.maxCost() << "% "
 //             << m_frameCache.size() << "entries";
-//    qDebug() << "id:" << cacheId;
     struct Scope {
         ~Scope() { /*qDebug() << "internalRenderSlot done";*/ } }
     debugScopeGuard;
@@ -348,38 +722,40 @@ Service::internalRenderSlot()
         return;
     }
 
+    const FrameRenderer renderer = frameRenderer();
+    const QString cacheId = renderer.cacheKey( m_inputViewCacheId );
+    const int mipLevel = renderer.mipLevel;
+//    qDebug() << "id:" << cacheId;
+
     // seems it is copying, so no need to copy again for more safe usage
     auto cachedRawImage = m_frameCache.object(cacheId);
+    budgetTouch( m_frameCacheHandle );
+
+    // zoomed in views that show a small part of the frame only render the visible tiles,
+    // unless the whole frame is already rendered
+    QRect tiles;
+    const bool tiled = ! cachedRawImage && mipLevel == 0 && visibleTiles( tiles );
 
     // start the timer
     QElapsedTimer timer;
     timer.start();
 
     // render the frame if needed
-    if (!cachedRawImage) {
-        // cacheRaw miss
-
-        // disable pixelPipelineCache in case [clipMin, clipMax] = nan
-        if ( pixelPipelineCacheSettings().enabled && !std::isnan(clipMin) && !std::isnan(clipMax) ) {
-            if ( pixelPipelineCacheSettings().interpolated ) {
-                if ( ! m_cachedPPinterp ) {
-                    m_cachedPPinterp.reset( new Lib::PixelPipeline::CachedPipeline < true > () );
-                    m_cachedPPinterp-> cache( * m_pixelPipelineRaw,
-                            pixelPipelineCacheSettings().size, clipMin, clipMax );
-                }
-                ::iView2qImage( m_inputView.get(), * m_cachedPPinterp, m_frameImage, nanColor );
-            }
-            else {
-                if ( ! m_cachedPP ) {
-                    m_cachedPP.reset( new Lib::PixelPipeline::CachedPipeline < false > () );
-                    m_cachedPP-> cache( * m_pixelPipelineRaw,
-                            pixelPipelineCacheSettings().size, clipMin, clipMax );
-                }
-                ::iView2qImage( m_inputView.get(), * m_cachedPP, m_frameImage, nanColor );
+    if ( tiled ) {
+        // tiles are rendered as they are drawn below
+    }
+    else if (!cachedRawImage) {
+        // cacheRaw miss, colormap the frame data if possible
+        if ( ! colormapFromFrameData( renderer, m_frameImage ) ) {
+            // figure out which view to render, the full frame or one of the mipmap levels
+            NdArray::RawViewInterface * renderView = m_inputView.get();
+            std::unique_ptr < NdArray::RawViewInterface > levelView;
+            if ( mipLevel > 0 ) {
+                levelView.reset( mipmapView( mipLevel ) );
+                renderView = levelView.get();
             }
-        }
-        else {
-            ::iView2qImage( m_inputView.get(), * m_pixelPipelineRaw, m_frameImage, nanColor );
+
+            colormapView( renderer, renderView, m_frameImage );
         }
     }
     else
@@ -388,12 +764,30 @@ Service::internalRenderSlot()
         m_frameImage = *cachedRawImage;
     }
 
+    // prepare output
+    QImage img( m_outputSize, OptimalQImageFormat );
+    if ( tiled && m_outputSize.width() > 0 && m_outputSize.height() > 0 ) {
+        img.fill( QColor( 50, 50, 50 ) );
+        QPainter p( & img );
+        p.setRenderHint( QPainter::SmoothPixmapTransform, false );
+
+        // tile (tx,ty) covers pixels [tx*size, (tx+1)*size) x [ty*size, (ty+1)*size), and
+        // like the frame image it is stored bottom-up
+        const int size = m_tileSettings.size;
+        for ( int ty = tiles.top() ; ty <= tiles.bottom() ; ty++ ) {
+            for ( int tx = tiles.left() ; tx <= tiles.right() ; tx++ ) {
+                QImage tileImage = tile( renderer, tx, ty );
+                QPointF p1 = img2screen( QPointF( tx * size - 0.5, ty * size + tileImage.height() - 0.5 ) );
+                QPointF p2 = img2screen( QPointF( tx * size + tileImage.width() - 0.5, ty * size - 0.5 ) );
+                p.drawImage( QRectF( p1, p2 ), tileImage );
+            }
+        }
+    }
+
     // end the timer
     qDebug() << "Time for applying the colormap on the current view of image:" << timer.elapsed() << "ms";
 
-    // prepare output
-    QImage img( m_outputSize, OptimalQImageFormat );
-    if ( m_outputSize.width() > 0 && m_outputSize.height() > 0 ){
+    if ( ! tiled && m_outputSize.width() > 0 && m_outputSize.height() > 0 ){
 
         //    img.fill( QColor( "blue" ) );
         img.fill( QColor( 50, 50, 50 ) );
@@ -403,9 +797,12 @@ Service::internalRenderSlot()
         //    QPointF p1 = img2screen( QPointF( -0.5, -0.5 ) );
         //    QPointF p2 = img2screen( QPointF( m_frameImage.width()-0.5, m_frameImage.height()-0.5));
 
-        int imageHeight = m_frameImage.height();
+        // m_frameImage can be a mipmap level, which is stretched over the full
+        // frame; scaling the level size up would overshoot for odd sized frames
+        int imageWidth = m_inputView-> dims()[0];
+        int imageHeight = m_inputView-> dims()[1];
         QPointF p1 = img2screen( QPointF( - 0.5, imageHeight - 0.5 ) );
-        QPointF p2 = img2screen( QPointF( m_frameImage.width() - 0.5, - 0.5 ) );
+        QPointF p2 = img2screen( QPointF( imageWidth - 0.5, - 0.5 ) );
 
         QRectF rectf( p1, p2 );
         p.setRenderHint( QPainter::SmoothPixmapTransform, false );
@@ -451,10 +848,11 @@ Service::internalRenderSlot()
         }
     }
 
-    if (!cachedRawImage) {
+    if (!cachedRawImage && !tiled) {
         // insert this image into frame cache, they may be alterd by emit done, so change to insert first.
         if (m_frameImage.byteCount() >0 && img.byteCount()>0) {
-            m_frameCache.insert( cacheId, new QImage( m_frameImage ), img.byteCount() );
+            // the cost is the size of the cached frame, not of the output image
+            m_frameCache.insert( cacheId, new QImage( m_frameImage ), m_frameImage.byteCount() );
         } else {
             qDebug() << "m_frameCache is empty, will not be inserted";
         }
@@ -463,6 +861,12 @@ Service::internalRenderSlot()
     // report result
     emit done( img, m_lastSubmittedJobId );
 
+    // whatever this render added to the caches may have pushed the process over its
+    // memory budget; this is the first point where no cached object is referenced
+    if ( m_memoryBudget ) {
+        m_memoryBudget-> enforce();
+    }
+
 } // internalRenderSlot
 
 }
@@ -15,7 +15,13 @@
  * caching considerations (internal notes)
  *   eg. when zooming/panning there is no need to re-apply colormap
  *   or when switching between frames, maybe we can cache some frames to make this faster
- *   or when looking at really large 2d data, we could use mipmaps (future optimization)
+ *   or when looking at really large 2d data, we could use mipmaps
+ *   - zoomed out images (zoom < 1) are rendered from a lazily built pyramid of downsampled
+ *     frames (see Algorithms::MipmapPyramid), so the cost scales with the screen size
+ *   - zoomed in images only colormap the tiles covering the screen (plus a margin), and
+ *     the tiles are cached, so panning reuses the neighbouring ones
+ *   - below the frame cache there is a cache of colormap independent frame data (pipeline
+ *     cache indices or float pixels), so colormap changes do not read the view again
  *
  * asynchronous result reporting
  *   the render service might possibly live in a separate thread
@@ -33,6 +39,9 @@
 #include "CartaLib/PixelPipeline/IPixelPipeline.h"
 #include "CartaLib/Nullable.h"
 #include "CartaLib/IImageRenderService.h"
+#include "CartaLib/MemoryBudget.h"
+#include "core/Algorithms/mipmapPyramid.h"
+#include "core/Algorithms/floatFrameView.h"
 #include <QImage>
 #include <QObject>
 #include <QColor>
@@ -73,6 +82,64 @@ public:
 
     typedef Carta::Lib::IImageRenderService::PixelPipelineCacheSettings PixelPipelineCacheSettings;
 
+    /// settings that control rendering of zoomed out images from downsampled frames
+    struct MipmapSettings {
+        /// whether mipmaps are used for zoom < 1
+        bool enabled = true;
+        /// how pixels are combined when downsampling
+        Algorithms::MipmapPyramid::Method method = Algorithms::MipmapPyramid::Method::Mean;
+    };
+
+    /// settings that control rendering of zoomed in images one tile at a time
+    struct TileSettings {
+        /// whether only the visible tiles are rendered when that is cheaper than
+        /// rendering the whole frame
+        bool enabled = true;
+        /// width and height of a tile, in image pixels
+        int size = 256;
+        /// number of tiles rendered around the visible ones, so that pans can reuse them
+        int margin = 1;
+    };
+
+    /// \brief the settings needed to colormap a frame, captured at one point in time
+    ///
+    /// This allows frames other than the input view (e.g. the frames an animation is
+    /// about to show) to be rendered away from the service, possibly in another thread,
+    /// and then added to the frame cache with insertFrame().
+    struct FrameRenderer {
+        /// appended to the view cache id to make the key of the frame cache
+        QString cacheKeySuffix;
+
+        /// color of NaN pixels
+        QRgb nanColor = 0;
+
+        /// the mipmap level frames are rendered at, 0 means full resolution
+        int mipLevel = 0;
+
+        /// how pixels are combined when downsampling to mipLevel
+        Algorithms::MipmapPyramid::Method mipmapMethod = Algorithms::MipmapPyramid::Method::Mean;
+
+        /// the cached (and therefore thread safe) pixel pipelines, at most one is set
+        Lib::PixelPipeline::CachedPipeline < true >::SharedPtr cachedPPinterp = nullptr;
+        Lib::PixelPipeline::CachedPipeline < false >::SharedPtr cachedPP = nullptr;
+
+        /// can render() be called from another thread? This is false when the pixel
+        /// pipeline is not cached.
+        bool
+        isThreadSafe() const;
+
+        /// key of the frame cache for the view with the given cache id
+        QString
+        cacheKey( const QString & viewCacheId ) const;
+
+        /// \brief colormap a full resolution frame, downsampling it to mipLevel first
+        /// \param view the frame
+        /// \param nThreads number of threads to use for colormapping (<= 0 means all)
+        /// \return the rendered frame, or a null image if isThreadSafe() is false
+        QImage
+        render( Carta::Lib::NdArray::RawViewInterface * view, int nThreads ) const;
+    };
+
     /// constructor
     explicit
     Service( QObject * parent = 0 );
@@ -162,6 +229,41 @@ public:
     virtual const PixelPipelineCacheSettings &
     pixelPipelineCacheSettings() const override;
 
+    /// set settings that control the use of mipmaps
+    void
+    setMipmapSettings( const MipmapSettings & params );
+
+    /// get the current mipmap settings
+    const MipmapSettings &
+    mipmapSettings() const;
+
+    /// set settings that control tiled rendering
+    void
+    setTileSettings( const TileSettings & params );
+
+    /// get the current tile settings
+    const TileSettings &
+    tileSettings() const;
+
+    /// \brief register the caches of this service with a memory budget
+    /// \param budget the process-wide budget, nullptr if only the limits of the
+    /// individual caches apply
+    void
+    setMemoryBudget( Carta::Lib::MemoryBudget::SharedPtr budget );
+
+    /// \brief capture the current rendering settings, for frames of the same size as the
+    /// input view
+    FrameRenderer
+    frameRenderer();
+
+    /// is a frame with the given key (see FrameRenderer::cacheKey()) in the frame cache?
+    bool
+    isFrameCached( const QString & key ) const;
+
+    /// add a frame rendered by a FrameRenderer to the frame cache
+    void
+    insertFrame( const QString & key, const QImage & frame );
+
     /// convert image coordinates to screen coordinates
     /// \param p coordinates to convert
     /// \return converted coordinates
@@ -226,6 +328,67 @@ protected slots:
 
 private:
 
+    /// return a view of the given mipmap level of the input view, building the level
+    /// (and caching the pyramid) if needed, caller assumes ownership
+    Carta::Lib::NdArray::RawViewInterface *
+    mipmapView( int level );
+
+    /// the mipmap level to render the input view at, for the current zoom
+    int
+    mipmapLevel() const;
+
+    /// tell the memory budget (if any) that one of the caches of this service was used
+    void
+    budgetTouch( Carta::Lib::MemoryBudget::Handle handle );
+
+    /// make sure the cached pixel pipeline for the current settings is built
+    void
+    updateCachedPipeline( double clipMin, double clipMax );
+
+    /// colormap a full resolution view with the renderer's pipeline, or with the raw
+    /// pipeline if the renderer has none
+    void
+    colormapView( const FrameRenderer & renderer, Carta::Lib::NdArray::RawViewInterface * view,
+                  QImage & image );
+
+    /// \brief find the tiles to render for the current pan/zoom/output size
+    /// \param tiles set to the range of tiles (in tile units) covering the visible part of
+    /// the input view plus the margin, empty if none of the view is visible
+    /// \return whether rendering the tiles is cheaper than rendering the whole frame
+    bool
+    visibleTiles( QRect & tiles ) const;
+
+    /// return a tile of the input view, rendering (and caching) it if needed; the tile
+    /// is cut out of the cached frame data when there is any
+    QImage
+    tile( const FrameRenderer & renderer, int tileX, int tileY );
+
+    /// return the key of the frame data of the input view for the renderer in
+    /// m_frameDataCache, or an empty string if the frame data cache does not apply
+    QString
+    frameDataKey( const FrameRenderer & renderer ) const;
+
+    /// \brief colormap the full resolution input view from its cached frame data,
+    /// creating the frame data if needed
+    /// \return false if the frame data cache does not apply to the input view or the
+    /// renderer, in which case the image is untouched
+    bool
+    colormapFromFrameData( const FrameRenderer & renderer, QImage & image );
+
+    /// colormap independent data of a full resolution frame, see m_frameDataCache
+    struct FrameData {
+        /// indices of the pixels into the cache of a non-interpolated pipeline, see
+        /// RasterRender::view2indices()
+        std::vector < uint16_t > indices;
+
+        /// or a copy of the pixels, for input views with float pixels
+        Algorithms::FloatFrameView::SharedPtr values = nullptr;
+
+        /// memory used, in bytes
+        int64_t
+        byteCount() const;
+    };
+
     // the following are rendering parameters
     Carta::Lib::NdArray::RawViewInterface::SharedPtr m_inputView = nullptr;
     QString m_inputViewCacheId;
@@ -242,8 +405,9 @@ private:
     QPointF m_pan = QPointF( 0, 0 );
 
     // cached pipelines
-    Lib::PixelPipeline::CachedPipeline < true >::UniquePtr m_cachedPPinterp = nullptr;
-    Lib::PixelPipeline::CachedPipeline < false >::UniquePtr m_cachedPP = nullptr;
+    // (shared with the frame renderers handed out by frameRenderer())
+    Lib::PixelPipeline::CachedPipeline < true >::SharedPtr m_cachedPPinterp = nullptr;
+    Lib::PixelPipeline::CachedPipeline < false >::SharedPtr m_cachedPP = nullptr;
     PixelPipelineCacheSettings m_pixelPipelineCacheSettings;
 
     /// here we store the whole frame rendered, it is essentially a cache to make
@@ -253,6 +417,32 @@ private:
     /// cache for individual frames (to make movie playing little bit faster)
     QCache < QString, QImage > m_frameCache;
 
+    /// cache for the colormap independent data of frames; index images are keyed by view
+    /// cache id and pipeline cache geometry (size and clips), float pixels by view cache id
+    QCache < QString, FrameData > m_frameDataCache;
+
+    /// mipmap settings
+    MipmapSettings m_mipmapSettings;
+
+    /// cache for mipmap pyramids of the input views, keyed by view cache id and method
+    QCache < QString, Algorithms::MipmapPyramid > m_mipmapCache;
+
+    /// tile settings
+    TileSettings m_tileSettings;
+
+    /// cache for rendered tiles, keyed by frame cache key, tile size and tile position
+    QCache < QString, QImage > m_tileCache;
+
+    /// the budget the caches above are registered with, see setMemoryBudget()
+    Carta::Lib::MemoryBudget::SharedPtr m_memoryBudget = nullptr;
+
+    /// handles of the caches in m_memoryBudget, the cached pipelines are only accounted for
+    Carta::Lib::MemoryBudget::Handle m_frameCacheHandle = - 1;
+    Carta::Lib::MemoryBudget::Handle m_frameDataCacheHandle = - 1;
+    Carta::Lib::MemoryBudget::Handle m_mipmapCacheHandle = - 1;
+    Carta::Lib::MemoryBudget::Handle m_tileCacheHandle = - 1;
+    Carta::Lib::MemoryBudget::Handle m_pipelineHandle = - 1;
+
     /// last requested job id
     JobId m_lastSubmittedJobId = - 1;
 
@@ -108,6 +108,18 @@ ParsedInfo parse(const QString & filePath)
     _storeBool( json["developerLayout"], &info.m_developerLayout, "developer layout");
     _storePositiveInt( json["histogramBinCountMax"], &info.m_histogramBinCountMax, "histogram bin count max");
     _storePositiveInt( json["contourLevelCountMax"], &info.m_contourLevelCountMax, "contour level count max");
+    _storePositiveInt( json["memoryCacheMB"], &info.m_memoryCacheMB, "memory cache size");
+    _storePositiveInt( json["memoryCacheShards"], &info.m_memoryCacheShards, "memory cache shards");
+    _storePositiveInt( json["memoryCacheWriteBatch"], &info.m_memoryCacheWriteBatch, "memory cache write batch");
+    _storePositiveInt( json["memoryCacheNegativeSeconds"], &info.m_memoryCacheNegativeSeconds, "memory cache negative seconds");
+    _storePositiveInt( json["contourCacheMB"], &info.m_contourCacheMB, "contour cache size");
+    //Prefetching is off unless the configuration turns it on.
+    if ( !json["animationPrefetch"].isUndefined() ){
+        _storeBool( json["animationPrefetch"], &info.m_animationPrefetch, "animation prefetch");
+    }
+    _storePositiveInt( json["animationPrefetchFrames"], &info.m_animationPrefetchFrames, "animation prefetch frames");
+    _storePositiveInt( json["animationPrefetchMB"], &info.m_animationPrefetchMB, "animation prefetch size");
+    _storePositiveInt( json["memoryBudgetMB"], &info.m_memoryBudgetMB, "memory budget");
 
     return info;
 }
@@ -135,6 +147,42 @@ int ParsedInfo::getHistogramBinCountMax() const {
     return m_histogramBinCountMax;
 }
 
+int ParsedInfo::getMemoryCacheMB() const {
+    return m_memoryCacheMB;
+}
+
+int ParsedInfo::getMemoryCacheShards() const {
+    return m_memoryCacheShards;
+}
+
+int ParsedInfo::getMemoryCacheWriteBatch() const {
+    return m_memoryCacheWriteBatch;
+}
+
+int ParsedInfo::getMemoryCacheNegativeSeconds() const {
+    return m_memoryCacheNegativeSeconds;
+}
+
+int ParsedInfo::getContourCacheMB() const {
+    return m_contourCacheMB;
+}
+
+bool ParsedInfo::isAnimationPrefetch() const {
+    return m_animationPrefetch;
+}
+
+int ParsedInfo::getAnimationPrefetchFrames() const {
+    return m_animationPrefetchFrames;
+}
+
+int ParsedInfo::getAnimationPrefetchMB() const {
+    return m_animationPrefetchMB;
+}
+
+int ParsedInfo::getMemoryBudgetMB() const {
+    return m_memoryBudgetMB;
+}
+
 const QJsonObject &ParsedInfo::json() const
 {
     return m_json;
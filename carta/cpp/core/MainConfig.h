@@ -40,6 +40,63 @@ public:
      */
     int getContourLevelCountMax() const;
 
+    /**
+     * Returns the size of the in-memory cache that is kept in front of the
+     * persistent cache.
+     * @return the maximum size of the in-memory cache in megabytes.
+     */
+    int getMemoryCacheMB() const;
+
+    /**
+     * Returns the number of independently locked shards of the in-memory cache.
+     * @return the number of shards of the in-memory cache.
+     */
+    int getMemoryCacheShards() const;
+
+    /**
+     * Returns how many writes the in-memory cache collects before passing them
+     * on to the persistent cache.
+     * @return the number of writes that are passed on together.
+     */
+    int getMemoryCacheWriteBatch() const;
+
+    /**
+     * Returns how long the in-memory cache remembers that the persistent cache
+     * does not have an entry.
+     * @return the time the absence of an entry is remembered, in seconds.
+     */
+    int getMemoryCacheNegativeSeconds() const;
+
+    /**
+     * Returns the size of the cache of computed contours.
+     * @return the maximum size of the cached contours in megabytes.
+     */
+    int getContourCacheMB() const;
+
+    /**
+     * Returns whether the frames an animation is about to show are read ahead of time.
+     * @return true if upcoming animation frames are prefetched; false otherwise.
+     */
+    bool isAnimationPrefetch() const;
+
+    /**
+     * Returns how many upcoming frames an animation reads ahead of time, at most.
+     * @return the maximum number of frames read ahead of time.
+     */
+    int getAnimationPrefetchFrames() const;
+
+    /**
+     * Returns the memory the frames read ahead of time may use.
+     * @return the maximum size of the prefetched frames in megabytes.
+     */
+    int getAnimationPrefetchMB() const;
+
+    /**
+     * Returns the memory all the in-memory caches of the process may use together.
+     * @return the process-wide cache budget in megabytes.
+     */
+    int getMemoryBudgetMB() const;
+
     /// whether hacks are enabled or not
     bool hacksEnabled() const;
 
@@ -94,6 +151,15 @@ protected:
     bool m_developerLayout = false;
     int m_histogramBinCountMax = -1;
     int m_contourLevelCountMax = -1;
+    int m_memoryCacheMB = 64;
+    int m_memoryCacheShards = 16;
+    int m_memoryCacheWriteBatch = 64;
+    int m_memoryCacheNegativeSeconds = 10;
+    int m_contourCacheMB = 256;
+    bool m_animationPrefetch = false;
+    int m_animationPrefetchFrames = 8;
+    int m_animationPrefetchMB = 512;
+    int m_memoryBudgetMB = 2048;
 
     QJsonObject m_json;
 
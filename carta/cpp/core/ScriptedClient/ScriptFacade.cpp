@@ -13,8 +13,12 @@
 #include "Data/Preferences/PreferencesSave.h"
 #include "Data/Image/Grid/GridControls.h"
 #include "Data/Image/Contour/ContourControls.h"
+#include "Globals.h"
+#include "CartaLib/MemoryBudget.h"
 
 #include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <cmath>
 
 using Carta::State::ObjectManager;
@@ -158,6 +162,25 @@ QStringList ScriptFacade::getPluginList() const {
     return resultList;
 }
 
+QStringList ScriptFacade::getMemoryUsage() const {
+    QStringList resultList;
+    std::shared_ptr<Carta::Lib::MemoryBudget> budget = Globals::instance()->memoryBudget();
+    QJsonObject total;
+    total["maxBytes"] = double( budget->maxBytes() );
+    total["usedBytes"] = double( budget->usedBytes() );
+    resultList.append( QJsonDocument( total ).toJson( QJsonDocument::Compact ) );
+    for ( const Carta::Lib::MemoryBudget::Usage& usage : budget->usage() ) {
+        QJsonObject cache;
+        cache["name"] = usage.name;
+        cache["priority"] = Carta::Lib::MemoryBudget::priorityName( usage.priority );
+        cache["bytes"] = double( usage.bytes );
+        cache["evictable"] = usage.evictable;
+        cache["evictions"] = double( usage.evictions );
+        resultList.append( QJsonDocument( cache ).toJson( QJsonDocument::Compact ) );
+    }
+    return resultList;
+}
+
 QStringList ScriptFacade::loadFile( const QString& objectId, const QString& fileName){
     QStringList resultList;
     bool loadSuccess = false;
@@ -225,6 +225,14 @@ public:
      */
     QStringList getPluginList() const;
 
+    /**
+     * Returns the memory used by the in-memory caches of the server.
+     * @return a JSON object with the budget and the memory used by all caches together,
+     *      followed by a JSON object for each cache with its name, priority, size and
+     *      the number of times it was shrunk to stay within the budget.
+     */
+    QStringList getMemoryUsage() const;
+
     /**
      * Set the image channel to the specified value.
      * @param animatorId the unique server-side id of an object managing an animator.
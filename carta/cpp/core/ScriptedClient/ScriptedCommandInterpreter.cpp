@@ -102,6 +102,10 @@ ScriptedCommandInterpreter::tagMessageReceivedCB( TagMessage tm )
         result = m_scriptFacade->getPluginList();
     }
 
+    else if ( cmd == "getmemoryusage" ) {
+        result = m_scriptFacade->getMemoryUsage();
+    }
+
     else if ( cmd == "addlink" ) {
         QString source = args["sourceView"].toString();
         QString dest = args["destView"].toString();
@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "IPlatform.h"
 #include "State/ObjectManager.h"
+#include "Data/ComputeWorkerPool.h"
 #include "Data/ViewManager.h"
 #include "Data/Image/Controller.h"
 #include "PluginManager.h"
@@ -14,7 +15,6 @@
 #include "CmdLine.h"
 #include "ScriptedClient/Listener.h"
 #include "ScriptedClient/ScriptedCommandInterpreter.h"
-#include "CartaLib/Hooks/GetPersistentCache.h"
 
 #include <QImage>
 #include <QColor>
@@ -92,6 +92,10 @@ Viewer::start()
     // tell all plugins that the core has initialized
     globals.pluginManager()-> prepare < Carta::Lib::Hooks::Initialize > ().executeAll();
 
+    // fork the compute workers now, so that they inherit the loaded plugins and the
+    // first histogram or profile does not have to wait for them
+    Carta::Data::ComputeWorkerPool::instance()-> start();
+
 	// ask plugins to load the image
 	qDebug() << "======== trying to load image ========";
 	QString fname;
@@ -125,20 +129,9 @@ Viewer::start()
 }
 
 void Viewer::DBClose() {
-
-    std::shared_ptr<Carta::Lib::IPCache> m_diskCache;
-
-    // find the unique shared_ptr of cache and release it by force
-    auto res = Globals::instance()-> pluginManager()
-               -> prepare < Carta::Lib::Hooks::GetPersistentCache > ().first();
-    if ( res.isNull() || ! res.val() ) {
-        qWarning( "Could not find a disk cache plugin." );
-        m_diskCache = nullptr;
-    }
-    else {
-        m_diskCache = res.val();
-        m_diskCache->Release();
-    }
+    // write the pending entries of the in-memory cache and release the
+    // persistent cache by force
+    Globals::instance()-> releaseDiskCache();
 }
 
 void Viewer::setDeveloperView( ){
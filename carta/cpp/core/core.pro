@@ -27,6 +27,7 @@ HEADERS += \
     ImageView.h \
     Data/Animator/Animator.h \
     Data/Animator/AnimatorType.h \
+    Data/Animator/FrameSequence.h \
     Data/Clips.h \
     Data/Colormap/Colormap.h \
     Data/Colormap/Colormaps.h \
@@ -34,6 +35,7 @@ HEADERS += \
     Data/Colormap/Gamma.h \
     Data/Colormap/TransformsData.h \
     Data/Colormap/TransformsImage.h \
+    Data/ComputeWorkerPool.h \
     Data/DataLoader.h \
     Data/Error/ErrorReport.h \
     Data/Error/ErrorManager.h \
@@ -42,8 +44,6 @@ HEADERS += \
     Data/Histogram/ChannelUnits.h \
     Data/Histogram/PlotStyles.h \
     Data/Histogram/Render/HistogramRenderService.h \
-    Data/Histogram/Render/HistogramRenderThread.h \
-    Data/Histogram/Render/HistogramRenderWorker.h \
     Data/Histogram/Render/HistogramRenderRequest.h \
     Data/ILinkable.h \
     Data/Settings.h \
@@ -63,6 +63,7 @@ HEADERS += \
     Data/Image/Contour/GeneratorState.h \
     Data/Image/CoordinateSystems.h \
     Data/Image/DataSource.h \
+    Data/Image/FramePrefetcher.h \
     Data/Image/Draw/DrawGroupSynchronizer.h \
     Data/Image/Draw/DrawImageViewsSynchronizer.h \
     Data/Image/Draw/DrawSynchronizer.h \
@@ -77,6 +78,7 @@ HEADERS += \
     Data/Image/ImageZoom.h \
     Data/Image/IPercentIntensityMap.h \
     Data/Image/LayerCompositionModes.h \
+    Data/Image/Render/FrameRenderThread.h \
     Data/Image/Render/RenderRequest.h \
     Data/Image/Render/RenderResponse.h \
     Data/Image/Save/SaveService.h \
@@ -101,8 +103,6 @@ HEADERS += \
     Data/Profile/ProfilePlotStyles.h \
     Data/Profile/Render/ProfileRenderRequest.h \
     Data/Profile/Render/ProfileRenderService.h \
-    Data/Profile/Render/ProfileRenderThread.h \
-    Data/Profile/Render/ProfileRenderWorker.h \
     Data/Profile/ProfileStatistics.h \
     Data/Profile/GenerateModes.h \
     Data/Region/Region.h \
@@ -149,6 +149,12 @@ HEADERS += \
     ScriptedClient/ScriptFacade.h \
     Algorithms/percentileAlgorithms.h \
     Algorithms/percentileManku99.h \
+    Algorithms/rasterRender.h \
+    Algorithms/mipmapPyramid.h \
+    Algorithms/tileGrid.h \
+    Algorithms/prefetchCap.h \
+    Algorithms/frameStatistics.h \
+    Algorithms/floatFrameView.h \
     ScriptedClient/Listener.h \
     ScriptedClient/ScriptedCommandInterpreter.h \
     ScriptedClient/VarLengthMessage.h \
@@ -187,6 +193,7 @@ SOURCES += \
     Data/Settings.cpp \
     Data/Animator/Animator.cpp \
     Data/Animator/AnimatorType.cpp \
+    Data/Animator/FrameSequence.cpp \
     Data/Clips.cpp \
     Data/Colormap/Colormap.cpp \
     Data/Colormap/Colormaps.cpp \
@@ -210,6 +217,7 @@ SOURCES += \
     Data/Image/Contour/GeneratorState.cpp \
     Data/Image/CoordinateSystems.cpp \
     Data/Image/DataSource.cpp \
+    Data/Image/FramePrefetcher.cpp \
     Data/Image/Grid/AxisMapper.cpp \
     Data/Image/Grid/DataGrid.cpp \
     Data/Image/Grid/Fonts.cpp \
@@ -223,11 +231,13 @@ SOURCES += \
     Data/Image/ImageContext.cpp \
     Data/Image/ImageZoom.cpp \
     Data/Image/LayerCompositionModes.cpp \
+    Data/Image/Render/FrameRenderThread.cpp \
     Data/Image/Render/RenderRequest.cpp \
     Data/Image/Render/RenderResponse.cpp \
     Data/Image/Save/SaveService.cpp \
     Data/Image/Save/SaveView.cpp \
     Data/Image/Save/SaveViewLayered.cpp \
+    Data/ComputeWorkerPool.cpp \
     Data/DataLoader.cpp \
     Data/Error/ErrorReport.cpp \
     Data/Error/ErrorManager.cpp \
@@ -235,8 +245,6 @@ SOURCES += \
     Data/Histogram/Histogram.cpp \
     Data/Histogram/ChannelUnits.cpp \
     Data/Histogram/Render/HistogramRenderService.cpp \
-    Data/Histogram/Render/HistogramRenderThread.cpp \
-    Data/Histogram/Render/HistogramRenderWorker.cpp \
     Data/Histogram/Render/HistogramRenderRequest.cpp \
     Data/Histogram/PlotStyles.cpp \
     Data/LinkableImpl.cpp \
@@ -258,8 +266,6 @@ SOURCES += \
     Data/Profile/ProfilePlotStyles.cpp \
     Data/Profile/Render/ProfileRenderRequest.cpp \
     Data/Profile/Render/ProfileRenderService.cpp \
-    Data/Profile/Render/ProfileRenderThread.cpp \
-    Data/Profile/Render/ProfileRenderWorker.cpp \
     Data/Profile/ProfileStatistics.cpp \
     Data/Profile/GenerateModes.cpp \
     Data/Region/Region.cpp \
@@ -304,6 +310,12 @@ SOURCES += \
     Shape/ShapeRectangle.cpp \
     ImageRenderService.cpp \
     Algorithms/percentileAlgorithms.cpp \
+    Algorithms/rasterRender.cpp \
+    Algorithms/mipmapPyramid.cpp \
+    Algorithms/tileGrid.cpp \
+    Algorithms/prefetchCap.cpp \
+    Algorithms/frameStatistics.cpp \
+    Algorithms/floatFrameView.cpp \
     ScriptedClient/Listener.cpp \
     ScriptedClient/ScriptedCommandInterpreter.cpp \
     ScriptedClient/VarLengthMessage.cpp \
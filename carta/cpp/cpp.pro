@@ -11,7 +11,9 @@ SUBDIRS = \
     Tests \
     testCache \
     testRegion \
-    testPercentile
+    testPercentile \
+    testRender \
+    testContour
 
 isEmpty(NOSERVER) {
 	SUBDIRS +=server
@@ -26,6 +28,8 @@ plugins.depends = core
 testRegion.depends = core
 testCache.depends = core
 testPercentile.depends = core
+testRender.depends = core
+testContour.depends = core
 
 isEmpty(NOSERVER) {
         Tests.depends = core desktop server plugins
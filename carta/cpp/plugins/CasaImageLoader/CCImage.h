@@ -8,6 +8,7 @@
 #include "CartaLib/IImage.h"
 #include "CartaLib/AxisInfo.h"
 #include "CCRawView.h"
+#include "FitsMappedView.h"
 #include "CCMetaDataInterface.h"
 #include "casacore/images/Images/ImageInterface.h"
 #include "casacore/images/Images/ImageUtilities.h"
@@ -157,9 +158,23 @@ public:
     virtual Carta::Lib::NdArray::RawViewInterface *
     getDataSlice( const SliceND & sliceInfo ) override
     {
+        if ( m_mapped ) {
+            return new FitsMappedRawView( m_mapped, sliceInfo.apply( m_dims ) );
+        }
         return new CCRawView < PType > ( this, sliceInfo );
     }
 
+    /// read the pixels from a memory mapping of the file rather than through casacore
+    /// \param mapped the mapped file, it has to hold the same pixels as the casacore image
+    /// \note only valid for CCImage<float>, as the mapped views always have Real32 pixels
+    void
+    setMappedData( FitsMappedData::SharedPtr mapped )
+    {
+        CARTA_ASSERT( m_pixelType == Carta::Lib::Image::PixelType::Real32 );
+        CARTA_ASSERT( ! mapped || mapped-> dims() == m_dims );
+        m_mapped = mapped;
+    }
+
     /// \todo implement this
     virtual Carta::Lib::NdArray::Byte *
     getMaskSlice( const SliceND & sliceInfo) override
@@ -267,6 +282,9 @@ protected:
     /// meta data pointer
     CCMetaDataInterface::SharedPtr m_meta;
 
+    /// memory mapped pixels of an uncompressed FITS file, if any
+    FitsMappedData::SharedPtr m_mapped = nullptr;
+
     /// we want CCRawView to access our internals...
     /// \todo maybe we just need a public accessor, no? I don't like friends :) (Pavol)
     friend class CCRawView < PType >;
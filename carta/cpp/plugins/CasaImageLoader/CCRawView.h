@@ -5,10 +5,14 @@
 #pragma once
 
 #include "CartaLib/IImage.h"
-#include <casacore/lattices/Lattices/LatticeStepper.h>
-#include <casacore/lattices/Lattices/LatticeIterator.h>
+#include <casacore/casa/Arrays/Array.h>
 #include <casacore/casa/Arrays/IPosition.h>
+#include <casacore/casa/Arrays/Slicer.h>
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <vector>
 
 template < typename PType >
 class CCImage;
@@ -66,36 +70,37 @@ public:
         return new CCRawView( m_ccimage, newAr);
     }
 
+    /// sequential read of the next chunk, see the stateless read() below
     virtual int64_t
     read( int64_t buffSize, char * buff,
           Traversal traversal = Traversal::Sequential ) override
     {
-        Q_UNUSED( buffSize);
-        Q_UNUSED( buff);
-        Q_UNUSED( traversal);
-        qFatal( "not implemented");
+        int64_t n = read( m_readChunk, buffSize, buff, traversal );
+        if ( n > 0 ) {
+            m_readChunk++;
+        }
+        return n;
     }
 
+    /// set the chunk index for the next read()
+    /// \note the index is in units of chunks, so the buffer size passed to read()
+    /// has to stay the same between seek() and read()
     virtual void
-    seek(int64_t ind) override
+    seek( int64_t ind ) override
     {
-        Q_UNUSED( ind);
-        qFatal( "not implemented");
+        m_readChunk = ind;
     }
 
     /// another high performance accessor to data
     /// motivated by unix read() but stateless (i.e. one needs to supply the
     /// chunk number)
+    ///
+    /// Sequential chunks hold buffSize bytes each (except for the last one). Optimal
+    /// chunks are shaped after the tiles of the image, so each one can hold fewer.
+    /// In both cases 0 is returned once the chunk index is past the end of the view.
     virtual int64_t
     read( int64_t chunk, int64_t buffSize, char * buff,
-          Traversal traversal = Traversal::Sequential ) override
-    {
-        Q_UNUSED( chunk );
-        Q_UNUSED( buffSize );
-        Q_UNUSED( buff );
-        Q_UNUSED( traversal );
-        qFatal( "not implemented" );
-    }
+          Traversal traversal = Traversal::Sequential ) override;
 
     /// yet another high performance accessor... similar to forEach above,
     /// but this time the supplied function gets called with whatever number
@@ -105,14 +110,7 @@ public:
         int64_t buffSize,
         std::function < void (const char *, int64_t count) > func,
         char * buff = nullptr,
-        Traversal traversal = Traversal::Sequential ) override
-    {
-        Q_UNUSED( buffSize );
-        Q_UNUSED( func );
-        Q_UNUSED( buff );
-        Q_UNUSED( traversal );
-        qFatal( "not implemented" );
-    }
+        Traversal traversal = Traversal::Sequential ) override;
 
 protected:
 
@@ -129,6 +127,41 @@ protected:
 
     // minicache to make get() a little bit faster
     VI m_destPos;
+
+    // chunk to be returned by the next stateful read()
+    int64_t m_readChunk = 0;
+
+    /// number of pixels in this view
+    int64_t
+    _nPixels() const;
+
+    /// read a box of the view (in view coordinates) into dst, in column-major order
+    void
+    _readBox( const VI & origin, const VI & shape, PType * dst );
+
+    /// read 'count' pixels into dst, starting at the sequential index 'first'
+    void
+    _readSequential( int64_t first, int64_t count, PType * dst );
+
+    /// the chunk shape (in view pixels) for the optimal traversal, derived from the
+    /// tile shape of the image, with at most maxPixels pixels
+    VI
+    _optimalChunkShape( int64_t maxPixels );
+
+    /// the shape of the boxes that a sequential traversal with buffers of maxPixels
+    /// pixels mostly reads: whole leading axes, a part of the next one
+    VI
+    _sequentialChunkShape( int64_t maxPixels ) const;
+
+    /// the box of the given chunk, when the view is divided into chunks of chunkShape
+    /// \return false if the chunk is past the end of the view
+    bool
+    _chunkBox( int64_t chunk, const VI & chunkShape, VI & origin, VI & shape ) const;
+
+    /// tell casacore how large a tile cache we need to traverse the view in chunks
+    /// of the given shape
+    void
+    _setCacheHint( const VI & chunkShape );
 };
 
 // public constructor
@@ -211,54 +244,303 @@ CCRawView < PType >::forEach(
     std::function < void (const char *) > func,
     Carta::Lib::NdArray::RawViewInterface::Traversal traversal )
 {
-    if ( traversal != Carta::Lib::NdArray::RawViewInterface::Traversal::Sequential ) {
-        qFatal( "sorry, not implemented yet" );
+    // number of pixels to read from casacore at once
+    const int64_t buffPixels = 1024 * 1024;
+
+    const int ndim = m_viewDims.size();
+    const int64_t nPixels = _nPixels();
+    m_currPosView.assign( ndim, 0 );
+    if ( nPixels == 0 ) {
+        return;
+    }
+
+    // moves pos to the next pixel of the box, in column-major order
+    auto advance = [ndim] ( VI & pos, const VI & origin, const VI & shape ) {
+        for ( int i = 0 ; i < ndim ; i++ ) {
+            if ( ++pos[i] < origin[i] + shape[i] ) {
+                return;
+            }
+            pos[i] = origin[i];
+        }
+    };
+
+    if ( traversal == Traversal::Sequential ) {
+        const int64_t capacity = std::min( buffPixels, nPixels );
+        std::vector < PType > buff( capacity );
+        const VI zero( ndim, 0 );
+        _setCacheHint( _sequentialChunkShape( capacity ) );
+        for ( int64_t first = 0 ; first < nPixels ; first += capacity ) {
+            const int64_t count = std::min( capacity, nPixels - first );
+            _readSequential( first, count, buff.data() );
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                func( reinterpret_cast < const char * > ( & buff[i] ) );
+                advance( m_currPosView, zero, m_viewDims );
+            }
+        }
+    }
+    else {
+        const VI chunkShape = _optimalChunkShape( buffPixels );
+        std::vector < PType > buff( std::accumulate( chunkShape.begin(), chunkShape.end(),
+                                                     int64_t( 1 ), std::multiplies < int64_t > () ) );
+        _setCacheHint( chunkShape );
+        VI origin, shape;
+        for ( int64_t chunk = 0 ; _chunkBox( chunk, chunkShape, origin, shape ) ; chunk++ ) {
+            _readBox( origin, shape, buff.data() );
+            m_currPosView = origin;
+            const int64_t count = std::accumulate( shape.begin(), shape.end(), int64_t( 1 ),
+                                                   std::multiplies < int64_t > () );
+            for ( int64_t i = 0 ; i < count ; i++ ) {
+                func( reinterpret_cast < const char * > ( & buff[i] ) );
+                advance( m_currPosView, origin, shape );
+            }
+        }
+    }
+} // forEach
+
+template < typename PType >
+void
+CCRawView < PType >::forEach(
+    int64_t buffSize,
+    std::function < void (const char *, int64_t) > func,
+    char * buff,
+    Carta::Lib::NdArray::RawViewInterface::Traversal traversal )
+{
+    const int64_t capacity = std::max < int64_t > ( 1, buffSize / sizeof( PType ) );
+
+    // use our own storage if the caller did not supply any
+    std::vector < PType > ownBuff;
+    if ( buff == nullptr ) {
+        ownBuff.resize( capacity );
+        buff = reinterpret_cast < char * > ( ownBuff.data() );
     }
-    auto casaII     = m_ccimage-> m_casaII;
-    int imgDims     = casaII-> ndim();
-    auto imageShape = casaII-> shape();
-
-//    qDebug() << "CCRawView::forEach=" << m_appliedSlice.toStr()  ;
-
-    // set the cursor shape to load partial file at each step
-    casacore::IPosition cursorShape( imgDims );
-    auto shapeVec = imageShape.asVector();
-    for(auto i=0; i<imgDims; i++){
-        // Restrict the maximum size in one dim to 16
-        // (The number is given arbitarily. Maybe it can be changed in the future)
-        cursorShape(i) = std::min( shapeVec(i), 16);
-        if ( i == 0 || i == 1 ){
-            // The first two dims are used as the dims of qimage in ImageRenderService
-            // To keep the rendering working, the sizes of the two dims cannot be changed so far.
-            cursorShape(i) = shapeVec(i);
+    PType * dst = reinterpret_cast < PType * > ( buff );
+
+    const int64_t nPixels = _nPixels();
+    if ( traversal == Traversal::Sequential ) {
+        _setCacheHint( _sequentialChunkShape( capacity ) );
+        for ( int64_t first = 0 ; first < nPixels ; first += capacity ) {
+            const int64_t count = std::min( capacity, nPixels - first );
+            _readSequential( first, count, dst );
+            func( buff, count );
         }
     }
+    else {
+        const VI chunkShape = _optimalChunkShape( capacity );
+        _setCacheHint( chunkShape );
+        VI origin, shape;
+        for ( int64_t chunk = 0 ; _chunkBox( chunk, chunkShape, origin, shape ) ; chunk++ ) {
+            _readBox( origin, shape, dst );
+            func( buff, std::accumulate( shape.begin(), shape.end(), int64_t( 1 ),
+                                         std::multiplies < int64_t > () ) );
+        }
+    }
+} // forEach
+
+template < typename PType >
+int64_t
+CCRawView < PType >::read(
+    int64_t chunk,
+    int64_t buffSize,
+    char * buff,
+    Carta::Lib::NdArray::RawViewInterface::Traversal traversal )
+{
+    const int64_t capacity = buffSize / sizeof( PType );
+    if ( capacity < 1 || chunk < 0 ) {
+        return 0;
+    }
+    PType * dst = reinterpret_cast < PType * > ( buff );
+
+    if ( traversal == Traversal::Sequential ) {
+        const int64_t first = chunk * capacity;
+        const int64_t nPixels = _nPixels();
+        if ( first >= nPixels ) {
+            return 0;
+        }
+        if ( chunk == 0 ) {
+            _setCacheHint( _sequentialChunkShape( capacity ) );
+        }
+        const int64_t count = std::min( capacity, nPixels - first );
+        _readSequential( first, count, dst );
+        return count * sizeof( PType );
+    }
+
+    const VI chunkShape = _optimalChunkShape( capacity );
+    VI origin, shape;
+    if ( ! _chunkBox( chunk, chunkShape, origin, shape ) ) {
+        return 0;
+    }
+    if ( chunk == 0 ) {
+        _setCacheHint( chunkShape );
+    }
+    _readBox( origin, shape, dst );
+    return std::accumulate( shape.begin(), shape.end(), int64_t( 1 ),
+                            std::multiplies < int64_t > () ) * sizeof( PType );
+} // read
+
+template < typename PType >
+int64_t
+CCRawView < PType >::_nPixels() const
+{
+    return std::accumulate( m_viewDims.begin(), m_viewDims.end(), int64_t( 1 ),
+                            std::multiplies < int64_t > () );
+}
 
-    casacore::LatticeStepper stepper( imageShape, cursorShape, casacore::LatticeStepper::RESIZE );
-    casacore::IPosition blc( imgDims, 0 );
-    auto trc = blc;
-    auto inc = blc;
-    for ( int i = 0 ; i < imgDims ; i++ ) {
+template < typename PType >
+void
+CCRawView < PType >::_readBox( const VI & origin, const VI & shape, PType * dst )
+{
+    auto casaII = m_ccimage-> m_casaII;
+    const int ndim = m_viewDims.size();
+    casacore::IPosition start( ndim ), length( ndim ), stride( ndim );
+    int64_t count = 1;
+    for ( int i = 0 ; i < ndim ; i++ ) {
         const auto & slice1d = m_appliedSlice.dims()[i];
-        blc( i ) = slice1d.start;
-        trc( i ) = slice1d.end();
-        inc( i ) = slice1d.step;
+        start( i ) = slice1d.start + origin[i] * slice1d.step;
+        length( i ) = shape[i];
+        stride( i ) = slice1d.step;
+        count *= shape[i];
     }
-    stepper.subSection( blc, trc, inc );
-    casacore::RO_LatticeIterator < PType > iterator( * casaII, stepper );
+    casacore::Slicer slicer( start, length, stride, casacore::Slicer::endIsLength );
+
+    // let casacore read straight into the destination; some lattices return a
+    // reference to their own storage instead, in which case we copy from it
+    casacore::Array < PType > arr( length, dst, casacore::SHARE );
+    casaII-> getSlice( arr, slicer );
+    if ( arr.data() != dst ) {
+        bool deleteIt;
+        const PType * src = arr.getStorage( deleteIt );
+        std::copy( src, src + count, dst );
+        arr.freeStorage( src, deleteIt );
+    }
+} // _readBox
 
-    for ( iterator.reset() ; ! iterator.atEnd() ; iterator++ ) {
-        const auto & cursor = iterator.cursor();
-        for ( const auto & val : cursor ) {
-            func( reinterpret_cast < const char * > ( & val ) );
+template < typename PType >
+void
+CCRawView < PType >::_readSequential( int64_t first, int64_t count, PType * dst )
+{
+    // A sequential range is split into boxes: at every position we take as many
+    // whole rows/planes/cubes... as are aligned and fit into the range. That is at
+    // most 2*ndim boxes per range, each read with a single casacore call.
+    const int ndim = m_viewDims.size();
+    const int64_t end = first + count;
+    VI origin( ndim ), shape( ndim );
+    while ( first < end ) {
+        int64_t rem = first;
+        for ( int i = 0 ; i < ndim ; i++ ) {
+            origin[i] = rem % m_viewDims[i];
+            rem /= m_viewDims[i];
+        }
+
+        // find the highest axis k such that all axes below k can be taken whole
+        int k = 0;
+        int64_t blockSize = 1;
+        while ( k < ndim - 1 && origin[k] == 0 && blockSize * m_viewDims[k] <= end - first ) {
+            blockSize *= m_viewDims[k];
+            k++;
+        }
+        const int64_t n = std::min < int64_t > ( ( end - first ) / blockSize,
+                                                 m_viewDims[k] - origin[k] );
+        for ( int i = 0 ; i < ndim ; i++ ) {
+            shape[i] = i < k ? m_viewDims[i] : ( i == k ? n : 1 );
         }
+        _readBox( origin, shape, dst );
+        dst += n * blockSize;
+        first += n * blockSize;
     }
-} // forEach
+} // _readSequential
+
+template < typename PType >
+typename CCRawView < PType >::VI
+CCRawView < PType >::_optimalChunkShape( int64_t maxPixels )
+{
+    const int ndim = m_viewDims.size();
+    maxPixels = std::max < int64_t > ( 1, std::min < int64_t > (
+                                           maxPixels, std::numeric_limits < unsigned int >::max() ) );
+
+    // casacore knows the tile shape, we only need to translate it to view pixels
+    casacore::IPosition nice = m_ccimage-> m_casaII-> niceCursorShape( maxPixels );
+    VI shape( ndim );
+    int64_t size = 1;
+    for ( int i = 0 ; i < ndim ; i++ ) {
+        const int step = std::max( 1, m_appliedSlice.dims()[i].step );
+        shape[i] = std::max( 1, std::min < int > ( nice( i ) / step, m_viewDims[i] ) );
+        size *= shape[i];
+    }
+
+    // a single tile can be larger than the buffer, shrink from the last axis down
+    for ( int i = ndim - 1 ; i >= 0 && size > maxPixels ; i-- ) {
+        size /= shape[i];
+        shape[i] = std::max < int64_t > ( 1, maxPixels / size );
+        size *= shape[i];
+    }
+
+    // with strides the tiles cover fewer view pixels, so grow the chunk in whole
+    // multiples (to stay aligned with the tiles) while it fits into the buffer
+    for ( int i = 0 ; i < ndim ; i++ ) {
+        while ( shape[i] < m_viewDims[i] && size * 2 <= maxPixels ) {
+            size /= shape[i];
+            shape[i] = std::min( shape[i] * 2, m_viewDims[i] );
+            size *= shape[i];
+        }
+    }
+    return shape;
+} // _optimalChunkShape
+
+template < typename PType >
+typename CCRawView < PType >::VI
+CCRawView < PType >::_sequentialChunkShape( int64_t maxPixels ) const
+{
+    const int ndim = m_viewDims.size();
+    VI shape( ndim, 1 );
+    int64_t size = 1;
+    for ( int i = 0 ; i < ndim ; i++ ) {
+        shape[i] = std::max < int64_t > ( 1, std::min < int64_t > ( maxPixels / size, m_viewDims[i] ) );
+        if ( shape[i] < m_viewDims[i] ) {
+            break;
+        }
+        size *= shape[i];
+    }
+    return shape;
+} // _sequentialChunkShape
+
+template < typename PType >
+bool
+CCRawView < PType >::_chunkBox( int64_t chunk, const VI & chunkShape, VI & origin, VI & shape ) const
+{
+    const int ndim = m_viewDims.size();
+    origin.resize( ndim );
+    shape.resize( ndim );
+    for ( int i = 0 ; i < ndim ; i++ ) {
+        if ( m_viewDims[i] == 0 ) {
+            return false;
+        }
+        const int64_t nChunks = ( m_viewDims[i] + chunkShape[i] - 1 ) / chunkShape[i];
+        origin[i] = ( chunk % nChunks ) * chunkShape[i];
+        shape[i] = std::min( chunkShape[i], m_viewDims[i] - origin[i] );
+        chunk /= nChunks;
+    }
+    return chunk == 0;
+} // _chunkBox
+
+template < typename PType >
+void
+CCRawView < PType >::_setCacheHint( const VI & chunkShape )
+{
+    const int ndim = m_viewDims.size();
+    casacore::IPosition sliceShape( ndim ), windowStart( ndim ), windowLength( ndim ), axisPath( ndim );
+    for ( int i = 0 ; i < ndim ; i++ ) {
+        const auto & slice1d = m_appliedSlice.dims()[i];
+        sliceShape( i ) = ( chunkShape[i] - 1 ) * slice1d.step + 1;
+        windowStart( i ) = slice1d.start;
+        windowLength( i ) = std::max( 1, ( slice1d.count - 1 ) * slice1d.step + 1 );
+        axisPath( i ) = i;
+    }
+    m_ccimage-> m_casaII-> setCacheSizeFromPath( sliceShape, windowStart, windowLength, axisPath );
+} // _setCacheHint
 
 template < typename PType >
 const Carta::Lib::NdArray::RawViewInterface::VI &
 CCRawView < PType >::currentPos()
 {
-    qFatal( "Not implemented yet");
     return m_currPosView;
 }
@@ -126,6 +126,17 @@ Carta::Lib::Image::ImageInterface::SharedPtr CasaImageLoader::loadImage( const Q
 
     CCImageBase::SharedPtr res;
     res = tryCast<float>(lat);
+
+    // casacore still provides the coordinates and other metadata of FITS images, but
+    // the pixels of uncompressed ones are read straight from a memory mapping
+    if( res && filetype == casacore::ImageOpener::ImageTypes::FITS) {
+        FitsMappedData::SharedPtr mapped = FitsMappedData::open( fname);
+        if( mapped && mapped->dims() == res->dims()) {
+            std::static_pointer_cast<CCImage<float> >( res)->setMappedData( mapped);
+            qDebug() << "\t-pixels are memory mapped";
+        }
+    }
+
     // Please note that the following code will not be reached
     // even if the FITS file is defined in 64 bit
     // and FitsHeaderExtractor::_CasaFitsConverter assumes that
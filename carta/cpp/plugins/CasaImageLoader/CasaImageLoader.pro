@@ -12,14 +12,18 @@ SOURCES += \
     CCImage.cpp \
     CCMetaDataInterface.cpp \
     CCRawView.cpp \
-    CCCoordinateFormatter.cpp
+    CCCoordinateFormatter.cpp \
+    FitsMappedView.cpp \
+    ../WcsPlotter/SimpleFitsParser.cpp
 
 HEADERS += \
     CasaImageLoader.h \
     CCImage.h \
     CCMetaDataInterface.h \
     CCRawView.h \
-    CCCoordinateFormatter.h
+    CCCoordinateFormatter.h \
+    FitsMappedView.h \
+    ../WcsPlotter/SimpleFitsParser.h
 
 casacoreLIBS += -L$${CASACOREDIR}/lib
 casacoreLIBS += -lcasa_lattices -lcasa_tables -lcasa_scimath -lcasa_scimath_f -lcasa_mirlib
@@ -0,0 +1,338 @@
+/**
+ *
+ **/
+
+#include "FitsMappedView.h"
+#include "../WcsPlotter/SimpleFitsParser.h"
+#include <QDebug>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+/// number of elements a 1D slice extracts
+inline int
+sliceCount( const Slice1D::ApplyResult & res )
+{
+    return res.isSingle() ? 1 : res.count;
+}
+
+/// convert big endian pixels of type Raw (stored as Bits) to native floats
+///
+/// The loops are kept free of calls and data dependent branches so that the byte
+/// swap and the conversion are vectorized.
+template < typename Raw, typename Bits >
+void
+bigEndianToFloat( const uchar * src, int64_t count, float * dst,
+                  bool scaling, double bscale, double bzero, bool hasBlank, int64_t blank )
+{
+    static_assert( sizeof( Raw ) == sizeof( Bits ), "Raw and Bits must have the same size" );
+    if ( ! scaling ) {
+        for ( int64_t i = 0 ; i < count ; i++ ) {
+            Bits bits = qFromBigEndian < Bits > ( src + i * sizeof( Bits ) );
+            Raw raw;
+            std::memcpy( & raw, & bits, sizeof( raw ) );
+            dst[i] = float( raw );
+        }
+        return;
+    }
+
+    const float nan = std::numeric_limits < float >::quiet_NaN();
+    for ( int64_t i = 0 ; i < count ; i++ ) {
+        Bits bits = qFromBigEndian < Bits > ( src + i * sizeof( Bits ) );
+        Raw raw;
+        std::memcpy( & raw, & bits, sizeof( raw ) );
+        const float val = float( bzero + bscale * raw );
+        dst[i] = ( hasBlank && raw == blank ) ? nan : val;
+    }
+}
+}
+
+FitsMappedData::FitsMappedData()
+{ }
+
+FitsMappedData::SharedPtr
+FitsMappedData::open( const QString & fileName )
+{
+    WcsPlotterPluginNS::SimpleFitsParser parser;
+    if ( ! parser.loadFile( fileName ) ) {
+        return nullptr;
+    }
+    const WcsPlotterPluginNS::SimpleFitsParser::HeaderInfo & info = parser.getHeaderInfo();
+    if ( info.bitpix != - 32 && info.bitpix != - 64 && info.bitpix != 16 && info.bitpix != 32 ) {
+        return nullptr;
+    }
+
+    SharedPtr mapped( new FitsMappedData() );
+    mapped-> m_dims = info.m_dims;
+    mapped-> m_bitpix = info.bitpix;
+    mapped-> m_bscale = info.bscale;
+    mapped-> m_bzero = info.bzero;
+    mapped-> m_hasBlank = info.hasBlank;
+    mapped-> m_blank = info.blank;
+    mapped-> m_scaling = info.scalingRequired;
+
+    int64_t size = info.bitpixSize;
+    for ( int dim : mapped-> m_dims ) {
+        size *= dim;
+    }
+
+    mapped-> m_file.setFileName( fileName );
+    if ( ! mapped-> m_file.open( QFile::ReadOnly ) ) {
+        return nullptr;
+    }
+    if ( info.dataOffset + size > mapped-> m_file.size() ) {
+        qWarning() << "FITS file" << fileName << "is shorter than its header says, not mapping it";
+        return nullptr;
+    }
+    mapped-> m_data = mapped-> m_file.map( info.dataOffset, size );
+    if ( ! mapped-> m_data ) {
+        qWarning() << "Could not map" << fileName << ":" << mapped-> m_file.errorString();
+        return nullptr;
+    }
+    return mapped;
+} // open
+
+FitsMappedData::~FitsMappedData()
+{
+    if ( m_data ) {
+        m_file.unmap( m_data );
+    }
+}
+
+const std::vector < int > &
+FitsMappedData::dims() const
+{
+    return m_dims;
+}
+
+void
+FitsMappedData::convert( int64_t first, int64_t count, float * dst ) const
+{
+    switch ( m_bitpix )
+    {
+    case - 32 :
+        bigEndianToFloat < float, quint32 > ( m_data + first * 4, count, dst,
+                                              m_scaling, m_bscale, m_bzero, m_hasBlank, m_blank );
+        break;
+    case - 64 :
+        bigEndianToFloat < double, quint64 > ( m_data + first * 8, count, dst,
+                                               m_scaling, m_bscale, m_bzero, m_hasBlank, m_blank );
+        break;
+    case 16 :
+        bigEndianToFloat < qint16, quint16 > ( m_data + first * 2, count, dst,
+                                               m_scaling, m_bscale, m_bzero, m_hasBlank, m_blank );
+        break;
+    case 32 :
+        bigEndianToFloat < qint32, quint32 > ( m_data + first * 4, count, dst,
+                                               m_scaling, m_bscale, m_bzero, m_hasBlank, m_blank );
+        break;
+    default :
+        CARTA_ASSERT_X( false, "Unsupported BITPIX" );
+    }
+}
+
+const float *
+FitsMappedData::native( int64_t first ) const
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    if ( m_bitpix == - 32 && ! m_scaling ) {
+        return reinterpret_cast < const float * > ( m_data ) + first;
+    }
+#else
+    Q_UNUSED( first );
+#endif
+    return nullptr;
+}
+
+FitsMappedRawView::FitsMappedRawView( FitsMappedData::SharedPtr data,
+                                      const SliceND::ApplyResult & appliedSlice )
+    : m_data( data ), m_appliedSlice( appliedSlice )
+{
+    CARTA_ASSERT( m_data );
+    CARTA_ASSERT( ! m_appliedSlice.isError() );
+    const VI & origDims = m_data-> dims();
+    CARTA_ASSERT( m_appliedSlice.dims().size() == origDims.size() );
+    for ( size_t i = 0 ; i < origDims.size() ; i++ ) {
+        const Slice1D::ApplyResult & res = m_appliedSlice.dims()[i];
+        m_viewDims.push_back( sliceCount( res ) );
+        m_whole = m_whole && res.start == 0 && res.step == 1 && m_viewDims[i] == origDims[i];
+    }
+    m_currentPos.resize( m_viewDims.size(), 0 );
+}
+
+FitsMappedRawView::PixelType
+FitsMappedRawView::pixelType()
+{
+    return PixelType::Real32;
+}
+
+const FitsMappedRawView::VI &
+FitsMappedRawView::dims()
+{
+    return m_viewDims;
+}
+
+const char *
+FitsMappedRawView::get( const VI & pos )
+{
+    const VI & origDims = m_data-> dims();
+    int64_t ind = 0;
+    int64_t stride = 1;
+    for ( size_t i = 0 ; i < origDims.size() ; i++ ) {
+        const Slice1D::ApplyResult & res = m_appliedSlice.dims()[i];
+        const int64_t p = i < pos.size() ? pos[i] : 0;
+        ind += ( res.start + p * res.step ) * stride;
+        stride *= origDims[i];
+    }
+    m_data-> convert( ind, 1, & m_buff );
+    return reinterpret_cast < const char * > ( & m_buff );
+}
+
+void
+FitsMappedRawView::forEach( std::function < void (const char *) > func, Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    const int64_t total = nPixels();
+    if ( total == 0 ) {
+        return;
+    }
+    const int width = m_viewDims[0];
+    std::vector < float > row( width );
+    std::fill( m_currentPos.begin(), m_currentPos.end(), 0 );
+    for ( int64_t first = 0 ; first < total ; first += width ) {
+        copySequential( first, width, row.data() );
+        for ( int x = 0 ; x < width ; x++ ) {
+            m_currentPos[0] = x;
+            func( reinterpret_cast < const char * > ( & row[x] ) );
+        }
+        // advance the position of the next row
+        for ( size_t i = 1 ; i < m_currentPos.size() ; i++ ) {
+            if ( ++m_currentPos[i] < m_viewDims[i] ) {
+                break;
+            }
+            m_currentPos[i] = 0;
+        }
+    }
+}
+
+const FitsMappedRawView::VI &
+FitsMappedRawView::currentPos()
+{
+    return m_currentPos;
+}
+
+Carta::Lib::NdArray::RawViewInterface *
+FitsMappedRawView::getView( const SliceND & sliceInfo )
+{
+    SliceND::ApplyResult ar = sliceInfo.apply( m_viewDims );
+    return new FitsMappedRawView( m_data, SliceND::ApplyResult::combine( m_appliedSlice, ar ) );
+}
+
+int64_t
+FitsMappedRawView::read( int64_t buffSize, char * buff, Traversal traversal )
+{
+    int64_t n = read( m_readChunk, buffSize, buff, traversal );
+    if ( n > 0 ) {
+        m_readChunk++;
+    }
+    return n;
+}
+
+void
+FitsMappedRawView::seek( int64_t ind )
+{
+    m_readChunk = ind;
+}
+
+int64_t
+FitsMappedRawView::read( int64_t chunk, int64_t buffSize, char * buff, Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    const int64_t capacity = buffSize / sizeof( float );
+    const int64_t first = chunk * capacity;
+    if ( capacity < 1 || chunk < 0 || first >= nPixels() ) {
+        return 0;
+    }
+    const int64_t count = std::min( capacity, nPixels() - first );
+    copySequential( first, count, reinterpret_cast < float * > ( buff ) );
+    return count * sizeof( float );
+}
+
+void
+FitsMappedRawView::forEach( int64_t buffSize,
+                            std::function < void (const char *, int64_t) > func,
+                            char * buff,
+                            Traversal traversal )
+{
+    Q_UNUSED( traversal );
+    const int64_t total = nPixels();
+    const int64_t n = std::max < int64_t > ( 1, buffSize / sizeof( float ) );
+    const bool direct = m_whole && ! buff && m_data-> native( 0 );
+    std::vector < float > ownBuff;
+    if ( ! direct && ! buff ) {
+        ownBuff.resize( std::min( n, total ) );
+        buff = reinterpret_cast < char * > ( ownBuff.data() );
+    }
+    for ( int64_t i = 0 ; i < total ; i += n ) {
+        const int64_t count = std::min( n, total - i );
+        if ( direct ) {
+            func( reinterpret_cast < const char * > ( m_data-> native( i ) ), count );
+        }
+        else {
+            copySequential( i, count, reinterpret_cast < float * > ( buff ) );
+            func( buff, count );
+        }
+    }
+}
+
+int64_t
+FitsMappedRawView::nPixels() const
+{
+    int64_t n = 1;
+    for ( int dim : m_viewDims ) {
+        n *= dim;
+    }
+    return n;
+}
+
+void
+FitsMappedRawView::copySequential( int64_t first, int64_t count, float * dst ) const
+{
+    if ( m_whole ) {
+        m_data-> convert( first, count, dst );
+        return;
+    }
+    const VI & origDims = m_data-> dims();
+    const std::vector < Slice1D::ApplyResult > & slices = m_appliedSlice.dims();
+    const int64_t width = m_viewDims[0];
+    while ( count > 0 ) {
+        // find the start of the current row in the file
+        int64_t row = first / width;
+        int64_t x = first % width;
+        int64_t offset = 0;
+        int64_t stride = origDims[0];
+        for ( size_t i = 1 ; i < slices.size() ; i++ ) {
+            const int64_t p = row % m_viewDims[i];
+            row /= m_viewDims[i];
+            offset += ( slices[i].start + p * slices[i].step ) * stride;
+            stride *= origDims[i];
+        }
+        const int64_t n = std::min( count, width - x );
+        const int64_t step = slices[0].step;
+        const int64_t rowStart = offset + slices[0].start + x * step;
+        if ( step == 1 ) {
+            m_data-> convert( rowStart, n, dst );
+        }
+        else {
+            for ( int64_t j = 0 ; j < n ; j++ ) {
+                m_data-> convert( rowStart + j * step, 1, dst + j );
+            }
+        }
+        dst += n;
+        first += n;
+        count -= n;
+    }
+}
@@ -0,0 +1,158 @@
+/**
+ * Access to the pixels of uncompressed FITS files through a memory mapping of the
+ * data unit, bypassing casacore's lattice and iterator layers.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/IImage.h"
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/// memory mapping of the data unit of the primary HDU of an uncompressed FITS file
+///
+/// Only BITPIX -32, -64, 16 and 32 are supported. The pixels are converted to floats
+/// (big endian to native, BZERO/BSCALE applied, BLANK replaced by NaN) a block at a
+/// time, in loops the compiler can vectorize.
+class FitsMappedData
+{
+    CLASS_BOILERPLATE( FitsMappedData );
+
+public:
+
+    /// \brief map the pixels of a FITS file
+    /// \param fileName the file
+    /// \return the mapping, or nullptr if the file is not a supported FITS file
+    static SharedPtr
+    open( const QString & fileName );
+
+    ~FitsMappedData();
+
+    /// dimensions of the image, i.e. NAXIS1, NAXIS2, ...
+    const std::vector < int > &
+    dims() const;
+
+    /// \brief convert consecutive pixels to floats
+    /// \param first index of the first pixel, in file order
+    /// \param count number of pixels
+    /// \param dst where to store the pixels
+    void
+    convert( int64_t first, int64_t count, float * dst ) const;
+
+    /// \brief direct access to the mapped pixels
+    /// \param first index of a pixel, in file order
+    /// \return pointer to the pixel if the file holds native floats (BITPIX = -32 without
+    /// scaling on a big endian machine), nullptr otherwise
+    const float *
+    native( int64_t first ) const;
+
+private:
+
+    FitsMappedData();
+
+    QFile m_file;
+
+    /// the mapped data unit
+    uchar * m_data = nullptr;
+
+    int m_bitpix = 0;
+    double m_bscale = 1;
+    double m_bzero = 0;
+    bool m_hasBlank = false;
+    int64_t m_blank = 0;
+
+    /// whether BZERO, BSCALE or BLANK have to be applied
+    bool m_scaling = false;
+
+    std::vector < int > m_dims;
+};
+
+/// \brief view of (a slice of) a memory mapped FITS image, with Real32 pixels
+///
+/// The same slicing rules as for CCRawView apply. Pixels are converted a row (or a
+/// buffer) at a time, so there is no per pixel overhead besides the conversion itself.
+class FitsMappedRawView : public Carta::Lib::NdArray::RawViewInterface
+{
+    CLASS_BOILERPLATE( FitsMappedRawView );
+
+public:
+
+    /// \brief create a view of a slice of the image
+    /// \param data the mapped image, shared between all views created from this one
+    /// \param appliedSlice the slice, applied to the dimensions of the image
+    FitsMappedRawView( FitsMappedData::SharedPtr data, const SliceND::ApplyResult & appliedSlice );
+
+    virtual PixelType
+    pixelType() override;
+
+    virtual const VI &
+    dims() override;
+
+    virtual const char *
+    get( const VI & pos ) override;
+
+    virtual void
+    forEach( std::function < void (const char *) > func,
+             Traversal traversal = Traversal::Sequential ) override;
+
+    virtual const VI &
+    currentPos() override;
+
+    virtual RawViewInterface *
+    getView( const SliceND & sliceInfo ) override;
+
+    /// sequential read of the next chunk, see the stateless read() below
+    virtual int64_t
+    read( int64_t buffSize, char * buff,
+          Traversal traversal = Traversal::Sequential ) override;
+
+    /// set the chunk index for the next read()
+    virtual void
+    seek( int64_t ind ) override;
+
+    /// read chunk number 'chunk' of buffSize bytes, the traversal is always sequential
+    virtual int64_t
+    read( int64_t chunk, int64_t buffSize, char * buff,
+          Traversal traversal = Traversal::Sequential ) override;
+
+    /// when the mapped pixels are native floats, the view covers all of them and the
+    /// caller supplies no buffer, the function is handed pointers straight into the mapping
+    virtual void
+    forEach( int64_t buffSize,
+             std::function < void (const char *, int64_t) > func,
+             char * buff = nullptr,
+             Traversal traversal = Traversal::Sequential ) override;
+
+private:
+
+    /// number of pixels in the view
+    int64_t
+    nPixels() const;
+
+    /// convert 'count' pixels, starting at the sequential index 'first', into dst
+    void
+    copySequential( int64_t first, int64_t count, float * dst ) const;
+
+    FitsMappedData::SharedPtr m_data;
+
+    /// dimensions of the view
+    VI m_viewDims;
+
+    /// the slice of the image this view covers
+    SliceND::ApplyResult m_appliedSlice;
+
+    /// whether the view covers all the pixels, in order
+    bool m_whole = true;
+
+    /// position reported by currentPos() during the per element forEach()
+    VI m_currentPos;
+
+    /// storage for the pixel returned by get()
+    float m_buff = 0;
+
+    /// chunk to be returned by the next stateful read()
+    int64_t m_readChunk = 0;
+};
@@ -0,0 +1,209 @@
+#include "FitsMappedView.h"
+#include <casacore/images/Images/FITSImage.h>
+#include <casacore/casa/Arrays/Array.h>
+#include <casacore/casa/Arrays/IPosition.h>
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+class TestFitsMappedView: public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_float();
+    void test_scaledShort();
+};
+
+namespace {
+
+const std::vector<int> DIMS = { 7, 5, 3 };
+
+/// a slice of the image in casacore terms, on every axis
+struct CasaSlice {
+    casacore::IPosition start;
+    casacore::IPosition shape;
+    casacore::IPosition stride;
+};
+
+/// append a header card, padded to 80 characters
+void appendCard( QByteArray& header, const QString& key, const QString& value ){
+    QString card = QString( "%1= %2" ).arg( key, -8 ).arg( value, 20 );
+    header.append( card.leftJustified( 80, ' ' ).toLatin1() );
+}
+
+/// write a FITS file with the given BITPIX, extra cards and big endian pixels
+void writeFits( const QString& fileName, int bitpix, const QList<QPair<QString,QString> >& cards,
+        const QByteArray& pixels ){
+    QByteArray header;
+    appendCard( header, "SIMPLE", "T" );
+    appendCard( header, "BITPIX", QString::number( bitpix ) );
+    appendCard( header, "NAXIS", QString::number( DIMS.size() ) );
+    for ( size_t i = 0; i < DIMS.size(); i++ ){
+        appendCard( header, QString( "NAXIS%1" ).arg( i + 1 ), QString::number( DIMS[i] ) );
+    }
+    for ( const auto& card : cards ){
+        appendCard( header, card.first, card.second );
+    }
+    header.append( QString( "END" ).leftJustified( 80, ' ' ).toLatin1() );
+    while ( header.size() % 2880 ){
+        header.append( ' ' );
+    }
+    QByteArray data = pixels;
+    while ( data.size() % 2880 ){
+        data.append( '\0' );
+    }
+    QFile file( fileName );
+    QVERIFY( file.open( QFile::WriteOnly ) );
+    QVERIFY( file.write( header ) == header.size() );
+    QVERIFY( file.write( data ) == data.size() );
+}
+
+/// the pixels of a slice read by casacore, with masked pixels as NaN
+std::vector<float> casaPixels( const QString& fileName, const CasaSlice& slice ){
+    casacore::FITSImage image( fileName.toStdString() );
+    casacore::Array<casacore::Float> values = image.getSlice( slice.start, slice.shape, slice.stride );
+    casacore::Array<casacore::Bool> mask = image.getMaskSlice( slice.start, slice.shape, slice.stride );
+    std::vector<float> result( values.begin(), values.end() );
+    std::vector<bool> good( mask.begin(), mask.end() );
+    for ( size_t i = 0; i < result.size(); i++ ){
+        if ( !good[i] ){
+            result[i] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+    return result;
+}
+
+void compare( const std::vector<float>& actual, const std::vector<float>& expected, const char* what ){
+    QVERIFY2( actual.size() == expected.size(), what );
+    for ( size_t i = 0; i < actual.size(); i++ ){
+        if ( std::isnan( expected[i] ) ){
+            QVERIFY2( std::isnan( actual[i] ), what );
+        }
+        else {
+            QVERIFY2( actual[i] == expected[i], what );
+        }
+    }
+}
+
+/// read a view in all the ways it can be read, and compare each with casacore
+void compareView( Carta::Lib::NdArray::RawViewInterface& view, const std::vector<float>& expected,
+        const casacore::IPosition& shape ){
+    std::vector<int> dims( shape.begin(), shape.end() );
+    QVERIFY( view.dims() == dims );
+
+    // buffered, with a buffer that does not hold whole rows
+    std::vector<float> buffered;
+    view.forEach( 4 * sizeof( float ), [&buffered]( const char* data, int64_t count ){
+        const float* vals = reinterpret_cast<const float*>( data );
+        buffered.insert( buffered.end(), vals, vals + count );
+    });
+    compare( buffered, expected, "buffered forEach" );
+
+    // one pixel at a time
+    std::vector<float> perPixel;
+    view.forEach( [&perPixel]( const char* data ){
+        perPixel.push_back( *reinterpret_cast<const float*>( data ) );
+    });
+    compare( perPixel, expected, "per pixel forEach" );
+
+    // chunks
+    std::vector<float> chunks;
+    std::vector<float> buff( 3 );
+    char* buffPtr = reinterpret_cast<char*>( buff.data() );
+    for ( int64_t chunk = 0; ; chunk++ ){
+        int64_t bytes = view.read( chunk, buff.size() * sizeof( float ), buffPtr );
+        if ( bytes == 0 ){
+            break;
+        }
+        chunks.insert( chunks.end(), buff.begin(), buff.begin() + bytes / sizeof( float ) );
+    }
+    compare( chunks, expected, "read" );
+
+    // random access to the last pixel
+    std::vector<int> last;
+    for ( int dim : dims ){
+        last.push_back( dim - 1 );
+    }
+    std::vector<float> lastPixel( 1, *reinterpret_cast<const float*>( view.get( last ) ) );
+    compare( lastPixel, std::vector<float>( 1, expected.back() ), "get" );
+}
+
+/// compare the full image, a strided slice and a slice of a slice with casacore
+void compareSlices( const QString& fileName ){
+    FitsMappedData::SharedPtr data = FitsMappedData::open( fileName );
+    QVERIFY( data );
+    QVERIFY( data->dims() == DIMS );
+
+    // full image
+    FitsMappedRawView full( data, SliceND().next().next().apply( DIMS ) );
+    CasaSlice fullSlice = { casacore::IPosition( 3, 0, 0, 0 ), casacore::IPosition( 3, 7, 5, 3 ),
+            casacore::IPosition( 3, 1, 1, 1 ) };
+    compareView( full, casaPixels( fileName, fullSlice ), fullSlice.shape );
+
+    // every other pixel in x and y, the last two planes
+    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> strided( full.getView(
+            SliceND().start( 1 ).step( 2 ).next().step( 2 ).next().start( 1 ) ) );
+    CasaSlice stridedSlice = { casacore::IPosition( 3, 1, 0, 1 ), casacore::IPosition( 3, 3, 3, 2 ),
+            casacore::IPosition( 3, 2, 2, 1 ) };
+    compareView( *strided, casaPixels( fileName, stridedSlice ), stridedSlice.shape );
+
+    // a slice of x = 1.., y = 1..4, then x = 1::2, y = 2 and every other plane of that
+    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> outer( full.getView(
+            SliceND().start( 1 ).next().start( 1 ).end( 5 ).next() ) );
+    std::unique_ptr<Carta::Lib::NdArray::RawViewInterface> nested( outer->getView(
+            SliceND().start( 1 ).step( 2 ).next().index( 2 ).next().step( 2 ) ) );
+    CasaSlice nestedSlice = { casacore::IPosition( 3, 2, 3, 0 ), casacore::IPosition( 3, 3, 1, 2 ),
+            casacore::IPosition( 3, 2, 1, 2 ) };
+    compareView( *nested, casaPixels( fileName, nestedSlice ), nestedSlice.shape );
+}
+
+int pixelCount(){
+    int count = 1;
+    for ( int dim : DIMS ){
+        count *= dim;
+    }
+    return count;
+}
+}
+
+void TestFitsMappedView::test_float() {
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    QString fileName = dir.path() + "/float.fits";
+
+    QByteArray pixels( pixelCount() * 4, '\0' );
+    for ( int i = 0; i < pixelCount(); i++ ){
+        float val = ( i % 11 == 4 ) ? std::numeric_limits<float>::quiet_NaN() : i * 0.25f - 10;
+        quint32 bits;
+        std::memcpy( &bits, &val, sizeof( bits ) );
+        qToBigEndian<quint32>( bits, reinterpret_cast<uchar*>( pixels.data() ) + i * 4 );
+    }
+    writeFits( fileName, -32, {}, pixels );
+    compareSlices( fileName );
+}
+
+void TestFitsMappedView::test_scaledShort() {
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    QString fileName = dir.path() + "/short.fits";
+
+    const qint16 blank = -32768;
+    QByteArray pixels( pixelCount() * 2, '\0' );
+    for ( int i = 0; i < pixelCount(); i++ ){
+        qint16 raw = ( i % 13 == 6 ) ? blank : qint16( i * 37 - 2000 );
+        qToBigEndian<qint16>( raw, reinterpret_cast<uchar*>( pixels.data() ) + i * 2 );
+    }
+    QList<QPair<QString,QString> > cards;
+    cards.append( qMakePair( QString( "BSCALE" ), QString( "0.5" ) ) );
+    cards.append( qMakePair( QString( "BZERO" ), QString( "100.0" ) ) );
+    cards.append( qMakePair( QString( "BLANK" ), QString::number( blank ) ) );
+    writeFits( fileName, 16, cards, pixels );
+    compareSlices( fileName );
+}
+
+QTEST_MAIN(TestFitsMappedView)
+#include "testFitsMappedView.moc"
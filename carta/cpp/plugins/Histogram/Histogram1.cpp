@@ -179,7 +179,7 @@ Histogram1::handleHook( BaseHook & hookData )
         QString regionId = hook.paramsPtr->regionId;
         casacore::ImageRegion* imageRegion = nullptr;
         if ( regionBase ){
-        	imageRegion = ImageRegionGenerator::makeRegion( casaImage, regionBase );
+        	imageRegion = ImageRegionGenerator::makeRegion( casaImage, regionBase, & Carta::Lib::Regions::RegionMaskCache::shared() );
         }
         m_histogram->setRegion( imageRegion, regionId  );
         m_histogram->setBinCount( hook.paramsPtr->binCount );
@@ -6,6 +6,7 @@
 #include "CartaLib/Hooks/HistogramResult.h"
 #include "CartaLib/IPlugin.h"
 #include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/RegionMask.h"
 #include "ImageHistogram.h"
 #include <QObject>
 #include <vector>
@@ -1,13 +1,15 @@
 /**
  * Produces casacore ImageRegions based on region models passed in.
+ *
+ * The region is rasterized into a mask of the pixels it contains, and handed to casacore
+ * as a pixel set over the bounding box of the mask, extended along all the other axes.
+ * Casacore then only needs to look the pixels up in the mask instead of testing each one
+ * against the shape of the region in world coordinates.
  */
 #pragma once
 
 #include <memory>
-#include <casacore/coordinates/Coordinates/CoordinateSystem.h>
-#include <casacore/casa/Arrays/Vector.h>
-#include <QString>
-#include <QRectF>
+#include <casacore/casa/aips.h>
 
 namespace casacore {
     class ImageRegion;
@@ -18,9 +20,7 @@ namespace Carta {
 	namespace Lib {
 		namespace Regions {
 			class RegionBase;
-			class Rectangle;
-			class Ellipse;
-			class Polygon;
+			class RegionMaskCache;
 		}
 	}
 }
@@ -31,25 +31,17 @@ public:
 	 * Make a casacore ImageRegion based on the image and region model passed in.
 	 * @param casaImage - an image.
 	 * @param region - a region in the image.
+	 * @param masks - the masks of recently used regions (may be null).
+	 * @return - the region or nullptr if the region does not contain any pixel of the image.
 	 */
 	static casacore::ImageRegion* makeRegion( casacore::ImageInterface<casacore::Float> * casaImage,
-			std::shared_ptr<Carta::Lib::Regions::RegionBase> region );
+			std::shared_ptr<Carta::Lib::Regions::RegionBase> region,
+			Carta::Lib::Regions::RegionMaskCache* masks = nullptr );
 
 	virtual ~ImageRegionGenerator();
 
 private:
 
-	static std::pair<casacore::Vector<casacore::Quantity>,casacore::Vector<casacore::Quantity> > _getEllipsePositionRadii(
-			Carta::Lib::Regions::Ellipse* ellipse, const casacore::CoordinateSystem &cs );
-	static casacore::ImageRegion* _makeRegionRectangle( casacore::ImageInterface<casacore::Float> * casaImage,
-			const QRectF& outlineBox);
-	static casacore::ImageRegion* _makeRegionEllipse( casacore::ImageInterface<casacore::Float> * casaImage,
-			Carta::Lib::Regions::Ellipse* ellipse);
-	static casacore::ImageRegion* _makeRegionPolygon( casacore::ImageInterface<casacore::Float> * casaImage,
-			Carta::Lib::Regions::Polygon* polygon );
-	static casacore::Vector<casacore::Double> _toWorld( const casacore::CoordinateSystem& cSys,
-			double x, double y, bool* successful );
-	const static QString RAD_UNITS;
 	ImageRegionGenerator();
 	ImageRegionGenerator( const ImageRegionGenerator& other );
 	ImageRegionGenerator operator=( const ImageRegionGenerator& other );
@@ -8,13 +8,11 @@ TEMPLATE = lib
 CONFIG += plugin
 
 SOURCES += \
-    RegionRecordFactory.cpp \
     StatisticsCASA.cpp \
     StatisticsCASAImage.cpp \
     StatisticsCASARegion.cpp
 
 HEADERS += \
-    RegionRecordFactory.h \
     StatisticsCASA.h \
     StatisticsCASAImage.h \
     StatisticsCASARegion.h
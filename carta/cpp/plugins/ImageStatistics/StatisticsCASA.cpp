@@ -11,7 +11,8 @@
 
 
 StatisticsCASA::StatisticsCASA( QObject * parent ) :
-    QObject( parent )
+    QObject( parent ),
+    m_statsCache( 10000 )
 { }
 
 
@@ -30,6 +31,10 @@ StatisticsCASA::handleHook( BaseHook & hookData ){
             return false;
         }
 
+        //Get the regions and the vector of current plane information
+        std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> > regionInfos = hook.paramsPtr->m_regionInfos;
+        std::vector<int> slice = hook.paramsPtr->m_slice;
+
         QList< QList< QList<Carta::Lib::StatInfo> > > imageResults;
         for ( int i = 0; i < imageCount; i++ ){
             std::shared_ptr<Carta::Lib::Image::ImageInterface> image = images[i];
@@ -49,14 +54,12 @@ StatisticsCASA::handleHook( BaseHook & hookData ){
             QList<Carta::Lib::StatInfo> statResultImage = StatisticsCASAImage::getStats( casaImage );
             statResults.append( statResultImage );
 
-            //Get the region statistics if there are some
-            std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> > regionInfos = hook.paramsPtr->m_regionInfos;
-            //Get the vector of current plane information
-            std::vector<int> slice = hook.paramsPtr->m_slice;
-            int regionCount = regionInfos.size();
-            for ( int i = 0; i < regionCount; i++ ){
-                QList<Carta::Lib::StatInfo> statResultRegion = StatisticsCASARegion::getStats( casaImage, regionInfos[i], slice );
-                statResults.append( statResultRegion );
+            //Get the region statistics if there are some, all of them in one pass
+            if ( !regionInfos.empty() ){
+                QList< QList<Carta::Lib::StatInfo> > statResultRegions = StatisticsCASARegion::getStats(
+                        casaImage, regionInfos, slice,
+                        Carta::Lib::Regions::RegionMaskCache::shared(), m_statsCache );
+                statResults.append( statResultRegions );
             }
 
             imageResults.append( statResults );
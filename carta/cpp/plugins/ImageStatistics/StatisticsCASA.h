@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CartaLib/IPlugin.h"
+#include "CartaLib/Regions/RegionStatistics.h"
 #include <QObject>
 
 class StatisticsCASA : public QObject, public IPlugin
@@ -26,5 +27,9 @@ public:
 
     virtual ~StatisticsCASA();
 
+private:
+
+    /// Statistics of the regions and planes used recently.
+    Carta::Lib::Regions::RegionStatisticsCache m_statsCache;
 
 };
@@ -1,161 +1,308 @@
 #include "StatisticsCASARegion.h"
 #include "StatisticsCASA.h"
-#include "RegionRecordFactory.h"
-#include "imageanalysis/ImageAnalysis/ImageStatsCalculator.h"
+#include "casacore/casa/Arrays/Array.h"
+#include "casacore/casa/Arrays/Slicer.h"
+#include "casacore/coordinates/Coordinates/CoordinateSystem.h"
+#include "casacore/coordinates/Coordinates/CoordinateUtil.h"
+#include "casacore/images/Images/ImageInfo.h"
 
 #include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+/// Approximate number of pixels read at a time.
+const int StripPixels = 4 * 1024 * 1024;
+}
 
 StatisticsCASARegion::StatisticsCASARegion() {
 }
 
 
-QList<Carta::Lib::StatInfo>
+QList<QList<Carta::Lib::StatInfo> >
 StatisticsCASARegion::getStats(
         casacore::ImageInterface<casacore::Float>* image,
-        std::shared_ptr<Carta::Lib::Regions::RegionBase> regionInfo,
-        const std::vector<int>& slice ){
-    QList<Carta::Lib::StatInfo> stats;
-    QString regionTypeStr;
-    casacore::Record regionRecord = RegionRecordFactory:: getRegionRecord(
-            image, regionInfo, slice, regionTypeStr );
-    _getStatsFromCalculator( image, regionRecord, slice, stats, regionTypeStr );
-    return stats;
-}
+        const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regionInfos,
+        const std::vector<int>& slice, Carta::Lib::Regions::RegionMaskCache& masks,
+        Carta::Lib::Regions::RegionStatisticsCache& cache ){
+    int regionCount = regionInfos.size();
+    QList<QList<Carta::Lib::StatInfo> > results;
+    for ( int i = 0; i < regionCount; i++ ){
+        results.append( QList<Carta::Lib::StatInfo>() );
+    }
 
+    //Do a quick check to make sure the slice is actually in the image.
+    casacore::IPosition shape = image->shape();
+    int dims = shape.nelements();
+    if ( static_cast<int>( slice.size() ) != dims ){
+        //Slice does not match image shape.
+        return results;
+    }
+    for ( int i = 0; i < dims; i++ ){
+        if ( slice[i] >= shape[i] ){
+            //Slice is not in image;
+            return results;
+        }
+    }
+    const casacore::CoordinateSystem& cs = image->coordinates();
+    int directionIndex = cs.findCoordinate( casacore::Coordinate::DIRECTION );
+    if ( directionIndex < 0 ){
+        qDebug() << "Region statistics: image has no direction coordinate";
+        return results;
+    }
+    casacore::Vector<casacore::Int> dirPixelAxis = cs.pixelAxes( directionIndex );
+    const int xAxis = dirPixelAxis[0];
+    const int yAxis = dirPixelAxis[1];
 
-void StatisticsCASARegion::_getStatsFromCalculator( casacore::ImageInterface<casacore::Float>* image,
-       const casacore::Record& region, const std::vector<int>& slice,
-       QList<Carta::Lib::StatInfo>& stats, const QString& regionType ){
-    //If the region record is empty, there are not stats - just return.
-    int fieldCount = region.nfields();
-    if ( fieldCount == 0 ){
-        return;
+    //Look up the statistics of the regions that did not change, and compute the
+    //statistics of all the other regions in one pass over the plane.
+    const QString imageId( image->name().c_str() );
+    std::vector<Carta::Lib::Regions::RegionMask::ConstSharedPtr> regionMasks( regionCount );
+    std::vector<QByteArray> revisions( regionCount );
+    std::vector<Carta::Lib::Regions::RegionStatistics> regionStats( regionCount );
+    std::vector<Carta::Lib::Regions::RegionMask::ConstSharedPtr> missingMasks;
+    std::vector<int> missing;
+    for ( int i = 0; i < regionCount; i++ ){
+        if ( !regionInfos[i] ){
+            continue;
+        }
+        regionMasks[i] = masks.mask( *regionInfos[i], shape(xAxis), shape(yAxis) );
+        revisions[i] = Carta::Lib::Regions::RegionMask::revision( *regionInfos[i] );
+        if ( !regionMasks[i]->isEmpty() &&
+                !cache.find( imageId, revisions[i], slice, regionStats[i] ) ){
+            missing.push_back( i );
+            missingMasks.push_back( regionMasks[i] );
+        }
+    }
+    if ( !missing.empty() ){
+        std::vector<Carta::Lib::Regions::RegionStatistics> computed;
+        if ( !_computeStats( image, missingMasks, slice, xAxis, yAxis, computed ) ){
+            return results;
+        }
+        int missingCount = missing.size();
+        for ( int i = 0; i < missingCount; i++ ){
+            regionStats[missing[i]] = computed[i];
+            cache.insert( imageId, revisions[missing[i]], slice, computed[i] );
+        }
     }
-    //std::shared_ptr<const casacore::ImageInterface<casacore::Float> > imagePtr( image->cloneII() );
 
-    casacore::CoordinateSystem cs = image->coordinates();
-    casacore::Vector<casacore::Int> displayAxes = cs.directionAxesNumbers();
-    casacore::Quantum<casacore::Double> pix0( 0, "pix");
-    casacore::IPosition shape = image->shape();
-    int nAxes = shape.nelements();
-    casacore::Vector<casacore::Quantum<casacore::Double> > blcq( nAxes, pix0);
-    casacore::Vector<casacore::Quantum<casacore::Double> > trcq( nAxes, pix0);
-    for ( int i = 0; i < nAxes; i++ ){
-        if ( i == displayAxes[0] || i == displayAxes[1]){
-            trcq[i].setValue( shape[i] - 1 );
+    for ( int i = 0; i < regionCount; i++ ){
+        if ( !regionMasks[i] || regionMasks[i]->isEmpty() ){
+            continue;
         }
-        else {
-            // select the current spectral or stoke channel
-            blcq[i].setValue( slice[i] );
-            trcq[i].setValue( slice[i] );
+        QString regionType = regionInfos[i]->typeName();
+        if ( !regionType.isEmpty() ){
+            regionType[0] = regionType[0].toUpper();
+        }
+        try {
+            _insertStats( image, regionStats[i], regionMasks[i]->boundingRect(), slice,
+                    xAxis, yAxis, regionType, results[i] );
+        }
+        catch( const casacore::AipsError& error ){
+            qWarning() << "Could not format region statistics: " << error.getMesg().c_str();
         }
     }
+    return results;
+}
 
-    /**
-     * We get Rectangle, Polygon, Ellipse or Point region first.
-     * Rectangle and Point objects can select the range of spectral or stoke channel (frame),
-     * by default we select the current channel. They are defined in the "RegionRecordFactory.cpp".
-     * On the other hand, Polygon and Ellipse objects can not select the range of spectral or stoke channel.
-     * So we need the second stage of the box region process,
-     * which is used to select the range of spectral or stoke channel.
-     */
-    casacore::WCBox box( blcq, trcq, cs, casacore::Vector<casacore::Int>());
-    casacore::ImageRegion* imgBox = new casacore::ImageRegion( box );
-    std::shared_ptr<casacore::SubImage<casacore::Float> > boxImage( new casacore::SubImage<Float>(*image, *imgBox ) );
-
-    casa::ImageStatsCalculator calc( boxImage, &region, "", true);
-    calc.setList(false);
-    Record result = calc.calculate();
-    const casacore::String blcKey( "blc");
-    const casacore::String trcKey( "trc");
-    _insertScalar( result, "npts", Carta::Lib::StatInfo::StatType::FrameCount, stats );
-    _insertScalar( result, "sum", Carta::Lib::StatInfo::StatType::Sum, stats );
-    _insertScalar( result, "sumsq", Carta::Lib::StatInfo::StatType::SumSq, stats );
-    _insertScalar( result, "min", Carta::Lib::StatInfo::StatType::Min, stats );
-    _insertScalar( result, "max", Carta::Lib::StatInfo::StatType::Max, stats );
-    _insertScalar( result, "mean", Carta::Lib::StatInfo::StatType::Mean, stats );
-    _insertScalar( result, "sigma", Carta::Lib::StatInfo::StatType::Sigma, stats );
-    _insertScalar( result, "rms", Carta::Lib::StatInfo::StatType::RMS, stats );
-    _insertScalar( result, "flux", Carta::Lib::StatInfo::StatType::FluxDensity, stats );
-    _insertList( result, blcKey, Carta::Lib::StatInfo::StatType::Blc, stats, slice );
-    _insertList( result, trcKey, Carta::Lib::StatInfo::StatType::Trc, stats, slice );
-    _insertList( result, "minpos", Carta::Lib::StatInfo::StatType::MinPos, stats, slice );
-    _insertList( result, "maxpos", Carta::Lib::StatInfo::StatType::MaxPos, stats, slice );
-    _insertString( result, "blcf", Carta::Lib::StatInfo::StatType::Blcf, stats );
-    _insertString( result, "trcf", Carta::Lib::StatInfo::StatType::Trcf, stats );
-    _insertString( result, "minposf", Carta::Lib::StatInfo::StatType::MinPosf, stats );
-    _insertString( result, "maxposf", Carta::Lib::StatInfo::StatType::MaxPosf, stats );
 
-    //Put in an identifier.
-    if ( result.isDefined( blcKey ) && result.isDefined( trcKey ) ){
-        casacore::Vector<int> blcArray = result.asArrayInt( blcKey );
-        QString blcVal = _vectorToString( blcArray, slice );
-        casacore::Vector<int> trcArray = result.asArrayInt( trcKey );
-        QString trcVal = _vectorToString( trcArray, slice );
-        QString idVal = regionType + ": ";
-        // Note: It is meaningless to show the statistics for a "Point" region, this may need to correct in future.
-        if ( blcVal != trcVal ){
-            idVal = idVal + blcVal + " -> " + trcVal;
+bool StatisticsCASARegion::_computeStats( casacore::ImageInterface<casacore::Float>* image,
+        const std::vector<Carta::Lib::Regions::RegionMask::ConstSharedPtr>& masks,
+        const std::vector<int>& slice, int xAxis, int yAxis,
+        std::vector<Carta::Lib::Regions::RegionStatistics>& stats ){
+    Carta::Lib::Regions::RegionStatisticsReducer reducer( masks );
+    QRect box = reducer.boundingRect();
+    const int width = box.width();
+
+    //Read strips of whole rows of tiles, starting at a tile boundary.
+    const int tileRows = std::max( 1, static_cast<int>( image->niceCursorShape()( yAxis ) ) );
+    const int stripRows = std::max( 1, StripPixels / width / tileRows ) * tileRows;
+    int dims = slice.size();
+    casacore::IPosition start( dims, 0 );
+    casacore::IPosition length( dims, 1 );
+    for ( int i = 0; i < dims; i++ ){
+        if ( i != xAxis && i != yAxis ){
+            start(i) = slice[i];
         }
-        Carta::Lib::StatInfo info( Carta::Lib::StatInfo::StatType::Name );
-        info.setValue( idVal );
-        info.setImageStat( false );
-        stats.append( info );
     }
+    start(xAxis) = box.left();
+    length(xAxis) = width;
+
+    //The values of the strip with the columns of the masks first, if they are not in that
+    //order in the image or some pixels are masked.
+    const bool swapped = xAxis > yAxis;
+    const bool masked = image->isMasked();
+    std::vector<float> strip;
+    try {
+        for ( int y0 = box.top() - box.top() % tileRows; y0 <= box.bottom(); y0 += stripRows ){
+            const int firstRow = std::max( y0, box.top() );
+            const int rows = std::min( y0 + stripRows, box.bottom() + 1 ) - firstRow;
+            start(yAxis) = firstRow;
+            length(yAxis) = rows;
+            casacore::Slicer slicer( start, length );
+            casacore::Array<casacore::Float> data;
+            image->getSlice( data, slicer, false );
+            bool deleteData = false;
+            const casacore::Float* values = data.getStorage( deleteData );
+            if ( !swapped && !masked ){
+                reducer.add( firstRow, rows, values );
+            }
+            else {
+                casacore::Array<casacore::Bool> pixelMask;
+                bool deleteMask = false;
+                const casacore::Bool* flags = nullptr;
+                if ( masked ){
+                    image->getMaskSlice( pixelMask, slicer, false );
+                    flags = pixelMask.getStorage( deleteMask );
+                }
+                strip.resize( static_cast<size_t>( rows ) * width );
+                for ( int r = 0; r < rows; r++ ){
+                    for ( int c = 0; c < width; c++ ){
+                        size_t index = swapped ? static_cast<size_t>( c ) * rows + r :
+                                static_cast<size_t>( r ) * width + c;
+                        strip[static_cast<size_t>( r ) * width + c] = ( !flags || flags[index] ) ?
+                                values[index] : std::numeric_limits<float>::quiet_NaN();
+                    }
+                }
+                if ( flags ){
+                    pixelMask.freeStorage( flags, deleteMask );
+                }
+                reducer.add( firstRow, rows, strip.data() );
+            }
+            data.freeStorage( values, deleteData );
+        }
+    }
+    catch( const casacore::AipsError& error ){
+        qWarning() << "Could not read the region statistics data: " << error.getMesg().c_str();
+        return false;
+    }
+    stats = reducer.result();
+    return true;
 }
 
 
+bool StatisticsCASARegion::_getFlux( casacore::ImageInterface<casacore::Float>* image,
+        const std::vector<int>& slice, double sum, double& flux ){
+    QString unit( image->units().getName().c_str() );
+    if ( unit.compare( "Jy/pixel", Qt::CaseInsensitive ) == 0 ){
+        flux = sum;
+        return true;
+    }
+    if ( unit.compare( "Jy/beam", Qt::CaseInsensitive ) != 0 ){
+        return false;
+    }
+    const casacore::ImageInfo& info = image->imageInfo();
+    const casacore::CoordinateSystem& cs = image->coordinates();
+    if ( !info.hasBeam() || !cs.hasDirectionCoordinate() ){
+        return false;
+    }
+    //The beam of the current channel and stokes, if there is one per plane.
+    int spectralAxis = cs.spectralAxisNumber();
+    int stokesAxis = cs.polarizationAxisNumber();
+    int channel = spectralAxis >= 0 ? slice[spectralAxis] : 0;
+    int stokes = stokesAxis >= 0 ? slice[stokesAxis] : 0;
+    double beamArea = info.getBeamAreaInPixels( channel, stokes, cs.directionCoordinate() );
+    if ( beamArea <= 0 ){
+        return false;
+    }
+    flux = sum / beamArea;
+    return true;
+}
 
-void
-StatisticsCASARegion::_insertList( const casacore::Record& result, const casacore::String& key,
-        Carta::Lib::StatInfo::StatType statType, QList<Carta::Lib::StatInfo>& stats,
-        const std::vector<int>& slice ){
-    if ( result.isDefined( key) ){
-        casacore::Vector<int> valArray = result.asArrayInt( key );
-        QString val = _vectorToString( valArray, slice );
-        if ( !val.isEmpty()){
-            Carta::Lib::StatInfo info( statType );
-            info.setValue( val );
-            stats.append( info );
-        }
+
+casacore::IPosition StatisticsCASARegion::_getPosition( int x, int y, const std::vector<int>& slice,
+        int xAxis, int yAxis ){
+    int dims = slice.size();
+    casacore::IPosition pos( dims );
+    for ( int i = 0; i < dims; i++ ){
+        pos(i) = slice[i];
     }
+    pos(xAxis) = x;
+    pos(yAxis) = y;
+    return pos;
 }
 
 
-void
-StatisticsCASARegion::_insertScalar( const casacore::Record& result, const casacore::String& key,
-        Carta::Lib::StatInfo::StatType statType, QList<Carta::Lib::StatInfo>& stats ){
-    if ( result.isDefined( key ) ){
-        casacore::Vector<double> valArray = result.asArrayDouble(key);
-        if ( valArray.nelements() > 0 ){
-            Carta::Lib::StatInfo info( statType );
-            info.setValue( QString::number( valArray[0] ) );
-            stats.append( info );
+void StatisticsCASARegion::_insertStats( casacore::ImageInterface<casacore::Float>* image,
+        const Carta::Lib::Regions::RegionStatistics& regionStats, const QRect& box,
+        const std::vector<int>& slice, int xAxis, int yAxis, const QString& regionType,
+        QList<Carta::Lib::StatInfo>& stats ){
+    const casacore::CoordinateSystem& cs = image->coordinates();
+    const bool hasValues = regionStats.count > 0;
+    casacore::IPosition blc = _getPosition( box.left(), box.top(), slice, xAxis, yAxis );
+    casacore::IPosition trc = _getPosition( box.right(), box.bottom(), slice, xAxis, yAxis );
+    casacore::IPosition minPos = _getPosition( regionStats.minX, regionStats.minY, slice, xAxis, yAxis );
+    casacore::IPosition maxPos = _getPosition( regionStats.maxX, regionStats.maxY, slice, xAxis, yAxis );
+
+    _insertScalar( regionStats.count, Carta::Lib::StatInfo::StatType::FrameCount, stats );
+    _insertScalar( regionStats.sum, Carta::Lib::StatInfo::StatType::Sum, stats );
+    _insertScalar( regionStats.sumSq, Carta::Lib::StatInfo::StatType::SumSq, stats );
+    if ( hasValues ){
+        _insertScalar( regionStats.min, Carta::Lib::StatInfo::StatType::Min, stats );
+        _insertScalar( regionStats.max, Carta::Lib::StatInfo::StatType::Max, stats );
+        _insertScalar( regionStats.mean(), Carta::Lib::StatInfo::StatType::Mean, stats );
+        _insertScalar( regionStats.sigma(), Carta::Lib::StatInfo::StatType::Sigma, stats );
+        _insertScalar( regionStats.rms(), Carta::Lib::StatInfo::StatType::RMS, stats );
+        double flux = 0;
+        if ( _getFlux( image, slice, regionStats.sum, flux ) ){
+            _insertScalar( flux, Carta::Lib::StatInfo::StatType::FluxDensity, stats );
         }
     }
+    QString blcVal = _vectorToString( blc );
+    QString trcVal = _vectorToString( trc );
+    _insertString( blcVal, Carta::Lib::StatInfo::StatType::Blc, stats );
+    _insertString( trcVal, Carta::Lib::StatInfo::StatType::Trc, stats );
+    if ( hasValues ){
+        _insertString( _vectorToString( minPos ), Carta::Lib::StatInfo::StatType::MinPos, stats );
+        _insertString( _vectorToString( maxPos ), Carta::Lib::StatInfo::StatType::MaxPos, stats );
+    }
+    _insertString( casacore::CoordinateUtil::formatCoordinate( blc, cs ).c_str(),
+            Carta::Lib::StatInfo::StatType::Blcf, stats );
+    _insertString( casacore::CoordinateUtil::formatCoordinate( trc, cs ).c_str(),
+            Carta::Lib::StatInfo::StatType::Trcf, stats );
+    if ( hasValues ){
+        _insertString( casacore::CoordinateUtil::formatCoordinate( minPos, cs ).c_str(),
+                Carta::Lib::StatInfo::StatType::MinPosf, stats );
+        _insertString( casacore::CoordinateUtil::formatCoordinate( maxPos, cs ).c_str(),
+                Carta::Lib::StatInfo::StatType::MaxPosf, stats );
+    }
+
+    //Put in an identifier.
+    QString idVal = regionType + ": ";
+    // Note: It is meaningless to show the statistics for a "Point" region, this may need to correct in future.
+    if ( blcVal != trcVal ){
+        idVal = idVal + blcVal + " -> " + trcVal;
+    }
+    Carta::Lib::StatInfo info( Carta::Lib::StatInfo::StatType::Name );
+    info.setValue( idVal );
+    info.setImageStat( false );
+    stats.append( info );
 }
 
+
 void
-StatisticsCASARegion::_insertString( const casacore::Record& result, const casacore::String& key,
-        Carta::Lib::StatInfo::StatType statType, QList<Carta::Lib::StatInfo>& stats ){
-    if ( result.isDefined( key ) ){
-        casacore::String valStr = result.asString(key);
+StatisticsCASARegion::_insertScalar( double value, Carta::Lib::StatInfo::StatType statType,
+        QList<Carta::Lib::StatInfo>& stats ){
+    Carta::Lib::StatInfo info( statType );
+    info.setValue( QString::number( value ) );
+    stats.append( info );
+}
+
+void
+StatisticsCASARegion::_insertString( const QString& value, Carta::Lib::StatInfo::StatType statType,
+        QList<Carta::Lib::StatInfo>& stats ){
+    if ( !value.isEmpty() ){
         Carta::Lib::StatInfo info( statType );
-        info.setValue( valStr.c_str() );
+        info.setValue( value );
         stats.append( info );
     }
 }
 
-QString StatisticsCASARegion::_vectorToString( const casacore::Vector<int>& valArray,
-        const std::vector<int>& slice ){
+QString StatisticsCASARegion::_vectorToString( const casacore::IPosition& valArray ){
     int elementCount = valArray.nelements();
     QString val("[");
     for ( int i = 0; i < elementCount; i++ ){
-        if ( slice[i] == -1 ) {
-            val = val + QString::number(valArray[i]);
-        } else {
-            val = val + QString::number(slice[i]);
-        }
+        val = val + QString::number( valArray(i) );
         if ( i < elementCount - 1 ){
             val = val + ", ";
         }
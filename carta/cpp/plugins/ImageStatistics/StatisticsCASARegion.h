@@ -1,47 +1,81 @@
 /**
- * Generates statistics for a region of an image.
+ * Generates statistics for the regions of an image.
+ *
+ * The regions are rasterized into masks, and the statistics of all the regions that
+ * are not cached yet are computed in a single pass over the rows of the current plane.
  */
 
 #pragma once
 
-#include <QMap>
+#include <QList>
+#include <QRect>
 #include <QString>
 
 #include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/RegionStatistics.h"
 #include "CartaLib/StatInfo.h"
 #include "casacore/images/Images/ImageInterface.h"
-#include "casacore/casa/Containers/Record.h"
 
 class StatisticsCASARegion {
 
 public:
 
     /**
-     * Returns a map of (key,value) pairs representing the statistics of the specified region
+     * Returns lists of (key,value) pairs representing the statistics of the specified regions
      * in the specified image.
      * @param image - a specified image.
-     * @param regionInfo - a specified region.
+     * @param regionInfos - the regions.
      * @param slice - information about the frames that are selected on the image.
-     * @return - a map of (key,value) pairs which are the statistics for the region in the
-     *      image.
+     * @param masks - the masks of recently used regions.
+     * @param cache - the statistics of recently used regions and planes.
+     * @return - a list of (key,value) pairs for each region, in the order of the regions; the
+     *      list is empty if the region does not contain any pixel of the image.
      */
-    static QList<Carta::Lib::StatInfo>
-    getStats( casacore::ImageInterface<casacore::Float>* image, std::shared_ptr<Carta::Lib::Regions::RegionBase> regionInfo,
-            const std::vector<int>& slice );
+    static QList<QList<Carta::Lib::StatInfo> >
+    getStats( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<std::shared_ptr<Carta::Lib::Regions::RegionBase> >& regionInfos,
+            const std::vector<int>& slice, Carta::Lib::Regions::RegionMaskCache& masks,
+            Carta::Lib::Regions::RegionStatisticsCache& cache );
 private:
     StatisticsCASARegion();
-    static void _getStatsFromCalculator( casacore::ImageInterface<casacore::Float>* image,
-           const casacore::Record& region, const std::vector<int>& slice,
-           QList<Carta::Lib::StatInfo>& stats, const QString& typeStr );
-
-    static void _insertScalar( const casacore::Record& result, const casacore::String& key,
-            Carta::Lib::StatInfo::StatType statType, QList<Carta::Lib::StatInfo>& stats );
-    static void _insertList(const casacore::Record& result, const casacore::String& key,
-            Carta::Lib::StatInfo::StatType statType, QList<Carta::Lib::StatInfo>& stats,
-            const std::vector<int> &slice);
-    static void _insertString( const casacore::Record& result, const casacore::String& key,
-            Carta::Lib::StatInfo::StatType statType, QList<Carta::Lib::StatInfo>& stats );
-    static QString _vectorToString(const casacore::Vector<int>& valArray, const std::vector<int> &slice);
+
+    /**
+     * Computes the statistics of the regions in a single pass over the rows of the plane.
+     * @param image - a specified image.
+     * @param masks - the masks of the regions in the plane.
+     * @param slice - information about the frames that are selected on the image.
+     * @param xAxis - the image axis of the columns of the masks.
+     * @param yAxis - the image axis of the rows of the masks.
+     * @param stats - set to the statistics of the regions, in the order of the masks.
+     * @return - true if the data could be read; false otherwise.
+     */
+    static bool _computeStats( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<Carta::Lib::Regions::RegionMask::ConstSharedPtr>& masks,
+            const std::vector<int>& slice, int xAxis, int yAxis,
+            std::vector<Carta::Lib::Regions::RegionStatistics>& stats );
+
+    /**
+     * Computes the flux density of a sum of pixel values.
+     * @param image - a specified image.
+     * @param slice - information about the frames that are selected on the image.
+     * @param sum - the sum of the pixel values.
+     * @param flux - set to the flux density.
+     * @return - true if the brightness unit of the image allows a flux density; false otherwise.
+     */
+    static bool _getFlux( casacore::ImageInterface<casacore::Float>* image,
+            const std::vector<int>& slice, double sum, double& flux );
+
+    static void _insertStats( casacore::ImageInterface<casacore::Float>* image,
+            const Carta::Lib::Regions::RegionStatistics& regionStats, const QRect& box,
+            const std::vector<int>& slice, int xAxis, int yAxis, const QString& regionType,
+            QList<Carta::Lib::StatInfo>& stats );
+    static void _insertScalar( double value, Carta::Lib::StatInfo::StatType statType,
+            QList<Carta::Lib::StatInfo>& stats );
+    static void _insertString( const QString& value, Carta::Lib::StatInfo::StatType statType,
+            QList<Carta::Lib::StatInfo>& stats );
+    static casacore::IPosition _getPosition( int x, int y, const std::vector<int>& slice,
+            int xAxis, int yAxis );
+    static QString _vectorToString( const casacore::IPosition& valArray );
 
     virtual ~StatisticsCASARegion();
 
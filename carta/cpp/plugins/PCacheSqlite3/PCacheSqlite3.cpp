@@ -3,12 +3,20 @@
 #include <QDebug>
 #include <QtSql>
 #include <QDir>
+#include <QHash>
+#include <algorithm>
 
 typedef Carta::Lib::Hooks::GetPersistentCache GetPersistentCacheHook;
 
 ///
 /// Implementation of IPCache using sqlite
 ///
+/// Every key has a single row (later values replace earlier ones) in a table indexed by
+/// key, so lookups do not scan the table. The size of every row and the time it was
+/// last used are recorded, and the least recently used rows are evicted when the total
+/// size exceeds the maximum storage. The database runs in WAL mode and the batched
+/// accessors run in a single transaction with statements that are prepared only once.
+///
 class SqLitePCache : public Carta::Lib::IPCache
 {
 public:
@@ -16,19 +24,27 @@ public:
     virtual uint64_t
     maxStorage() override
     {
-        return 1;
+        return m_maxStorage;
     }
 
     virtual uint64_t
     usedStorage() override
     {
-        return 1;
+        return m_usedStorage;
     }
 
     virtual uint64_t
     nEntries() override
     {
-        return 1;
+        if ( ! m_db.isOpen() ) {
+            return 0;
+        }
+        QSqlQuery query( m_db );
+        if ( ! query.exec( "SELECT COUNT(*) FROM entries" ) || ! query.next() ) {
+            qWarning() << "Count query failed:" << query.lastError().text();
+            return 0;
+        }
+        return query.value( 0 ).toULongLong();
     }
 
     virtual void
@@ -38,11 +54,12 @@ public:
             return;
         }
         QSqlQuery query( m_db );
-        query.prepare( "DELETE FROM db;" );
-
-        if ( ! query.exec() ) {
+        if ( ! query.exec( "DELETE FROM entries" ) ) {
             qWarning() << "Delete query failed.";
+            return;
         }
+        m_usedStorage = 0;
+        m_touched.clear();
     } // deleteAll
 
     virtual bool
@@ -51,23 +68,7 @@ public:
         if ( ! m_db.isOpen() ) {
             return false;
         }
-        QSqlQuery query( m_db );
-        //query.prepare( "SELECT val FROM db WHERE key = :key" );
-
-        // choose "val" and "error" with the minimum "error" for the specific "key"
-        query.prepare( "SELECT val,error FROM db WHERE key = :key ORDER BY error ASC LIMIT 1" );
-        query.bindValue( ":key", key );
-
-        if ( ! query.exec() ) {
-            qWarning() << "Select query failed.";
-            return false;
-        }
-        if ( query.next() ) {
-            val = query.value( 0 ).toByteArray();
-            error = query.value( 1 ).toByteArray();
-            return true;
-        }
-        return false;
+        return _read( key, val, error );
     } // readEntry
 
     virtual void
@@ -76,32 +77,48 @@ public:
         if ( ! m_db.isOpen() ) {
             return;
         }
+        m_db.transaction();
+        _write( key, val, error );
+        m_db.commit();
+        _evictIfNeeded();
+    } // setEntry
 
-        //Q_UNUSED( priority );
-        QSqlQuery query( m_db );
-        //query.prepare( "INSERT OR REPLACE INTO db (key, val) VALUES ( :key, :val )" );
-
-        // add a new value "error" in the row
-        query.prepare( "INSERT INTO db (key, val, error) VALUES (:key, :val, :error)" );
-
-        query.bindValue( ":key", key );
-        query.bindValue( ":val", val );
-        query.bindValue( ":error", error );
+    virtual void
+    readEntries( std::vector < Entry > & entries ) override
+    {
+        if ( ! m_db.isOpen() ) {
+            return;
+        }
+        m_db.transaction();
+        for ( Entry & entry : entries ) {
+            entry.found = _read( entry.key, entry.val, entry.error );
+        }
+        m_db.commit();
+    } // readEntries
 
-        if ( ! query.exec() ) {
-            qWarning() << "Insert query failed:" << query.lastError().text();
+    virtual void
+    setEntries( const std::vector < Entry > & entries ) override
+    {
+        if ( ! m_db.isOpen() ) {
+            return;
         }
-    } // setEntry
+        m_db.transaction();
+        for ( const Entry & entry : entries ) {
+            _write( entry.key, entry.val, entry.error );
+        }
+        m_db.commit();
+        _evictIfNeeded();
+    } // setEntries
 
     static
     Carta::Lib::IPCache::SharedPtr
-    getCacheSingleton( QString dirPath)
+    getCacheSingleton( QString dirPath, uint64_t maxStorage )
     {
         if ( m_cachePtr ) {
             qCritical() << "PCacheSQlite3Plugin::Calling GetPersistentCacheHook multiple times!!!";
         }
         else {
-            m_cachePtr.reset( new SqLitePCache( dirPath) );
+            m_cachePtr.reset( new SqLitePCache( dirPath, maxStorage ) );
         }
         return m_cachePtr;
     }
@@ -113,36 +130,230 @@ public:
 
     ~SqLitePCache()
     {
+        if ( m_db.isOpen() ) {
+            _flushTouched();
+        }
+
+        // prepared queries have to be released before the database is closed
+        m_readQuery = QSqlQuery();
+        m_sizeQuery = QSqlQuery();
+        m_writeQuery = QSqlQuery();
+        m_touchQuery = QSqlQuery();
         m_db.close();
     }
 
 private:
 
-    SqLitePCache( QString dirPath)
+    SqLitePCache( QString dirPath, uint64_t maxStorage )
     {
+        m_maxStorage = maxStorage;
         m_db = QSqlDatabase::addDatabase( "QSQLITE" );
 
         m_db.setDatabaseName( dirPath );
         bool ok = m_db.open();
         if ( ! ok ) {
             qCritical() << "Could not open sqlite database at location" << dirPath;
+            return;
         }
 
         QSqlQuery query( m_db );
 
-        //query.prepare( "CREATE TABLE IF NOT EXISTS db (key TEXT PRIMARY KEY, val BLOB)" );
-
-        // allow to insert rows with the same "key TEXT" but may have different errors
-        query.prepare( "CREATE TABLE IF NOT EXISTS db (key TEXT, val BLOB, error BLOB)" );
+        // readers do not block the writer (and vice versa) in WAL mode, and a commit
+        // does not need to wait for the disk
+        if ( ! query.exec( "PRAGMA journal_mode=WAL" ) ) {
+            qWarning() << "Could not switch to WAL journal:" << query.lastError().text();
+        }
+        query.exec( "PRAGMA synchronous=NORMAL" );
 
-        if ( ! query.exec() ) {
+        // one row per key; 'used' orders the rows by the time of last use
+        if ( ! query.exec( "CREATE TABLE IF NOT EXISTS entries "
+                           "(key BLOB PRIMARY KEY, val BLOB, error BLOB, size INTEGER, used INTEGER)" ) ) {
             qCritical() << "Create table query failed:" << query.lastError().text();
         }
+        if ( ! query.exec( "CREATE INDEX IF NOT EXISTS entries_used ON entries (used)" ) ) {
+            qCritical() << "Create index query failed:" << query.lastError().text();
+        }
+        _migrate();
+
+        // continue the clock and the accounting where they were left
+        if ( query.exec( "SELECT IFNULL(MAX(used),0), IFNULL(SUM(size),0) FROM entries" ) && query.next() ) {
+            m_clock = query.value( 0 ).toLongLong();
+            m_usedStorage = query.value( 1 ).toULongLong();
+        }
+        query.finish();
+
+        m_readQuery = QSqlQuery( m_db );
+        m_readQuery.prepare( "SELECT val, error FROM entries WHERE key = ?" );
+        m_sizeQuery = QSqlQuery( m_db );
+        m_sizeQuery.prepare( "SELECT size FROM entries WHERE key = ?" );
+        m_writeQuery = QSqlQuery( m_db );
+        m_writeQuery.prepare( "INSERT OR REPLACE INTO entries (key, val, error, size, used) "
+                              "VALUES (?, ?, ?, ?, ?)" );
+        m_touchQuery = QSqlQuery( m_db );
+        m_touchQuery.prepare( "UPDATE entries SET used = ? WHERE key = ?" );
+
+        _evictIfNeeded();
     }
 
+    /// move the rows of the old table (several rows per key) into the new one, keeping
+    /// the row that readEntry() used to return for each key
+    void
+    _migrate()
+    {
+        QSqlQuery query( m_db );
+        if ( ! query.exec( "SELECT name FROM sqlite_master WHERE type='table' AND name='db'" ) ||
+             ! query.next() ) {
+            return;
+        }
+        query.finish();
+        m_db.transaction();
+        bool ok = query.exec( "INSERT OR IGNORE INTO entries (key, val, error, size, used) "
+                              "SELECT key, val, error, "
+                              "IFNULL(LENGTH(key),0) + IFNULL(LENGTH(val),0) + IFNULL(LENGTH(error),0), 0 "
+                              "FROM db ORDER BY error ASC" ) &&
+                  query.exec( "DROP TABLE db" );
+        if ( ok ) {
+            m_db.commit();
+        }
+        else {
+            qWarning() << "Could not migrate the old cache table:" << query.lastError().text();
+            m_db.rollback();
+        }
+    } // _migrate
+
+    bool
+    _read( const QByteArray & key, QByteArray & val, QByteArray & error )
+    {
+        m_readQuery.addBindValue( key );
+        if ( ! m_readQuery.exec() ) {
+            qWarning() << "Select query failed.";
+            return false;
+        }
+        bool found = m_readQuery.next();
+        if ( found ) {
+            val = m_readQuery.value( 0 ).toByteArray();
+            error = m_readQuery.value( 1 ).toByteArray();
+
+            // remember the use, it is written out together with other uses
+            m_touched[key] = ++ m_clock;
+        }
+        m_readQuery.finish();
+        if ( m_touched.size() >= TOUCH_BATCH ) {
+            _flushTouched();
+        }
+        return found;
+    } // _read
+
+    void
+    _write( const QByteArray & key, const QByteArray & val, const QByteArray & error )
+    {
+        // the replaced row no longer counts
+        m_sizeQuery.addBindValue( key );
+        if ( m_sizeQuery.exec() && m_sizeQuery.next() ) {
+            m_usedStorage -= std::min < uint64_t > ( m_usedStorage, m_sizeQuery.value( 0 ).toULongLong() );
+        }
+        m_sizeQuery.finish();
+
+        const qint64 size = key.size() + val.size() + error.size();
+        m_writeQuery.addBindValue( key );
+        m_writeQuery.addBindValue( val );
+        m_writeQuery.addBindValue( error );
+        m_writeQuery.addBindValue( size );
+        m_writeQuery.addBindValue( ++ m_clock );
+        if ( ! m_writeQuery.exec() ) {
+            qWarning() << "Insert query failed:" << m_writeQuery.lastError().text();
+            return;
+        }
+        m_usedStorage += size;
+        m_touched.remove( key );
+    } // _write
+
+    void
+    _flushTouched()
+    {
+        if ( m_touched.isEmpty() ) {
+            return;
+        }
+        bool own = m_db.transaction();
+        for ( auto it = m_touched.constBegin() ; it != m_touched.constEnd() ; ++it ) {
+            m_touchQuery.addBindValue( it.value() );
+            m_touchQuery.addBindValue( it.key() );
+            if ( ! m_touchQuery.exec() ) {
+                qWarning() << "Update query failed:" << m_touchQuery.lastError().text();
+            }
+        }
+        if ( own ) {
+            m_db.commit();
+        }
+        m_touched.clear();
+    } // _flushTouched
+
+    /// remove the least recently used entries until the used storage is below 90%
+    /// of the maximum
+    void
+    _evictIfNeeded()
+    {
+        if ( m_maxStorage == 0 || m_usedStorage <= m_maxStorage ) {
+            return;
+        }
+        _flushTouched();
+        const uint64_t target = m_maxStorage / 10 * 9;
+        m_db.transaction();
+        QSqlQuery select( m_db );
+        select.prepare( "SELECT key, size FROM entries ORDER BY used ASC LIMIT 256" );
+        QSqlQuery remove( m_db );
+        remove.prepare( "DELETE FROM entries WHERE key = ?" );
+        while ( m_usedStorage > target ) {
+            if ( ! select.exec() ) {
+                qWarning() << "Eviction query failed:" << select.lastError().text();
+                break;
+            }
+            QList < QPair < QByteArray, uint64_t > > oldest;
+            while ( select.next() ) {
+                oldest.append( qMakePair( select.value( 0 ).toByteArray(), select.value( 1 ).toULongLong() ) );
+            }
+            select.finish();
+            if ( oldest.isEmpty() ) {
+                m_usedStorage = 0;
+                break;
+            }
+            int removed = 0;
+            for ( const auto & entry : oldest ) {
+                if ( m_usedStorage <= target ) {
+                    break;
+                }
+                remove.addBindValue( entry.first );
+                if ( remove.exec() ) {
+                    m_usedStorage -= std::min( m_usedStorage, entry.second );
+                    removed++;
+                }
+            }
+            if ( removed == 0 ) {
+                qWarning() << "Eviction failed:" << remove.lastError().text();
+                break;
+            }
+        }
+        m_db.commit();
+    } // _evictIfNeeded
+
 private:
 
     QSqlDatabase m_db;
+    QSqlQuery m_readQuery, m_sizeQuery, m_writeQuery, m_touchQuery;
+
+    // storage limit (0 = unlimited) and the storage currently used, in bytes
+    uint64_t m_maxStorage = 0;
+    uint64_t m_usedStorage = 0;
+
+    // logical clock for the last use of entries
+    qint64 m_clock = 0;
+
+    // entries read since the last time uses were written out
+    QHash < QByteArray, qint64 > m_touched;
+
+    // number of uses that are written out at once
+    static const int TOUCH_BATCH = 256;
+
     static Carta::Lib::IPCache::SharedPtr m_cachePtr; //  = nullptr;
 };
 
@@ -167,7 +378,7 @@ PCacheSQlite3Plugin::handleHook( BaseHook & hookData )
         }
 
         // try to create the database
-        hook.result = SqLitePCache::getCacheSingleton( m_dbPath);
+        hook.result = SqLitePCache::getCacheSingleton( m_dbPath, m_maxStorage );
 
         // return true if result is not null
         return hook.result != nullptr;
@@ -187,6 +398,9 @@ PCacheSQlite3Plugin::initialize( const IPlugin::InitInfo & initInfo )
     // extract the location of the database from carta.config
     m_dbPath = initInfo.json.value( "dbPath").toString();
 
+    // maximum size of the cache, least recently used entries are evicted beyond it
+    m_maxStorage = initInfo.json.value( "maxStorageMB" ).toDouble( 1024 ) * 1024 * 1024;
+
     if( m_dbPath.isNull()) {
         qCritical() << "No dbPath specified for PCacheSqlite3 plugin!!!";
     }
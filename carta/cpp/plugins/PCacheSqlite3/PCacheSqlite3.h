@@ -28,4 +28,5 @@ public :
 private:
 
     QString m_dbPath;
+    uint64_t m_maxStorage = 0;
 };
@@ -34,7 +34,7 @@ private:
 
 
 template <typename Scalar>
-PercentileHistogram<Scalar>::PercentileHistogram(const unsigned int numberOfBins) : Carta::Lib::IPercentilesToPixels<Scalar>(1/numberOfBins, "Histogram approximation", true, true), numberOfBins(numberOfBins) {
+PercentileHistogram<Scalar>::PercentileHistogram(const unsigned int numberOfBins) : Carta::Lib::IPercentilesToPixels<Scalar>(1.0/numberOfBins, "Histogram approximation", true, true), numberOfBins(numberOfBins) {
 }
 
 
@@ -92,20 +92,24 @@ std::map<double, Scalar> PercentileHistogram<Scalar>::percentile2pixels(
             Carta::Lib::NdArray::Double viewSlice = Carta::Lib::viewSliceForFrame(view, spectralIndex, f);
 
             // iterate over the frame
-            viewSlice.forEach([&bins, this, &pixelIndex, &minIntensity, &intensityRange, &converter, &hertzVal] (const Scalar &val) {
-                if (std::isfinite(val)) {
-                    pixelIndex = static_cast<unsigned int>(round(this->numberOfBins * (converter->_frameDependentConvert(val, hertzVal) - minIntensity) / intensityRange));
-                    bins[pixelIndex]++;
+            viewSlice.forEachBlock([&bins, this, &pixelIndex, &minIntensity, &intensityRange, &converter, &hertzVal] (const Scalar * vals, int64_t count) {
+                for (int64_t i = 0; i < count; i++) {
+                    if (std::isfinite(vals[i])) {
+                        pixelIndex = static_cast<unsigned int>(round(this->numberOfBins * (converter->_frameDependentConvert(vals[i], hertzVal) - minIntensity) / intensityRange));
+                        bins[pixelIndex]++;
+                    }
                 }
             });
         }
     } else {
         // we don't have to do any conversions in the loop
         // and we can loop over the flat image
-        view.forEach([&bins, this, &pixelIndex, &minIntensity, &intensityRange] (const Scalar &val) {
-            if (std::isfinite(val)) {
-                pixelIndex = static_cast<unsigned int>(round(this->numberOfBins * (val - minIntensity) / intensityRange));
-                bins[pixelIndex]++;
+        view.forEachBlock([&bins, this, &pixelIndex, &minIntensity, &intensityRange] (const Scalar * vals, int64_t count) {
+            for (int64_t i = 0; i < count; i++) {
+                if (std::isfinite(vals[i])) {
+                    pixelIndex = static_cast<unsigned int>(round(this->numberOfBins * (vals[i] - minIntensity) / intensityRange));
+                    bins[pixelIndex]++;
+                }
             }
         });
     }
@@ -163,5 +167,5 @@ std::map<double, Scalar> PercentileHistogram<Scalar>::percentile2pixels(
 template <typename Scalar>
 void PercentileHistogram<Scalar>::reconfigure(const QJsonObject config) {
     this->numberOfBins = config["numberOfBins"].toInt();
-    this->error = 1/this->numberOfBins;
+    this->error = 1.0/this->numberOfBins;
 }
\ No newline at end of file
@@ -4,16 +4,22 @@
 #include "CartaLib/IImage.h"
 #include "CartaLib/IntensityUnitConverter.h"
 #include "CartaLib/IPercentileCalculator.h"
+#include "CartaLib/Slice.h"
 
+#include <QJsonObject>
 #include <vector>
-#include <queue>
-#include <set>
+#include <deque>
+#include <map>
+#include <memory>
 #include <random>
 #include <limits>
-#include <functional>
 #include <algorithm>
+#include <numeric>
+#include <cmath>
 
-template<class T> using min_heap = std::priority_queue<T, std::vector<T>, std::greater<T> >;
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 template <typename Scalar>
 class Buffer {
@@ -25,18 +31,25 @@ public:
 
     /** The weight of the buffer */
     size_t weight;
-    
+
     /** The level of the buffer */
     size_t level;
-    
-    /** The elements */
-    min_heap<Scalar> elements;
+
+    /** The elements, sorted in ascending order */
+    std::vector<Scalar> elements;
 
     // TODO: we can probably just remove this
     Buffer() : weight(0), level(0) {
     }
 };
 
+/// Sketch of the Manku, Rajagopalan & Lindsay (1999) algorithm.
+///
+/// Sampled values are collected in a plain vector, which is sorted once when it is full
+/// (instead of pushing every value into a heap). Several sketches built over different parts
+/// of the data can be combined by running output() on the union of their buffers; since
+/// the error of every sketch is bounded relative to the number of values it has seen, the
+/// error of the combined result has the same bound relative to the total.
 template <typename Scalar>
 class Manku99Algorithm {
 public:
@@ -46,69 +59,99 @@ public:
         const size_t sampleAfter,
         Carta::Lib::IntensityUnitConverter::SharedPtr converter
     );
-    
-    /** Process a value */
+
+    /** Process a finite value */
     void process(const Scalar & val, const double & hzVal);
 
+    /** Process a block of values from the same frame; non-finite values are skipped */
+    void processBlock(const Scalar * values, size_t count, const double hzVal);
+
+    /** Flush the partially filled block and buffer; no more values may be processed after this */
+    void finish();
+
+    /** The buffers which hold data, to be used in output(); only valid after finish() */
+    std::vector<const Buffer<Scalar>*> nonEmptyBuffers() const;
+
     /** OUTPUT operation */
     std::map<double, Scalar> opOutput(const std::vector<double> quantiles);
+
+    /** OUTPUT operation on a set of buffers, possibly coming from several sketches */
+    static std::map<double, Scalar> output(const std::vector<const Buffer<Scalar>*> & buffers, const std::vector<double> quantiles);
+
+    /** The exact minimum and maximum of the (converted) values processed so far */
+    Scalar minimum() const {
+        return minValue;
+    }
+    Scalar maximum() const {
+        return maxValue;
+    }
+
 private:
     const size_t numBuffers;
     const size_t bufferCapacity;
     const size_t sampleAfter;
-    
+
     size_t samplingRate;
     size_t newBufferLevel;
     size_t height;
     std::vector<Buffer<Scalar> > buffers;
-    
-    /** Temporary storage for blocks of data before and after sampling */
-    std::vector<Scalar> elementBlock;
-    std::vector<double> hzForBlock; // we need to keep these so that we can convert after sampling
-    min_heap<Scalar> bufferElements;
 
-    /** For unit conversion */
+    /** Sampled elements which have not been stored in a buffer yet */
+    std::vector<Scalar> bufferElements;
+
+    /** Position within the current block of samplingRate values, and the position to be sampled */
+    size_t blockPos;
+    size_t ri;
+
+    /** For unit conversion; only sampled values (and the extremes of every block) are converted */
     Carta::Lib::IntensityUnitConverter::SharedPtr converter;
-    std::function<void(Scalar, double)> blockPushLambda;
-    std::function<Scalar(size_t)> convertedValueLambda;
-    std::function<void()> blockClearLambda;
+    bool frameDependent;
+
+    /** Exact extremes, the sampling would lose them */
+    Scalar minValue;
+    Scalar maxValue;
 
     /** Keep track of empty buffers */
     std::deque<Buffer<Scalar>*> empty;
 
-    /** Keep track of full buffers and their levels */
-    min_heap<size_t> fullLevelHeap;
-    std::set<size_t> fullLevelSet;
+    /** Full buffers by level */
     std::map<size_t, std::vector<Buffer<Scalar>*> > full;
 
+    /** The buffer holding the last, partially filled set of elements */
+    Buffer<Scalar>* partial;
+
     /** Randomness */
     std::random_device rd;
     std::mt19937 mt;
-    std::uniform_int_distribution<> dist;
-    size_t ri;
+    std::uniform_int_distribution<size_t> dist;
 
     /** NEW operation */
     Buffer<Scalar>* opNew();
 
-    /** Weighted buffer merge, used in COLLAPSE and OUTPUT operations */
-    void merge(
-        std::vector<Buffer<Scalar>*> inputBuffers, size_t start,
-        std::function<bool()> stopIterationLambda,
-        std::function<size_t(size_t)> nextIndexLambda,
-        std::function<void(size_t, Scalar)> processValueLambda
-    );
+    /** Weighted merge of sorted buffers, used in COLLAPSE and OUTPUT operations.
+     * Calls processValue(index, value) for every index of the virtual expanded (by weight) list
+     * returned by nextIndex, starting with start, until nextIndex returns the maximum size_t. */
+    template <typename NextIndex, typename ProcessValue>
+    static void merge(const std::vector<const Buffer<Scalar>*> & inputBuffers, size_t start,
+        NextIndex nextIndex, ProcessValue processValue);
 
     /** Will be toggled in successive calls of the collapse operation */
     bool collapseChoice;
-    
+
     /** COLLAPSE operation */
     void opCollapse(std::vector<Buffer<Scalar>*> & inputBuffers);
 
+    /** Collapse the lowest level buffers, to free at least one buffer */
+    void collapseLowest();
+
     /** Helper function to add a full buffer */
-    void addFullBuffer(Buffer<Scalar> *& fullBuffer);
-    
+    void addFullBuffer(Buffer<Scalar> * fullBuffer);
+
     /** Helper function to get all full buffers at the lowest level */
     std::vector<Buffer<Scalar>*> getLowest();
+
+    /** Sort the collected elements into a new buffer, collapsing if no buffers are left */
+    void storeElements();
 };
 
 
@@ -116,127 +159,83 @@ template <typename Scalar>
 Manku99Algorithm<Scalar>::Manku99Algorithm(const size_t numBuffers, const size_t bufferCapacity, const size_t sampleAfter,
     Carta::Lib::IntensityUnitConverter::SharedPtr converter) : numBuffers(numBuffers),
     bufferCapacity(bufferCapacity), sampleAfter(sampleAfter),
-    samplingRate(1), newBufferLevel(0), height(0)
+    samplingRate(1), newBufferLevel(0), height(0), blockPos(0), ri(0),
+    converter(converter), frameDependent(converter && converter->frameDependent),
+    minValue(std::numeric_limits<Scalar>::max()), maxValue(std::numeric_limits<Scalar>::lowest()),
+    partial(nullptr), collapseChoice(false)
 {
+    // a collapse needs at least two buffers
+    CARTA_ASSERT( numBuffers >= 2 );
 
-    for (size_t i = 0; i < numBuffers; i++) {
-        buffers.push_back(Buffer<Scalar>());
-    }
+    buffers.resize(numBuffers);
 
     for (auto& b : buffers) {
         empty.push_back(&b);
     }
 
     mt = std::mt19937(rd());
-    dist = std::uniform_int_distribution<>(0, samplingRate - 1);
-    
-    this->converter = converter;
-    
-    if (converter && converter->frameDependent) {
-        blockPushLambda = [this] (const Scalar val, const double hzVal) {
-            this->elementBlock.push_back(val);
-            this->hzForBlock.push_back(hzVal);
-        };
-        
-        convertedValueLambda = [this] (const size_t & ri) {
-            return this->converter->_frameDependentConvert(this->elementBlock[ri], this->hzForBlock[ri]);
-        };
-        
-        blockClearLambda = [this] () {
-            this->elementBlock.clear();
-            this->hzForBlock.clear();
-        };
-    } else {
-        blockPushLambda = [this] (const Scalar val, const double hzVal) {
-            Q_UNUSED(hzVal);
-            this->elementBlock.push_back(val);
-        };
-        
-        convertedValueLambda = [this] ( const size_t & ri) {
-            return this->elementBlock[ri];
-        };
-        
-        blockClearLambda = [this] () {
-            this->elementBlock.clear();
-        };
-    }
+    dist = std::uniform_int_distribution<size_t>(0, samplingRate - 1);
+    bufferElements.reserve(bufferCapacity);
 }
 
 
 template <typename Scalar>
 Buffer<Scalar>* Manku99Algorithm<Scalar>::opNew() {
     Buffer<Scalar>* buffer = empty.front();
-    
-    buffer->elements = std::move(bufferElements);
+
+    std::sort(bufferElements.begin(), bufferElements.end());
+    buffer->elements.swap(bufferElements);
     buffer->weight = samplingRate;
     buffer->level = newBufferLevel;
-    
+    bufferElements.clear();
+
     empty.pop_front();
-    
+
     return buffer;
 }
 
 
 template <typename Scalar>
+template <typename NextIndex, typename ProcessValue>
 void Manku99Algorithm<Scalar>::merge(
-    std::vector<Buffer<Scalar>*> inputBuffers, size_t start,
-    std::function<bool()> stopIterationLambda,
-    std::function<size_t(size_t)> nextIndexLambda,
-    std::function<void(size_t, Scalar)> processValueLambda
+    const std::vector<const Buffer<Scalar>*> & inputBuffers, size_t start,
+    NextIndex nextIndex, ProcessValue processValue
 ) {
-    // buffers which have elements left
-    std::vector<Buffer<Scalar>*> remainingBuffers;
-    for (auto& b : inputBuffers) {
-        remainingBuffers.push_back(b);
-    }
-    
-    // the index of the buffer with the overall lowest next value
-    size_t minBufferIndex;
-    // the overall lowest next value
-    Scalar minNextVal;
-    // the corresponding buffer weight
-    size_t weight;
+    const size_t stop = std::numeric_limits<size_t>::max();
+
+    // read position within each of the buffers
+    std::vector<size_t> positions(inputBuffers.size(), 0);
 
     // the position within the virtual expanded list of elements
     size_t pos(0);
     // the next index to be sampled from the expanded list of elements
-    size_t nextIndex(start);
+    size_t next(start);
 
-    // while the destination element buffer isn't full
-    while (!stopIterationLambda()) {
+    while (next != stop) {
         // find the buffer with the lowest overall next value
-        
-        minNextVal = std::numeric_limits<Scalar>::max();
-            
-        for (size_t i = 0; i < remainingBuffers.size(); i++) {
-            if (remainingBuffers[i]->elements.top() < minNextVal) {
+        int minBufferIndex = -1;
+        for (size_t i = 0; i < inputBuffers.size(); i++) {
+            if (positions[i] < inputBuffers[i]->size() &&
+                (minBufferIndex < 0 ||
+                 inputBuffers[i]->elements[positions[i]] < inputBuffers[minBufferIndex]->elements[positions[minBufferIndex]])) {
                 minBufferIndex = i;
-                // peek at the value here
-                minNextVal = remainingBuffers[i]->elements.top();
-                weight = remainingBuffers[i]->weight;
             }
         }
-        
-        // actually pop the value here
-        remainingBuffers[minBufferIndex]->elements.pop();
-
-        // if the buffer is now empty, remove it from the list of non-empty buffers
-        // it doesn't matter if any elements are left in some of the buffers after the merge
-        // because we're going to overwrite them in the NEW operation afterwards
-        if (remainingBuffers[minBufferIndex]->elements.empty()) {
-            remainingBuffers.erase(remainingBuffers.begin() + minBufferIndex);
+        if (minBufferIndex < 0) {
+            // all the buffers are exhausted
+            break;
         }
-        
-        // I'm sure there's a cleaner way to do this
+
+        const Buffer<Scalar>* minBuffer = inputBuffers[minBufferIndex];
+        const Scalar minNextVal = minBuffer->elements[positions[minBufferIndex]++];
+
         // if any samples fall within the next [weight] elements of the expanded list, use this value for those samples
-        for (size_t p = pos; p < pos + weight; p++) {
-            if (p == nextIndex) {
-                processValueLambda(nextIndex, minNextVal);
-                nextIndex = nextIndexLambda(nextIndex);
-            }
+        while (next != stop && next < pos + minBuffer->weight) {
+            processValue(next, minNextVal);
+            next = nextIndex(next);
         }
         // actually advance our position in the expanded list
-        pos += weight;
+        pos += minBuffer->weight;
     }
 }
 
@@ -244,11 +243,11 @@ void Manku99Algorithm<Scalar>::merge(
 template <typename Scalar>
 void Manku99Algorithm<Scalar>::opCollapse(std::vector<Buffer<Scalar>*> & inputBuffers) {
     // Weight of collapsed buffer is the sum of the weights of all input buffers
-    size_t YWeight = std::accumulate (begin(inputBuffers), end(inputBuffers), 0, [](size_t a, Buffer<Scalar>*& b){ return b->weight + a; });
+    size_t YWeight = std::accumulate (begin(inputBuffers), end(inputBuffers), size_t(0), [](size_t a, Buffer<Scalar>*& b){ return b->weight + a; });
     // Level of collapsed buffer is one more than the level of each input buffer
     size_t YLevel = inputBuffers[0]->level + 1;
 
-    // Calculate sampling offset from total weight 
+    // Calculate sampling offset from total weight
     size_t offset;
     if (YWeight % 2) { // odd
         offset = (YWeight + 1) / 2;
@@ -260,24 +259,23 @@ void Manku99Algorithm<Scalar>::opCollapse(std::vector<Buffer<Scalar>*> & inputBu
 
     collapseChoice = !collapseChoice;
 
-    // the destination for the sampled, merged elements
-    min_heap<Scalar> YElements;
-
-    auto stopIterationLambda = [this, &YElements] () {
-        return (YElements.size() >= this->bufferCapacity);
-    };
+    // the destination for the sampled, merged elements (sorted, since the merge is)
+    std::vector<Scalar> YElements;
+    YElements.reserve(bufferCapacity);
 
-    auto nextIndexLambda = [&YWeight] (size_t lastIndex) {
-        return lastIndex + YWeight;
+    const size_t capacity = bufferCapacity;
+    auto nextIndexLambda = [&YWeight, &YElements, capacity] (size_t lastIndex) {
+        return (YElements.size() >= capacity) ? std::numeric_limits<size_t>::max() : lastIndex + YWeight;
     };
 
     auto processValueLambda = [&YElements] (size_t index, Scalar value) {
         Q_UNUSED(index);
-        YElements.push(value);
+        YElements.push_back(value);
     };
 
     // perform the weighted merge
-    merge(inputBuffers, offset - 1, stopIterationLambda, nextIndexLambda, processValueLambda);
+    std::vector<const Buffer<Scalar>*> constInputs(inputBuffers.begin(), inputBuffers.end());
+    merge(constInputs, offset - 1, nextIndexLambda, processValueLambda);
 
     for (auto& b : inputBuffers) {
         // weight and level are cosmetic here; is there a performance benefit to not setting them?
@@ -286,174 +284,197 @@ void Manku99Algorithm<Scalar>::opCollapse(std::vector<Buffer<Scalar>*> & inputBu
     }
 
     Buffer<Scalar>*& Y = inputBuffers[0];
-    Y->elements = std::move(YElements);
+    Y->elements.swap(YElements);
     Y->weight = YWeight;
     Y->level = YLevel;
 }
 
 
 template <typename Scalar>
-void Manku99Algorithm<Scalar>::addFullBuffer(Buffer<Scalar> *& fullBuffer) {
-    size_t& level = fullBuffer->level;
-    if (fullLevelSet.find(level) == fullLevelSet.end()) {
-        // add the level to the set
-        fullLevelSet.insert(level);
-        // add the level to the heap
-        fullLevelHeap.push(level);
-    }
-    // add the buffer to the map of full buffers
-    full[newBufferLevel].push_back(fullBuffer);
+void Manku99Algorithm<Scalar>::addFullBuffer(Buffer<Scalar> * fullBuffer) {
+    full[fullBuffer->level].push_back(fullBuffer);
 }
 
 
 template <typename Scalar>
 std::vector<Buffer<Scalar>*> Manku99Algorithm<Scalar>::getLowest() {
-    size_t lowestFullLevel = fullLevelHeap.top();
-    fullLevelHeap.pop();
-    fullLevelSet.erase(lowestFullLevel);
-    
-    std::vector<Buffer<Scalar>*> lowest = full[lowestFullLevel];
-    full.erase(lowestFullLevel);
+    auto lowestIt = full.begin();
+    std::vector<Buffer<Scalar>*> lowest = std::move(lowestIt->second);
+    full.erase(lowestIt);
     return lowest;
 }
 
+
 template <typename Scalar>
-void Manku99Algorithm<Scalar>::process(const Scalar & val, const double & hzVal) {
-    if (empty.size()) {
-        blockPushLambda(val, hzVal);
-        
-        if (elementBlock.size() == samplingRate) {
-            // select random element from block, do unit conversion and push to elements
-            ri = dist(mt);
-            bufferElements.push(convertedValueLambda(ri));
-            blockClearLambda();
-            
-            // create new buffer whenever elements reach buffer capacity
-            // we'll do it once more at the end to account for a possible partial buffer
-            if (bufferElements.size() == bufferCapacity) { // NEW operation
-                Buffer<Scalar>* newBuffer = opNew();
-                addFullBuffer(newBuffer);
-            }
-        }
-    } else { // COLLAPSE operation
-        // Find full buffers with the lowest level
-        std::vector<Buffer<Scalar>*> lowest = getLowest();
-        
-        // If there is only one,
-        if (lowest.size() == 1) {
-            // add the next lowest buffer(s) and promote the lowest buffer
-            std::vector<Buffer<Scalar>*> secondLowest = getLowest();
-            lowest[0]->level = secondLowest[0]->level;
-            secondLowest.push_back(lowest[0]);
-            lowest = std::move(secondLowest);
-        }
+void Manku99Algorithm<Scalar>::collapseLowest() {
+    // Find full buffers with the lowest level
+    std::vector<Buffer<Scalar>*> lowest = getLowest();
+
+    // If there is only one,
+    if (lowest.size() == 1) {
+        // add the next lowest buffer(s) and promote the lowest buffer
+        std::vector<Buffer<Scalar>*> secondLowest = getLowest();
+        lowest[0]->level = secondLowest[0]->level;
+        secondLowest.push_back(lowest[0]);
+        lowest = std::move(secondLowest);
+    }
 
-        // perform the collapse
-        opCollapse(lowest);
+    // perform the collapse
+    opCollapse(lowest);
 
-        // all buffers after the first are now empty
-        for (size_t i = 1; i < lowest.size(); i++) {
-            empty.push_back(lowest[i]);
-        }
+    // all buffers after the first are now empty
+    for (size_t i = 1; i < lowest.size(); i++) {
+        lowest[i]->elements.clear();
+        empty.push_back(lowest[i]);
+    }
 
-        // the first buffer is full
-        addFullBuffer(lowest[0]);
-        
-        // update tree height
-        height = std::max(height, lowest[0]->level);
-        
-        // update new buffer level, sampling rate and random distribution
-        if (height >= sampleAfter) {
-            newBufferLevel = height - sampleAfter + 1;
-            samplingRate = pow(2, newBufferLevel);
-            dist = std::uniform_int_distribution<>(0, samplingRate - 1);
-        }
+    // the first buffer is full
+    addFullBuffer(lowest[0]);
+
+    // update tree height
+    height = std::max(height, lowest[0]->level);
+
+    // update new buffer level, sampling rate and random distribution
+    if (height >= sampleAfter) {
+        newBufferLevel = height - sampleAfter + 1;
+        samplingRate = size_t(1) << newBufferLevel;
+        dist = std::uniform_int_distribution<size_t>(0, samplingRate - 1);
     }
 }
 
 
 template <typename Scalar>
-std::map<double, Scalar> Manku99Algorithm<Scalar>::opOutput(const std::vector<double> quantiles) {
-    // process a possible partial block
-    if (elementBlock.size()) {
-        // select random element from block, do unit conversion and append to elements
+void Manku99Algorithm<Scalar>::storeElements() {
+    addFullBuffer(opNew());
+    // make sure there is always an empty buffer for the next NEW operation
+    if (empty.empty()) {
+        collapseLowest();
+    }
+}
+
+
+template <typename Scalar>
+inline void Manku99Algorithm<Scalar>::process(const Scalar & val, const double & hzVal) {
+    // keep one random element from every block of samplingRate elements, and only convert that one
+    if (blockPos == ri) {
+        bufferElements.push_back(frameDependent ? converter->_frameDependentConvert(val, hzVal) : val);
+    }
+    if (++blockPos == samplingRate) {
+        // create new buffer whenever elements reach buffer capacity
+        // we'll do it once more at the end to account for a possible partial buffer
+        if (bufferElements.size() == bufferCapacity) { // NEW operation
+            storeElements();
+        }
+        blockPos = 0;
         ri = dist(mt);
-        // we may not select any element from this incomplete block
-        if (ri < elementBlock.size()){
-            bufferElements.push(convertedValueLambda(ri));
+    }
+}
+
+
+template <typename Scalar>
+void Manku99Algorithm<Scalar>::processBlock(const Scalar * values, size_t count, const double hzVal) {
+    Scalar blockMin = std::numeric_limits<Scalar>::max();
+    Scalar blockMax = std::numeric_limits<Scalar>::lowest();
+    bool finite = false;
+    for (size_t i = 0; i < count; i++) {
+        if (std::isfinite(values[i])) {
+            blockMin = std::min(blockMin, values[i]);
+            blockMax = std::max(blockMax, values[i]);
+            finite = true;
+            process(values[i], hzVal);
         }
-        elementBlock.clear();
-        hzForBlock.clear();
     }
-    
-    // process a possible partial buffer
-    Buffer<Scalar>* partial;
+    if (finite) {
+        // the conversions are monotonic within a frame, so converting the extremes is enough
+        if (frameDependent) {
+            Scalar a = converter->_frameDependentConvert(blockMin, hzVal);
+            Scalar b = converter->_frameDependentConvert(blockMax, hzVal);
+            blockMin = std::min(a, b);
+            blockMax = std::max(a, b);
+        }
+        minValue = std::min(minValue, blockMin);
+        maxValue = std::max(maxValue, blockMax);
+    }
+}
 
-    if (bufferElements.size()) {        
+
+template <typename Scalar>
+void Manku99Algorithm<Scalar>::finish() {
+    // a possible partial block was already sampled if its random element was reached
+    blockPos = 0;
+
+    // process a possible partial buffer
+    if (bufferElements.size()) {
         partial = opNew();
     }
+}
 
-    // Final set of buffers to be used in output operation
-    std::vector<Buffer<Scalar>*> nonEmptyBuffers;
-    
-    while (!fullLevelHeap.empty()) {
-        std::vector<Buffer<Scalar>*> lowest = getLowest();
-        nonEmptyBuffers.insert(nonEmptyBuffers.end(), lowest.begin(), lowest.end());
-    }
 
+template <typename Scalar>
+std::vector<const Buffer<Scalar>*> Manku99Algorithm<Scalar>::nonEmptyBuffers() const {
+    std::vector<const Buffer<Scalar>*> nonEmpty;
+    for (auto& level : full) {
+        nonEmpty.insert(nonEmpty.end(), level.second.begin(), level.second.end());
+    }
     // partial buffer goes at the end
     if (partial) {
-        nonEmptyBuffers.push_back(partial);
+        nonEmpty.push_back(partial);
     }
+    return nonEmpty;
+}
+
+
+template <typename Scalar>
+std::map<double, Scalar> Manku99Algorithm<Scalar>::opOutput(const std::vector<double> quantiles) {
+    finish();
+    return output(nonEmptyBuffers(), quantiles);
+}
+
+
+template <typename Scalar>
+std::map<double, Scalar> Manku99Algorithm<Scalar>::output(const std::vector<const Buffer<Scalar>*> & buffers, const std::vector<double> quantiles) {
+    std::map<double, Scalar> values;
 
     // kW is the sum of the weight x actual size of all input buffers
-    size_t kW = std::accumulate (begin(nonEmptyBuffers), end(nonEmptyBuffers), 0, [](size_t a, Buffer<Scalar>*& b){ return (b->size() * b->weight) + a; });
+    size_t kW = 0;
+    for (auto& b : buffers) {
+        kW += b->size() * b->weight;
+    }
+
+    if (kW == 0) {
+        // no finite values
+        for (auto & phi : quantiles) {
+            values[phi] = std::numeric_limits<Scalar>::quiet_NaN();
+        }
+        return values;
+    }
 
     // Quantiles close together may have the same index
-    // We need to eliminate the duplicates to avoid breaking the merge algorithm
-    std::set<size_t> indicesSet;
-    min_heap<size_t> indices;
     std::map<size_t, std::vector<double> > quantilesForIndex;
-    
+
     for (auto & phi : quantiles) {
         size_t index = (size_t) std::max(ceil(phi * kW) - 1, 0.0);
-        if (indicesSet.find(index) == indicesSet.end()) {
-            indicesSet.insert(index);
-            indices.push(index);
-        }
         quantilesForIndex[index].push_back(phi);
     }
-    
-    bool stopIteration(false);
-    
-    auto stopIterationLambda = [&stopIteration] () {
-        return stopIteration;
-    };
 
-    auto nextIndexLambda = [&indices, &stopIteration] (size_t lastIndex) {
+    // the indices are visited in increasing order
+    auto indexIt = quantilesForIndex.begin();
+
+    auto nextIndexLambda = [&indexIt, &quantilesForIndex] (size_t lastIndex) {
         Q_UNUSED(lastIndex);
-        size_t next(0);
-        if (indices.empty()) {
-            stopIteration = true;
-        } else {
-            next = indices.top();
-            indices.pop();
-        }
-        return next;
+        ++indexIt;
+        return indexIt == quantilesForIndex.end() ? std::numeric_limits<size_t>::max() : indexIt->first;
     };
 
-    std::map<double, Scalar> values;
-
-    auto processValueLambda = [&quantilesForIndex, &values] (size_t index, Scalar value) {
-        for (auto& q : quantilesForIndex[index]) {
+    auto processValueLambda = [&indexIt, &values] (size_t index, Scalar value) {
+        Q_UNUSED(index);
+        for (auto& q : indexIt->second) {
             values[q] = value;
         }
     };
-    
+
     // perform the weighted merge
-    size_t startIndex = indices.top();
-    indices.pop();
-    merge(nonEmptyBuffers, startIndex, stopIterationLambda, nextIndexLambda, processValueLambda);
+    merge(buffers, indexIt->first, nextIndexLambda, processValueLambda);
 
     return values;
 }
@@ -463,12 +484,17 @@ std::map<double, Scalar> Manku99Algorithm<Scalar>::opOutput(const std::vector<do
 template <typename Scalar>
 class PercentileManku99 : public Carta::Lib::IPercentilesToPixels<Scalar> {
 public:
+    /**
+     * Constructor.
+     * @param numThreads the number of independent sketches built in parallel; 0 means one per core.
+     */
     PercentileManku99(
-        const size_t numBuffers, 
-        const size_t bufferCapacity, 
-        const size_t sampleAfter
+        const size_t numBuffers,
+        const size_t bufferCapacity,
+        const size_t sampleAfter,
+        const int numThreads = 0
     );
-        
+
     std::map<double, Scalar> percentile2pixels(
         Carta::Lib::NdArray::TypedView < Scalar > & view,
         std::vector <double> percentiles,
@@ -476,18 +502,22 @@ public:
         Carta::Lib::IntensityUnitConverter::SharedPtr converter,
         std::vector<double> hertzValues
     ) override;
-    
+
     void reconfigure(const QJsonObject config) override;
 
+    /** Number of values handed to a sketch at a time */
+    static constexpr size_t BLOCK_SIZE = 256 * 1024;
+
 private:
     size_t numBuffers;
     size_t bufferCapacity;
     size_t sampleAfter;
+    int numThreads;
 };
 
 // TODO: error is completely wrong; work out what it actually is
 template <typename Scalar>
-PercentileManku99<Scalar>::PercentileManku99(const size_t numBuffers, const size_t bufferCapacity, const size_t sampleAfter) :Carta::Lib:: IPercentilesToPixels<Scalar>(0.5, "Manku99 approximation", true), numBuffers(numBuffers), bufferCapacity(bufferCapacity), sampleAfter(sampleAfter) {
+PercentileManku99<Scalar>::PercentileManku99(const size_t numBuffers, const size_t bufferCapacity, const size_t sampleAfter, const int numThreads) :Carta::Lib:: IPercentilesToPixels<Scalar>(0.5, "Manku99 approximation", true), numBuffers(numBuffers), bufferCapacity(bufferCapacity), sampleAfter(sampleAfter), numThreads(numThreads) {
 }
 
 template <typename Scalar>
@@ -498,6 +528,9 @@ std::map<double, Scalar> PercentileManku99<Scalar>::percentile2pixels(
     Carta::Lib::IntensityUnitConverter::SharedPtr converter,
     std::vector<double> hertzValues
 ) {
+    typedef Carta::Lib::NdArray::RawViewInterface RawViewInterface;
+    typedef Carta::Lib::Image::PixelType PixelType;
+
     // basic preconditions
     if ( CARTA_RUNTIME_CHECKS ) {
         for ( auto q : percentiles ) {
@@ -512,39 +545,102 @@ std::map<double, Scalar> PercentileManku99<Scalar>::percentile2pixels(
         qFatal("Cannot find intensities in these units: the conversion is frame-dependent and there is no spectral axis.");
     }
 
-    double hertzVal;
-
-    Manku99Algorithm<Scalar> algorithm(numBuffers, bufferCapacity, sampleAfter, converter);
-    
-    // Enter all the values into buffers
-    if (converter && converter->frameDependent) {
-        // to avoid calculating the frame index repeatedly we use slices to iterate over the image one frame at a time
-
-        for (size_t f = 0; f < hertzValues.size(); f++) {
-            hertzVal = hertzValues[f];
-            Carta::Lib::NdArray::Double viewSlice = Carta::Lib::viewSliceForFrame(view, spectralIndex, f);
-            
-            // iterate over the frame
-            viewSlice.forEach([&algorithm, &hertzVal] ( const Scalar & val ) {
-                if (std::isfinite(val)) {
-                    algorithm.process(val, hertzVal);
+    int threadCount = 1;
+#ifdef _OPENMP
+    threadCount = numThreads > 0 ? numThreads : omp_get_max_threads();
+#endif
+
+    // one independent sketch per thread
+    std::vector<std::unique_ptr<Manku99Algorithm<Scalar> > > sketches;
+    std::vector<Manku99Algorithm<Scalar>*> sketchPtrs;
+    for (int t = 0; t < threadCount; t++) {
+        sketches.emplace_back(new Manku99Algorithm<Scalar>(numBuffers, bufferCapacity, sampleAfter, converter));
+        sketchPtrs.push_back(sketches.back().get());
+    }
+
+    // frames are only needed for frame-dependent conversions
+    const bool frameDependent = converter && converter->frameDependent;
+    const size_t frameCount = frameDependent ? hertzValues.size() : 1;
+
+    // The view is read by this thread only (image views are not thread safe), a block at a time.
+    // Every block is processed by a task, which adds it to the sketch of the thread executing it.
+    // Tasks on the same thread never run concurrently, so every sketch is only used by one thread.
+    auto readAll = [&]() {
+        int outstanding = 0;
+        for (size_t f = 0; f < frameCount; f++) {
+            std::unique_ptr<RawViewInterface> frameView;
+            RawViewInterface * rawView = view.rawView();
+            if (frameDependent) {
+                SliceND frame;
+                for (size_t d = 0; d < view.dims().size(); d++) {
+                    if ((int)d == spectralIndex) {
+                        frame.index(f);
+                    } else {
+                        frame.next();
+                    }
                 }
-            });
-        }
-    } else {
-        auto view_lambda = [&algorithm] ( const Scalar & val ) {
-            if (std::isfinite(val)) {
-                algorithm.process(val, -1);
+                frameView.reset(rawView->getView(frame));
+                rawView = frameView.get();
             }
-        };
-        
-        // we can loop over the flat image
-        view.forEach(view_lambda);
+            const double hertzVal = frameDependent ? hertzValues[f] : -1;
+            const PixelType pixelType = rawView->pixelType();
+            const int64_t pixelSize = Carta::Lib::Image::pixelType2size(pixelType);
+
+            auto blockFunc = [&](const char * data, int64_t count) {
+                std::shared_ptr<std::vector<Scalar> > block = std::make_shared<std::vector<Scalar> >(count);
+                if (!Carta::Lib::convertPixels<Scalar>(pixelType, data, count, block->data())) {
+                    qFatal("PercentileManku99: unsupported pixel type");
+                }
+#ifdef _OPENMP
+                const double hz = hertzVal;
+                Manku99Algorithm<Scalar> * const * sketchList = sketchPtrs.data();
+                #pragma omp task firstprivate(block, hz, sketchList)
+                sketchList[omp_get_thread_num()]->processBlock(block->data(), block->size(), hz);
+
+                // bound the memory used by blocks waiting to be processed
+                if (++outstanding >= 2 * threadCount) {
+                    #pragma omp taskwait
+                    outstanding = 0;
+                }
+#else
+                Q_UNUSED(outstanding);
+                sketchPtrs[0]->processBlock(block->data(), block->size(), hertzVal);
+#endif
+            };
+            rawView->forEach(BLOCK_SIZE * pixelSize, blockFunc, nullptr, RawViewInterface::Traversal::Sequential);
+        }
+    };
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(threadCount)
+    {
+        #pragma omp single
+        readAll();
+    }
+#else
+    readAll();
+#endif
+
+    // merge the sketches: the output operation runs on the union of all their buffers
+    std::vector<const Buffer<Scalar>*> buffers;
+    for (auto& sketch : sketches) {
+        sketch->finish();
+        std::vector<const Buffer<Scalar>*> sketchBuffers = sketch->nonEmptyBuffers();
+        buffers.insert(buffers.end(), sketchBuffers.begin(), sketchBuffers.end());
     }
 
-    // call output to handle the end of the data and find the quantiles
+    std::map <double, Scalar> result = Manku99Algorithm<Scalar>::output(buffers, percentiles);
 
-    std::map <double, Scalar> result = algorithm.opOutput(percentiles);
+    // the extremes are known exactly
+    for (auto& sketch : sketches) {
+        for (auto& q : percentiles) {
+            if (q == 0) {
+                result[q] = std::min(result[q], sketch->minimum());
+            } else if (q == 1) {
+                result[q] = std::max(result[q], sketch->maximum());
+            }
+        }
+    }
 
     return result;
 }
@@ -554,4 +650,5 @@ void PercentileManku99<Scalar>::reconfigure(const QJsonObject config) {
     this->numBuffers = config["numBuffers"].toInt();
     this->bufferCapacity = config["bufferCapacity"].toInt();
     this->sampleAfter = config["sampleAfter"].toInt();
+    this->numThreads = config["numThreads"].toInt(0);
 }
@@ -21,7 +21,7 @@ bool PercentileManku99Plugin::handleHook( BaseHook & hookData ){
         // TODO this is currently unused, but we should use it to pick a plugin (maybe)
         std::shared_ptr<Carta::Lib::Image::ImageInterface> image = hook.paramsPtr->m_image;
                 
-        hook.result = std::make_shared<PercentileManku99<double> >(m_numBuffers, m_bufferCapacity, m_sampleAfter);
+        hook.result = std::make_shared<PercentileManku99<double> >(m_numBuffers, m_bufferCapacity, m_sampleAfter, m_numThreads);
         
         return true;
     }
@@ -73,6 +73,14 @@ void PercentileManku99Plugin::initialize( const IPlugin::InitInfo & initInfo )
     if( m_sampleAfter <= 0) {
         qCritical() << "No valid sampleAfter value specified for percentile histogram plugin. Must be a positive integer.";
     }
+    
+    // optional; 0 means one sketch per core
+    m_numThreads = initInfo.json.value( "numThreads").toInt( 0 );
+    
+    if( m_numThreads < 0) {
+        qCritical() << "No valid numThreads value specified for percentile histogram plugin. Must be a non-negative integer.";
+        m_numThreads = 0;
+    }
 }
 
 
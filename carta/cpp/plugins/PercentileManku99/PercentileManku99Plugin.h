@@ -29,4 +29,5 @@ private:
     int m_numBuffers;
     int m_bufferCapacity;
     int m_sampleAfter;
+    int m_numThreads = 0;
 };
@@ -7,12 +7,20 @@ class TestPercentileManku99: public QObject
     Q_OBJECT
 private slots:
     void test_quantiles();
+    void test_quantiles_data();
 };
 
+void TestPercentileManku99::test_quantiles_data() {
+    QTest::addColumn<int>("numThreads");
+    QTest::newRow("single sketch") << 1;
+    QTest::newRow("merged sketches") << 4;
+}
+
 void TestPercentileManku99::test_quantiles() {
+    QFETCH(int, numThreads);
     std::vector<QuantileTestData> testCases = commonTestCases();
     
-    Carta::Lib::IPercentilesToPixels<double>::SharedPtr calculator = std::make_shared<PercentileManku99<double> >(10, 1000, 10);
+    Carta::Lib::IPercentilesToPixels<double>::SharedPtr calculator = std::make_shared<PercentileManku99<double> >(10, 1000, 10, numThreads);
     
     for (auto& testCase : testCases) {
         std::map<double, double> intensities = calculator->percentile2pixels(testCase.view, testCase.percentiles, testCase.spectralIndex, testCase.converter, testCase.hzValues);
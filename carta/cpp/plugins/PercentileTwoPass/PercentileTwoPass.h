@@ -0,0 +1,388 @@
+/**
+ * Exact percentile algorithm with bounded memory, based on a histogram of histograms.
+ *
+ * Pass one builds a coarse histogram of every frame (a Carta::Lib::Algorithms::SparseHistogram),
+ * with bins defined by the top 16 bits of an order preserving integer representation of the
+ * (double) values. The bins do not depend on the data range, so the per-frame histograms can
+ * be stored and reused by later calls. Pass two re-reads only the frames which have pixels in the bins containing the
+ * requested percentiles, and only keeps those pixels. If that would be more than the
+ * candidate budget, the bins are refined by the next 16 bits first (another pass over
+ * the same frames), so memory use is bounded for any data.
+ **/
+
+#pragma once
+
+#include "CartaLib/CartaLib.h"
+#include "CartaLib/Algorithms/SparseHistogram.h"
+#include "CartaLib/IImage.h"
+#include "CartaLib/IntensityUnitConverter.h"
+#include "CartaLib/IPercentileCalculator.h"
+#include "CartaLib/Slice.h"
+
+#include <QCache>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+/// Stored coarse histograms of individual frames, shared by all instances of the algorithm.
+class PercentileFrameSummaryStore {
+    CLASS_BOILERPLATE( PercentileFrameSummaryStore );
+public:
+    /// Sparse histogram of the finite values of one frame.
+    typedef Carta::Lib::Algorithms::SparseHistogram Summary;
+
+    /**
+     * Constructor.
+     * @param maxBytes the maximum memory used by the stored summaries.
+     */
+    PercentileFrameSummaryStore(const int64_t maxBytes) : m_cache(int(std::max<int64_t>(1, maxBytes / 1024))) {
+    }
+
+    /** Returns the summary stored under the given key, or nullptr. */
+    std::shared_ptr<const Summary> find(const QString& key) {
+        QMutexLocker locker(&m_mutex);
+        std::shared_ptr<const Summary>* summary = m_cache.object(key);
+        return summary ? *summary : nullptr;
+    }
+
+    /** Stores a summary under the given key, possibly evicting older ones. */
+    void insert(const QString& key, std::shared_ptr<const Summary> summary) {
+        QMutexLocker locker(&m_mutex);
+        int64_t bytes = summary->bins.size() * (sizeof(uint16_t) + sizeof(uint64_t)) + sizeof(Summary);
+        m_cache.insert(key, new std::shared_ptr<const Summary>(summary), int(std::max<int64_t>(1, bytes / 1024)));
+    }
+
+private:
+    QMutex m_mutex;
+    QCache<QString, std::shared_ptr<const Summary> > m_cache;
+};
+
+template <typename Scalar>
+class PercentileTwoPass : public Carta::Lib::IPercentilesToPixels<Scalar> {
+public:
+    /**
+     * Constructor.
+     * @param store where to keep per-frame summaries between calls; may be nullptr.
+     * @param candidateBudget the maximum number of pixels kept in memory at the same time.
+     */
+    PercentileTwoPass(PercentileFrameSummaryStore::SharedPtr store, const int64_t candidateBudget);
+
+    std::map<double, Scalar> percentile2pixels(
+        Carta::Lib::NdArray::TypedView < Scalar > & view,
+        std::vector <double> percentiles,
+        int spectralIndex,
+        Carta::Lib::IntensityUnitConverter::SharedPtr converter,
+        std::vector<double> hertzValues
+    ) override;
+
+    void reconfigure(const QJsonObject config) override;
+
+    /** Number of bits resolved by each histogram pass, the same as the bits of the summaries */
+    static constexpr int BITS_PER_PASS = Carta::Lib::Algorithms::SparseHistogram::Bits;
+
+private:
+    typedef Carta::Lib::NdArray::RawViewInterface RawViewInterface;
+
+    /// call func(values, count) for blocks of (converted) values of frame f
+    template <typename Func>
+    void scanFrame(size_t f, Func func);
+
+    Carta::Lib::NdArray::TypedView < Scalar > * m_view = nullptr;
+    int m_spectralIndex = -1;
+    Carta::Lib::IntensityUnitConverter::SharedPtr m_converter = nullptr;
+    std::vector<double> m_hertzValues;
+
+    PercentileFrameSummaryStore::SharedPtr m_store;
+    int64_t m_candidateBudget;
+};
+
+template <typename Scalar>
+PercentileTwoPass<Scalar>::PercentileTwoPass(PercentileFrameSummaryStore::SharedPtr store, const int64_t candidateBudget) : Carta::Lib::IPercentilesToPixels<Scalar>(0, "Exact two-pass histogram percentile algorithm"), m_store(store), m_candidateBudget(std::max<int64_t>(1, candidateBudget)) {
+}
+
+template <typename Scalar>
+template <typename Func>
+void PercentileTwoPass<Scalar>::scanFrame(size_t f, Func func) {
+    typedef Carta::Lib::Image::PixelType PixelType;
+
+    // with a spectral axis every frame is a separate slice, otherwise there is a single frame
+    std::unique_ptr<RawViewInterface> frameView;
+    RawViewInterface * rawView = m_view->rawView();
+    if (m_spectralIndex >= 0) {
+        SliceND frame;
+        for (size_t d = 0; d < m_view->dims().size(); d++) {
+            if ((int)d == m_spectralIndex) {
+                frame.index(f);
+            } else {
+                frame.next();
+            }
+        }
+        frameView.reset(rawView->getView(frame));
+        rawView = frameView.get();
+    }
+
+    const bool frameDependent = m_converter && m_converter->frameDependent;
+    const double hertzVal = frameDependent ? m_hertzValues[f] : 0;
+    const PixelType pixelType = rawView->pixelType();
+    const int64_t pixelSize = Carta::Lib::Image::pixelType2size(pixelType);
+    std::vector<double> values;
+
+    auto block = [&](const char * data, int64_t count) {
+        values.resize(count);
+        if (!Carta::Lib::convertPixels<double>(pixelType, data, count, values.data())) {
+            qFatal("PercentileTwoPass: unsupported pixel type");
+        }
+        if (frameDependent) {
+            for (auto& val : values) {
+                if (std::isfinite(val)) {
+                    val = m_converter->_frameDependentConvert(val, hertzVal);
+                }
+            }
+        }
+        func(values.data(), count);
+    };
+    rawView->forEach(pixelSize * 1024 * 1024, block, nullptr, RawViewInterface::Traversal::Sequential);
+}
+
+/// compute requested percentiles exactly
+/// \param view the input dataset
+/// \param percentiles which percentiles to compute
+/// \return the computed intensities, identical to the results of the quickselect algorithm.
+///
+/// \note NANs and infinities are treated as if they did not exist
+template <typename Scalar>
+std::map<double, Scalar> PercentileTwoPass<Scalar>::percentile2pixels(
+    Carta::Lib::NdArray::TypedView < Scalar > & view,
+    std::vector <double> percentiles,
+    int spectralIndex,
+    Carta::Lib::IntensityUnitConverter::SharedPtr converter,
+    std::vector<double> hertzValues
+) {
+    typedef PercentileFrameSummaryStore::Summary Summary;
+
+    // basic preconditions
+    if ( CARTA_RUNTIME_CHECKS ) {
+        for ( auto q : percentiles ) {
+            CARTA_ASSERT( 0.0 <= q && q <= 1.0 );
+            Q_UNUSED(q);
+        }
+    }
+
+    // if we have a frame-dependent converter and no spectral axis,
+    // we can't do anything because we don't know the channel units
+    if (converter && converter->frameDependent && spectralIndex < 0) {
+        qFatal("Cannot find intensities in these units: the conversion is frame-dependent and there is no spectral axis.");
+    }
+
+    m_view = &view;
+    m_spectralIndex = spectralIndex;
+    m_converter = converter;
+    m_hertzValues = hertzValues;
+
+    const bool frameDependent = converter && converter->frameDependent;
+    size_t frameCount = 1;
+    if (frameDependent) {
+        frameCount = hertzValues.size();
+    } else if (spectralIndex >= 0) {
+        frameCount = view.dims()[spectralIndex];
+    }
+
+    // start timer for scanning the raw data
+    QElapsedTimer timer;
+    timer.start();
+
+    // pass one: coarse histogram of every frame, from the store if possible
+    const int binCount = 1 << BITS_PER_PASS;
+    const int topShift = 64 - BITS_PER_PASS;
+    std::vector<std::shared_ptr<const Summary> > summaries(frameCount);
+    std::vector<uint64_t> bins(binCount, 0);
+    uint64_t total = 0;
+
+    for (size_t f = 0; f < frameCount; f++) {
+        QString summaryKey;
+        if (m_store && !this->dataId.isEmpty()) {
+            summaryKey = QString("%1/%2/%3").arg(this->dataId)
+                .arg(spectralIndex >= 0 ? QString::number(this->firstFrame + f) : QString("all"))
+                .arg(frameDependent ? converter->label : QString("NONE"));
+            summaries[f] = m_store->find(summaryKey);
+        }
+        if (!summaries[f]) {
+            Carta::Lib::Algorithms::SparseHistogramAccumulator accumulator;
+            scanFrame(f, [&accumulator](const double * values, int64_t count) {
+                for (int64_t i = 0; i < count; i++) {
+                    if (std::isfinite(values[i])) {
+                        accumulator.add(values[i]);
+                    }
+                }
+            });
+            auto summary = std::make_shared<Summary>(accumulator.result());
+            summaries[f] = summary;
+            if (!summaryKey.isEmpty()) {
+                m_store->insert(summaryKey, summary);
+            }
+        }
+        const Summary& summary = *summaries[f];
+        for (size_t i = 0; i < summary.bins.size(); i++) {
+            bins[summary.bins[i]] += summary.counts[i];
+        }
+        total += summary.total;
+    }
+
+    // indicate bad clip if no finite numbers were found
+    if ( total == 0 ) {
+        qFatal( "The size of raw data is zero !!" );
+    }
+
+    // every percentile is narrowed down to a group of pixels sharing the top bits of their key,
+    // and its rank within that group
+    struct Target {
+        uint64_t prefix;
+        uint64_t rank;
+        uint64_t count;
+        double value;
+    };
+    std::vector<Target> targets(percentiles.size());
+
+    for (size_t t = 0; t < percentiles.size(); t++) {
+        // the same rank as the quickselect algorithm
+        uint64_t rank = Carta::Lib::clamp<uint64_t>(total * percentiles[t], 1, total) - 1;
+        int b = 0;
+        while (rank >= bins[b]) {
+            rank -= bins[b];
+            b++;
+        }
+        targets[t] = { uint64_t(b), rank, bins[b], 0 };
+    }
+    int shift = topShift; // number of unresolved low bits of the keys
+
+    // distinct prefixes of the targets, sorted
+    auto targetPrefixes = [&targets]() {
+        std::vector<uint64_t> prefixes;
+        for (auto& target : targets) {
+            prefixes.push_back(target.prefix);
+        }
+        std::sort(prefixes.begin(), prefixes.end());
+        prefixes.erase(std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+        return prefixes;
+    };
+
+    // only frames with pixels in one of the groups need to be read again
+    auto frameNeeded = [&summaries, &shift, topShift](size_t f, const std::vector<uint64_t>& prefixes) {
+        for (uint64_t prefix : prefixes) {
+            if (summaries[f]->count(prefix >> (topShift - shift)) > 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // pass two (or more): refine the groups until the pixels in them fit into the budget
+    while (shift > 0) {
+        std::vector<uint64_t> prefixes = targetPrefixes();
+        uint64_t candidates = 0;
+        for (uint64_t prefix : prefixes) {
+            for (auto& target : targets) {
+                if (target.prefix == prefix) {
+                    candidates += target.count;
+                    break;
+                }
+            }
+        }
+        if (candidates <= uint64_t(m_candidateBudget)) {
+            break;
+        }
+
+        const int subShift = shift - BITS_PER_PASS;
+        std::vector<std::vector<uint64_t> > subBins(prefixes.size(), std::vector<uint64_t>(binCount, 0));
+        for (size_t f = 0; f < frameCount; f++) {
+            if (!frameNeeded(f, prefixes)) {
+                continue;
+            }
+            scanFrame(f, [&](const double * values, int64_t count) {
+                for (int64_t i = 0; i < count; i++) {
+                    if (!std::isfinite(values[i])) {
+                        continue;
+                    }
+                    uint64_t k = Carta::Lib::Algorithms::valueKey(values[i]);
+                    auto it = std::lower_bound(prefixes.begin(), prefixes.end(), k >> shift);
+                    if (it != prefixes.end() && *it == (k >> shift)) {
+                        subBins[it - prefixes.begin()][(k >> subShift) & (binCount - 1)]++;
+                    }
+                }
+            });
+        }
+
+        for (auto& target : targets) {
+            const std::vector<uint64_t>& sub = subBins[std::lower_bound(prefixes.begin(), prefixes.end(), target.prefix) - prefixes.begin()];
+            int b = 0;
+            while (target.rank >= sub[b]) {
+                target.rank -= sub[b];
+                b++;
+            }
+            target.prefix = (target.prefix << BITS_PER_PASS) | b;
+            target.count = sub[b];
+        }
+        shift = subShift;
+    }
+
+    if (shift == 0) {
+        // all the pixels in a group have the same value
+        for (auto& target : targets) {
+            target.value = Carta::Lib::Algorithms::keyValue(target.prefix);
+        }
+    } else {
+        // collect the pixels of the groups and select the ranks inside them
+        std::vector<uint64_t> prefixes = targetPrefixes();
+        std::vector<std::vector<double> > candidates(prefixes.size());
+        for (size_t f = 0; f < frameCount; f++) {
+            if (!frameNeeded(f, prefixes)) {
+                continue;
+            }
+            scanFrame(f, [&](const double * values, int64_t count) {
+                for (int64_t i = 0; i < count; i++) {
+                    if (!std::isfinite(values[i])) {
+                        continue;
+                    }
+                    uint64_t prefix = Carta::Lib::Algorithms::valueKey(values[i]) >> shift;
+                    auto it = std::lower_bound(prefixes.begin(), prefixes.end(), prefix);
+                    if (it != prefixes.end() && *it == prefix) {
+                        candidates[it - prefixes.begin()].push_back(values[i]);
+                    }
+                }
+            });
+        }
+        for (auto& target : targets) {
+            std::vector<double>& group = candidates[std::lower_bound(prefixes.begin(), prefixes.end(), target.prefix) - prefixes.begin()];
+            CARTA_ASSERT( target.rank < group.size() );
+            std::nth_element(group.begin(), group.begin() + target.rank, group.end());
+            target.value = group[target.rank];
+        }
+    }
+
+    std::map<double, Scalar> result;
+    for (size_t t = 0; t < percentiles.size(); t++) {
+        result[percentiles[t]] = targets[t].value;
+    }
+
+    // end of timer for computing the percentiles
+    int elapsedTime = timer.elapsed();
+    if (CARTA_RUNTIME_CHECKS) {
+        qCritical() << "<> Time to get the exact value (two-pass):" << elapsedTime << "ms";
+    }
+
+    m_view = nullptr;
+    m_converter = nullptr;
+    return result;
+}
+
+template <typename Scalar>
+void PercentileTwoPass<Scalar>::reconfigure(const QJsonObject config) {
+    this->m_candidateBudget = std::max<int64_t>(1, config["candidateBudget"].toDouble());
+}
@@ -0,0 +1,57 @@
+#include "CartaLib/Hooks/Initialize.h"
+#include "CartaLib/Hooks/PercentileToPixelHook.h"
+#include "plugins/PercentileTwoPass/PercentileTwoPassPlugin.h"
+#include "plugins/PercentileTwoPass/PercentileTwoPass.h"
+#include <QJsonDocument>
+#include <QDebug>
+
+PercentileTwoPassPlugin::PercentileTwoPassPlugin( QObject * parent ) : QObject( parent ) {
+}
+
+bool PercentileTwoPassPlugin::handleHook( BaseHook & hookData ){
+    if ( hookData.is < Carta::Lib::Hooks::Initialize > () ) {
+        return true;
+    }
+    
+    else if ( hookData.is < Carta::Lib::Hooks::PercentileToPixelHook<double> > () ) {
+        Carta::Lib::Hooks::PercentileToPixelHook<double> & hook
+            = static_cast <Carta::Lib::Hooks::PercentileToPixelHook<double> & > ( hookData );
+        
+        hook.result = std::make_shared<PercentileTwoPass<double> >(m_store, m_candidateBudget);
+        
+        return true;
+    }
+    
+    qWarning() << "Percentile two-pass plugin doesn't know how to handle this hook";
+    return false;
+} // handleHook
+
+
+std::vector < HookId > PercentileTwoPassPlugin::getInitialHookList() {
+    return {
+        Carta::Lib::Hooks::Initialize::staticId,
+        Carta::Lib::Hooks::PercentileToPixelHook<double>::staticId
+    };
+}
+
+void PercentileTwoPassPlugin::initialize( const IPlugin::InitInfo & initInfo )
+{
+    qDebug() << "PercentileTwoPassPlugin initializing...";
+    QJsonDocument doc( initInfo.json );
+    qDebug() << doc.toJson();
+    
+    if ( initInfo.json.contains( "candidateBudget" ) ) {
+        m_candidateBudget = initInfo.json.value( "candidateBudget" ).toDouble();
+    }
+    
+    if( m_candidateBudget <= 0) {
+        qCritical() << "No valid candidateBudget value specified for percentile two-pass plugin. Must be a positive integer.";
+        m_candidateBudget = 16 * 1024 * 1024;
+    }
+    
+    int summaryCacheMB = initInfo.json.value( "summaryCacheMB" ).toInt( 64 );
+    m_store = std::make_shared<PercentileFrameSummaryStore>( int64_t( summaryCacheMB ) * 1024 * 1024 );
+}
+
+PercentileTwoPassPlugin::~PercentileTwoPassPlugin() {
+}
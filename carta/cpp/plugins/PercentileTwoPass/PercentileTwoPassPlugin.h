@@ -0,0 +1,34 @@
+/// Plugin for calculating exact percentiles with bounded memory.
+
+#pragma once
+
+#include "CartaLib/IPlugin.h"
+#include "plugins/PercentileTwoPass/PercentileTwoPass.h"
+#include <QObject>
+
+class PercentileTwoPassPlugin : public QObject, public IPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA( IID "org.cartaviewer.IPlugin" )
+    Q_INTERFACES( IPlugin );
+
+public:
+
+    /**
+     * Constructor.
+     */
+    PercentileTwoPassPlugin( QObject * parent = 0 );
+    
+    virtual bool handleHook( BaseHook & hookData ) override;
+    virtual std::vector < HookId > getInitialHookList() override;
+    virtual ~PercentileTwoPassPlugin();
+
+    virtual void initialize( const InitInfo & initInfo ) override;
+
+private:
+    // maximum number of pixels kept in memory by the second pass
+    int64_t m_candidateBudget = 16 * 1024 * 1024;
+
+    // per-frame histograms, shared by all calculators created by this plugin
+    PercentileFrameSummaryStore::SharedPtr m_store = nullptr;
+};
@@ -0,0 +1,49 @@
+#include "PercentileTwoPass.h"
+#include "core/Algorithms/percentileAlgorithms.h"
+#include "Tests/quantileTestCommon.h"
+#include <QtTest/QtTest>
+#include <QDebug>
+
+class TestPercentileTwoPass: public QObject
+{
+    Q_OBJECT
+private slots:
+    void test_quantiles();
+    void test_refinement();
+};
+
+/// the results have to be identical to the exact quickselect algorithm
+static void compareToExact(Carta::Lib::IPercentilesToPixels<double>::SharedPtr calculator) {
+    std::vector<QuantileTestData> testCases = commonTestCases();
+    Carta::Core::Algorithms::PercentilesToPixels<double> exact;
+    
+    for (auto& testCase : testCases) {
+        std::map<double, double> intensities = calculator->percentile2pixels(testCase.view, testCase.percentiles, testCase.spectralIndex, testCase.converter, testCase.hzValues);
+        std::map<double, double> expected = exact.percentile2pixels(testCase.view, testCase.percentiles, testCase.spectralIndex, testCase.converter, testCase.hzValues);
+        
+        QVERIFY(intensities.size() == testCase.percentiles.size());
+        
+        for (auto& p : testCase.percentiles) {
+            QCOMPARE(intensities[p], expected[p]);
+        }
+    }
+}
+
+void TestPercentileTwoPass::test_quantiles() {
+    auto store = std::make_shared<PercentileFrameSummaryStore>(1024 * 1024);
+    auto calculator = std::make_shared<PercentileTwoPass<double> >(store, 1000000);
+    calculator->setDataId("test", 0);
+    
+    compareToExact(calculator);
+    // the second time around the frame histograms come from the store
+    compareToExact(calculator);
+}
+
+void TestPercentileTwoPass::test_refinement() {
+    // a tiny budget forces extra histogram passes down to individual values
+    auto calculator = std::make_shared<PercentileTwoPass<double> >(nullptr, 1);
+    compareToExact(calculator);
+}
+
+QTEST_MAIN(TestPercentileTwoPass)
+#include "testPercentileTwoPass.moc"
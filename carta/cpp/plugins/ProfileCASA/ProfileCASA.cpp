@@ -1,4 +1,5 @@
 #include "ProfileCASA.h"
+#include "SpectralProfileEngine.h"
 #include "plugins/CasaImageLoader/CCImage.h"
 #include "plugins/CasaImageLoader/CCMetaDataInterface.h"
 #include "CartaLib/Hooks/Initialize.h"
@@ -12,6 +13,7 @@
 #include <coordinates/Coordinates/DirectionCoordinate.h>
 #include <images/Regions/WCEllipsoid.h>
 #include <images/Regions/RegionManager.h>
+#include <images/Images/TempImage.h>
 #include <imageanalysis/ImageAnalysis/ImagePolarimetry.h>
 
 #include <iterator>
@@ -22,7 +24,9 @@ using namespace std;
 #include <imageanalysis/ImageAnalysis/ImageCollapserData.h>
 
 #include <iostream>
+#include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
 
 
 ProfileCASA::ProfileCASA(QObject *parent) :
@@ -160,18 +164,37 @@ Carta::Lib::Hooks::ProfileResult ProfileCASA::_generateProfile( casacore::ImageI
             = make_shared<casacore::SubImage<casacore::Float> > (*imagePtr->cloneII(), slicer, casacore::AxesSpecifier() );
         // qWarning() << image->shape().asStdVector();
 
-        casa::PixelValueManipulator<casacore::Float> pvm(image, &regionRecord, "");
         casa::ImageCollapserData::AggregateType funct = _getCombineMethod( profileInfo );
         casacore::MFrequency::Types freqType = _determineRefFrame( image );
         casacore::String frame = casacore::String( casacore::MFrequency::showType( freqType));
-
         casacore::Quantity restFreq( restFrequency, casacore::Unit( restUnit.toStdString().c_str()));
-        casacore::Record result = pvm.getProfile( spectralAxis, funct, unit, specType,
-                &restFreq, frame );
 
-        const casacore::String VALUE_KEY( "values");
-        if ( result.isDefined( VALUE_KEY )){
-            result.get( VALUE_KEY, jyValues );
+        //Regions are read directly from the tiles; casa is then only needed for the
+        //spectral coordinates, which it can get from an image that is a single pixel wide.
+        std::vector<double> fastValues;
+        SpectralProfileEngine engine( imagePtr, spectralAxis, stokesAxis, stokesFrame,
+                m_spectralCache.get(), &Carta::Lib::Regions::RegionMaskCache::shared() );
+        bool fast = engine.getProfile( regionInfo, profileInfo.getAggregateType(), fastValues );
+        casacore::Record result;
+        if ( fast ){
+            casacore::Record wholeImage;
+            casa::PixelValueManipulator<casacore::Float> pvm( _getSpectralImage( image, spectralAxis ),
+                    &wholeImage, "");
+            result = pvm.getProfile( spectralAxis, funct, unit, specType, &restFreq, frame );
+            jyValues.resize( fastValues.size() );
+            for ( size_t i = 0; i < fastValues.size(); i++ ){
+                jyValues[i] = fastValues[i];
+            }
+        }
+        else {
+            casa::PixelValueManipulator<casacore::Float> pvm(image, &regionRecord, "");
+            result = pvm.getProfile( spectralAxis, funct, unit, specType,
+                    &restFreq, frame );
+
+            const casacore::String VALUE_KEY( "values");
+            if ( result.isDefined( VALUE_KEY )){
+                result.get( VALUE_KEY, jyValues );
+            }
         }
 
         const casacore::String X_KEY( "coords");
@@ -179,7 +202,7 @@ Carta::Lib::Hooks::ProfileResult ProfileCASA::_generateProfile( casacore::ImageI
             result.get( X_KEY, xValues );
         }
 
-        int dataCount = jyValues.size();
+        int dataCount = std::min( jyValues.size(), xValues.size() );
         for ( int i = 0; i < dataCount; i++ ){
             std::pair<double,double> dataPair(xValues[i], jyValues[i]);
             profileData.push_back( dataPair );
@@ -284,6 +307,32 @@ casacore::ImageRegion* ProfileCASA::_getEllipsoid(const casacore::CoordinateSyst
 }
 
 
+std::shared_ptr<casacore::ImageInterface<casacore::Float> > ProfileCASA::_getSpectralImage(
+        std::shared_ptr<casacore::ImageInterface<casacore::Float> > image, int spectralAxis ) const {
+    casacore::IPosition shape( image->ndim(), 1 );
+    shape(spectralAxis) = image->shape()(spectralAxis);
+    std::shared_ptr<casacore::TempImage<casacore::Float> > spectralImage =
+            std::make_shared<casacore::TempImage<casacore::Float> >(
+                    casacore::TiledShape( shape ), image->coordinates() );
+    spectralImage->set( 0 );
+    return spectralImage;
+}
+
+
+void ProfileCASA::initialize( const IPlugin::InitInfo & initInfo ){
+    //The spectral cache is optional and off by default; it is enabled by giving it a directory.
+    QString cacheDir = initInfo.json.value( "spectralCacheDir" ).toString();
+    if ( !cacheDir.isEmpty() ){
+        cacheDir.replace( "$(HOME)", QDir::homePath() );
+        cacheDir.replace( "$(APPDIR)", QCoreApplication::applicationDirPath() );
+        cacheDir = QDir( cacheDir ).absolutePath();
+        qint64 cacheMB = initInfo.json.value( "spectralCacheMB" ).toInt( 512 );
+        int minChannels = initInfo.json.value( "spectralCacheMinChannels" ).toInt( 256 );
+        m_spectralCache.reset( new SpectralCache( cacheDir, cacheMB * 1024 * 1024, minChannels ) );
+    }
+}
+
+
 std::vector<HookId> ProfileCASA::getInitialHookList(){
     return {
         Carta::Lib::Hooks::Initialize::staticId,
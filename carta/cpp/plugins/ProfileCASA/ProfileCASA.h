@@ -6,11 +6,14 @@
 #include "CartaLib/IPlugin.h"
 #include "CartaLib/ProfileInfo.h"
 #include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/RegionMask.h"
 #include "CartaLib/Hooks/ProfileResult.h"
+#include "SpectralCache.h"
 #include "plugins/CasaImageLoader/CCImage.h"
 #include <imageanalysis/ImageAnalysis/ImageCollapserData.h>
 
 #include <QObject>
+#include <memory>
 
 
 namespace casacore {
@@ -31,6 +34,7 @@ public:
      */
     ProfileCASA(QObject *parent = 0);
     virtual bool handleHook(BaseHook & hookData) override;
+    virtual void initialize( const InitInfo & initInfo ) override;
     virtual std::vector<HookId> getInitialHookList() override;
     virtual ~ProfileCASA();
 
@@ -40,6 +44,8 @@ private:
             std::shared_ptr<casacore::ImageInterface<casacore::Float> > img ) const;
     Carta::Lib::Hooks::ProfileResult _generateProfile( casacore::ImageInterface < casacore::Float > * imagePtr,
             std::shared_ptr<Carta::Lib::Regions::RegionBase> regionInfo, Carta::Lib::ProfileInfo profileInfo ) const;
+    std::shared_ptr<casacore::ImageInterface<casacore::Float> > _getSpectralImage(
+            std::shared_ptr<casacore::ImageInterface<casacore::Float> > image, int spectralAxis ) const;
     casa::ImageCollapserData::AggregateType _getCombineMethod( Carta::Lib::ProfileInfo profileInfo ) const;
     casacore::ImageRegion* _getEllipsoid(const casacore::CoordinateSystem& cSys,
             const casacore::Vector<casacore::Double>& x, const casacore::Vector<casacore::Double>& y) const;
@@ -50,6 +56,9 @@ private:
 
     casacore::Vector<casacore::Double> _toWorld( const casacore::CoordinateSystem& cSys,
     		double x, double y, bool* successful ) const;
+    //Spectral-major copies of cubes for point profiles (null when disabled).
+    std::unique_ptr<SpectralCache> m_spectralCache;
+
     const QString PIXEL_UNIT;
     const QString RADIAN_UNIT;
 };
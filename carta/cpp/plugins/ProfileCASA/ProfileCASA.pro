@@ -8,10 +8,14 @@ TEMPLATE = lib
 CONFIG += plugin
 
 SOURCES += \
-    ProfileCASA.cpp
+    ProfileCASA.cpp \
+    SpectralCache.cpp \
+    SpectralProfileEngine.cpp
 
 HEADERS += \
-    ProfileCASA.h
+    ProfileCASA.h \
+    SpectralCache.h \
+    SpectralProfileEngine.h
 
 casacoreLIBS += -L$${CASACOREDIR}/lib
 casacoreLIBS += -lcasa_lattices -lcasa_tables -lcasa_scimath -lcasa_scimath_f -lcasa_mirlib
@@ -0,0 +1,387 @@
+#include "SpectralCache.h"
+
+#include <casa/Arrays/Array.h>
+#include <casa/Arrays/Slicer.h>
+#include <images/Images/ImageOpener.h>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace {
+
+//Maximum number of pixels read with one call to casacore while building a copy.
+const casacore::Int64 BUILD_SLAB_PIXELS = 32 * 1024 * 1024;
+
+//Age after which a lock without a valid process id is considered abandoned.
+const int STALE_LOCK_SECONDS = 60;
+
+bool _readFully( int file, char* data, qint64 size, qint64 offset ){
+    while ( size > 0 ){
+        ssize_t n = pread( file, data, size, offset );
+        if ( n <= 0 ){
+            if ( n < 0 && errno == EINTR ){
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+bool _writeFully( int file, const char* data, qint64 size ){
+    while ( size > 0 ){
+        ssize_t n = write( file, data, size );
+        if ( n <= 0 ){
+            if ( n < 0 && errno == EINTR ){
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+}
+
+const int SpectralCache::HEADER_SIZE = 64;
+const char SpectralCache::MAGIC[8] = { 'C', 'A', 'R', 'T', 'A', 'S', 'P', '1' };
+
+
+SpectralCache::SpectralCache( const QString& directory, qint64 maxBytes, int minChannels ) :
+    m_directory( directory ),
+    m_maxBytes( maxBytes ),
+    m_minChannels( minChannels ),
+    m_openFile( -1 ){
+}
+
+
+QString SpectralCache::_getKey( const QString& fileName, const Axes& axes ) const {
+    QFileInfo info( fileName );
+    QString id = QString( "%1|%2|%3|%4|%5|%6|%7" ).arg( info.absoluteFilePath() )
+            .arg( info.lastModified().toMSecsSinceEpoch() )
+            .arg( axes.x ).arg( axes.y ).arg( axes.spectral ).arg( axes.stokes ).arg( axes.stokesFrame );
+    return QCryptographicHash::hash( id.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+}
+
+
+bool SpectralCache::_openCopy( const QString& path, casacore::Int64 width, casacore::Int64 height,
+        casacore::Int64 channelCount ){
+    if ( m_openFile >= 0 && m_openPath == path ){
+        return true;
+    }
+    if ( m_openFile >= 0 ){
+        close( m_openFile );
+        m_openFile = -1;
+        m_openPath.clear();
+    }
+    int file = open( path.toLocal8Bit().constData(), O_RDONLY );
+    if ( file < 0 ){
+        return false;
+    }
+    char header[HEADER_SIZE];
+    casacore::Int64 dims[3];
+    if ( !_readFully( file, header, HEADER_SIZE, 0 ) || memcmp( header, MAGIC, sizeof(MAGIC) ) != 0 ){
+        close( file );
+        return false;
+    }
+    memcpy( dims, header + sizeof(MAGIC), sizeof(dims) );
+    if ( dims[0] != width || dims[1] != height || dims[2] != channelCount ){
+        close( file );
+        return false;
+    }
+    m_openFile = file;
+    m_openPath = path;
+    return true;
+}
+
+
+bool SpectralCache::readSpectrum( casacore::ImageInterface<casacore::Float>* image, const Axes& axes,
+        int x, int y, std::vector<float>& values ){
+    if ( !image || m_directory.isEmpty() ){
+        return false;
+    }
+    QString fileName( image->name( false ).c_str() );
+    if ( fileName.isEmpty() || !QFileInfo( fileName ).exists() ){
+        return false;
+    }
+    casacore::IPosition shape = image->shape();
+    const casacore::Int64 width = shape(axes.x);
+    const casacore::Int64 height = shape(axes.y);
+    const casacore::Int64 channelCount = shape(axes.spectral);
+    if ( channelCount < m_minChannels || x < 0 || x >= width || y < 0 || y >= height ){
+        return false;
+    }
+
+    QString key = _getKey( fileName, axes );
+    QString path = QDir( m_directory ).filePath( key + ".spec" );
+    if ( !_openCopy( path, width, height, channelCount ) ){
+        if ( !m_scheduled.contains( key ) ){
+            m_scheduled.insert( key );
+            _schedule( fileName, key, axes, HEADER_SIZE + width * height * channelCount * sizeof(float) );
+        }
+        return false;
+    }
+
+    values.resize( channelCount );
+    qint64 offset = HEADER_SIZE + ( y * width + x ) * channelCount * sizeof(float);
+    if ( !_readFully( m_openFile, reinterpret_cast<char*>( values.data() ),
+            channelCount * sizeof(float), offset ) ){
+        close( m_openFile );
+        m_openFile = -1;
+        m_openPath.clear();
+        return false;
+    }
+
+    //The modification time of a copy records when it was last used.
+    utime( path.toLocal8Bit().constData(), nullptr );
+    return true;
+}
+
+
+void SpectralCache::_schedule( const QString& fileName, const QString& key, const Axes& axes,
+        casacore::Int64 copyBytes ){
+    if ( copyBytes > m_maxBytes ){
+        return;
+    }
+    if ( !QDir().mkpath( m_directory ) ){
+        qWarning() << "Could not create the spectral cache directory "<<m_directory;
+        return;
+    }
+
+    //The lock holds the id of the process building the copy; a lock left behind by a
+    //process that no longer exists is removed. A process that died between creating
+    //the lock and writing its id leaves an empty lock, which is removed once it is old.
+    QString lockPath = QDir( m_directory ).filePath( key + ".lock" );
+    QByteArray lockName = lockPath.toLocal8Bit();
+    int lock = open( lockName.constData(), O_CREAT | O_EXCL | O_WRONLY, 0644 );
+    if ( lock < 0 && errno == EEXIST ){
+        QFile lockFile( lockPath );
+        if ( lockFile.open( QIODevice::ReadOnly ) ){
+            bool valid = false;
+            pid_t owner = lockFile.readAll().trimmed().toInt( &valid );
+            lockFile.close();
+            bool stale = false;
+            if ( valid ){
+                stale = kill( owner, 0 ) != 0 && errno == ESRCH;
+            }
+            else {
+                QDateTime modified = QFileInfo( lockPath ).lastModified();
+                stale = modified.isValid() &&
+                        modified.secsTo( QDateTime::currentDateTime() ) > STALE_LOCK_SECONDS;
+            }
+            if ( stale ){
+                unlink( lockName.constData() );
+                lock = open( lockName.constData(), O_CREAT | O_EXCL | O_WRONLY, 0644 );
+            }
+        }
+    }
+    if ( lock < 0 ){
+        return;
+    }
+    //Owned by this process until the grandchild building the copy takes it over.
+    QByteArray ownerId = QByteArray::number( static_cast<qint64>( getpid() ) );
+    _writeFully( lock, ownerId.constData(), ownerId.size() );
+
+    //The copy is built by a detached grandchild, so this process does not have to
+    //reap it and can keep serving requests.
+    QString path = QDir( m_directory ).filePath( key + ".spec" );
+    QString directory = m_directory;
+    qint64 maxBytes = m_maxBytes;
+    pid_t child = fork();
+    if ( child == 0 ){
+        pid_t grandchild = fork();
+        if ( grandchild == 0 ){
+            //Do not keep the sockets and files of the parent alive.
+            long maxFiles = std::min( sysconf( _SC_OPEN_MAX ), 4096L );
+            for ( int i = 3; i < maxFiles; i++ ){
+                if ( i != lock ){
+                    close( i );
+                }
+            }
+            QByteArray pid = QByteArray::number( static_cast<qint64>( getpid() ) );
+            if ( ftruncate( lock, 0 ) == 0 && lseek( lock, 0, SEEK_SET ) == 0 ){
+                _writeFully( lock, pid.constData(), pid.size() );
+            }
+            close( lock );
+            bool built = _build( fileName, axes, path );
+            if ( built ){
+                _evict( directory, maxBytes );
+            }
+            unlink( lockName.constData() );
+            _exit( built ? 0 : 1 );
+        }
+        if ( grandchild < 0 ){
+            unlink( lockName.constData() );
+        }
+        _exit( 0 );
+    }
+    close( lock );
+    if ( child < 0 ){
+        qWarning() << "Could not start building the spectral cache: "<<strerror( errno );
+        unlink( lockName.constData() );
+        return;
+    }
+    while ( waitpid( child, nullptr, 0 ) < 0 && errno == EINTR ){
+    }
+}
+
+
+bool SpectralCache::_build( const QString& fileName, const Axes& axes, const QString& path ){
+    QString tempPath = QString( "%1.%2.tmp" ).arg( path ).arg( static_cast<qint64>( getpid() ) );
+    QByteArray tempName = tempPath.toLocal8Bit();
+    int file = -1;
+    bool built = false;
+    try {
+        std::unique_ptr<casacore::LatticeBase> lattice(
+                casacore::ImageOpener::openImage( fileName.toStdString() ) );
+        casacore::ImageInterface<casacore::Float>* image =
+                dynamic_cast<casacore::ImageInterface<casacore::Float>*>( lattice.get() );
+        if ( !image ){
+            return false;
+        }
+        casacore::IPosition shape = image->shape();
+        const int ndim = shape.size();
+        const casacore::Int64 width = shape(axes.x);
+        const casacore::Int64 height = shape(axes.y);
+        const casacore::Int64 channelCount = shape(axes.spectral);
+
+        file = open( tempName.constData(), O_CREAT | O_TRUNC | O_WRONLY, 0644 );
+        if ( file < 0 ){
+            return false;
+        }
+        char header[HEADER_SIZE];
+        memset( header, 0, HEADER_SIZE );
+        memcpy( header, MAGIC, sizeof(MAGIC) );
+        casacore::Int64 dims[3] = { width, height, channelCount };
+        memcpy( header + sizeof(MAGIC), dims, sizeof(dims) );
+        bool written = _writeFully( file, header, HEADER_SIZE );
+
+        //Read whole rows of tiles with all their channels, then write them out pixel by pixel.
+        casacore::Int64 rows = std::max<casacore::Int64>( 1, BUILD_SLAB_PIXELS / ( width * channelCount ) );
+        casacore::Int64 tileRows = std::max<casacore::Int64>( 1, image->niceCursorShape()(axes.y) );
+        if ( rows > tileRows ){
+            rows = rows / tileRows * tileRows;
+        }
+        rows = std::min( rows, height );
+        const bool masked = image->isMasked();
+        std::vector<float> pixelRow( width * channelCount );
+        for ( casacore::Int64 y0 = 0; y0 < height && written; y0 += rows ){
+            casacore::IPosition start( ndim, 0 );
+            casacore::IPosition length( ndim, 1 );
+            start(axes.y) = y0;
+            length(axes.x) = width;
+            length(axes.y) = std::min( rows, height - y0 );
+            length(axes.spectral) = channelCount;
+            if ( axes.stokes >= 0 ){
+                start(axes.stokes) = axes.stokesFrame;
+            }
+            casacore::Slicer slicer( start, length, casacore::Slicer::endIsLength );
+            casacore::Array<casacore::Float> data = image->getSlice( slicer );
+            casacore::Array<casacore::Bool> mask;
+            if ( masked ){
+                mask = image->getMaskSlice( slicer );
+            }
+            casacore::Bool deleteData = false;
+            casacore::Bool deleteMask = false;
+            const casacore::Float* pixels = data.getStorage( deleteData );
+            const casacore::Bool* good = masked ? mask.getStorage( deleteMask ) : nullptr;
+
+            casacore::Int64 stride = 1;
+            casacore::Int64 strideX = 1;
+            casacore::Int64 strideY = 1;
+            casacore::Int64 strideChannel = 1;
+            for ( int i = 0; i < ndim; i++ ){
+                if ( i == axes.x ){
+                    strideX = stride;
+                }
+                else if ( i == axes.y ){
+                    strideY = stride;
+                }
+                else if ( i == axes.spectral ){
+                    strideChannel = stride;
+                }
+                stride *= length(i);
+            }
+            for ( casacore::Int64 row = 0; row < length(axes.y) && written; row++ ){
+                for ( casacore::Int64 x = 0; x < width; x++ ){
+                    float* spectrum = &pixelRow[x * channelCount];
+                    casacore::Int64 index = x * strideX + row * strideY;
+                    for ( casacore::Int64 c = 0; c < channelCount; c++ ){
+                        spectrum[c] = ( good && !good[index] ) ?
+                                std::numeric_limits<float>::quiet_NaN() : pixels[index];
+                        index += strideChannel;
+                    }
+                }
+                written = _writeFully( file, reinterpret_cast<const char*>( pixelRow.data() ),
+                        pixelRow.size() * sizeof(float) );
+            }
+            data.freeStorage( pixels, deleteData );
+            if ( good ){
+                mask.freeStorage( good, deleteMask );
+            }
+        }
+        built = written && close( file ) == 0;
+        file = -1;
+        if ( built ){
+            built = rename( tempName.constData(), path.toLocal8Bit().constData() ) == 0;
+        }
+    }
+    catch( const casacore::AipsError& error ){
+        qDebug() << "Could not build the spectral cache of "<<fileName<<": "<<error.getMesg().c_str();
+        built = false;
+    }
+    if ( file >= 0 ){
+        close( file );
+    }
+    if ( !built ){
+        unlink( tempName.constData() );
+    }
+    return built;
+}
+
+
+void SpectralCache::_evict( const QString& directory, qint64 maxBytes ){
+    QDir dir( directory );
+    QFileInfoList copies = dir.entryInfoList( QStringList( "*.spec" ), QDir::Files,
+            QDir::Time | QDir::Reversed );
+    qint64 total = 0;
+    for ( const QFileInfo& copy : copies ){
+        total += copy.size();
+    }
+    for ( const QFileInfo& copy : copies ){
+        if ( total <= maxBytes ){
+            break;
+        }
+        if ( QFile::remove( copy.absoluteFilePath() ) ){
+            total -= copy.size();
+        }
+    }
+}
+
+
+SpectralCache::~SpectralCache(){
+    if ( m_openFile >= 0 ){
+        close( m_openFile );
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * Disk cache of spectral-major ("transposed") copies of image cubes.
+ *
+ * Cubes are normally stored one image plane after another, so the spectrum of a
+ * single pixel is scattered over the whole file. When a point profile is requested
+ * for a large enough cube, a background process writes a copy of the cube in which the
+ * channels of each pixel are adjacent; subsequent point profiles of that cube are a
+ * single contiguous read from the copy.
+ *
+ * The copies live in one directory, are named after the image, its modification time
+ * and the polarization, and are evicted least recently used first when their total size
+ * exceeds the budget. Several worker processes can share the directory; a lock file
+ * makes sure each copy is built only once.
+ */
+#pragma once
+
+#include <images/Images/ImageInterface.h>
+
+#include <QString>
+#include <QSet>
+
+#include <vector>
+
+
+class SpectralCache {
+
+public:
+
+    /// pixel axes of the image that the copy is made from
+    struct Axes {
+        int x;
+        int y;
+        int spectral;
+        int stokes;
+        int stokesFrame;
+    };
+
+    /**
+     * Constructor.
+     * @param directory - the directory where the copies are stored.
+     * @param maxBytes - the maximum total size of the copies.
+     * @param minChannels - the smallest number of channels for which a copy is made.
+     */
+    SpectralCache( const QString& directory, qint64 maxBytes, int minChannels );
+
+    /**
+     * Reads the spectrum of a pixel from the copy of the image. If there is no copy yet,
+     * one is scheduled to be made in the background.
+     * @param image - the image.
+     * @param axes - the axes and polarization of the image.
+     * @param x - the pixel position along the x axis.
+     * @param y - the pixel position along the y axis.
+     * @param values - set to the pixel value of each channel; masked pixels are NaN.
+     * @return - true if the spectrum was read from the copy; false otherwise.
+     */
+    bool readSpectrum( casacore::ImageInterface<casacore::Float>* image, const Axes& axes,
+            int x, int y, std::vector<float>& values );
+
+    /**
+     * Destructor.
+     */
+    ~SpectralCache();
+
+private:
+
+    QString _getKey( const QString& fileName, const Axes& axes ) const;
+    bool _openCopy( const QString& path, casacore::Int64 width, casacore::Int64 height,
+            casacore::Int64 channelCount );
+    void _schedule( const QString& fileName, const QString& key, const Axes& axes,
+            casacore::Int64 copyBytes );
+
+    /// builds a copy in the background process, returns true on success
+    static bool _build( const QString& fileName, const Axes& axes, const QString& path );
+
+    /// removes the least recently used copies until the budget is met
+    static void _evict( const QString& directory, qint64 maxBytes );
+
+    QString m_directory;
+    qint64 m_maxBytes;
+    int m_minChannels;
+
+    //Copies whose construction has already been attempted by this process.
+    QSet<QString> m_scheduled;
+
+    //The most recently read copy is kept open.
+    QString m_openPath;
+    int m_openFile;
+
+    //Size of the header that precedes the pixel data in a copy.
+    static const int HEADER_SIZE;
+    static const char MAGIC[8];
+
+    SpectralCache( const SpectralCache& other);
+    SpectralCache& operator=( const SpectralCache& other );
+};
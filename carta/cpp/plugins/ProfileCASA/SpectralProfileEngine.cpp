@@ -0,0 +1,241 @@
+#include "SpectralProfileEngine.h"
+#include "CartaLib/Regions/Point.h"
+
+#include <casa/Arrays/Array.h>
+#include <casa/Arrays/Slicer.h>
+#include <coordinates/Coordinates/CoordinateSystem.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QDebug>
+
+
+const casacore::Int64 SpectralProfileEngine::SLAB_PIXELS = 1024 * 1024;
+
+
+SpectralProfileEngine::SpectralProfileEngine( casacore::ImageInterface<casacore::Float>* image,
+        int spectralAxis, int stokesAxis, int stokesFrame, SpectralCache* cache,
+        Carta::Lib::Regions::RegionMaskCache* masks ) :
+    m_image( image ),
+    m_spectralAxis( spectralAxis ),
+    m_stokesAxis( stokesAxis ),
+    m_stokesFrame( stokesFrame ),
+    m_cache( cache ),
+    m_masks( masks ){
+}
+
+
+bool SpectralProfileEngine::isSupported( Carta::Lib::ProfileInfo::AggregateType aggregate ){
+    bool supported = false;
+    if ( aggregate == Carta::Lib::ProfileInfo::AggregateType::MEAN ||
+            aggregate == Carta::Lib::ProfileInfo::AggregateType::SUM ||
+            aggregate == Carta::Lib::ProfileInfo::AggregateType::MIN ||
+            aggregate == Carta::Lib::ProfileInfo::AggregateType::MAX ||
+            aggregate == Carta::Lib::ProfileInfo::AggregateType::RMS ){
+        supported = true;
+    }
+    return supported;
+}
+
+
+bool SpectralProfileEngine::getProfile( std::shared_ptr<Carta::Lib::Regions::RegionBase> region,
+        Carta::Lib::ProfileInfo::AggregateType aggregate,
+        std::vector<double>& values ) const {
+    if ( !m_image || !region || !isSupported( aggregate ) ){
+        return false;
+    }
+    bool point = region->typeName() == Carta::Lib::Regions::Point::TypeName;
+
+    //The region is given in the pixel coordinates of the direction axes.
+    const casacore::CoordinateSystem& cSys = m_image->coordinates();
+    int directionIndex = cSys.findCoordinate( casacore::Coordinate::DIRECTION );
+    if ( directionIndex < 0 ){
+        return false;
+    }
+    casacore::Vector<casacore::Int> dirPixelAxis = cSys.pixelAxes( directionIndex );
+    if ( dirPixelAxis.size() != 2 || dirPixelAxis[0] < 0 || dirPixelAxis[1] < 0 ){
+        return false;
+    }
+    const int xAxis = dirPixelAxis[0];
+    const int yAxis = dirPixelAxis[1];
+
+    //Any other axis that is not degenerate would need to be collapsed as well;
+    //leave that to casa.
+    casacore::IPosition shape = m_image->shape();
+    const int ndim = shape.size();
+    if ( m_spectralAxis < 0 || m_spectralAxis >= ndim ||
+            m_spectralAxis == xAxis || m_spectralAxis == yAxis ){
+        return false;
+    }
+    for ( int i = 0; i < ndim; i++ ){
+        if ( i != xAxis && i != yAxis && i != m_spectralAxis && i != m_stokesAxis && shape(i) > 1 ){
+            return false;
+        }
+    }
+
+    //Pixels of the region; the bounding box of the mask is read and only the pixels in
+    //the mask are used.
+    const int width = shape(xAxis);
+    const int height = shape(yAxis);
+    Carta::Lib::Regions::RegionMask::ConstSharedPtr mask = m_masks ?
+            m_masks->mask( *region, width, height ) :
+            Carta::Lib::Regions::RegionMask::fromRegion( *region, width, height );
+    if ( mask->isEmpty() ){
+        return false;
+    }
+    QRect box = mask->boundingRect();
+    casacore::IPosition blc( ndim, 0 );
+    casacore::IPosition length( ndim, 1 );
+    blc(xAxis) = box.x();
+    blc(yAxis) = box.y();
+    length(xAxis) = box.width();
+    length(yAxis) = box.height();
+    if ( m_stokesAxis >= 0 && m_stokesAxis < ndim ){
+        if ( m_stokesFrame < 0 || m_stokesFrame >= shape(m_stokesAxis) ){
+            return false;
+        }
+        blc(m_stokesAxis) = m_stokesFrame;
+    }
+
+    //A point is a single contiguous read if there is a spectral-major copy of the image.
+    if ( point && m_cache ){
+        SpectralCache::Axes axes = { xAxis, yAxis, m_spectralAxis, m_stokesAxis,
+                m_stokesAxis >= 0 ? m_stokesFrame : 0 };
+        std::vector<float> spectrum;
+        if ( m_cache->readSpectrum( m_image, axes, blc(xAxis), blc(yAxis), spectrum ) ){
+            values.resize( spectrum.size() );
+            for ( size_t i = 0; i < spectrum.size(); i++ ){
+                double value = spectrum[i];
+                if ( std::isnan( value ) ){
+                    value = 0;
+                }
+                else if ( aggregate == Carta::Lib::ProfileInfo::AggregateType::RMS ){
+                    value = std::fabs( value );
+                }
+                values[i] = value;
+            }
+            return true;
+        }
+    }
+
+    //Read slabs of whole tiles along the spectral axis, as deep as the pixel budget allows.
+    const casacore::Int64 channelCount = shape(m_spectralAxis);
+    const casacore::Int64 footprint = length(xAxis) * length(yAxis);
+    casacore::IPosition tileShape = m_image->niceCursorShape();
+    casacore::Int64 tileDepth = std::max<casacore::Int64>( 1, tileShape(m_spectralAxis) );
+    casacore::Int64 slabDepth = tileDepth * std::max<casacore::Int64>( 1, SLAB_PIXELS / ( footprint * tileDepth ) );
+    slabDepth = std::min( slabDepth, channelCount );
+
+    casacore::IPosition sliceShape = length;
+    sliceShape(m_spectralAxis) = slabDepth;
+    casacore::IPosition windowLength = length;
+    windowLength(m_spectralAxis) = channelCount;
+    casacore::IPosition axisPath( ndim );
+    axisPath(0) = m_spectralAxis;
+    for ( int i = 0, j = 1; i < ndim; i++ ){
+        if ( i != m_spectralAxis ){
+            axisPath(j++) = i;
+        }
+    }
+    m_image->setCacheSizeFromPath( sliceShape, blc, windowLength, axisPath );
+
+    std::vector<double> sums( channelCount, 0 );
+    std::vector<double> squares( channelCount, 0 );
+    std::vector<double> mins( channelCount, std::numeric_limits<double>::max() );
+    std::vector<double> maxs( channelCount, std::numeric_limits<double>::lowest() );
+    std::vector<casacore::Int64> counts( channelCount, 0 );
+
+    const std::vector<Carta::Lib::Regions::RegionMask::Run>& runs = mask->runs();
+    const bool masked = m_image->isMasked();
+    try {
+        for ( casacore::Int64 first = 0; first < channelCount; first += slabDepth ){
+            casacore::Int64 depth = std::min( slabDepth, channelCount - first );
+            casacore::IPosition start = blc;
+            start(m_spectralAxis) = first;
+            casacore::IPosition slabLength = length;
+            slabLength(m_spectralAxis) = depth;
+            casacore::Slicer slicer( start, slabLength, casacore::Slicer::endIsLength );
+
+            casacore::Array<casacore::Float> data = m_image->getSlice( slicer );
+            casacore::Array<casacore::Bool> pixelMask;
+            if ( masked ){
+                pixelMask = m_image->getMaskSlice( slicer );
+            }
+            casacore::Bool deleteData = false;
+            casacore::Bool deleteMask = false;
+            const casacore::Float* pixels = data.getStorage( deleteData );
+            const casacore::Bool* good = masked ? pixelMask.getStorage( deleteMask ) : nullptr;
+
+            //Offsets of a step along the axes in the slab.
+            casacore::IPosition strides( ndim, 1 );
+            for ( int i = 1; i < ndim; i++ ){
+                strides(i) = strides(i - 1) * slabLength(i - 1);
+            }
+            for ( casacore::Int64 c = 0; c < depth; c++ ){
+                const casacore::Int64 channel = first + c;
+                double sum = 0;
+                double square = 0;
+                double minValue = mins[channel];
+                double maxValue = maxs[channel];
+                casacore::Int64 n = 0;
+                for ( const Carta::Lib::Regions::RegionMask::Run& run : runs ){
+                    casacore::Int64 i = c * strides(m_spectralAxis) +
+                            ( run.y - blc(yAxis) ) * strides(yAxis) +
+                            ( run.x0 - blc(xAxis) ) * strides(xAxis);
+                    for ( int x = run.x0; x < run.x1; x++, i += strides(xAxis) ){
+                        const double value = pixels[i];
+                        if ( std::isnan( value ) || ( good && !good[i] ) ){
+                            continue;
+                        }
+                        sum += value;
+                        square += value * value;
+                        minValue = std::min( minValue, value );
+                        maxValue = std::max( maxValue, value );
+                        n++;
+                    }
+                }
+                sums[channel] += sum;
+                squares[channel] += square;
+                mins[channel] = minValue;
+                maxs[channel] = maxValue;
+                counts[channel] += n;
+            }
+
+            data.freeStorage( pixels, deleteData );
+            if ( good ){
+                pixelMask.freeStorage( good, deleteMask );
+            }
+        }
+    }
+    catch( const casacore::AipsError& error ){
+        qDebug() << "Could not read profile data: "<<error.getMesg().c_str();
+        return false;
+    }
+
+    //Channels without any valid pixel are reported as zero, as the collapser does.
+    values.resize( channelCount );
+    for ( casacore::Int64 i = 0; i < channelCount; i++ ){
+        double value = 0;
+        if ( counts[i] > 0 ){
+            if ( aggregate == Carta::Lib::ProfileInfo::AggregateType::MEAN ){
+                value = sums[i] / counts[i];
+            }
+            else if ( aggregate == Carta::Lib::ProfileInfo::AggregateType::SUM ){
+                value = sums[i];
+            }
+            else if ( aggregate == Carta::Lib::ProfileInfo::AggregateType::MIN ){
+                value = mins[i];
+            }
+            else if ( aggregate == Carta::Lib::ProfileInfo::AggregateType::MAX ){
+                value = maxs[i];
+            }
+            else if ( aggregate == Carta::Lib::ProfileInfo::AggregateType::RMS ){
+                value = std::sqrt( squares[i] / counts[i] );
+            }
+        }
+        values[i] = value;
+    }
+    return true;
+}
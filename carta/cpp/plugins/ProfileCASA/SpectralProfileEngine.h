@@ -0,0 +1,73 @@
+/**
+ * Computes spectral profiles of regions directly from the pixel data.
+ *
+ * Casa's PixelValueManipulator goes through the general region and collapser
+ * machinery, which is needed for statistics such as the median, but is far too slow
+ * for a cursor following a single pixel through a large cube, and tests every pixel
+ * against the shape of the region again for every profile. This engine reads the
+ * bounding box of the region one slab of channels at a time, with the slab depth
+ * chosen from the tile shape so that every tile is read once and in order, and
+ * accumulates the statistic for all channels in a single pass over the pixels of the
+ * region's rasterized mask.
+ */
+#pragma once
+
+#include "SpectralCache.h"
+#include "CartaLib/ProfileInfo.h"
+#include "CartaLib/Regions/IRegion.h"
+#include "CartaLib/Regions/RegionMask.h"
+
+#include <images/Images/ImageInterface.h>
+
+#include <memory>
+#include <vector>
+
+
+class SpectralProfileEngine {
+
+public:
+
+    /**
+     * Constructor.
+     * @param image - the image to profile; it is not owned by the engine.
+     * @param spectralAxis - the pixel axis along which the profile is taken.
+     * @param stokesAxis - the polarization axis of the image or -1 if there is none.
+     * @param stokesFrame - the frame of the polarization axis to profile.
+     * @param cache - spectral-major copies used for point profiles (may be null).
+     * @param masks - the masks of recently profiled regions (may be null).
+     */
+    SpectralProfileEngine( casacore::ImageInterface<casacore::Float>* image,
+            int spectralAxis, int stokesAxis, int stokesFrame, SpectralCache* cache = nullptr,
+            Carta::Lib::Regions::RegionMaskCache* masks = nullptr );
+
+    /**
+     * Returns whether the engine is able to compute the statistic.
+     * @param aggregate - the statistic that combines the pixels of a channel.
+     * @return - true if the statistic can be computed by the engine; false otherwise.
+     */
+    static bool isSupported( Carta::Lib::ProfileInfo::AggregateType aggregate );
+
+    /**
+     * Computes the profile of a region.
+     * @param region - the region to profile.
+     * @param aggregate - the statistic that combines the pixels of a channel.
+     * @param values - set to the value of the statistic for each channel.
+     * @return - true if the profile was computed; false if the region, statistic or image
+     *      are not handled by the engine and the general method should be used instead.
+     */
+    bool getProfile( std::shared_ptr<Carta::Lib::Regions::RegionBase> region,
+            Carta::Lib::ProfileInfo::AggregateType aggregate,
+            std::vector<double>& values ) const;
+
+private:
+
+    casacore::ImageInterface<casacore::Float>* m_image;
+    int m_spectralAxis;
+    int m_stokesAxis;
+    int m_stokesFrame;
+    SpectralCache* m_cache;
+    Carta::Lib::Regions::RegionMaskCache* m_masks;
+
+    //Maximum number of pixels read with one call to casacore.
+    static const casacore::Int64 SLAB_PIXELS;
+};
@@ -3,6 +3,7 @@ TEMPLATE = subdirs
 
 SUBDIRS += casaCore
 SUBDIRS += CasaImageLoader
+SUBDIRS += CasaImageLoader/Test.pro
 SUBDIRS += Colormaps1
 SUBDIRS += Fitter1D
 SUBDIRS += Histogram
@@ -23,6 +24,8 @@ SUBDIRS += DevIntegration
 SUBDIRS += PCacheSqlite3
 SUBDIRS += PercentileHistogram
 SUBDIRS += PercentileHistogram/Test.pro
+SUBDIRS += PercentileTwoPass
+SUBDIRS += PercentileTwoPass/Test.pro
 SUBDIRS += PercentileManku99
 SUBDIRS += PercentileManku99/Test.pro
 
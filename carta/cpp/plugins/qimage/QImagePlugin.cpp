@@ -164,11 +164,7 @@ public:
              char * buff,
              Traversal traversal ) override
     {
-        Q_UNUSED( buffSize );
-        Q_UNUSED( func );
-        Q_UNUSED( buff );
-        Q_UNUSED( traversal );
-        qFatal( "not implemented" );
+        forEachBufferedFallback( buffSize, func, buff, traversal );
     }
 
 private:
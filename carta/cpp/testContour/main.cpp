@@ -0,0 +1,183 @@
+/*
+ * Benchmark for the contour algorithm (CartaLib/Algorithms/ContourConrec.h)
+ *
+ * Contours a synthetic float frame with the original single threaded algorithm and
+ * with the banded one, checks that the results are identical (nearly identical when
+ * smoothing, as the banded algorithm smooths with two 1D passes), and reports the
+ * time taken for different numbers of threads. Then reports the time taken to also
+ * join the segments into polylines, and how many polylines that makes. Finally
+ * reports the time taken by the larger kernels and by downsampling, which the
+ * original algorithm does not have.
+ *
+ * Usage: $./testContour [width] [height] [levels] [repeats]
+ *
+ * for example: $./testContour 4096 4096 20 3
+ *
+ */
+
+#include "CartaLib/Algorithms/ContourConrec.h"
+#include "Tests/benchmarkCommon.h"
+#include "Tests/conrecSerial.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <cmath>
+#include <random>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace tContour
+{
+typedef Carta::Lib::NdArray::RawViewInterface RawViewInterface;
+using tBenchmark::bestMs;
+
+/// number of segments that differ between two results by more than the tolerance;
+/// for levels with a different number of segments, only the difference is counted
+static size_t
+countDifferences( const Carta::Lib::Algorithms::ContourConrec::Result & a,
+                  const Carta::Lib::Algorithms::ContourConrec::Result & b, double tolerance )
+{
+    size_t count = 0;
+    for ( size_t k = 0 ; k < a.size() && k < b.size() ; k++ ) {
+        if ( a[k].size() != b[k].size() ) {
+            count += std::max( a[k].size(), b[k].size() ) - std::min( a[k].size(), b[k].size() );
+            continue;
+        }
+        for ( size_t s = 0 ; s < a[k].size() ; s++ ) {
+            for ( int p = 0 ; p < 2 ; p++ ) {
+                if ( std::abs( a[k][s][p].x() - b[k][s][p].x() ) > tolerance ||
+                     std::abs( a[k][s][p].y() - b[k][s][p].y() ) > tolerance ) {
+                    count++;
+                    break;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+static bool
+benchmarkType( QTextStream & out, const QString & type, RawViewInterface * view,
+               const std::vector < double > & levels, int repeats )
+{
+    typedef Carta::Lib::Algorithms::ContourConrec ContourConrec;
+    ContourConrec cc;
+    cc.setLevels( levels );
+
+    out << type << "\n";
+    ContourConrec::Result reference;
+    double ms = bestMs( [&] () {
+        reference = conrecSerial( view, levels, type );
+    }, repeats );
+    size_t nSegments = 0;
+    for ( const auto & level : reference ) {
+        nSegments += level.size();
+    }
+    out << "  serial:  " << ms << " ms, " << nSegments << " segments\n";
+
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = std::max( 1, omp_get_max_threads() );
+#endif
+    bool identical = tBenchmark::forThreadCounts( maxThreads, [&] ( int nThreads ) {
+        ContourConrec::Result result;
+        cc.setThreadCount( nThreads );
+        double ms = bestMs( [&] () {
+            result = cc.computeSegments( view, type );
+        }, repeats );
+        // with smoothing, rounding differences move a few nearly flat contours, and
+        // may even change the segments of cells where the data is close to a level
+        size_t nDifferent = countDifferences( result, reference, 1e-3 );
+        bool same = type == "No smoothing" ? result == reference
+                                           : nDifferent <= nSegments / 100000;
+        out << "  banded, " << nThreads << " thread(s): " << ms << " ms";
+        if ( type != "No smoothing" ) {
+            out << ", " << nDifferent << " segment(s) differ";
+        }
+        out << ( same ? "" : "  MISMATCH" ) << "\n";
+        out.flush();
+        return same;
+    });
+
+    ContourConrec::Result polylines;
+    ms = bestMs( [&] () {
+        polylines = cc.compute( view, type );
+    }, repeats );
+    size_t nPolylines = 0;
+    for ( const auto & level : polylines ) {
+        nPolylines += level.size();
+    }
+    out << "  stitched, " << maxThreads << " thread(s): " << ms << " ms, " << nPolylines
+        << " polylines\n";
+    return identical;
+} // benchmarkType
+
+/// time the banded algorithm alone, for the types the serial one does not support
+static void
+benchmarkBanded( QTextStream & out, const QString & type, RawViewInterface * view,
+                 const std::vector < double > & levels, int repeats )
+{
+    typedef Carta::Lib::Algorithms::ContourConrec ContourConrec;
+    ContourConrec cc;
+    cc.setLevels( levels );
+    ContourConrec::Result result;
+    double ms = bestMs( [&] () {
+        result = cc.computeSegments( view, type );
+    }, repeats );
+    size_t nSegments = 0;
+    for ( const auto & level : result ) {
+        nSegments += level.size();
+    }
+    out << type << "\n  banded: " << ms << " ms, " << nSegments << " segments\n";
+    out.flush();
+}
+}
+
+int
+main( int argc, char * * argv )
+{
+    QCoreApplication app( argc, argv );
+    QStringList args = app.arguments();
+    int width = args.size() > 1 ? args[1].toInt() : 4096;
+    int height = args.size() > 2 ? args[2].toInt() : 4096;
+    int nLevels = args.size() > 3 ? args[3].toInt() : 20;
+    int repeats = args.size() > 4 ? args[4].toInt() : 3;
+
+    QTextStream out( stdout );
+    out << "Contouring " << width << "x" << height << " float frame with " << nLevels
+        << " levels, best of " << repeats << " run(s)\n";
+
+    // smooth structures plus noise, with a few NaNs
+    auto data = std::make_shared < std::vector < float > > ( int64_t( width ) * height );
+    std::mt19937 gen( 1 );
+    std::normal_distribution < float > dist( 0.0, 0.02 );
+    for ( int row = 0 ; row < height ; row++ ) {
+        for ( int col = 0 ; col < width ; col++ ) {
+            ( * data )[col + int64_t( row ) * width] =
+                std::sin( col * 0.01 ) * std::cos( row * 0.013 ) + dist( gen );
+        }
+    }
+    for ( size_t i = 0 ; i < data-> size() ; i += 1009 ) {
+        ( * data )[i] = std::numeric_limits < float >::quiet_NaN();
+    }
+    tBenchmark::MemoryRawView < float > view( data, 0, width, height );
+
+    std::vector < double > levels( nLevels );
+    for ( int i = 0 ; i < nLevels ; i++ ) {
+        levels[i] = -1.0 + 2.0 * ( i + 0.5 ) / nLevels;
+    }
+
+    bool ok = true;
+    ok = tContour::benchmarkType( out, "No smoothing", & view, levels, repeats ) && ok;
+    ok = tContour::benchmarkType( out, "Gaussian blur 3x3", & view, levels, repeats ) && ok;
+    ok = tContour::benchmarkType( out, "Box blur 5x5", & view, levels, repeats ) && ok;
+    tContour::benchmarkBanded( out, "Gaussian blur 9x9", & view, levels, repeats );
+    tContour::benchmarkBanded( out, "Gaussian blur sigma 3", & view, levels, repeats );
+    tContour::benchmarkBanded( out, "Downsample 2x", & view, levels, repeats );
+    tContour::benchmarkBanded( out, "Downsample 4x", & view, levels, repeats );
+
+    out << ( ok ? "All results match\n" : "Results differ!\n" );
+    return ok ? 0 : 1;
+} // main
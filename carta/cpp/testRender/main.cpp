@@ -0,0 +1,177 @@
+/*
+ * Benchmark for the raster render kernel (core/Algorithms/rasterRender.h)
+ *
+ * Renders a synthetic frame with the original per-pixel algorithm and with
+ * the banded, multithreaded kernel, checks that the results are identical, and
+ * reports megapixels/s for different numbers of threads. For float frames the
+ * kernel is also timed with the values forced to doubles, which is what it did
+ * before float pixels were kept native.
+ *
+ * At the end the peak resident set size of the process is printed; run the
+ * benchmark once with float and once with double pixels to compare the two.
+ *
+ * Usage: $./testRender [width] [height] [repeats] [float|double]
+ *
+ * for example: $./testRender 8192 8192 3 float
+ *
+ */
+
+#include "core/Algorithms/rasterRender.h"
+#include "Tests/benchmarkCommon.h"
+#include "core/GrayColormap.h"
+#include "CartaLib/PixelPipeline/CustomizablePixelPipeline.h"
+#include <QCoreApplication>
+#include <QImage>
+#include <QStringList>
+#include <QTextStream>
+#include <random>
+#include <sys/resource.h>
+
+namespace tRender
+{
+namespace RasterRender = Carta::Core::Algorithms::RasterRender;
+typedef Carta::Lib::NdArray::RawViewInterface RawViewInterface;
+
+/// the original per-pixel render algorithm
+template < class Pipeline >
+static void
+perPixelRender( RawViewInterface * rawView, Pipeline & pipe, QImage & img, QRgb nanColor )
+{
+    int width = img.width();
+    QRgb * outPtr = reinterpret_cast < QRgb * > ( img.scanLine( img.height() - 1 ) );
+    int64_t counter = 0;
+    Carta::Lib::NdArray::Double typedView( rawView, false );
+    typedView.forEach( [&] ( const double & val ) {
+        if ( Q_LIKELY( ! std::isnan( val ) ) ) {
+            pipe.convertq( val, * outPtr );
+        }
+        else {
+            * outPtr = nanColor;
+        }
+        outPtr++;
+        counter++;
+        if ( counter % width == 0 ) {
+            outPtr -= width * 2;
+        }
+    });
+}
+
+/// time func() and return the best megapixels/s out of 'repeats' runs
+static double
+bestMpixPerSec( std::function < void () > func, int64_t nPixels, int repeats )
+{
+    return nPixels / tBenchmark::bestMs( func, repeats ) * 1e-3;
+}
+
+template < class Pipeline >
+static bool
+benchmarkPipeline( QTextStream & out, const QString & name, RawViewInterface * view,
+                   Pipeline & pipe, int repeats )
+{
+    const int width = view-> dims()[0];
+    const int height = view-> dims()[1];
+    const int64_t nPixels = int64_t( width ) * height;
+    const QRgb nanColor = qRgb( 255, 0, 0 );
+
+    QImage reference( width, height, QImage::Format_ARGB32 );
+    QImage result( width, height, QImage::Format_ARGB32 );
+
+    out << name << "\n";
+    double mpps = bestMpixPerSec( [&] () {
+        perPixelRender( view, pipe, reference, nanColor );
+    }, nPixels, repeats );
+    out << "  per-pixel forEach:  " << mpps << " Mpix/s\n";
+
+    int maxThreads = RasterRender::defaultThreadCount();
+    bool identical = tBenchmark::forThreadCounts( maxThreads, [&] ( int nThreads ) {
+        double mpps = bestMpixPerSec( [&] () {
+            RasterRender::view2qImage( view, pipe, result, nanColor, nThreads );
+        }, nPixels, repeats );
+        bool same = result == reference;
+        out << "  banded, " << nThreads << " thread(s): " << mpps << " Mpix/s"
+            << ( same ? "" : "  MISMATCH" ) << "\n";
+        out.flush();
+        return same;
+    });
+
+    if ( view-> pixelType() == Carta::Lib::Image::PixelType::Real32 ) {
+        mpps = bestMpixPerSec( [&] () {
+            RasterRender::view2qImageAs < double > ( view, pipe, result, nanColor, maxThreads );
+        }, nPixels, repeats );
+        bool same = result == reference;
+        identical = identical && same;
+        out << "  banded as doubles, " << maxThreads << " thread(s): " << mpps << " Mpix/s"
+            << ( same ? "" : "  MISMATCH" ) << "\n";
+    }
+    return identical;
+} // benchmarkPipeline
+
+/// peak resident set size of the process, in MB
+static double
+peakRssMB()
+{
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, & usage ) != 0 ) {
+        return 0;
+    }
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / ( 1024.0 * 1024.0 );
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+/// render a synthetic frame with Scalar pixels, with and without interpolation
+template < typename Scalar >
+static bool
+benchmarkFrame( QTextStream & out, int width, int height, int repeats )
+{
+    // the values are generated as floats, so the float and double frames are the same
+    auto data = std::make_shared < std::vector < Scalar > > ( int64_t( width ) * height );
+    std::mt19937 gen( 1 );
+    std::normal_distribution < float > dist( 0.0, 1.0 );
+    for ( auto & x : * data ) {
+        x = dist( gen );
+    }
+    for ( size_t i = 0 ; i < data-> size() ; i += 101 ) {
+        ( * data )[i] = std::numeric_limits < float >::quiet_NaN();
+    }
+    tBenchmark::MemoryRawView < Scalar > view( data, 0, width, height );
+
+    auto pp = std::make_shared < Carta::Lib::PixelPipeline::CustomizablePixelPipeline > ();
+    pp-> setColormap( std::make_shared < Carta::Core::GrayColormap > () );
+    pp-> setMinMax( -3, 3 );
+
+    Carta::Lib::PixelPipeline::CachedPipeline < false > cpp;
+    cpp.cache( * pp, 10000, -3, 3 );
+    Carta::Lib::PixelPipeline::CachedPipeline < true > cppi;
+    cppi.cache( * pp, 10000, -3, 3 );
+
+    bool ok = true;
+    ok = benchmarkPipeline( out, "CachedPipeline<false>", & view, cpp, repeats ) && ok;
+    ok = benchmarkPipeline( out, "CachedPipeline<true>", & view, cppi, repeats ) && ok;
+    return ok;
+} // benchmarkFrame
+}
+
+int
+main( int argc, char * * argv )
+{
+    QCoreApplication app( argc, argv );
+    QStringList args = app.arguments();
+    int width = args.size() > 1 ? args[1].toInt() : 4096;
+    int height = args.size() > 2 ? args[2].toInt() : 4096;
+    int repeats = args.size() > 3 ? args[3].toInt() : 3;
+    bool doublePixels = args.size() > 4 && args[4] == "double";
+
+    QTextStream out( stdout );
+    out << "Rendering " << width << "x" << height << ( doublePixels ? " double" : " float" )
+        << " frame, best of " << repeats << " run(s)\n";
+
+    bool ok = doublePixels ? tRender::benchmarkFrame < double > ( out, width, height, repeats )
+                           : tRender::benchmarkFrame < float > ( out, width, height, repeats );
+
+    out << "Peak RSS: " << tRender::peakRssMB() << " MB\n";
+    out << ( ok ? "All results identical\n" : "Results differ!\n" );
+    return ok ? 0 : 1;
+} // main
@@ -735,6 +735,7 @@ qx.Class.define("skel.boundWidgets.Animator", {
                 title : this.m_title
             };
             this.fireDataEvent( "movieStart", data );
+            this._sendPlaying( true );
             if (this.m_timer) {
                 this.m_timer.stop();
                 if (this.m_timer.hasListener("interval")) {
@@ -847,6 +848,22 @@ qx.Class.define("skel.boundWidgets.Animator", {
             }
         },
 
+        /**
+         * Notify the server that the animation started or stopped playing, so that it
+         * only reads frames ahead during playback.
+         * @param playing {Boolean} true if the animation is playing; false otherwise.
+         */
+        _sendPlaying : function( playing ) {
+            if ( this.m_connector !== null && !this.m_noSends ){
+                if ( this.m_animId !== null && this.m_animId.length > 0 ){
+                    var path = skel.widgets.Path.getInstance();
+                    var cmd = this.m_animId + path.SEP_COMMAND + "setPlaying";
+                    var params = "playing:"+playing;
+                    this.m_connector.sendCommand( cmd, params, function(){});
+                }
+            }
+        },
+
         /**
          * Send a command to the server indicating the new frame rate.
          */
@@ -991,6 +1008,7 @@ qx.Class.define("skel.boundWidgets.Animator", {
                 title : this.m_title
             };
             this.fireDataEvent( "movieStop", data );
+            this._sendPlaying( false );
             if (this.m_timer !== null) {
                 this.m_playButton.setValue(false);
                 this.m_revPlayButton.setValue(false);
@@ -66,6 +66,14 @@ qx.Class.define("skel.widgets.Image.Contour.GeneratorPage", {
             }
         },
 
+        /**
+         * Enables the smoothing sigma only for the contour type that uses it.
+         */
+        _contourTypeChanged : function(){
+            var type = this.m_typeItemCombo.getValue();
+            this.m_sigmaWidget.setEnabled( type == "Gaussian blur sigma" );
+        },
+
         /**
          * Initializes the UI.
          */
@@ -85,7 +93,22 @@ qx.Class.define("skel.widgets.Image.Contour.GeneratorPage", {
             typeItemContainer.add( typeItemLabel );
             typeItemContainer.add( this.m_typeItemCombo );
             this.m_typeItemCombo.setToolTipText( "Specify a contour type to generate.");
+            this.m_typeItemCombo.addListener( "selectChanged", this._contourTypeChanged, this );
             typeContainer.add( typeItemContainer );
+
+            //Smoothing sigma
+            var sigmaContainer = new qx.ui.container.Composite();
+            sigmaContainer.setLayout( new qx.ui.layout.HBox(2));
+            var sigmaLabel = new qx.ui.basic.Label( "Sigma:");
+            this.m_sigmaWidget = new skel.widgets.CustomUI.NumericTextField(0.0001,100);
+            skel.widgets.TestID.addTestId( this.m_sigmaWidget, "contourSmoothingSigma" );
+            this.m_sigmaWidget.setIntegerOnly( false );
+            this.m_sigmaWidget.setEnabled( false );
+            this.m_sigmaWidget.setToolTipText( "Set the standard deviation, in pixels, of the Gaussian blur sigma smoothing.");
+            this.m_sigmaWidget.addListener( "textChanged", this._sendSmoothingSigmaCmd, this );
+            sigmaContainer.add( sigmaLabel );
+            sigmaContainer.add( this.m_sigmaWidget );
+            typeContainer.add( sigmaContainer );
             typeContainer.add( new qx.ui.core.Spacer(), {flex:1});
 
             //Name
@@ -354,6 +377,22 @@ qx.Class.define("skel.widgets.Image.Contour.GeneratorPage", {
             }
         },
 
+        /**
+         * Send a command to the server specifying the standard deviation of the
+         * Gaussian blur sigma smoothing.
+         */
+        _sendSmoothingSigmaCmd : function(){
+            var errorMan = skel.widgets.ErrorHandler.getInstance();
+            errorMan.clearErrors();
+            if ( this.m_id !== null && this.m_connector !== null){
+                var sigma = this.m_sigmaWidget.getValue();
+                var path = skel.widgets.Path.getInstance();
+                var cmd = this.m_id + path.SEP_COMMAND + "setSmoothingSigma";
+                var params = "sigma:"+sigma;
+                this.m_connector.sendCommand( cmd, params, function(){});
+            }
+        },
+
         /**
          * Send a command to the server specifying the number of contour levels.
          */
@@ -423,6 +462,7 @@ qx.Class.define("skel.widgets.Image.Contour.GeneratorPage", {
             this._setDashedNegative( controls.dashedNegative );
             this._setGenerateMethod( controls.generateMode );
             this._setContourType( controls.typeMode );
+            this._setSmoothingSigma( controls.smoothingSigma );
             this._setLevelCountMax( controls.levelCountMax );
             this._setLevelCount( controls.levelCount );
             this._setSpacingMethod( controls.spacingMode );
@@ -509,6 +549,19 @@ qx.Class.define("skel.widgets.Image.Contour.GeneratorPage", {
         _setContourType : function( type ){
             if ( this.m_typeItemCombo.getValue() != type ){
                 this.m_typeItemCombo.setSelectValue( type, false );
+                this._contourTypeChanged();
+            }
+        },
+
+        /**
+         * Update the UI based on server-side information about the standard deviation
+         * of the Gaussian blur sigma smoothing.
+         * @param value {Number} - the standard deviation, in pixels.
+         */
+        _setSmoothingSigma : function( value ){
+            var sigma = this.m_sigmaWidget.getValue();
+            if ( sigma === null || sigma != value ){
+                this.m_sigmaWidget.setValue( value.toString() );
             }
         },
 
@@ -612,6 +665,7 @@ qx.Class.define("skel.widgets.Image.Contour.GeneratorPage", {
         m_limitMaxText : null,
         m_nameCombo : null,
         m_negativeCheck : null,
+        m_sigmaWidget : null,
         m_sharedVarGenerateModes : null,
         m_sharedVarTypeModes : null,
         m_sharedVarSpacingModes : null,
@@ -280,6 +280,27 @@ class Cartavis:
         result = self.con.cmdTagList("getPluginList")
         return result
 
+    def getMemoryUsage(self):
+        """
+        Returns the memory used by the in-memory caches of the server.
+        All caches together are kept within a budget set by the
+        memoryBudgetMB entry of config.json; when they grow beyond it,
+        the least recently used caches with the lowest priority are
+        shrunk first.
+
+        Returns
+        -------
+        dict
+            'maxBytes' and 'usedBytes' give the budget and the memory used
+            by all caches together, 'caches' is a list with a dict for each
+            cache, with its 'name', 'priority', size in 'bytes', whether it
+            is 'evictable' and how many 'evictions' it went through.
+        """
+        result = self.con.cmdTagList("getMemoryUsage")
+        usage = json.loads(result[0])
+        usage['caches'] = [json.loads(cache) for cache in result[1:]]
+        return usage
+
     def getEmptyWindowCount(self):
         """
         Returns the number of empty windows in the application.
@@ -805,3 +805,15 @@ def _loadFilesFromDirectory(imageView, directory):
     for filename in os.listdir(directory):
         assert imageView.loadFile(directory + '/' + filename) == ['']
         time.sleep(1)
+
+def test_getMemoryUsage(cartavisInstance, cleanSlate):
+    """
+    Test that the caches of a loaded image are reported within the budget.
+    """
+    i = cartavisInstance.getImageViews()
+    i[0].loadFile(os.getcwd() + '/data/mexinputtest.fits')
+    usage = cartavisInstance.getMemoryUsage()
+    assert usage['maxBytes'] > 0
+    assert usage['usedBytes'] <= usage['maxBytes']
+    assert sum(cache['bytes'] for cache in usage['caches']) == usage['usedBytes']
+    assert any(cache['name'].endswith('frames') for cache in usage['caches'])